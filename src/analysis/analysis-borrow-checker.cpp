@@ -13,133 +13,864 @@
  *  limitations under the License.
  */
 #include <gyoji-analysis.hpp>
+#include <gyoji-misc/bitset.hpp>
+#include <algorithm>
 #include <stdio.h>
 
 using namespace Gyoji::mir;
 using namespace Gyoji::context;
 using namespace Gyoji::analysis;
+using Gyoji::misc::BitSet;
 
-/**
- * This class indicates an operation
- * inside a basic block.  The block
- * is the ID of the basic block
- * and operation is the index into
- * that basic block indicating
- * a specific operation.
- */
-class BasicBlockOperation {
-public:
-    BasicBlockOperation(size_t _blockid, size_t _operationid);
-    BasicBlockOperation(const BasicBlockOperation & _other);
-    ~BasicBlockOperation();
-    size_t blockid;
-    size_t operationid;
-};
-
-/**
- * This class represents an edge in the control-flow
- * graph with edges between operations and the 'next'
- * operation in the graph.
- */
-class CFGEdge {
-public:
-    CFGEdge(const BasicBlockOperation & start, const BasicBlockOperation & end);
-    CFGEdge(const CFGEdge & _other);
-    ~CFGEdge();
-    BasicBlockOperation start;
-    BasicBlockOperation end;
-};
 ///////////////////////////////
-// BasicBlockOperation
+// AnalysisPassBorrowChecker
 ///////////////////////////////
-BasicBlockOperation::BasicBlockOperation(size_t _blockid, size_t _operationid)
-    : blockid(_blockid)
-    , operationid(_operationid)
+AnalysisPassBorrowChecker::AnalysisPassBorrowChecker(CompilerContext & _compiler_context)
+    : FunctionAnalysisPass(_compiler_context, "borrow checker")
 {}
-BasicBlockOperation::BasicBlockOperation(const BasicBlockOperation & _other)
-    : blockid(_other.blockid)
-    , operationid(_other.operationid)
+AnalysisPassBorrowChecker::~AnalysisPassBorrowChecker()
 {}
-BasicBlockOperation::~BasicBlockOperation()
+
+// Marks an origin, loan, or variable that
+// isn't there.
+static const size_t none = (size_t)-1;
+
+namespace Gyoji::analysis {
+
+    // A loan is created each time the address of
+    // a local variable (or a member or element of it)
+    // is taken.  Loans are always of the whole variable,
+    // so borrowing one member of a class borrows
+    // all of it.
+    class Loan {
+    public:
+	Loan(Atom _variable, const std::string & _variable_name, const Operation & _operation);
+	Loan(const Loan & other);
+	~Loan();
+	Atom variable;
+	std::string variable_name;
+	const Operation & operation;
+    };
+
+    // These are the Polonius facts for a single
+    // operation.  Origins are numbered densely
+    // across the function and loans are numbered
+    // densely in the order they are issued.
+    class OperationFacts {
+    public:
+	OperationFacts();
+	OperationFacts(const OperationFacts & other);
+	~OperationFacts();
+	// subset_base(from, to): loans held by 'from'
+	// flow into 'to' at this operation.
+	std::vector<std::pair<size_t, size_t>> subset_base;
+	// Origins that are overwritten by this operation.
+	std::vector<size_t> defs;
+	// Origins that are read by this operation.
+	std::vector<size_t> uses;
+	// Origins that are used, defined, or flowed into
+	// here but are not live after this operation
+	// so they can be emptied.
+	std::vector<size_t> dying;
+	// loan_issued_at(origin, loan)
+	size_t loan_issued;
+	size_t loan_origin;
+	// loan_invalidated_at: the loans of this variable
+	// are invalidated by this operation.
+	bool invalidates;
+	Atom invalidated_variable;
+	// loan_killed_at: the variable went out of scope, so
+	// the loans of it can no longer be used after this.
+	bool kills;
+    };
+
+    // Liveness of origins: an operation makes the
+    // origins it reads live and the origins it
+    // overwrites dead.
+    class OriginLiveness : public DataFlowProblem {
+    public:
+	OriginLiveness(
+	    const std::vector<std::vector<OperationFacts>> & _block_facts,
+	    size_t _norigins
+	    );
+	virtual ~OriginLiveness();
+	virtual void effect(
+	    size_t block_id,
+	    size_t operation_index,
+	    const Operation & operation,
+	    BitSet & gen,
+	    BitSet & kill
+	    ) const;
+    private:
+	const std::vector<std::vector<OperationFacts>> & block_facts;
+    };
+
+    // Extracts the facts about the loans, origins, and
+    // liveness of a function from its MIR.
+    class BorrowFacts {
+    public:
+	BorrowFacts(const Function & _function);
+	~BorrowFacts();
+
+	size_t get_origin_count() const;
+	const std::vector<Loan> & get_loans() const;
+	const BitSet & get_loans_of_variable(Atom variable) const;
+	const std::vector<OperationFacts> & get_block_facts(size_t blockid) const;
+	const BitSet & get_live_in(size_t blockid) const;
+    private:
+	const Function & function;
+	const CFGInfo & cfg;
+
+	std::vector<size_t> tmpvar_origin;
+	std::map<Atom, size_t> variable_origin;
+	std::map<const Type*, bool> carries_references_memo;
+	size_t norigins;
+
+	// The local variable each tmpvar is a place
+	// inside of, if any, and whether the
+	// place is the whole variable.
+	std::vector<Atom> place_root;
+	std::vector<const std::string*> root_name;
+	std::vector<bool> has_root;
+	std::vector<bool> whole_variable;
+	// Tmpvars whose value is read rather than
+	// only being the destination of an assignment.
+	std::vector<bool> read_use;
+
+	std::vector<Loan> loans;
+	std::map<Atom, BitSet> loans_of_variable;
+	BitSet no_loans;
+
+	std::vector<std::vector<OperationFacts>> block_facts;
+	std::vector<BitSet> live_in;
+
+	bool carries_references(const Type *type);
+	size_t origin_of_variable(Atom variable, const Type *type);
+	size_t origin_of_variable(Atom variable) const;
+	size_t origin_of_tmpvar(size_t tmpvar) const;
+
+	void extract_places();
+	void extract_operation(OperationFacts & facts, const Operation & operation);
+	void calculate_liveness();
+    };
+
+    // The loans held by each origin at a single
+    // program point.  The bitset of loans is only
+    // allocated for an origin the first time it holds
+    // a loan, so a function with many origins and few
+    // borrows stays cheap.
+    class OriginLoans {
+    public:
+	OriginLoans(size_t _norigins, size_t _nloans);
+	~OriginLoans();
+
+	typedef std::vector<std::pair<size_t, BitSet>> List;
+
+	void load(const List & list);
+	bool join_into(List & list, const BitSet & live) const;
+
+	void reset(size_t origin);
+	void flow(size_t from, size_t to);
+	void add_loan(size_t origin, size_t loan);
+	void kill(const BitSet & killed);
+	void live_loans_in(const BitSet & loans, BitSet & found) const;
+    private:
+	size_t nloans;
+	std::vector<BitSet> contains;
+	BitSet occupied;
+	void ensure(size_t origin);
+    };
+};
+
+//////////////////////////////////////////////
+// Loan
+//////////////////////////////////////////////
+Loan::Loan(Atom _variable, const std::string & _variable_name, const Operation & _operation)
+    : variable(_variable)
+    , variable_name(_variable_name)
+    , operation(_operation)
 {}
-///////////////////////////////
-// CFGEdge
-///////////////////////////////
-CFGEdge::CFGEdge(const BasicBlockOperation & _start, const BasicBlockOperation & _end)
-    : start(_start)
-    , end(_end)
+Loan::Loan(const Loan & other)
+    : variable(other.variable)
+    , variable_name(other.variable_name)
+    , operation(other.operation)
+{}
+Loan::~Loan()
+{}
+
+//////////////////////////////////////////////
+// OperationFacts
+//////////////////////////////////////////////
+OperationFacts::OperationFacts()
+    : loan_issued(none)
+    , loan_origin(none)
+    , invalidates(false)
+    , invalidated_variable(0)
+    , kills(false)
 {}
-CFGEdge::CFGEdge(const CFGEdge & _other)
-    : start(_other.start)
-    , end(_other.end)
+OperationFacts::OperationFacts(const OperationFacts & other)
+    : subset_base(other.subset_base)
+    , defs(other.defs)
+    , uses(other.uses)
+    , dying(other.dying)
+    , loan_issued(other.loan_issued)
+    , loan_origin(other.loan_origin)
+    , invalidates(other.invalidates)
+    , invalidated_variable(other.invalidated_variable)
+    , kills(other.kills)
 {}
-CFGEdge::~CFGEdge()
+OperationFacts::~OperationFacts()
 {}
 
-///////////////////////////////
-// AnalysisPassBorrowChecker
-///////////////////////////////
-AnalysisPassBorrowChecker::AnalysisPassBorrowChecker(CompilerContext & _compiler_context)
-    : AnalysisPass(_compiler_context, "borrow checker")
+//////////////////////////////////////////////
+// OriginLiveness
+//////////////////////////////////////////////
+OriginLiveness::OriginLiveness(
+    const std::vector<std::vector<OperationFacts>> & _block_facts,
+    size_t _norigins
+    )
+    : DataFlowProblem(BACKWARD, MAY, _norigins)
+    , block_facts(_block_facts)
 {}
-AnalysisPassBorrowChecker::~AnalysisPassBorrowChecker()
+
+OriginLiveness::~OriginLiveness()
 {}
 
 void
-AnalysisPassBorrowChecker::check(const MIR & mir) const
+OriginLiveness::effect(
+    size_t block_id,
+    size_t operation_index,
+    const Operation & operation,
+    BitSet & gen,
+    BitSet & kill
+    ) const
 {
-    // Here, we follow the basic plan of the 'Polonius' algorithm
-    // for borrow checking.
+    const OperationFacts & facts = block_facts.at(block_id).at(operation_index);
+    for (size_t origin : facts.uses) {
+	gen.set(origin);
+    }
+    for (size_t origin : facts.defs) {
+	kill.set(origin);
+    }
+}
+
+//////////////////////////////////////////////
+// BorrowFacts
+//////////////////////////////////////////////
+BorrowFacts::BorrowFacts(const Function & _function)
+    : function(_function)
+    , cfg(_function.get_cfg_info())
+    , norigins(0)
+{
+    // Every tmpvar that may hold a reference gets an origin.
+    size_t ntmpvars = function.tmpvar_count();
+    tmpvar_origin.resize(ntmpvars, none);
+    for (size_t tmpvar = 0; tmpvar < ntmpvars; tmpvar++) {
+	if (carries_references(function.tmpvar_get(tmpvar))) {
+	    tmpvar_origin[tmpvar] = norigins++;
+	}
+    }
+    // Arguments hold references handed to us by
+    // the caller, so they never hold loans of our
+    // own variables, but they may flow into them.
+    for (const auto & argument : function.get_arguments()) {
+	origin_of_variable(argument.get_name_atom(), argument.get_type());
+    }
+
+    extract_places();
 
-    for (const auto & function : mir.get_functions().get_functions()) {
-	check(*function);
+    block_facts.resize(cfg.get_block_limit());
+    for (size_t blockid : cfg.get_reverse_post_order()) {
+	const BasicBlock & block = function.get_basic_block(blockid);
+	std::vector<OperationFacts> & facts = block_facts[blockid];
+	facts.resize(block.get_operations().size());
+	for (size_t i = 0; i < facts.size(); i++) {
+	    extract_operation(facts[i], *block.get_operations().at(i));
+	}
     }
-    
+
+    // Now that all of the loans are known,
+    // we can size the loan sets.
+    no_loans.resize(loans.size());
+    for (size_t loan = 0; loan < loans.size(); loan++) {
+	BitSet & of_variable = loans_of_variable[loans[loan].variable];
+	of_variable.resize(loans.size());
+	of_variable.set(loan);
+    }
+
+    calculate_liveness();
+}
+
+BorrowFacts::~BorrowFacts()
+{}
+
+bool
+BorrowFacts::carries_references(const Type *type)
+{
+    if (type == nullptr) {
+	return false;
+    }
+    const auto & it = carries_references_memo.find(type);
+    if (it != carries_references_memo.end()) {
+	return it->second;
+    }
+    // Raw pointers are unsafe and are not tracked.  Function
+    // pointers are because a method bound to an object carries
+    // a reference to that object until it is called.
+    bool carries = false;
+    carries_references_memo[type] = false;
+    switch (type->get_type()) {
+    case Type::TYPE_REFERENCE:
+    case Type::TYPE_FUNCTION_POINTER:
+	carries = true;
+	break;
+    case Type::TYPE_ARRAY:
+	carries = carries_references(type->get_pointer_target());
+	break;
+    case Type::TYPE_COMPOSITE:
+    case Type::TYPE_ANONYMOUS_STRUCTURE:
+	for (const auto & member : type->get_members()) {
+	    if (carries_references(member.get_type())) {
+		carries = true;
+		break;
+	    }
+	}
+	break;
+    default:
+	break;
+    }
+    carries_references_memo[type] = carries;
+    return carries;
 }
 
-void AnalysisPassBorrowChecker::check(const Function & function) const
+size_t
+BorrowFacts::origin_of_variable(Atom variable, const Type *type)
 {
-    // We start with mapping the "edges" of the graph
-    // from the basic-blocks of the function.
-    const auto & blocks = function.get_blocks();
+    const auto & it = variable_origin.find(variable);
+    if (it != variable_origin.end()) {
+	return it->second;
+    }
+    if (!carries_references(type)) {
+	return none;
+    }
+    size_t origin = norigins++;
+    variable_origin.insert(std::pair(variable, origin));
+    return origin;
+}
+
+size_t
+BorrowFacts::origin_of_variable(Atom variable) const
+{
+    const auto & it = variable_origin.find(variable);
+    if (it == variable_origin.end()) {
+	return none;
+    }
+    return it->second;
+}
 
-    std::vector<CFGEdge> cfg_edges;
-    
-    for (const auto & block_it : blocks) {
-	const BasicBlock & block = *block_it.second;
-	const std::vector<Gyoji::owned<Operation>> & operations = block.get_operations();
+size_t
+BorrowFacts::origin_of_tmpvar(size_t tmpvar) const
+{
+    if (tmpvar >= tmpvar_origin.size()) {
+	return none;
+    }
+    return tmpvar_origin[tmpvar];
+}
 
-#if 0
-	// In principle, empty blocks are ok as long as
-	// they are not reachable.
-	// Each basic block must have at least one operation.
-	if (operations.size() == 0) {
-	    get_compiler_context()
-		.get_errors()
-		.add_simple_error(function.get_source_ref(),
-				  "Compiler bug!  Please report this message(borrow)",
-				  std::string("Function ") + function.get_name() + std::string(" found with empty Basic Block")
-		    );
-	    break;
-	}
-#endif
-	// TODO: Finish the logic of
-	// tying blocks together in a graph
-	// by traversing it.
-	BasicBlockOperation startblock(block_it.first, 0);
-	BasicBlockOperation endblock(block_it.first, 1);
-	cfg_edges.push_back(CFGEdge(startblock, endblock));
+void
+BorrowFacts::extract_places()
+{
+    size_t ntmpvars = function.tmpvar_count();
+    place_root.resize(ntmpvars, 0);
+    root_name.resize(ntmpvars, nullptr);
+    has_root.resize(ntmpvars, false);
+    whole_variable.resize(ntmpvars, false);
+    read_use.resize(ntmpvars, false);
+
+    // Tmpvars are defined before they are used along every
+    // path, so a single pass in reverse post-order sees the
+    // place of each operand before it is needed.
+    for (size_t blockid : cfg.get_reverse_post_order()) {
+	const BasicBlock & block = function.get_basic_block(blockid);
 	for (const auto & operation_ptr : block.get_operations()) {
 	    const Operation & operation = *operation_ptr;
+	    const std::vector<size_t> & operands = operation.get_operands();
+	    size_t noperands = operation.get_tmpvar_operand_count();
+	    for (size_t i = 0; i < noperands; i++) {
+		if (operation.get_type() == Operation::OP_ASSIGN && i == 0) {
+		    continue;
+		}
+		if (operands[i] < ntmpvars) {
+		    read_use[operands[i]] = true;
+		}
+	    }
+
+	    size_t result = operation.get_result();
+	    if (!operation.has_result() || result >= ntmpvars) {
+		continue;
+	    }
+	    switch (operation.get_type()) {
+	    case Operation::OP_LOCAL_VARIABLE:
+		{
+		const OperationLocalVariable & local_variable = (const OperationLocalVariable &)operation;
+		place_root[result] = local_variable.get_symbol_atom();
+		root_name[result] = &local_variable.get_symbol_name();
+		has_root[result] = true;
+		whole_variable[result] = true;
+		origin_of_variable(local_variable.get_symbol_atom(), local_variable.get_var_type());
+		}
+		break;
+	    case Operation::OP_LOCAL_DECLARE:
+		break;
+	    case Operation::OP_DOT:
+		// A member of a local variable is stored
+		// inside of that variable.
+		if (operands.size() > 0 && operands[0] < ntmpvars && has_root[operands[0]]) {
+		    place_root[result] = place_root[operands[0]];
+		    root_name[result] = root_name[operands[0]];
+		    has_root[result] = true;
+		}
+		break;
+	    case Operation::OP_ARRAY_INDEX:
+		// An element of an array is stored inside of the
+		// array, but the element a pointer points to is not.
+		if (operands.size() > 0 && operands[0] < ntmpvars && has_root[operands[0]]) {
+		    const Type *array_type = function.tmpvar_get(operands[0]);
+		    if (array_type != nullptr && array_type->is_array()) {
+			place_root[result] = place_root[operands[0]];
+			root_name[result] = root_name[operands[0]];
+			has_root[result] = true;
+		    }
+		}
+		break;
+	    default:
+		break;
+	    }
+	}
+    }
+}
+
+void
+BorrowFacts::extract_operation(OperationFacts & facts, const Operation & operation)
+{
+    const std::vector<size_t> & operands = operation.get_operands();
+    size_t noperands = operation.get_tmpvar_operand_count();
+    size_t result_origin = operation.has_result() ? origin_of_tmpvar(operation.get_result()) : none;
+
+    switch (operation.get_type()) {
+    case Operation::OP_LOCAL_DECLARE:
+	{
+	const OperationLocalDeclare & local_declare = (const OperationLocalDeclare &)operation;
+	size_t origin = origin_of_variable(local_declare.get_variable_atom(), local_declare.get_variable_type());
+	if (origin != none) {
+	    facts.defs.push_back(origin);
+	}
+	}
+	return;
+    case Operation::OP_LOCAL_UNDECLARE:
+	{
+	const OperationLocalUndeclare & local_undeclare = (const OperationLocalUndeclare &)operation;
+	Atom variable = local_undeclare.get_variable_atom();
+	size_t origin = origin_of_variable(variable);
+	if (origin != none) {
+	    facts.defs.push_back(origin);
+	}
+	facts.invalidates = true;
+	facts.invalidated_variable = variable;
+	facts.kills = true;
+	}
+	return;
+    case Operation::OP_LOCAL_VARIABLE:
+	{
+	const OperationLocalVariable & local_variable = (const OperationLocalVariable &)operation;
+	size_t origin = origin_of_variable(local_variable.get_symbol_atom());
+	if (origin != none && read_use[operation.get_result()]) {
+	    facts.uses.push_back(origin);
+	}
+	if (result_origin != none) {
+	    facts.defs.push_back(result_origin);
+	    if (origin != none) {
+		facts.subset_base.push_back(std::pair(origin, result_origin));
+	    }
+	}
+	}
+	return;
+    default:
+	break;
+    }
+
+    for (size_t i = 0; i < noperands; i++) {
+	if (operation.get_type() == Operation::OP_ASSIGN && i == 0) {
+	    continue;
+	}
+	size_t operand_origin = origin_of_tmpvar(operands[i]);
+	if (operand_origin == none) {
+	    continue;
+	}
+	facts.uses.push_back(operand_origin);
+	if (result_origin != none) {
+	    facts.subset_base.push_back(std::pair(operand_origin, result_origin));
 	}
     }
+    if (result_origin != none) {
+	facts.defs.push_back(result_origin);
+    }
 
-    // TODO:
-    // We need to finish the CFG above
-    // and also extract the 'loans', the 'regions',
-    // and the 'live/killed' status of each variable from the MIR.
+    if (operation.get_type() == Operation::OP_ASSIGN && operands.size() == 2) {
+	size_t destination = operands[0];
+	if (destination < has_root.size() && has_root[destination]) {
+	    Atom variable = place_root[destination];
+	    facts.invalidates = true;
+	    facts.invalidated_variable = variable;
 
-    // Finally, we perform the graph-traversal
-    // to solve this.  It should mainly take the form of
-    // a Hornsat solver, I think.
+	    // The value being assigned flows into the variable.
+	    // Assigning the whole variable replaces what it
+	    // held, but assigning to part of it does not.
+	    size_t variable_origin = origin_of_variable(variable);
+	    size_t value_origin = origin_of_tmpvar(operands[1]);
+	    if (variable_origin != none) {
+		if (whole_variable[destination]) {
+		    facts.defs.push_back(variable_origin);
+		}
+		if (value_origin != none) {
+		    facts.subset_base.push_back(std::pair(value_origin, variable_origin));
+		}
+	    }
+	}
+    }
+    else if (operation.get_type() == Operation::OP_ADDRESSOF && operands.size() == 1) {
+	size_t place = operands[0];
+	if (result_origin != none && place < has_root.size() && has_root[place]) {
+	    facts.loan_issued = loans.size();
+	    facts.loan_origin = result_origin;
+	    loans.push_back(Loan(place_root[place], *root_name[place], operation));
+	}
+    }
+}
+
+void
+BorrowFacts::calculate_liveness()
+{
+    // An origin is live at a point if some value holding
+    // it may be read later without being overwritten first.
+    OriginLiveness problem(block_facts, norigins);
+    DataFlow liveness(function, problem);
+
+    // Liveness is a backward problem, so what flows
+    // 'out' of a block is what is live at its start.
+    live_in.resize(cfg.get_block_limit());
+    BitSet live(norigins);
+    for (size_t blockid : cfg.get_reverse_post_order()) {
+	live_in[blockid] = liveness.get_out(blockid);
+
+	// Walk each block backward once more to find
+	// the last operation each origin is live at.
+	const std::vector<Gyoji::owned<Operation>> & operations = function.get_basic_block(blockid).get_operations();
+	std::vector<OperationFacts> & facts = block_facts[blockid];
+	live = liveness.get_in(blockid);
+	for (size_t i = facts.size(); i > 0; i--) {
+	    OperationFacts & operation_facts = facts[i-1];
+	    for (size_t origin : operation_facts.uses) {
+		if (!live.test(origin)) {
+		    operation_facts.dying.push_back(origin);
+		}
+	    }
+	    for (size_t origin : operation_facts.defs) {
+		if (!live.test(origin)) {
+		    operation_facts.dying.push_back(origin);
+		}
+	    }
+	    for (const auto & subset : operation_facts.subset_base) {
+		if (!live.test(subset.second)) {
+		    operation_facts.dying.push_back(subset.second);
+		}
+	    }
+	    liveness.apply(blockid, i-1, *operations.at(i-1), live);
+	}
+    }
+}
+
+size_t
+BorrowFacts::get_origin_count() const
+{ return norigins; }
+
+const std::vector<Loan> &
+BorrowFacts::get_loans() const
+{ return loans; }
+
+const BitSet &
+BorrowFacts::get_loans_of_variable(Atom variable) const
+{
+    const auto & it = loans_of_variable.find(variable);
+    if (it == loans_of_variable.end()) {
+	return no_loans;
+    }
+    return it->second;
+}
+
+const std::vector<OperationFacts> &
+BorrowFacts::get_block_facts(size_t blockid) const
+{ return block_facts.at(blockid); }
+
+const BitSet &
+BorrowFacts::get_live_in(size_t blockid) const
+{ return live_in.at(blockid); }
+
+//////////////////////////////////////////////
+// OriginLoans
+//////////////////////////////////////////////
+static bool
+origin_less(const std::pair<size_t, BitSet> & entry, size_t origin)
+{ return entry.first < origin; }
+
+OriginLoans::OriginLoans(size_t _norigins, size_t _nloans)
+    : nloans(_nloans)
+    , contains(_norigins)
+    , occupied(_norigins)
+{}
+
+OriginLoans::~OriginLoans()
+{}
+
+void
+OriginLoans::ensure(size_t origin)
+{
+    if (contains[origin].size() == 0) {
+	contains[origin].resize(nloans);
+    }
+}
+
+void
+OriginLoans::load(const List & list)
+{
+    for (size_t origin = occupied.find_next(0); origin < occupied.size(); origin = occupied.find_next(origin+1)) {
+	contains[origin].clear();
+    }
+    occupied.clear();
+    for (const auto & it : list) {
+	ensure(it.first);
+	contains[it.first] = it.second;
+	occupied.set(it.first);
+    }
+}
+
+bool
+OriginLoans::join_into(List & list, const BitSet & live) const
+{
+    // The list is kept sorted by origin.
+    bool changed = false;
+    for (size_t origin = occupied.find_next(0); origin < occupied.size(); origin = occupied.find_next(origin+1)) {
+	if (!live.test(origin)) {
+	    continue;
+	}
+	auto it = std::lower_bound(list.begin(), list.end(), origin, origin_less);
+	if (it == list.end() || it->first != origin) {
+	    list.insert(it, std::pair(origin, contains[origin]));
+	    changed = true;
+	}
+	else if (it->second.union_with(contains[origin])) {
+	    changed = true;
+	}
+    }
+    return changed;
+}
+
+void
+OriginLoans::reset(size_t origin)
+{
+    if (occupied.test(origin)) {
+	contains[origin].clear();
+	occupied.reset(origin);
+    }
+}
+
+void
+OriginLoans::flow(size_t from, size_t to)
+{
+    if (!occupied.test(from)) {
+	return;
+    }
+    ensure(to);
+    contains[to].union_with(contains[from]);
+    occupied.set(to);
+}
+
+void
+OriginLoans::add_loan(size_t origin, size_t loan)
+{
+    ensure(origin);
+    contains[origin].set(loan);
+    occupied.set(origin);
+}
+
+void
+OriginLoans::kill(const BitSet & killed)
+{
+    for (size_t origin = occupied.find_next(0); origin < occupied.size(); origin = occupied.find_next(origin+1)) {
+	contains[origin].subtract(killed);
+	if (contains[origin].empty()) {
+	    occupied.reset(origin);
+	}
+    }
+}
+
+void
+OriginLoans::live_loans_in(const BitSet & loans, BitSet & found) const
+{
+    // Only live origins ever hold loans because they are
+    // emptied as soon as they die, so any loan held
+    // here is one that will be used later.
+    for (size_t origin = occupied.find_next(0); origin < occupied.size(); origin = occupied.find_next(origin+1)) {
+	if (contains[origin].intersects(loans)) {
+	    BitSet held(contains[origin]);
+	    held.intersect_with(loans);
+	    found.union_with(held);
+	}
+    }
+}
+
+//////////////////////////////////////////////
+// Solver
+//////////////////////////////////////////////
+
+// Applies the facts of one operation to the loans
+// held at the point before it, giving the loans
+// held at the point after it.  If errors are given,
+// any live loan invalidated by the operation is
+// reported unless it has been reported already.
+static void
+apply_operation(
+    const BorrowFacts & borrow_facts,
+    const OperationFacts & facts,
+    const Operation & operation,
+    OriginLoans & state,
+    BitSet & scratch,
+    BitSet & reported,
+    Errors *errors
+    )
+{
+    if (facts.invalidates && errors != nullptr) {
+	const BitSet & loans = borrow_facts.get_loans_of_variable(facts.invalidated_variable);
+	scratch.clear();
+	state.live_loans_in(loans, scratch);
+	scratch.subtract(reported);
+	for (size_t loan_id = scratch.find_next(0); loan_id < scratch.size(); loan_id = scratch.find_next(loan_id+1)) {
+	    const Loan & loan = borrow_facts.get_loans().at(loan_id);
+	    reported.set(loan_id);
+	    Gyoji::owned<Error> error;
+	    if (facts.kills) {
+		error = Gyoji::owned_new<Error>("Borrowed value does not live long enough.");
+		error->add_message(
+		    operation.get_source_ref(),
+		    std::string("Variable ")
+		    + loan.variable_name
+		    + std::string(" goes out of scope here while it is still borrowed.")
+		    );
+	    }
+	    else {
+		error = Gyoji::owned_new<Error>("Assignment to borrowed variable.");
+		error->add_message(
+		    operation.get_source_ref(),
+		    std::string("Variable ")
+		    + loan.variable_name
+		    + std::string(" is assigned here while it is still borrowed.")
+		    );
+	    }
+	    error->add_message(
+		loan.operation.get_source_ref(),
+		std::string("Variable ")
+		+ loan.variable_name
+		+ std::string(" is borrowed here and the borrow is used later.")
+		);
+	    errors->add_error(std::move(error));
+	}
+    }
+    for (size_t origin : facts.defs) {
+	state.reset(origin);
+    }
+    for (const auto & subset : facts.subset_base) {
+	state.flow(subset.first, subset.second);
+    }
+    if (facts.loan_issued != none) {
+	state.add_loan(facts.loan_origin, facts.loan_issued);
+    }
+    if (facts.kills) {
+	state.kill(borrow_facts.get_loans_of_variable(facts.invalidated_variable));
+    }
+    for (size_t origin : facts.dying) {
+	state.reset(origin);
+    }
+}
+
+static void
+apply_block(
+    const Function & function,
+    const BorrowFacts & borrow_facts,
+    size_t blockid,
+    OriginLoans & state,
+    BitSet & scratch,
+    BitSet & reported,
+    Errors *errors
+    )
+{
+    const BasicBlock & block = function.get_basic_block(blockid);
+    const std::vector<OperationFacts> & facts = borrow_facts.get_block_facts(blockid);
+    for (size_t i = 0; i < facts.size(); i++) {
+	apply_operation(borrow_facts, facts[i], *block.get_operations().at(i), state, scratch, reported, errors);
+    }
+}
+
+void
+AnalysisPassBorrowChecker::check_function(const Function & function, Errors & errors) const
+{
+    // Here, we follow the basic plan of the 'Polonius' algorithm
+    // for borrow checking.  First, we extract the facts from
+    // the MIR: where each loan is issued, which origins flow
+    // into which (subset_base), where loans are invalidated
+    // and killed, and where each origin is live.
+    BorrowFacts borrow_facts(function);
+    size_t nloans = borrow_facts.get_loans().size();
+    if (nloans == 0) {
+	return;
+    }
+    const CFGInfo & cfg = function.get_cfg_info();
+    const std::vector<size_t> & rpo = cfg.get_reverse_post_order();
+    size_t norigins = borrow_facts.get_origin_count();
+
+    // Origins in the MIR are never nested inside of each
+    // other (a reference to a reference is tracked by the
+    // same origin as the outer reference), so a subset
+    // relation only needs to carry loans at the point where
+    // the value is copied.  That lets us solve for the loans
+    // each origin contains as a forward data-flow problem
+    // over bitsets, visiting each block again only when
+    // the loans reaching it have changed.
+    std::vector<OriginLoans::List> entry(cfg.get_block_limit());
+    OriginLoans state(norigins, nloans);
+    BitSet scratch(nloans);
+    BitSet reported(nloans);
+    BitSet pending(rpo.size());
+    for (size_t i = 0; i < rpo.size(); i++) {
+	pending.set(i);
+    }
+    for (size_t i = pending.find_next(0); i < pending.size(); i = pending.find_next(0)) {
+	pending.reset(i);
+	size_t blockid = rpo[i];
+	state.load(entry[blockid]);
+	apply_block(function, borrow_facts, blockid, state, scratch, reported, nullptr);
+	for (size_t successor : cfg.get_successors(blockid)) {
+	    if (state.join_into(entry[successor], borrow_facts.get_live_in(successor))) {
+		pending.set(cfg.get_rpo_index(successor));
+	    }
+	}
+    }
+
+    // Now that the loans reaching each block are known,
+    // we walk each block once more and report any loan
+    // that is invalidated while an origin holding it is
+    // still live.
+    for (size_t blockid : rpo) {
+	state.load(entry[blockid]);
+	apply_block(function, borrow_facts, blockid, state, scratch, reported, &errors);
+    }
 }
@@ -20,24 +20,16 @@ using namespace Gyoji::context;
 using namespace Gyoji::analysis;
 
 AnalysisPassReturnValues::AnalysisPassReturnValues(CompilerContext & _compiler_context)
-    : AnalysisPass(_compiler_context, "return-value consistency analysis")
+    : FunctionAnalysisPass(_compiler_context, "return-value consistency analysis")
 {}
 AnalysisPassReturnValues::~AnalysisPassReturnValues()
 {}
 
-void
-AnalysisPassReturnValues::check(const Gyoji::mir::MIR & mir) const
-{
-    for (const auto & function : mir.get_functions().get_functions()) {
-	check(*function);
-    }
-}
-
 namespace Gyoji::analysis {
     class ReturnOperationVisitor : public OperationVisitor {
     public:
 	ReturnOperationVisitor(
-	    CompilerContext & _compiler_context,
+	    Errors & _errors,
 	    const Function & _function
 	    );
 	~ReturnOperationVisitor();
@@ -49,7 +41,7 @@ namespace Gyoji::analysis {
 	    const Operation & operation
 	    );
     private:
-	CompilerContext & compiler_context;
+	Errors & errors;
 	const Function & function;
 	const Type *return_type;
     };
@@ -57,11 +49,11 @@ namespace Gyoji::analysis {
 };
 
 ReturnOperationVisitor::ReturnOperationVisitor(
-    CompilerContext & _compiler_context,
+    Errors & _errors,
     const Function & _function
     )
     : OperationVisitor()
-    , compiler_context(_compiler_context)
+    , errors(_errors)
     , function(_function)
     , return_type(_function.get_return_type())
 {
@@ -79,7 +71,7 @@ void ReturnOperationVisitor::visit(
 {
     if (operation.get_type() == Operation::OP_RETURN) {
 	const Type *operation_type = function.tmpvar_get(operation.get_operands().at(0));
-	if (return_type->get_name() != operation_type->get_name()) {
+	if (return_type->get_type_id() != operation_type->get_type_id()) {
 	    Gyoji::owned<Gyoji::context::Error> error = Gyoji::owned_new<Gyoji::context::Error>("Return statement returns incorrec type.");
 	    error->add_message(
 		operation.get_source_ref(),
@@ -89,9 +81,7 @@ void ReturnOperationVisitor::visit(
 		function.get_source_ref(),
 		"Return-value of function declared here."
 		);
-	    compiler_context
-		.get_errors()
-		.add_error(std::move(error));
+	    errors.add_error(std::move(error));
 	}
     }
     else if (operation.get_type() == Operation::OP_RETURN_VOID) {
@@ -105,17 +95,15 @@ void ReturnOperationVisitor::visit(
 		function.get_source_ref(),
 		"Return-type of function declared here."
 		);
-	    compiler_context
-		.get_errors()
-		.add_error(std::move(error));
+	    errors.add_error(std::move(error));
 	}
     }
 }
 
-void AnalysisPassReturnValues::check(const Function & function) const
+void AnalysisPassReturnValues::check_function(const Function & function, Errors & errors) const
 {
     // This is what the function should return.
-    ReturnOperationVisitor ppVisitor(get_compiler_context(), function);
+    ReturnOperationVisitor ppVisitor(errors, function);
     
     function.iterate_operations(ppVisitor);
 }
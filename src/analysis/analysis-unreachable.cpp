@@ -20,20 +20,12 @@ using namespace Gyoji::context;
 using namespace Gyoji::analysis;
 
 AnalysisPassUnreachable::AnalysisPassUnreachable(CompilerContext & _compiler_context)
-    : AnalysisPass(_compiler_context, "unreachable analysis")
+    : FunctionAnalysisPass(_compiler_context, "unreachable analysis")
 {}
 AnalysisPassUnreachable::~AnalysisPassUnreachable()
 {}
 
-void
-AnalysisPassUnreachable::check(const MIR & mir) const
-{
-    for (const auto & function : mir.get_functions().get_functions()) {
-	check(*function);
-    }
-}
-
-void AnalysisPassUnreachable::check(const Function & function) const
+void AnalysisPassUnreachable::check_function(const Function & function, Errors & errors) const
 {
     // Note that we do assume that all empty unreachable
     // blocks have already been culled.
@@ -42,20 +34,19 @@ void AnalysisPassUnreachable::check(const Function & function) const
     // These are by definition unreachable because
     // the terminator stops execution, so nothing after
     // that will be reachable.
+    const CFGInfo & cfg = function.get_cfg_info();
     const auto & blocks = function.get_blocks();
     for (const auto & block_it : blocks) {
 	const BasicBlock & block = *block_it.second;
 	const std::vector<Gyoji::owned<Operation>> & operations = block.get_operations();
-	if (block.get_reachable_from().size() == 0 && block_it.first != 0) {
+	if (!cfg.is_reachable(block_it.first)) {
 	    // Unreachable if the block is unreachable and has anything at all inside it.
 	    if (operations.size() != 0) {
 		const auto & op = operations.at(operations.size()-1);
-		get_compiler_context()
-		    .get_errors()
-		    .add_simple_error(op->get_source_ref(),
-				      "Unreachable statement",
-				      std::string("Statement is unreachable.")
-			);
+		errors.add_simple_error(op->get_source_ref(),
+					"Unreachable statement",
+					std::string("Statement is unreachable.")
+		    );
 	    }
 	}
 	else {
@@ -65,14 +56,12 @@ void AnalysisPassUnreachable::check(const Function & function) const
 	    for (const auto & op : operations) {
 		const auto & operation = *op;
 		if (terminated) {
-		    get_compiler_context()
-			.get_errors()
-			.add_simple_error(operation.get_source_ref(),
-					  "Unreachable Statement",
-					  std::string("Function ")
-					  + function.get_name()
-					  + std::string(" contains unreachable statement.")
-			    );
+		    errors.add_simple_error(operation.get_source_ref(),
+					    "Unreachable Statement",
+					    std::string("Function ")
+					    + function.get_name()
+					    + std::string(" contains unreachable statement.")
+			);
 		    break;
 		}
 		// We found a terminating operation.
@@ -18,57 +18,20 @@
 using namespace Gyoji::mir;
 using namespace Gyoji::context;
 using namespace Gyoji::analysis;
+using Gyoji::misc::BitSet;
 
-AnalysisPassUseBeforeAssignment::AnalysisPassUseBeforeAssignment(CompilerContext & _compiler_context)
-    : AnalysisPass(_compiler_context, "use-before-initialization checks")
-{}
-AnalysisPassUseBeforeAssignment::~AnalysisPassUseBeforeAssignment()
-{}
-
-void
-AnalysisPassUseBeforeAssignment::check(const Gyoji::mir::MIR & mir) const
-{
-    for (const auto & function : mir.get_functions().get_functions()) {
-	check(*function);
-    }
-}
+static const size_t none = (size_t)-1;
 
 namespace Gyoji::analysis {
 
-    // This is an access of a local variable
-    // inside a function.  Here, we track the
-    // name of the variable, the tmpvar it's
-    // loaded into, and the 'ProgramPoint' it was loaded/declared
-    // from.
-    class VariableLoadPoint {
-    public:
-	VariableLoadPoint(
-	    std::string _variable_name,
-	    ProgramPoint _program_point
-	    );
-	VariableLoadPoint(const VariableLoadPoint & other);
-	~VariableLoadPoint();
-	std::string variable_name;
-	size_t tmpvar;
-	ProgramPoint program_point;
-    };
-
-    class TmpvarAssignedAt {
-    public:
-	TmpvarAssignedAt(const TmpvarAssignedAt & other);
-	TmpvarAssignedAt(
-	    size_t _tmpvar,
-	    ProgramPoint _program_point
-	    );
-	~TmpvarAssignedAt();
-			 
-	size_t tmpvar;
-	ProgramPoint program_point;
-    };
-
+    // First, we need to just build a map
+    // of all the tmpvars to the local variables they
+    // represent (only for tmpvars associated with variables)
+    // and number the variables so they can be used
+    // as the facts of the data-flow problem.
     class VariableTmpvarVisitor : public OperationVisitor {
     public:
-	VariableTmpvarVisitor(const std::map<std::string, std::string> & _ignore_arguments);
+	VariableTmpvarVisitor(const Function & _function);
 	~VariableTmpvarVisitor();
 	void visit(
 	    size_t block_id,
@@ -76,39 +39,42 @@ namespace Gyoji::analysis {
 	    size_t operation_index,
 	    const Operation & operation
 	    );
-	const std::map<size_t, std::string> & get_tmpvars() const;
+	size_t get_variable_count() const;
+	size_t get_variable(Atom variable) const;
+	size_t get_tmpvar_variable(size_t tmpvar) const;
+	size_t get_tmpvar_root(size_t tmpvar) const;
+	const std::string & get_variable_name(size_t variable) const;
     private:
-	std::map<size_t, std::string> tmpvars;
-	const std::map<std::string, std::string> & ignore_arguments;
+	const Function & function;
+	std::map<Atom, bool> ignore_arguments;
+	std::map<Atom, size_t> variables;
+	std::vector<const std::string*> variable_names;
+	std::vector<size_t> tmpvars;
+	// Members and elements of a variable are
+	// places inside of it, so they lead back
+	// to the tmpvar of the variable itself.
+	std::vector<size_t> places;
     };
-        
-    // First, we need to just build a map
-    // of all the tmpvar to the variables they
-    // represent (only for tmpvars associated with variables)
-    class VariableUseVisitor : public OperationVisitor {
+
+    // A variable is definitely assigned at a point
+    // if it has been assigned along every path
+    // leading there since it was declared.
+    class DefiniteAssignment : public DataFlowProblem {
     public:
-	VariableUseVisitor(
-	    const std::map<size_t, std::string> & _tmpvars
-	    );
-	~VariableUseVisitor();
-	void visit(
+	DefiniteAssignment(const VariableTmpvarVisitor & _variables);
+	virtual ~DefiniteAssignment();
+	virtual void effect(
 	    size_t block_id,
-	    const BasicBlock & block,
 	    size_t operation_index,
-	    const Operation & operation
-	    );
-	const std::vector<VariableLoadPoint> & get_loads();
-	const std::vector<VariableLoadPoint> & get_stores();
+	    const Operation & operation,
+	    BitSet & gen,
+	    BitSet & kill
+	    ) const;
     private:
-	const std::map<size_t, std::string> & tmpvars;
-	std::vector<VariableLoadPoint> variable_loads;
-	std::vector<VariableLoadPoint> variable_stores;
+	const VariableTmpvarVisitor & variables;
     };
-
-    // Next, we need to find all of the places those tmpvars (variables)
-    // are used and all of the places they are assigned.
-    
 };
+
 //////////////////////////////////////////////
 // ProgramPoint
 //////////////////////////////////////////////
@@ -123,101 +89,30 @@ ProgramPoint::ProgramPoint(const ProgramPoint & other)
 {}
 ProgramPoint::~ProgramPoint()
 {}
+
 //////////////////////////////////////////////
-// VariableLoadPoint
+// AnalysisPassUseBeforeAssignment
 //////////////////////////////////////////////
-VariableLoadPoint::VariableLoadPoint(
-    std::string _variable_name,
-    ProgramPoint _program_point)
-    : variable_name(_variable_name)
-    , program_point(_program_point)
+AnalysisPassUseBeforeAssignment::AnalysisPassUseBeforeAssignment(CompilerContext & _compiler_context)
+    : FunctionAnalysisPass(_compiler_context, "use-before-initialization checks")
 {}
-VariableLoadPoint::VariableLoadPoint(const VariableLoadPoint & other)
-    : variable_name(other.variable_name)
-    , program_point(other.program_point)
+AnalysisPassUseBeforeAssignment::~AnalysisPassUseBeforeAssignment()
 {}
 
-VariableLoadPoint::~VariableLoadPoint()
-{}
-			 
 //////////////////////////////////////////////
-// VariableUseVisitor
+// VariableTmpvarVisitor
 //////////////////////////////////////////////
-
-VariableUseVisitor::VariableUseVisitor(
-    const std::map<size_t, std::string> & _tmpvars
-    )
-    : OperationVisitor()
-    , tmpvars(_tmpvars)
-{
-}
-
-VariableUseVisitor::~VariableUseVisitor()
-{}
-
-const std::vector<VariableLoadPoint> &
-VariableUseVisitor::get_loads()
-{
-    return variable_loads;
-}
-
-const std::vector<VariableLoadPoint> &
-VariableUseVisitor::get_stores()
-{ return variable_stores; }
-
-
-void VariableUseVisitor::visit(
-    size_t block_id,
-    const BasicBlock & block,
-    size_t operation_index,
-    const Operation & operation
-    )    
+VariableTmpvarVisitor::VariableTmpvarVisitor(const Function & _function)
+    : function(_function)
+    , tmpvars(_function.tmpvar_count(), none)
+    , places(_function.tmpvar_count(), none)
 {
-    const auto & operands = operation.get_operands();
-    size_t noperands = operands.size();
-    ProgramPoint program_point(block_id, operation_index);
-    
-    if (operation.get_type() == Operation::OP_ASSIGN) {
-	const auto & it = tmpvars.find(operands.at(0));
-	if (it != tmpvars.end()) {
-	    VariableLoadPoint assigned_at(
-		it->second,
-		program_point
-		);
-	    variable_stores.push_back(assigned_at);
-	}
-	// All other operands are accesses.
-	for (size_t operand_id = 1; operand_id < noperands; operand_id++) {
-	    const auto & it = tmpvars.find(operands.at(operand_id));
-	    if (it != tmpvars.end()) {
-		VariableLoadPoint assigned_at(
-		    it->second,
-		    program_point
-		    );
-		variable_loads.push_back(assigned_at);
-	    }
-	}
-    }
-    else {
-	// For other operations, all operands are 'use' of the variable.
-	for (size_t operand_id = 0; operand_id < noperands; operand_id++) {
-	    const auto & it = tmpvars.find(operands.at(operand_id));
-	    if (it != tmpvars.end()) {
-		VariableLoadPoint assigned_at(
-		    it->second,
-		    program_point
-		    );
-		variable_loads.push_back(assigned_at);
-	    }
-	}
+    // Arguments get initialized when the function
+    // begins, so we can ignore them.
+    for (const auto & arg : _function.get_arguments()) {
+	ignore_arguments[arg.get_name_atom()] = true;
     }
 }
-VariableTmpvarVisitor::VariableTmpvarVisitor(
-    const std::map<std::string, std::string> & _ignore_arguments
-    )
-    : tmpvars()
-    , ignore_arguments(_ignore_arguments)
-{}
 
 VariableTmpvarVisitor::~VariableTmpvarVisitor()
 {}
@@ -230,166 +125,185 @@ VariableTmpvarVisitor::visit(
     const Operation & operation
     )
 {
-    if (operation.get_type() == Operation::OP_LOCAL_DECLARE) {
-	const OperationLocalDeclare & local_declare = (const OperationLocalDeclare&)operation;
-//	variables.push_back(std::pair(local_declare.get_variable(), &local_declare.get_source_ref()));
+    if (operation.get_type() == Operation::OP_DOT || operation.get_type() == Operation::OP_ARRAY_INDEX) {
+	size_t base = operation.get_operands().at(0);
+	if (operation.get_result() >= places.size() || base >= places.size()) {
+	    return;
+	}
+	// Indexing through a pointer reaches
+	// memory outside of the variable.
+	if (operation.get_type() == Operation::OP_ARRAY_INDEX && !function.tmpvar_get(base)->is_array()) {
+	    return;
+	}
+	places[operation.get_result()] = base;
 	return;
     }
     if (operation.get_type() != Operation::OP_LOCAL_VARIABLE) {
 	return;
     }
     const OperationLocalVariable &operation_local = (const OperationLocalVariable &)operation;
-    const std::string & varname = operation_local.get_symbol_name();
-
-    // Check to see if it's an argument and we
-    // can ignore it since arguments get initialized
-    // when the function begins.
-    const auto & it = ignore_arguments.find(varname);
-    if (it != ignore_arguments.end()) {
+    Atom variable = operation_local.get_symbol_atom();
+    if (ignore_arguments.find(variable) != ignore_arguments.end()) {
+	return;
+    }
+    if (operation_local.get_result() >= tmpvars.size()) {
 	return;
     }
 
+    const auto & it = variables.find(variable);
+    size_t index;
+    if (it == variables.end()) {
+	index = variable_names.size();
+	variables.insert(std::pair(variable, index));
+	variable_names.push_back(&operation_local.get_symbol_name());
+    }
+    else {
+	index = it->second;
+    }
     // Just keep track of the tmpvars that map to local variables.
-    tmpvars[operation_local.get_result()] = varname;
+    tmpvars[operation_local.get_result()] = index;
 }
 
-const std::map<size_t, std::string> &
-VariableTmpvarVisitor::get_tmpvars() const
-{ return tmpvars; }
+size_t
+VariableTmpvarVisitor::get_variable_count() const
+{ return variable_names.size(); }
 
-bool AnalysisPassUseBeforeAssignment::true_at(
-    const Function & function,
-    std::map<size_t, bool> & already_checked,
-    const std::vector<ProgramPoint> & true_points,
-    const ProgramPoint & check_at
-    ) const
+size_t
+VariableTmpvarVisitor::get_variable(Atom variable) const
 {
-    bool found_in_same_block = false;
-    
-    for (const auto & true_point : true_points) {
-	if (check_at.block_id == true_point.block_id &&
-	    check_at.operation_index > true_point.operation_index) {
-	    found_in_same_block = true;
-	}
+    const auto & it = variables.find(variable);
+    if (it == variables.end()) {
+	return none;
     }
-    // It was true in the current block, so it's true.
-    if (found_in_same_block) {
-	return true;
+    return it->second;
+}
+
+size_t
+VariableTmpvarVisitor::get_tmpvar_variable(size_t tmpvar) const
+{
+    if (tmpvar >= tmpvars.size()) {
+	return none;
     }
-    const std::vector<size_t> & predecessors = function.get_basic_block(check_at.block_id).get_reachable_from();
-    if (predecessors.size() == 0) {
-	return false;
+    return tmpvars[tmpvar];
+}
+
+size_t
+VariableTmpvarVisitor::get_tmpvar_root(size_t tmpvar) const
+{
+    while (tmpvar < places.size() && places[tmpvar] != none) {
+	tmpvar = places[tmpvar];
     }
-    
-    // If it wasn't true in the current block, try all predecessors.
-    for (const auto & predecessor : predecessors) {
-	ProgramPoint pred_point(predecessor, function.get_basic_block(predecessor).get_operations().size());
+    return get_tmpvar_variable(tmpvar);
+}
 
-	bool is_true;
-	const auto & already_checked_it = already_checked.find(pred_point.block_id);
-	if (already_checked_it != already_checked.end()) {
-	    is_true = already_checked_it->second;
-	}
-	else {
-	    is_true = true_at(function, already_checked, true_points, pred_point);
-	    already_checked.insert(std::pair(pred_point.block_id, is_true));
+const std::string &
+VariableTmpvarVisitor::get_variable_name(size_t variable) const
+{ return *variable_names.at(variable); }
+
+//////////////////////////////////////////////
+// DefiniteAssignment
+//////////////////////////////////////////////
+DefiniteAssignment::DefiniteAssignment(const VariableTmpvarVisitor & _variables)
+    : DataFlowProblem(FORWARD, MUST, _variables.get_variable_count())
+    , variables(_variables)
+{}
+
+DefiniteAssignment::~DefiniteAssignment()
+{}
+
+void
+DefiniteAssignment::effect(
+    size_t block_id,
+    size_t operation_index,
+    const Operation & operation,
+    BitSet & gen,
+    BitSet & kill
+    ) const
+{
+    if (operation.get_type() == Operation::OP_LOCAL_DECLARE) {
+	// A variable starts out unassigned each time
+	// it comes into scope, even inside of a loop
+	// where it was assigned the last time around.
+	const OperationLocalDeclare & local_declare = (const OperationLocalDeclare&)operation;
+	size_t variable = variables.get_variable(local_declare.get_variable_atom());
+	if (variable != none) {
+	    kill.set(variable);
 	}
-	if (!is_true) {
-	    return false;
+    }
+    else if (operation.get_type() == Operation::OP_ASSIGN || operation.get_type() == Operation::OP_ADDRESSOF) {
+	// Storing into a member or an element only
+	// assigns part of the variable, but members
+	// aren't tracked separately, so it counts as
+	// an assignment of the whole thing.  Once the
+	// address is taken, it may be assigned through
+	// the pointer where we can't see it.
+	size_t variable = variables.get_tmpvar_root(operation.get_operands().at(0));
+	if (variable != none) {
+	    gen.set(variable);
 	}
     }
-    return true;
-
 }
 
-void AnalysisPassUseBeforeAssignment::check(const Function & function) const
+void AnalysisPassUseBeforeAssignment::check_function(const Function & function, Errors & errors) const
 {
-    std::map<std::string, std::string> ignore_arguments;
-    for (const auto & arg : function.get_arguments()) {
-	ignore_arguments[arg.get_name()] = arg.get_name();
-    }
-    
-    VariableTmpvarVisitor id_visitor(ignore_arguments);
-    function.iterate_operations(id_visitor);
-    
-    VariableUseVisitor visitor(id_visitor.get_tmpvars());
-    function.iterate_operations(visitor);
-    
-    std::map<std::string, std::vector<ProgramPoint>> store_points_by_variable;
-    for (const auto & store : visitor.get_stores()) {
-	store_points_by_variable[store.variable_name].push_back(store.program_point);
+    VariableTmpvarVisitor variables(function);
+    function.iterate_operations(variables);
+    if (variables.get_variable_count() == 0) {
+	return;
     }
-    
-    for (const auto & load : visitor.get_loads()) {
-	std::map<size_t, bool> already_checked;
-	bool is_true = true_at(function, already_checked, store_points_by_variable[load.variable_name], load.program_point);
-	if (!is_true) {
-	    Gyoji::owned<Gyoji::context::Error> error = Gyoji::owned_new<Gyoji::context::Error>("Variable use before initialization.");
-	    const SourceReference & source_ref =
-		function.get_basic_block(load.program_point.block_id).get_operations().at(load.program_point.operation_index)->get_source_ref();
 
-	    error->add_message(
-		source_ref,
-		std::string("Variable ")
-		+ load.variable_name
-		+ std::string(" is uninitialized.  This would result in undefined behavior.  Note that if this appears on a 'return' line, then it is most likely a destructor call.")
-		);
-	    get_compiler_context()
-		.get_errors()
-		.add_error(std::move(error));
+    DefiniteAssignment problem(variables);
+    DataFlow assigned(function, problem);
+
+    // Walk each block from the variables assigned on
+    // entry and check each read against the variables
+    // assigned at that point.
+    const CFGInfo & cfg = function.get_cfg_info();
+    BitSet facts(variables.get_variable_count());
+    for (const auto & block_it : function.get_blocks()) {
+	size_t blockid = block_it.first;
+	if (!cfg.is_reachable(blockid)) {
+	    continue;
+	}
+	const std::vector<Gyoji::owned<Operation>> & operations = block_it.second->get_operations();
+	facts = assigned.get_in(blockid);
+	for (size_t i = 0; i < operations.size(); i++) {
+	    const Operation & operation = *operations.at(i);
+	    const std::vector<size_t> & operands = operation.get_operands();
+	    size_t noperands = operation.get_tmpvar_operand_count();
+	    // The destination of an assignment is written
+	    // and the base of a member, an element, or an
+	    // address only names a place without reading
+	    // it, but all other operands are reads.
+	    size_t first = 0;
+	    switch (operation.get_type()) {
+	    case Operation::OP_ASSIGN:
+	    case Operation::OP_DOT:
+	    case Operation::OP_ADDRESSOF:
+		first = 1;
+		break;
+	    case Operation::OP_ARRAY_INDEX:
+		// Indexing through a pointer reads the pointer.
+		first = function.tmpvar_get(operands.at(0))->is_array() ? 1 : 0;
+		break;
+	    default:
+		break;
+	    }
+	    for (size_t operand_id = first; operand_id < noperands; operand_id++) {
+		size_t variable = variables.get_tmpvar_root(operands.at(operand_id));
+		if (variable == none || facts.test(variable)) {
+		    continue;
+		}
+		Gyoji::owned<Gyoji::context::Error> error = Gyoji::owned_new<Gyoji::context::Error>("Variable use before initialization.");
+		error->add_message(
+		    operation.get_source_ref(),
+		    std::string("Variable ")
+		    + variables.get_variable_name(variable)
+		    + std::string(" is uninitialized.  This would result in undefined behavior.  Note that if this appears on a 'return' line, then it is most likely a destructor call.")
+		    );
+		errors.add_error(std::move(error));
+	    }
+	    assigned.apply(blockid, i, operation, facts);
 	}
-	already_checked.insert(std::pair(load.program_point.block_id, is_true));
     }
-    
-
-    // We now have all of the places
-    // the variable was stored
-    // and all of the places it was initialized.
-    // Next for each load, we need to find out if
-    
-    // a) There exists a store for that variable
-    // b) For all stores that exist, they all happen "before" the
-    //    use.
-
-    // If they're in the same BB, it's easy.
-    // If they're not, we need to find all BB that are "before"
-    // and ask the question on each.
-    
 }
-//////////////////////////
-//
-/*
-  We start with the CFG graph of basic blocks.
-            0
-	   / \
-	  /   \
-	 1     2
-	/ \     \
-       /   \     3
-      4     5    /
-      \     /   /
-       \   /   /
-        \ /   /
-	 6----
-
-  Then we have some property like "used-at" which is
-  associated with a program-point such as (6,3) (basic block 6, 3rd instruction)
-
-  We also have several 'initialized-at' facts like
-    (4,7 ) (2,3)
-
-  What we would like to know if whether 'initialized-before(6,3)' is true.
-
-  The inference rule is P(b,i) = P(b,i+1) for all i.  This says if it was true at point i,
-  it is also true at point i+1 in the same block.
-
-  We also have the rule that says P(b,i) = | (for all c in Prececessors of b : P(c,end))
-
-  So we would like to know if initialized-before(6,3) is true,
-     We first check if there is a (6,k) with k<3.
-     If not, we check if ALL of (4,end) and (5,end) are true.
-        In this case, 4,end is true because (4,7) is true.
-	But (5,end) is false, so we check (1,end).  Again no.
-	But (3,end) is true because (2,end) is true.
-  
- */
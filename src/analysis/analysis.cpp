@@ -14,6 +14,9 @@
  */
 #include <gyoji-analysis.hpp>
 #include <stdio.h>
+#include <atomic>
+#include <thread>
+#include <functional>
 
 using namespace Gyoji::mir;
 using namespace Gyoji::context;
@@ -34,3 +37,144 @@ AnalysisPass::get_compiler_context() const
 const std::string &
 AnalysisPass::get_name() const
 { return name; }
+
+/////////////////////////////////////
+// FunctionAnalysisPass
+/////////////////////////////////////
+FunctionAnalysisPass::FunctionAnalysisPass(CompilerContext & _compiler_context, std::string _name)
+    : AnalysisPass(_compiler_context, _name)
+{}
+
+FunctionAnalysisPass::~FunctionAnalysisPass()
+{}
+
+void
+FunctionAnalysisPass::check(const MIR & mir) const
+{
+    std::vector<Gyoji::owned<Errors>> buffers;
+    for (const auto & function : mir.get_functions().get_functions()) {
+	buffers.push_back(Gyoji::owned_new<Errors>(get_compiler_context().get_token_stream()));
+	check_function(*function, *buffers.back());
+    }
+    get_compiler_context().get_errors().merge(buffers);
+}
+
+/////////////////////////////////////
+// AnalysisScheduler
+/////////////////////////////////////
+AnalysisScheduler::AnalysisScheduler(CompilerContext & _compiler_context, size_t _threads)
+    : compiler_context(_compiler_context)
+    , threads(_threads)
+{}
+
+AnalysisScheduler::~AnalysisScheduler()
+{}
+
+// Each thread takes the next work item that
+// nobody has started yet until there are none left.
+static void
+analysis_worker(
+    std::atomic<size_t> & next_item,
+    const std::vector<Gyoji::owned<Function>> & functions,
+    const std::vector<const FunctionAnalysisPass*> & function_passes,
+    std::vector<Gyoji::owned<Errors>> & buffers,
+    std::atomic<size_t> & errors_found,
+    size_t errors_allowed
+    )
+{
+    size_t npasses = function_passes.size();
+    while (true) {
+	if (errors_allowed != 0 && errors_found.load() >= errors_allowed) {
+	    break;
+	}
+	size_t item = next_item.fetch_add(1);
+	if (item >= buffers.size()) {
+	    break;
+	}
+	const Function & function = *functions.at(item / npasses);
+	function_passes.at(item % npasses)->check_function(function, *buffers.at(item));
+	errors_found += buffers.at(item)->size();
+    }
+}
+
+void
+AnalysisScheduler::run(
+    const MIR & mir,
+    const std::vector<Gyoji::owned<AnalysisPass>> & passes
+    ) const
+{
+    // Passes that look at the whole MIR run first,
+    // in order, on this thread.
+    std::vector<const FunctionAnalysisPass*> function_passes;
+    for (const auto & pass : passes) {
+	const FunctionAnalysisPass *function_pass = dynamic_cast<const FunctionAnalysisPass*>(pass.get());
+	if (function_pass == nullptr) {
+	    pass->check(mir);
+	}
+	else {
+	    function_passes.push_back(function_pass);
+	}
+    }
+
+    // The CFG information is computed lazily by
+    // each function, so we compute it here, before
+    // any threads start, so that the passes only
+    // ever read it.
+    const auto & functions = mir.get_functions().get_functions();
+    for (const auto & function : functions) {
+	function->get_cfg_info();
+    }
+
+    // Work items are laid out function by function
+    // and pass by pass within each function so
+    // that the order of the buffers is the order
+    // we use to break ties when merging the errors.
+    size_t npasses = function_passes.size();
+    size_t nitems = functions.size() * npasses;
+    std::vector<Gyoji::owned<Errors>> buffers;
+    for (size_t i = 0; i < nitems; i++) {
+	buffers.push_back(Gyoji::owned_new<Errors>(compiler_context.get_token_stream()));
+    }
+
+    // Once as many errors have been found as will be
+    // shown, the rest of the work is skipped.  Which of
+    // them are found first then depends on how the
+    // threads were scheduled, but only when there are
+    // more errors than the limit anyway.
+    Errors & errors = compiler_context.get_errors();
+    size_t errors_allowed = 0;
+    if (errors.get_error_limit() != 0) {
+	if (errors.is_error_limit_reached()) {
+	    return;
+	}
+	errors_allowed = errors.get_error_limit() - errors.size();
+    }
+
+    std::atomic<size_t> next_item(0);
+    std::atomic<size_t> errors_found(0);
+    size_t nthreads = std::min(threads, nitems);
+    if (nthreads <= 1) {
+	analysis_worker(next_item, functions, function_passes, buffers, errors_found, errors_allowed);
+    }
+    else {
+	std::vector<std::thread> pool;
+	for (size_t i = 0; i < nthreads; i++) {
+	    pool.push_back(
+		std::thread(
+		    analysis_worker,
+		    std::ref(next_item),
+		    std::cref(functions),
+		    std::cref(function_passes),
+		    std::ref(buffers),
+		    std::ref(errors_found),
+		    errors_allowed
+		    )
+		);
+	}
+	for (auto & thread : pool) {
+	    thread.join();
+	}
+    }
+
+    errors.merge(buffers);
+}
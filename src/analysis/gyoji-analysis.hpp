@@ -91,6 +91,89 @@ namespace Gyoji::analysis {
 	std::string name;
     };
 
+    /**
+     * @brief Analysis pass that looks at one function at a time.
+     *
+     * @details
+     * Most analysis passes look at each function on its own
+     * without needing anything from the other functions.  These
+     * passes implement check_function() instead of check() so
+     * that the AnalysisScheduler can run them on many functions
+     * at once.
+     *
+     * Because several functions may be checked at the same time,
+     * check_function() must not report errors through the
+     * compiler context.  Instead, it reports them into the
+     * Errors buffer it is given, which belongs only to that
+     * function and that pass.  It also must not change the MIR
+     * in any way, including the types table.
+     */
+    class FunctionAnalysisPass : public AnalysisPass {
+    public:
+	FunctionAnalysisPass(Gyoji::context::CompilerContext & _compiler_context, std::string _name);
+	virtual ~FunctionAnalysisPass();
+	/**
+	 * Checks each function in turn on the calling thread and
+	 * reports the errors in the same order as the AnalysisScheduler
+	 * would.
+	 */
+	virtual void check(const Gyoji::mir::MIR & mir) const;
+	/**
+	 * Checks a single function, reporting any errors found
+	 * into the given buffer.
+	 */
+	virtual void check_function(
+	    const Gyoji::mir::Function & function,
+	    Gyoji::context::Errors & errors
+	    ) const = 0;
+    };
+
+    /**
+     * @brief Runs analysis passes over the functions of the MIR in parallel.
+     *
+     * @details
+     * The scheduler breaks the work of the function analysis
+     * passes into one work item for each pass and function and
+     * hands those items out to a pool of threads.  Passes that
+     * need to see the whole MIR at once are run first on the
+     * calling thread.
+     *
+     * Each work item reports errors into a buffer of its own.
+     * Once all of the items are done, the buffers are merged into
+     * the errors of the compiler context, ordered by the source
+     * location of each error and then by the function and pass
+     * that reported it.  This means that the errors come out in
+     * the same order no matter how many threads are used or how
+     * the work happened to be divided among them.
+     */
+    class AnalysisScheduler {
+    public:
+	/**
+	 * Creates a scheduler that will use up to the given
+	 * number of threads.  A thread count of zero or one runs
+	 * everything on the calling thread.
+	 */
+	AnalysisScheduler(Gyoji::context::CompilerContext & _compiler_context, size_t _threads);
+	/**
+	 * @brief Move along, nothing to see here.
+	 *
+	 * @details
+	 * Move along, nothing to see here.
+	 */
+	~AnalysisScheduler();
+	/**
+	 * Runs each of the passes over the MIR and reports
+	 * the errors found to the compiler context.
+	 */
+	void run(
+	    const Gyoji::mir::MIR & mir,
+	    const std::vector<Gyoji::owned<AnalysisPass>> & passes
+	    ) const;
+    private:
+	Gyoji::context::CompilerContext & compiler_context;
+	size_t threads;
+    };
+
     /**
      * @brief Check that all types have been fully declared before use.
      * 
@@ -128,16 +211,14 @@ namespace Gyoji::analysis {
      * which are disconnected from the graph, so they
      * cannot be reached in any way.
      */
-    class AnalysisPassUnreachable : public AnalysisPass {
+    class AnalysisPassUnreachable : public FunctionAnalysisPass {
     public:
 	AnalysisPassUnreachable(Gyoji::context::CompilerContext & _compiler_context);
 	virtual ~AnalysisPassUnreachable();
 	
-	virtual void check(const Gyoji::mir::MIR & mir) const;
-    private:
-	void check(const Gyoji::mir::Function & function) const;
-	void check_all_blocks_reachable(
-	    const Gyoji::mir::Function & function
+	virtual void check_function(
+	    const Gyoji::mir::Function & function,
+	    Gyoji::context::Errors & errors
 	    ) const;
     };
 
@@ -146,15 +227,35 @@ namespace Gyoji::analysis {
      *
      * @details
      * The borrow-checker is modelled after the 'polonius'
-     * borrow checker from Rust.
+     * borrow checker from Rust.  Each tmpvar and local variable
+     * that may hold a reference is given an 'origin'.  Taking
+     * the address of a local variable issues a 'loan' into
+     * the origin of the result, and loans flow from one origin
+     * to another wherever a value is copied.  A variable
+     * that goes out of scope or is assigned to while an origin
+     * holding one of its loans is still live is reported
+     * as an error.
+     *
+     * The loans held by each origin are solved for as a
+     * forward data-flow problem over dense bitsets, and the
+     * liveness of each origin as a backward one, so that the
+     * cost grows roughly with the size of the function
+     * rather than with the number of program points times
+     * the number of facts.
+     *
+     * Loans are always of a whole variable, so borrowing
+     * a member of a class borrows all of it, and variables
+     * of the same name in different scopes share an origin.
+     * Loans stored through a dereference are not tracked.
      */
-    class AnalysisPassBorrowChecker : public AnalysisPass {
+    class AnalysisPassBorrowChecker : public FunctionAnalysisPass {
     public:
 	AnalysisPassBorrowChecker(Gyoji::context::CompilerContext & _compiler_context);
 	virtual ~AnalysisPassBorrowChecker();
-	virtual void check(const Gyoji::mir::MIR & mir) const;
-    private:
-	void check(const Gyoji::mir::Function & function) const;
+	virtual void check_function(
+	    const Gyoji::mir::Function & function,
+	    Gyoji::context::Errors & errors
+	    ) const;
     };
 
     /**
@@ -166,13 +267,14 @@ namespace Gyoji::analysis {
      * checks that all return statements return values that are
      * consistent with the return type of that function.
      */
-    class AnalysisPassReturnValues : public AnalysisPass {
+    class AnalysisPassReturnValues : public FunctionAnalysisPass {
     public:
 	AnalysisPassReturnValues(Gyoji::context::CompilerContext & _compiler_context);
 	virtual ~AnalysisPassReturnValues();
-	virtual void check(const Gyoji::mir::MIR & mir) const;
-    private:
-	void check(const Gyoji::mir::Function & function) const;
+	virtual void check_function(
+	    const Gyoji::mir::Function & function,
+	    Gyoji::context::Errors & errors
+	    ) const;
     };
     
     /**
@@ -204,21 +306,32 @@ namespace Gyoji::analysis {
      * from user input from a function).  Whatever it is, however, must be assigned
      * and not just some random leftover value from the stack or heap due to
      * uninitialized data.
+     *
+     * This is solved as a 'must' forward data-flow problem
+     * (see DataFlow) whose facts are the local variables
+     * that have definitely been assigned.  Assigning
+     * the whole variable makes it assigned and declaring
+     * it makes it unassigned again, which matters for
+     * variables declared inside of a loop.  Any read of
+     * a variable that isn't definitely assigned at that
+     * point is reported.  Function arguments are always
+     * assigned.
+     *
+     * Naming a member or an element of a variable, or
+     * taking its address, is not a read of the variable.
+     * Members and elements aren't tracked on their own,
+     * so storing into any of them, or taking the address
+     * where it may be assigned through the pointer,
+     * counts as assigning the whole variable.
      */
-    class AnalysisPassUseBeforeAssignment : public AnalysisPass {
+    class AnalysisPassUseBeforeAssignment : public FunctionAnalysisPass {
     public:
 	AnalysisPassUseBeforeAssignment(Gyoji::context::CompilerContext & _compiler_context);
 	virtual ~AnalysisPassUseBeforeAssignment();
-	virtual void check(const Gyoji::mir::MIR & mir) const;
-    private:
-	bool true_at(
+	virtual void check_function(
 	    const Gyoji::mir::Function & function,
-	    std::map<size_t, bool> & already_checked,
-	    const std::vector<ProgramPoint> & true_points,
-	    const ProgramPoint & check_at
+	    Gyoji::context::Errors & errors
 	    ) const;
-	
-	void check(const Gyoji::mir::Function & function) const;
     };
     
 };
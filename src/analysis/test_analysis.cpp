@@ -13,8 +13,281 @@
  *  limitations under the License.
  */
 #include <gyoji-analysis.hpp>
+#include <gyoji-misc/test.hpp>
+
+using namespace Gyoji::context;
+using namespace Gyoji::mir;
+using namespace Gyoji::analysis;
+
+static const SourceReference zero_source_ref("internal", 1, 0, 0);
+
+int test_use_before_assignment();
+int test_borrow_checker();
 
 int main(int argc, char **argv)
 {
+    {
+	int rc = test_use_before_assignment();
+	if (rc != 0) {
+	    return rc;
+	}
+    }
+    {
+	int rc = test_borrow_checker();
+	if (rc != 0) {
+	    return rc;
+	}
+    }
+    printf("PASSED\n");
+    return 0;
+}
+
+static size_t
+use_before_assignment_errors(const Function & function)
+{
+    CompilerContext context("internal");
+    AnalysisPassUseBeforeAssignment pass(context);
+    pass.check_function(function, context.get_errors());
+    return context.get_errors().size();
+}
+
+static std::string
+borrow_checker_error(const Function & function)
+{
+    CompilerContext context("internal");
+    AnalysisPassBorrowChecker pass(context);
+    pass.check_function(function, context.get_errors());
+    if (context.get_errors().size() != 1) {
+	return std::string("errors: ") + std::to_string(context.get_errors().size());
+    }
+    return context.get_errors().get(0).get(0).get_message();
+}
+
+// Each test declares a name only once, so its
+// atom also serves as its declaration id.
+static size_t
+load_variable(Function & function, size_t blockid, AtomTable & atoms, Atom variable, const Type *type)
+{
+    size_t tmpvar = function.tmpvar_define(type);
+    function.add_operation(blockid, Gyoji::owned_new<OperationLocalVariable>(zero_source_ref, tmpvar, atoms, variable, variable, type));
+    return tmpvar;
+}
+
+static size_t
+literal_u32(Function & function, size_t blockid, const Type *u32_type, unsigned int value)
+{
+    size_t tmpvar = function.tmpvar_define(u32_type);
+    function.add_operation(blockid, Gyoji::owned_new<OperationLiteralInt>(zero_source_ref, tmpvar, Type::TYPE_PRIMITIVE_u32, value));
+    return tmpvar;
+}
+
+static size_t
+array_element(Function & function, size_t blockid, AtomTable & atoms, Atom variable, const Type *array_type, unsigned int index)
+{
+    const Type *u32_type = array_type->get_pointer_target();
+    size_t array = load_variable(function, blockid, atoms, variable, array_type);
+    size_t element_index = literal_u32(function, blockid, u32_type, index);
+    size_t element = function.tmpvar_define(u32_type);
+    function.add_operation(blockid, Gyoji::owned_new<OperationArrayIndex>(zero_source_ref, element, array, element_index));
+    return element;
+}
+
+static void
+assign(Function & function, size_t blockid, size_t destination, size_t value)
+{
+    size_t result = function.tmpvar_duplicate(destination);
+    function.add_operation(blockid, Gyoji::owned_new<OperationBinary>(Operation::OP_ASSIGN, zero_source_ref, result, destination, value));
+}
+
+int test_use_before_assignment()
+{
+    CompilerContext context("internal");
+    AtomTable & atoms = context.get_atoms();
+    Atom a = atoms.intern("a");
+    Atom x = atoms.intern("x");
+    Types types;
+    const Type *u32_type = types.get_type("u32");
+    const Type *array_type = types.get_array_of(u32_type, 4, zero_source_ref);
+    std::vector<FunctionArgument> arguments;
+
+    // var a : u32[4]; a[0] = 1; return a[0];
+    // Naming the element to store into isn't a
+    // read of the array.
+    {
+	Function function("filled", u32_type, arguments, false, zero_source_ref);
+	size_t entry = function.add_block();
+	function.add_operation(entry, Gyoji::owned_new<OperationLocalDeclare>(zero_source_ref, atoms, a, a, array_type));
+	size_t element = array_element(function, entry, atoms, a, array_type, 0);
+	assign(function, entry, element, literal_u32(function, entry, u32_type, 1));
+	size_t value = array_element(function, entry, atoms, a, array_type, 0);
+	function.add_operation(entry, Gyoji::owned_new<OperationReturn>(zero_source_ref, value));
+	ASSERT_INT_EQUAL(0, use_before_assignment_errors(function), "Storing an element assigns the array");
+    }
+
+    // var a : u32[4]; return a[0];
+    {
+	Function function("unfilled", u32_type, arguments, false, zero_source_ref);
+	size_t entry = function.add_block();
+	function.add_operation(entry, Gyoji::owned_new<OperationLocalDeclare>(zero_source_ref, atoms, a, a, array_type));
+	size_t value = array_element(function, entry, atoms, a, array_type, 0);
+	function.add_operation(entry, Gyoji::owned_new<OperationReturn>(zero_source_ref, value));
+	ASSERT_INT_EQUAL(1, use_before_assignment_errors(function), "Reading an element of an unassigned array");
+    }
+
+    // var x : u32; &x; return x;
+    // Once the address is taken, the variable
+    // may be assigned through the pointer.
+    {
+	Function function("address", u32_type, arguments, false, zero_source_ref);
+	size_t entry = function.add_block();
+	function.add_operation(entry, Gyoji::owned_new<OperationLocalDeclare>(zero_source_ref, atoms, x, x, u32_type));
+	size_t variable = load_variable(function, entry, atoms, x, u32_type);
+	size_t address = function.tmpvar_define(types.get_pointer_to(u32_type, zero_source_ref));
+	function.add_operation(entry, Gyoji::owned_new<OperationUnary>(Operation::OP_ADDRESSOF, zero_source_ref, address, variable));
+	size_t value = load_variable(function, entry, atoms, x, u32_type);
+	function.add_operation(entry, Gyoji::owned_new<OperationReturn>(zero_source_ref, value));
+	ASSERT_INT_EQUAL(0, use_before_assignment_errors(function), "Taking the address isn't a read");
+    }
+
+    // var x : u32; if (c) { x = 1; } return x;
+    // The variable is only assigned along one
+    // of the paths to the return.
+    for (size_t both = 0; both < 2; both++) {
+	Function function("branches", u32_type, arguments, false, zero_source_ref);
+	size_t entry = function.add_block();
+	size_t then_block = function.add_block();
+	size_t else_block = function.add_block();
+	size_t join = function.add_block();
+	function.add_operation(entry, Gyoji::owned_new<OperationLocalDeclare>(zero_source_ref, atoms, x, x, u32_type));
+	size_t condition = function.tmpvar_define(types.get_type("bool"));
+	function.add_operation(entry, Gyoji::owned_new<OperationLiteralBool>(zero_source_ref, condition, true));
+	function.add_operation(entry, Gyoji::owned_new<OperationJumpConditional>(zero_source_ref, condition, then_block, else_block));
+	assign(function, then_block, load_variable(function, then_block, atoms, x, u32_type), literal_u32(function, then_block, u32_type, 1));
+	function.add_operation(then_block, Gyoji::owned_new<OperationJump>(zero_source_ref, join));
+	if (both) {
+	    assign(function, else_block, load_variable(function, else_block, atoms, x, u32_type), literal_u32(function, else_block, u32_type, 2));
+	}
+	function.add_operation(else_block, Gyoji::owned_new<OperationJump>(zero_source_ref, join));
+	size_t value = load_variable(function, join, atoms, x, u32_type);
+	function.add_operation(join, Gyoji::owned_new<OperationReturn>(zero_source_ref, value));
+	ASSERT_INT_EQUAL(both ? 0 : 1, use_before_assignment_errors(function), "Assigned along every path");
+    }
+
+    return 0;
+}
+
+static void
+declare(Function & function, size_t blockid, AtomTable & atoms, Atom variable, const Type *type)
+{
+    function.add_operation(blockid, Gyoji::owned_new<OperationLocalDeclare>(zero_source_ref, atoms, variable, variable, type));
+}
+
+static void
+undeclare(Function & function, size_t blockid, AtomTable & atoms, Atom variable)
+{
+    function.add_operation(blockid, Gyoji::owned_new<OperationLocalUndeclare>(zero_source_ref, atoms, variable, variable));
+}
+
+// r = &x
+static void
+borrow(Function & function, size_t blockid, AtomTable & atoms, Atom r, Atom x, const Type *reference_type)
+{
+    const Type *type = reference_type->get_pointer_target();
+    size_t place = load_variable(function, blockid, atoms, x, type);
+    size_t address = function.tmpvar_define(reference_type);
+    function.add_operation(blockid, Gyoji::owned_new<OperationUnary>(Operation::OP_ADDRESSOF, zero_source_ref, address, place));
+    assign(function, blockid, load_variable(function, blockid, atoms, r, reference_type), address);
+}
+
+// return *r
+static void
+return_through(Function & function, size_t blockid, AtomTable & atoms, Atom r, const Type *reference_type)
+{
+    size_t reference = load_variable(function, blockid, atoms, r, reference_type);
+    size_t value = function.tmpvar_define(reference_type->get_pointer_target());
+    function.add_operation(blockid, Gyoji::owned_new<OperationUnary>(Operation::OP_DEREFERENCE, zero_source_ref, value, reference));
+    function.add_operation(blockid, Gyoji::owned_new<OperationReturn>(zero_source_ref, value));
+}
+
+int test_borrow_checker()
+{
+    CompilerContext context("internal");
+    AtomTable & atoms = context.get_atoms();
+    Atom r = atoms.intern("r");
+    Atom x = atoms.intern("x");
+    Atom y = atoms.intern("y");
+    Types types;
+    const Type *u32_type = types.get_type("u32");
+    const Type *reference_type = types.get_reference_to(u32_type, zero_source_ref);
+    std::vector<FunctionArgument> arguments;
+
+    // u32 &r = &x; x = 2; return *r;
+    // The loan of x is held by r, which is still
+    // live when x is assigned.
+    for (size_t used_later = 0; used_later < 2; used_later++) {
+	Function function("assigned", u32_type, arguments, false, zero_source_ref);
+	size_t entry = function.add_block();
+	declare(function, entry, atoms, x, u32_type);
+	assign(function, entry, load_variable(function, entry, atoms, x, u32_type), literal_u32(function, entry, u32_type, 1));
+	declare(function, entry, atoms, r, reference_type);
+	borrow(function, entry, atoms, r, x, reference_type);
+	assign(function, entry, load_variable(function, entry, atoms, x, u32_type), literal_u32(function, entry, u32_type, 2));
+	if (used_later) {
+	    return_through(function, entry, atoms, r, reference_type);
+	    ASSERT_STR_EQUAL("Variable x is assigned here while it is still borrowed.", borrow_checker_error(function), "Assigned while borrowed");
+	}
+	else {
+	    function.add_operation(entry, Gyoji::owned_new<OperationReturn>(zero_source_ref, literal_u32(function, entry, u32_type, 0)));
+	    ASSERT_STR_EQUAL("errors: 0", borrow_checker_error(function), "The borrow is never used after the assignment");
+	}
+    }
+
+    // u32 &r; if (c) { r = &x; } else { r = &y; } x = 2; return *r;
+    // The loans flow into r along either path, so
+    // assigning either variable is an error.
+    {
+	Function function("branches", u32_type, arguments, false, zero_source_ref);
+	size_t entry = function.add_block();
+	size_t then_block = function.add_block();
+	size_t else_block = function.add_block();
+	size_t join = function.add_block();
+	declare(function, entry, atoms, x, u32_type);
+	declare(function, entry, atoms, y, u32_type);
+	declare(function, entry, atoms, r, reference_type);
+	size_t condition = function.tmpvar_define(types.get_type("bool"));
+	function.add_operation(entry, Gyoji::owned_new<OperationLiteralBool>(zero_source_ref, condition, true));
+	function.add_operation(entry, Gyoji::owned_new<OperationJumpConditional>(zero_source_ref, condition, then_block, else_block));
+	borrow(function, then_block, atoms, r, x, reference_type);
+	function.add_operation(then_block, Gyoji::owned_new<OperationJump>(zero_source_ref, join));
+	borrow(function, else_block, atoms, r, y, reference_type);
+	function.add_operation(else_block, Gyoji::owned_new<OperationJump>(zero_source_ref, join));
+	assign(function, join, load_variable(function, join, atoms, y, u32_type), literal_u32(function, join, u32_type, 2));
+	return_through(function, join, atoms, r, reference_type);
+	ASSERT_STR_EQUAL("Variable y is assigned here while it is still borrowed.", borrow_checker_error(function), "Loan flows in from one branch");
+    }
+
+    // u32 &r; { u32 x; r = &x; } return *r;
+    // The reference outlives the variable it borrows.
+    for (size_t used_later = 0; used_later < 2; used_later++) {
+	Function function("scope", u32_type, arguments, false, zero_source_ref);
+	size_t entry = function.add_block();
+	declare(function, entry, atoms, r, reference_type);
+	declare(function, entry, atoms, x, u32_type);
+	assign(function, entry, load_variable(function, entry, atoms, x, u32_type), literal_u32(function, entry, u32_type, 1));
+	borrow(function, entry, atoms, r, x, reference_type);
+	if (used_later) {
+	    undeclare(function, entry, atoms, x);
+	    return_through(function, entry, atoms, r, reference_type);
+	    ASSERT_STR_EQUAL("Variable x goes out of scope here while it is still borrowed.", borrow_checker_error(function), "Borrow outlives the variable");
+	}
+	else {
+	    // Reassigning r first replaces the loan it held.
+	    borrow(function, entry, atoms, r, y, reference_type);
+	    undeclare(function, entry, atoms, x);
+	    return_through(function, entry, atoms, r, reference_type);
+	    ASSERT_STR_EQUAL("errors: 0", borrow_checker_error(function), "The reference was reassigned first");
+	}
+    }
+
     return 0;
 }
@@ -13,12 +13,12 @@
  *  limitations under the License.
  */
 #include <gyoji-frontend.hpp>
-#include <gyoji-misc/input-source-file.hpp>
+#include <gyoji-misc/input-source-string.hpp>
 #include <gyoji-misc/getopt.hpp>
-#include <gyoji-misc/subprocess.hpp>
 #include <gyoji-analysis.hpp>
 #include <gyoji-codegen.hpp>
 #include <cstring>
+#include <thread>
 
 using namespace Gyoji::codegen;
 using namespace Gyoji::context;
@@ -26,7 +26,6 @@ using namespace Gyoji::frontend;
 using namespace Gyoji::mir;
 using namespace Gyoji::analysis;
 using namespace Gyoji::misc::cmdline;
-using namespace Gyoji::misc::subprocess;
 
 class JCCOptions {
 public:
@@ -57,6 +56,16 @@ public:
 
     bool get_verbose() const;
     void set_verbose(bool _verbose);
+
+    /**
+     * Whether to print statistics about the size
+     * of the MIR, and where to write them as JSON
+     * (empty for no JSON output).
+     */
+    bool get_mir_stats() const;
+    void set_mir_stats(bool _mir_stats);
+    const std::string & get_mir_stats_json() const;
+    void set_mir_stats_json(const std::string & _filename);
     
     /**
      * Whether to dump the LLVM IR representation.
@@ -67,8 +76,39 @@ public:
     int get_optimization_level() const;
     void set_optimization_level(int level);
 
+    /**
+     * Whether to check the bounds of
+     * accesses to fixed-size arrays.
+     */
+    bool get_bounds_check() const;
+    void set_bounds_check(bool _bounds_check);
+
     const std::vector<std::string> & get_include_directories() const;
     void set_include_directories(std::vector<std::string> _include_directories);
+
+    /**
+     * Number of threads to use for lowering functions
+     * and for the analysis passes.
+     */
+    size_t get_jobs() const;
+    void set_jobs(size_t _jobs);
+
+    /**
+     * Number of errors to report before giving
+     * up, or zero to report all of them.
+     */
+    size_t get_error_limit() const;
+    void set_error_limit(size_t _error_limit);
+
+    /**
+     * Where to write the files the source depends
+     * on for make (empty for nowhere), and whether
+     * to leave out files included as <file>.
+     */
+    const std::string & get_dependency_filename() const;
+    void set_dependency_filename(const std::string & _filename);
+    bool get_dependencies_user_only() const;
+    void set_dependencies_user_only(bool _user_only);
     
 private:
     std::string source_filename;
@@ -76,9 +116,16 @@ private:
     bool compile_only;
     bool output_mir;
     bool verbose;
+    bool mir_stats;
+    std::string mir_stats_json;
     bool output_llvm_ir;
     int optimization_level; // 0,1,2,3
+    bool bounds_check;
     std::vector<std::string> include_directories;
+    size_t jobs;
+    size_t error_limit;
+    std::string dependency_filename;
+    bool dependencies_user_only;
 };
 
 class JCCGetopt {
@@ -90,6 +137,14 @@ public:
     static const std::string JCC_OPTION_OUTPUT_FILENAME;
     static const std::string JCC_OPTION_INCLUDE_DIRECTORY;
     static const std::string JCC_OPTION_VERBOSE;
+    static const std::string JCC_OPTION_JOBS;
+    static const std::string JCC_OPTION_MIR_STATS;
+    static const std::string JCC_OPTION_MIR_STATS_JSON;
+    static const std::string JCC_OPTION_BOUNDS_CHECK;
+    static const std::string JCC_OPTION_ERROR_LIMIT;
+    static const std::string JCC_OPTION_DEPENDENCIES;
+    static const std::string JCC_OPTION_USER_DEPENDENCIES;
+    static const std::string JCC_OPTION_DEPENDENCY_FILENAME;
 
     static Gyoji::owned<JCCOptions> getopt(int argc, char **argv);
 };
@@ -101,6 +156,14 @@ const std::string JCCGetopt::JCC_OPTION_OPTIMIZATION_LEVEL = "optimization-level
 const std::string JCCGetopt::JCC_OPTION_OUTPUT_FILENAME = "output-filename";
 const std::string JCCGetopt::JCC_OPTION_INCLUDE_DIRECTORY = "include-directory";
 const std::string JCCGetopt::JCC_OPTION_VERBOSE = "verbose";
+const std::string JCCGetopt::JCC_OPTION_JOBS = "jobs";
+const std::string JCCGetopt::JCC_OPTION_MIR_STATS = "mir-stats";
+const std::string JCCGetopt::JCC_OPTION_MIR_STATS_JSON = "mir-stats-json";
+const std::string JCCGetopt::JCC_OPTION_BOUNDS_CHECK = "bounds-check";
+const std::string JCCGetopt::JCC_OPTION_ERROR_LIMIT = "error-limit";
+const std::string JCCGetopt::JCC_OPTION_DEPENDENCIES = "dependencies";
+const std::string JCCGetopt::JCC_OPTION_USER_DEPENDENCIES = "user-dependencies";
+const std::string JCCGetopt::JCC_OPTION_DEPENDENCY_FILENAME = "dependency-file";
 
 JCCOptions::JCCOptions()
 {}
@@ -148,6 +211,22 @@ void
 JCCOptions::set_verbose(bool _verbose)
 { verbose = _verbose; }
 
+bool
+JCCOptions::get_mir_stats() const
+{ return mir_stats; }
+
+void
+JCCOptions::set_mir_stats(bool _mir_stats)
+{ mir_stats = _mir_stats; }
+
+const std::string &
+JCCOptions::get_mir_stats_json() const
+{ return mir_stats_json; }
+
+void
+JCCOptions::set_mir_stats_json(const std::string & _filename)
+{ mir_stats_json = _filename; }
+
 bool
 JCCOptions::get_output_llvm_ir() const
 { return output_llvm_ir; }
@@ -164,6 +243,14 @@ void
 JCCOptions::set_optimization_level(int level)
 { optimization_level = level; }
 
+bool
+JCCOptions::get_bounds_check() const
+{ return bounds_check; }
+
+void
+JCCOptions::set_bounds_check(bool _bounds_check)
+{ bounds_check = _bounds_check; }
+
 const std::vector<std::string> &
 JCCOptions::get_include_directories() const
 { return include_directories; }
@@ -172,6 +259,38 @@ void
 JCCOptions::set_include_directories(std::vector<std::string> _include_directories)
 { include_directories = _include_directories; }
 
+size_t
+JCCOptions::get_jobs() const
+{ return jobs; }
+
+void
+JCCOptions::set_jobs(size_t _jobs)
+{ jobs = _jobs; }
+
+size_t
+JCCOptions::get_error_limit() const
+{ return error_limit; }
+
+void
+JCCOptions::set_error_limit(size_t _error_limit)
+{ error_limit = _error_limit; }
+
+const std::string &
+JCCOptions::get_dependency_filename() const
+{ return dependency_filename; }
+
+void
+JCCOptions::set_dependency_filename(const std::string & _filename)
+{ dependency_filename = _filename; }
+
+bool
+JCCOptions::get_dependencies_user_only() const
+{ return dependencies_user_only; }
+
+void
+JCCOptions::set_dependencies_user_only(bool _user_only)
+{ dependencies_user_only = _user_only; }
+
 Gyoji::owned<JCCOptions>
 JCCGetopt::getopt(int argc, char **argv)
 {
@@ -200,6 +319,30 @@ JCCGetopt::getopt(int argc, char **argv)
 	    "Output the LLVM IR representation of the program"
 	    )
 	);
+    options.push_back(
+	Option::create_boolean(
+	    JCC_OPTION_MIR_STATS,
+	    "",
+	    "mir-stats",
+	    "Print statistics about the size of the MIR and the memory used to build it"
+	    )
+	);
+    options.push_back(
+	Option::create_string(
+	    JCC_OPTION_MIR_STATS_JSON,
+	    "",
+	    "mir-stats-json",
+	    "Write the MIR statistics as JSON to the given file"
+	    )
+	);
+    options.push_back(
+	Option::create_boolean(
+	    JCC_OPTION_BOUNDS_CHECK,
+	    "",
+	    "bounds-check",
+	    "Trap on out-of-bounds array accesses that can't be proven safe"
+	    )
+	);
     options.push_back(
 	Option::create_boolean(
 	    JCC_OPTION_VERBOSE,
@@ -224,6 +367,46 @@ JCCGetopt::getopt(int argc, char **argv)
 	    "Name of the output file to produce"
 	    )
 	);
+    options.push_back(
+	Option::create_string(
+	    JCC_OPTION_JOBS,
+	    "j",
+	    "jobs",
+	    "Number of threads to use (default: one per processor)"
+	    )
+	);
+    options.push_back(
+	Option::create_string(
+	    JCC_OPTION_ERROR_LIMIT,
+	    "",
+	    "error-limit",
+	    "Stop after reporting this many errors (default: 0, no limit)"
+	    )
+	);
+    options.push_back(
+	Option::create_boolean(
+	    JCC_OPTION_DEPENDENCIES,
+	    "MD",
+	    "dependencies",
+	    "Write the files the source depends on to a make file (default: the output with .d)"
+	    )
+	);
+    options.push_back(
+	Option::create_boolean(
+	    JCC_OPTION_USER_DEPENDENCIES,
+	    "MMD",
+	    "user-dependencies",
+	    "Like -MD, but leave out files included as <file>"
+	    )
+	);
+    options.push_back(
+	Option::create_string(
+	    JCC_OPTION_DEPENDENCY_FILENAME,
+	    "MF",
+	    "dependency-file",
+	    "Name of the file to write the dependencies to (implies -MD)"
+	    )
+	);
     options.push_back(
 	Option::create_string_list(
 	    JCC_OPTION_INCLUDE_DIRECTORY,
@@ -264,7 +447,12 @@ JCCGetopt::getopt(int argc, char **argv)
     jcc_options->set_compile_only(selected_options->get_boolean(JCC_OPTION_COMPILE_ONLY));
     jcc_options->set_output_mir(selected_options->get_boolean(JCC_OPTION_OUTPUT_MIR));
     jcc_options->set_verbose(selected_options->get_boolean(JCC_OPTION_VERBOSE));
+    jcc_options->set_mir_stats(selected_options->get_boolean(JCC_OPTION_MIR_STATS));
+    if (selected_options->get_boolean(JCC_OPTION_MIR_STATS_JSON)) {
+	jcc_options->set_mir_stats_json(selected_options->get_string(JCC_OPTION_MIR_STATS_JSON));
+    }
     jcc_options->set_output_llvm_ir(selected_options->get_boolean(JCC_OPTION_OUTPUT_LLVM_IR));
+    jcc_options->set_bounds_check(selected_options->get_boolean(JCC_OPTION_BOUNDS_CHECK));
 
     if (selected_options->get_boolean(JCC_OPTION_OPTIMIZATION_LEVEL)) {
 	const std::string & level = selected_options->get_string(JCC_OPTION_OPTIMIZATION_LEVEL);
@@ -301,6 +489,53 @@ JCCGetopt::getopt(int argc, char **argv)
 	jcc_options->set_output_filename("a.out");
     }
 
+    if (selected_options->get_boolean(JCC_OPTION_JOBS)) {
+	const std::string & jobs = selected_options->get_string(JCC_OPTION_JOBS);
+	char *endptr = nullptr;
+	long njobs = strtol(jobs.c_str(), &endptr, 10);
+	if (jobs.size() == 0 || *endptr != '\0' || njobs < 1) {
+	    fprintf(stderr, "Invalid number of jobs %s\n", jobs.c_str());
+	    get_options.print_help("jcc", stderr);
+	    return nullptr;
+	}
+	jcc_options->set_jobs((size_t)njobs);
+    }
+    else {
+	jcc_options->set_jobs(std::max(std::thread::hardware_concurrency(), 1u));
+    }
+
+    if (selected_options->get_boolean(JCC_OPTION_ERROR_LIMIT)) {
+	const std::string & limit = selected_options->get_string(JCC_OPTION_ERROR_LIMIT);
+	char *endptr = nullptr;
+	long error_limit = strtol(limit.c_str(), &endptr, 10);
+	if (limit.size() == 0 || *endptr != '\0' || error_limit < 0) {
+	    fprintf(stderr, "Invalid error limit %s\n", limit.c_str());
+	    get_options.print_help("jcc", stderr);
+	    return nullptr;
+	}
+	jcc_options->set_error_limit((size_t)error_limit);
+    }
+    else {
+	jcc_options->set_error_limit(0);
+    }
+
+    // The dependency file is named after the output
+    // unless it is given, as with gcc and clang.
+    bool user_dependencies = selected_options->get_boolean(JCC_OPTION_USER_DEPENDENCIES);
+    jcc_options->set_dependencies_user_only(user_dependencies);
+    if (selected_options->get_boolean(JCC_OPTION_DEPENDENCY_FILENAME)) {
+	jcc_options->set_dependency_filename(selected_options->get_string(JCC_OPTION_DEPENDENCY_FILENAME));
+    }
+    else if (user_dependencies || selected_options->get_boolean(JCC_OPTION_DEPENDENCIES)) {
+	std::string dependency_filename = jcc_options->get_output_filename();
+	size_t dot = dependency_filename.rfind('.');
+	size_t slash = dependency_filename.rfind('/');
+	if (dot != std::string::npos && (slash == std::string::npos || dot > slash)) {
+	    dependency_filename.resize(dot);
+	}
+	jcc_options->set_dependency_filename(dependency_filename + std::string(".d"));
+    }
+
     const auto & include_it = named_arguments.find(JCC_OPTION_INCLUDE_DIRECTORY);
     if (include_it != named_arguments.end()) {
         jcc_options->set_include_directories(include_it->second);
@@ -309,6 +544,45 @@ JCCGetopt::getopt(int argc, char **argv)
     return jcc_options;
 }
 
+// Writes a path for make, which splits
+// words on spaces and expands '$'.
+static void
+write_dependency_path(FILE *file, const std::string & path)
+{
+    for (char c : path) {
+	if (c == ' ' || c == '#') {
+	    fputc('\\', file);
+	}
+	else if (c == '$') {
+	    fputc('$', file);
+	}
+	fputc(c, file);
+    }
+}
+
+static bool
+write_dependencies(
+    const std::string & dependency_filename,
+    const std::string & target,
+    const std::vector<std::string> & dependencies
+    )
+{
+    FILE *file = fopen(dependency_filename.c_str(), "w");
+    if (file == nullptr) {
+	fprintf(stderr, "Cannot open file %s\n", dependency_filename.c_str());
+	return false;
+    }
+    write_dependency_path(file, target);
+    fprintf(file, ":");
+    for (const std::string & dependency : dependencies) {
+	fprintf(file, " \\\n  ");
+	write_dependency_path(file, dependency);
+    }
+    fprintf(file, "\n");
+    fclose(file);
+    return true;
+}
+
 int main(int argc, char **argv)
 {
 
@@ -320,68 +594,61 @@ int main(int argc, char **argv)
     const std::string & input_filename = options->get_source_filename();
     const std::string & output_filename = options->get_output_filename();
 
-    std::string preprocessed_filename = input_filename + std::string(".preproc");
-    int preprocessed_fd = ::open(preprocessed_filename.c_str(), O_CREAT | O_WRONLY, 0777);
-    
-    // Call the preprocessor
-    SubProcess preprocessor(
-	std::move(Gyoji::owned_new<SubProcessReaderFile>(preprocessed_fd)),
-	std::move(Gyoji::owned_new<SubProcessReaderFile>(STDERR_FILENO)),
-	std::move(Gyoji::owned_new<SubProcessWriterEmpty>())
-	);
-
-    std::vector<std::string> arguments;
-    std::map<std::string, std::string> environment;
-
-    // Treat input as 'c'
-    // otherwise the .g suffix
-    // will imply that it's something for the linker.
-    arguments.push_back("--language");
-    arguments.push_back("c");
-
-    // Tell it we want to preprocess the file.
-    arguments.push_back("-E");
+    CompilerContext context(input_filename);
+    context.get_errors().set_error_limit(options->get_error_limit());
 
-    // TODO: wire this up to our command-line so
-    // we can specify include dirs directly.
+    // The preprocessor reads the file and the files it
+    // includes, leaving line markers for the lexer to
+    // follow back to the file each line came from.
+    std::string preprocessed;
+    Preprocessor preprocessor(context);
     for (const auto & include_dir : options->get_include_directories()) {
-	arguments.push_back("-I");
-	arguments.push_back(include_dir);
+	preprocessor.add_include_directory(include_dir);
     }
-
-    arguments.push_back(input_filename);
-    
-    int rc = preprocessor.invoke(
-	"clang",
-	arguments,
-	environment
-	);
-    if (rc != 0) {
-	fprintf(stderr, "Preprocessor failed\n");
-	return rc;
-    }
-	
-    
-//    int input = open(input_filename.c_str(), O_RDONLY);
-    int input = open(preprocessed_filename.c_str(), O_RDONLY);
-    if (input == -1) {
-	fprintf(stderr, "Cannot open file %s\n", input_filename.c_str());
+    if (!preprocessor.preprocess(input_filename, preprocessed)) {
+	context.get_errors().print();
 	return -1;
     }
+    if (options->get_dependency_filename().size() != 0) {
+	if (!write_dependencies(
+		options->get_dependency_filename(),
+		output_filename,
+		preprocessor.get_dependencies(options->get_dependencies_user_only())
+		)) {
+	    return -1;
+	}
+    }
+    Gyoji::misc::InputSourceString input_source(preprocessed);
     
-    CompilerContext context(input_filename);
-    Gyoji::misc::InputSourceFile input_source(input);
-    
-    Gyoji::owned<MIR> mir =
-	Parser::parse_to_mir(
+    // The syntax tree and the tokens are only needed
+    // long enough to lower them, but we measure them
+    // first in case the MIR statistics were asked for.
+    // Whitespace and comments are only needed to
+    // reproduce the input, and every body is lowered,
+    // so there is nothing to gain by deferring them.
+    const bool keep_trivia = false;
+    const bool defer_bodies = false;
+    Gyoji::owned<ParseResult> parse_result =
+	Parser::parse(
 	    context,
 	    input_source,
-	    options->get_verbose()
+	    keep_trivia,
+	    defer_bodies
 	    );
-    close(input);
-
-    // Remove the preprocessor temporary file.
-    unlink(preprocessed_filename.c_str());
+    size_t syntax_tree_bytes = parse_result->get_syntax_tree_footprint();
+    Gyoji::owned<MIR> mir =
+	Parser::lower_to_mir(
+	    context,
+	    *parse_result,
+	    options->get_verbose(),
+	    options->get_jobs()
+	    );
+    size_t token_count = context.get_token_stream().get_token_count();
+    size_t token_stream_bytes = context.get_token_stream().get_footprint();
+    parse_result.reset();
+    // Only the text and its lines are kept
+    // to give context to error messages.
+    context.get_token_stream().release_tokens();
 
     // Dump our MIR
     // for debugging/review purposes
@@ -409,23 +676,66 @@ int main(int argc, char **argv)
     analysis_passes.push_back(Gyoji::owned_new<AnalysisPassTypeResolution>(context));
     analysis_passes.push_back(Gyoji::owned_new<AnalysisPassUnreachable>(context));
     analysis_passes.push_back(Gyoji::owned_new<AnalysisPassReturnValues>(context));
-//    analysis_passes.push_back(Gyoji::owned_new<AnalysisPassUseBeforeAssignment>(context));
+    analysis_passes.push_back(Gyoji::owned_new<AnalysisPassUseBeforeAssignment>(context));
     analysis_passes.push_back(Gyoji::owned_new<AnalysisPassBorrowChecker>(context));
 
-    for (const auto & analysis_pass : analysis_passes) {
-	if (options->get_verbose()) {
+    if (options->get_verbose()) {
+	for (const auto & analysis_pass : analysis_passes) {
 	    fprintf(stderr, "============================\n");
 	    fprintf(stderr, "Analysis pass %s\n", analysis_pass->get_name().c_str());
 	    fprintf(stderr, "============================\n");
 	}
-	analysis_pass->check(*mir);
     }
+    AnalysisScheduler analysis_scheduler(context, options->get_jobs());
+    analysis_scheduler.run(*mir, analysis_passes);
 
     if (context.has_errors()) {
 	context.get_errors().print();
 	return -1;
     }
 
+    // Constants are folded only after the analysis
+    // passes have checked the program as it was
+    // written, so that errors in code which can never
+    // run are still reported.
+    for (const auto & function : mir->get_functions().get_functions()) {
+	ConstantPropagation constants(*function);
+	constants.fold();
+	if (options->get_verbose()) {
+	    fprintf(stderr, "Constants in %s: %ld operations folded, %ld branches resolved, %ld blocks removed, %ld operations removed\n",
+		    function->get_name().c_str(),
+		    constants.get_operations_folded(),
+		    constants.get_branches_resolved(),
+		    constants.get_blocks_removed(),
+		    constants.get_operations_removed());
+	}
+    }
+
+    // The statistics describe the MIR as it is handed
+    // to the code generator, after constants have been
+    // folded, so that the bounds checks counted are the
+    // ones that will actually be emitted.
+    if (options->get_mir_stats() || options->get_mir_stats_json().size() != 0) {
+	MIRStats mir_stats(*mir);
+	mir_stats.set_token_stream(
+	    token_count,
+	    token_stream_bytes + Gyoji::context::SourceTable::get_instance().get_footprint()
+	    );
+	mir_stats.set_syntax_tree_bytes(syntax_tree_bytes);
+	if (options->get_mir_stats()) {
+	    mir_stats.print_table(stdout);
+	}
+	if (options->get_mir_stats_json().size() != 0) {
+	    FILE *json_output = fopen(options->get_mir_stats_json().c_str(), "w");
+	    if (json_output == nullptr) {
+		fprintf(stderr, "Cannot open file %s\n", options->get_mir_stats_json().c_str());
+		return -1;
+	    }
+	    mir_stats.print_json(json_output);
+	    fclose(json_output);
+	}
+    }
+
     if (options->get_verbose()) {
 	fprintf(stderr, "============================\n");
 	fprintf(stderr, "Code Generation Pass\n");
@@ -441,6 +751,7 @@ int main(int argc, char **argv)
     llvm_options.set_output_filename(output_filename);
     llvm_options.set_optimization_level(options->get_optimization_level());
     llvm_options.set_verbose(options->get_verbose());
+    llvm_options.set_bounds_check(options->get_bounds_check());
     
     generate_code(context, *mir, llvm_options);
     
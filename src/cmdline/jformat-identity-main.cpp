@@ -13,7 +13,7 @@
  *  limitations under the License.
  */
 #include "jformat-identity.hpp"
-#include <gyoji-misc/input-source-file.hpp>
+#include <gyoji-misc/input-source-mmap.hpp>
 
 using namespace Gyoji::context;
 using namespace Gyoji::frontend;
@@ -38,12 +38,14 @@ int main(int argc, char **argv)
     
     CompilerContext context(argv[1]);
     
-    Gyoji::misc::InputSourceFile input_source(input);
+    Gyoji::misc::InputSourceMmap input_source(input);
     
     Gyoji::owned<ParseResult> parse_result = 
         Parser::parse(
 	    context,
-	    input_source
+	    input_source,
+	    true,
+	    false
 	    );
     close(input);
     if (parse_result->has_errors()) {
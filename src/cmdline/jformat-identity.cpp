@@ -26,19 +26,19 @@ JFormatIdentity::~JFormatIdentity()
 
 static void print_whitespace(const TerminalNonSyntax & node)
 {
-    printf("%s", node.get_data().c_str());
+    printf("%.*s", (int)node.get_data().size(), node.get_data().data());
 }
 static void print_comment_single_line(const TerminalNonSyntax & node)
 {
-    printf("%s", node.get_data().c_str());
+    printf("%.*s", (int)node.get_data().size(), node.get_data().data());
 }
 static void print_comment_multi_line(const TerminalNonSyntax & node)
 {
-    printf("%s", node.get_data().c_str());
+    printf("%.*s", (int)node.get_data().size(), node.get_data().data());
 }
 static void print_file_metadata(const TerminalNonSyntax & node)
 {
-    printf("%s", node.get_data().c_str());
+    printf("%.*s", (int)node.get_data().size(), node.get_data().data());
 }
 
 
@@ -67,7 +67,7 @@ static void print_node(const SyntaxNode &node)
 	for (const auto &non_syntax : terminal.non_syntax) {
 	    print_non_syntax(*non_syntax);
 	}
-	printf("%s", terminal.get_value().c_str());
+	printf("%.*s", (int)terminal.get_value().size(), terminal.get_value().data());
     }
     for (auto child : node.get_children()) {
 	print_node(child);
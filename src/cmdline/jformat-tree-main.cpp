@@ -13,7 +13,7 @@
  *  limitations under the License.
  */
 #include <gyoji-frontend.hpp>
-#include <gyoji-misc/input-source-file.hpp>
+#include <gyoji-misc/input-source-mmap.hpp>
 #include "jformat-tree.hpp"
 
 using namespace Gyoji::context;
@@ -22,14 +22,46 @@ using namespace Gyoji::frontend::tree;
 using namespace Gyoji::frontend::namespaces;
 using namespace Gyoji::cmdline;
 
+/**
+ * Finds the definition of the function with the given
+ * fully-qualified name, looking inside namespaces too.
+ */
+static const FileStatementFunctionDefinition *
+find_function(const std::vector<Gyoji::owned<FileStatement>> & statements, const std::string & symbol)
+{
+    for (const auto & statement : statements) {
+	const auto & file_statement = statement->get_statement();
+	if (std::holds_alternative<Gyoji::owned<FileStatementFunctionDefinition>>(file_statement)) {
+	    const auto & function_definition = std::get<Gyoji::owned<FileStatementFunctionDefinition>>(file_statement);
+	    if (function_definition->get_name().get_fully_qualified_name() == symbol) {
+		return function_definition.get();
+	    }
+	}
+	else if (std::holds_alternative<Gyoji::owned<FileStatementNamespace>>(file_statement)) {
+	    const auto & namespace_statement = std::get<Gyoji::owned<FileStatementNamespace>>(file_statement);
+	    const FileStatementFunctionDefinition *found =
+		find_function(namespace_statement->get_statement_list().get_statements(), symbol);
+	    if (found != nullptr) {
+		return found;
+	    }
+	}
+    }
+    return nullptr;
+}
+
 int main(int argc, char **argv)
 {
     
-    if (argc != 2) {
+    if (argc != 2 && argc != 3) {
 	fprintf(stderr, "Invalid number of arguments %d\n", argc);
-	fprintf(stderr, "Usage: parser backend file\n");
+	fprintf(stderr, "Usage: jformat-tree file [function]\n");
+	fprintf(stderr, "    Given the fully-qualified name of a function, only\n");
+	fprintf(stderr, "    that function's body is parsed and printed.\n");
 	exit(1);
     }
+    // When only one function is wanted, the other
+    // bodies are skipped instead of parsed.
+    bool defer_bodies = (argc == 3);
     
     int input = open(argv[1], O_RDONLY);
     if (input == -1) {
@@ -39,12 +71,14 @@ int main(int argc, char **argv)
     
     CompilerContext context(argv[1]);
     
-    Gyoji::misc::InputSourceFile input_source(input);
+    Gyoji::misc::InputSourceMmap input_source(input);
     
     Gyoji::owned<ParseResult> parse_result = 
         Parser::parse(
 	    context,
-	    input_source
+	    input_source,
+	    true,
+	    defer_bodies
 	    );
     close(input);
     if (parse_result->has_errors()) {
@@ -55,7 +89,22 @@ int main(int argc, char **argv)
     const TranslationUnit & translation_unit = parse_result->get_translation_unit();
     
     JFormatTree formatter;
-    formatter.process(translation_unit.get_syntax_node());
+    if (!defer_bodies) {
+	formatter.process(translation_unit.get_syntax_node());
+	return 0;
+    }
+    
+    const FileStatementFunctionDefinition *function_definition =
+	find_function(translation_unit.get_statements(), argv[2]);
+    if (function_definition == nullptr) {
+	fprintf(stderr, "Function %s is not defined in %s\n", argv[2], argv[1]);
+	return -1;
+    }
+    if (!Parser::parse_deferred_body(*parse_result, function_definition->get_scope_body())) {
+	parse_result->get_errors().print();
+	return -1;
+    }
+    formatter.process(function_definition->get_syntax_node());
     
     return 0;
 }
@@ -125,6 +125,7 @@ static TokenName token_names[] = {
     {TERMINAL_whitespace, "whitespace"},
     {TERMINAL_newline, "newline"},
     {TERMINAL_file_metadata, "file_metadata"},
+    {TERMINAL_DEFERRED_BODY, "DEFERRED_BODY"},
     
     // Syntax Non-terminals
     {NONTERMINAL_access_modifier, "access_modifier"},
@@ -242,7 +243,7 @@ void JFormatTree::print_comment_multi_line(const TerminalNonSyntax & node)
     printf("<comment-multi-line>\n");
     indent++;
     print_indent();
-    printf("%s\n", xml_to_cdata(node.get_data()).c_str());
+    printf("%s\n", xml_to_cdata(std::string(node.get_data())).c_str());
     indent--;
     print_indent();
     printf("</comment-multi-line>\n");
@@ -254,7 +255,7 @@ void JFormatTree::print_comment_single_line(const TerminalNonSyntax & node)
     printf("<comment-single-line>\n");
     indent++;
     print_indent();
-    printf("%s\n", xml_to_cdata(node.get_data()).c_str());
+    printf("%s\n", xml_to_cdata(std::string(node.get_data())).c_str());
     indent--;
     print_indent();
     printf("</comment-single-line>\n");
@@ -263,12 +264,12 @@ void JFormatTree::print_comment_single_line(const TerminalNonSyntax & node)
 void JFormatTree::print_whitespace(const TerminalNonSyntax & node)
 {
     print_indent();
-    printf("<whitespace>%s</whitespace>\n", xml_escape_whitespace(node.get_data()).c_str());
+    printf("<whitespace>%s</whitespace>\n", xml_escape_whitespace(std::string(node.get_data())).c_str());
 }
 
 void JFormatTree::print_file_metadata(const TerminalNonSyntax & node)
 {
-    printf("<metadata>%s</metadata>", xml_to_cdata(node.get_data()).c_str());
+    printf("<metadata>%s</metadata>", xml_to_cdata(std::string(node.get_data())).c_str());
 }
 
 
@@ -317,12 +318,12 @@ int JFormatTree::process(const SyntaxNode & node)
 		terminal.get_type() == TERMINAL_NAMESPACE_NAME
 		) {
 		printf(" value='%s' fq='%s'",
-		       xml_escape_attribute(terminal.get_value()).c_str(),
+		       xml_escape_attribute(std::string(terminal.get_value())).c_str(),
 		       xml_escape_attribute(terminal.get_fully_qualified_name()).c_str()
 		    );
 	    }
 	    else {
-		printf(" value='%s'", xml_escape_attribute(terminal.get_value()).c_str());
+		printf(" value='%s'", xml_escape_attribute(std::string(terminal.get_value())).c_str());
 	    }
 	}
     }
@@ -13,7 +13,8 @@
  *  limitations under the License.
  */
 #include "jformat-identity.hpp"
-#include <gyoji-misc/input-source-file.hpp>
+#include <gyoji-misc/input-source-mmap.hpp>
+#include <string.h>
 
 using namespace Gyoji::context;
 using namespace Gyoji::frontend;
@@ -21,29 +22,53 @@ using namespace Gyoji::frontend::tree;
 using namespace Gyoji::frontend::namespaces;
 using namespace Gyoji::cmdline;
 
+static void
+usage()
+{
+    fprintf(stderr, "Usage: jns [--bodies] file\n");
+    fprintf(stderr, "    --bodies  Parse function bodies too instead of skipping them.\n");
+}
+
 int main(int argc, char **argv)
 {
-    
-    if (argc != 2) {
-	fprintf(stderr, "Invalid number of arguments %d\n", argc);
-	fprintf(stderr, "Usage: parser backend file\n");
+    // Only the declarations make up the namespaces,
+    // so function bodies are skipped unless asked for.
+    bool defer_bodies = true;
+    const char *filename = nullptr;
+    for (int i = 1; i < argc; i++) {
+	if (strcmp(argv[i], "--bodies") == 0) {
+	    defer_bodies = false;
+	}
+	else if (filename == nullptr && argv[i][0] != '-') {
+	    filename = argv[i];
+	}
+	else {
+	    fprintf(stderr, "Invalid argument %s\n", argv[i]);
+	    usage();
+	    exit(1);
+	}
+    }
+    if (filename == nullptr) {
+	usage();
 	exit(1);
     }
     
-    int input = open(argv[1], O_RDONLY);
+    int input = open(filename, O_RDONLY);
     if (input == -1) {
-	fprintf(stderr, "Cannot open file %s\n", argv[1]);
+	fprintf(stderr, "Cannot open file %s\n", filename);
 	exit(1);
     }
     
-    CompilerContext context(argv[1]);
+    CompilerContext context(filename);
     
-    Gyoji::misc::InputSourceFile input_source(input);
+    Gyoji::misc::InputSourceMmap input_source(input);
     
     Gyoji::owned<ParseResult> parse_result = 
         Parser::parse(
 	    context,
-	    input_source
+	    input_source,
+	    true,
+	    defer_bodies
 	    );
     close(input);
     if (parse_result->has_errors()) {
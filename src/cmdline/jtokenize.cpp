@@ -13,49 +13,98 @@
  *  limitations under the License.
  */
 #include <gyoji-misc/input-source-file.hpp>
+#include <gyoji-misc/input-source-mmap.hpp>
 #include <gyoji-frontend.hpp>
 #include <gyoji-context.hpp>
 #include <gyoji.l.hpp>
 #include <gyoji.y.hpp>
+#include <chrono>
+#include <string.h>
 
 using namespace Gyoji::context;
 using namespace Gyoji::frontend::tree;
 using namespace Gyoji::frontend::yacc;
 
+static void
+usage()
+{
+    fprintf(stderr, "Usage: jtokenize [--benchmark] [--read] [--no-trivia] file\n");
+    fprintf(stderr, "    --benchmark  Report how fast the file was tokenized instead of printing the tokens.\n");
+    fprintf(stderr, "    --read       Read the file into memory instead of mapping it.\n");
+    fprintf(stderr, "    --no-trivia  Skip whitespace and comments the way the compiler does.\n");
+}
+
 int main(int argc, char **argv)
 {
-    if (argc != 2) {
-	fprintf(stderr, "Invalid number of arguments %d\n", argc);
-	fprintf(stderr, "Usage: jformat-identity file\n");
+    bool benchmark = false;
+    bool use_read = false;
+    bool keep_trivia = true;
+    const char *filename = nullptr;
+    for (int i = 1; i < argc; i++) {
+	if (strcmp(argv[i], "--benchmark") == 0) {
+	    benchmark = true;
+	}
+	else if (strcmp(argv[i], "--read") == 0) {
+	    use_read = true;
+	}
+	else if (strcmp(argv[i], "--no-trivia") == 0) {
+	    keep_trivia = false;
+	}
+	else if (filename == nullptr && argv[i][0] != '-') {
+	    filename = argv[i];
+	}
+	else {
+	    fprintf(stderr, "Invalid argument %s\n", argv[i]);
+	    usage();
+	    exit(1);
+	}
+    }
+    if (filename == nullptr) {
+	usage();
 	exit(1);
     }
+
+    auto start_time = std::chrono::steady_clock::now();
     
-    int input = open(argv[1], O_RDONLY);
+    int input = open(filename, O_RDONLY);
     if (input == -1) {
-	fprintf(stderr, "Cannot open file %s\n", argv[1]);
+	fprintf(stderr, "Cannot open file %s\n", filename);
 	exit(1);
     }
     
-    CompilerContext context(argv[1]);
-    Gyoji::frontend::namespaces::NS2Context ns2_context;
+    CompilerContext context(filename);
+    Gyoji::frontend::namespaces::NS2Context ns2_context(context.get_atoms());
     
-    Gyoji::misc::InputSourceFile input_source(input);
+    Gyoji::owned<Gyoji::misc::InputSource> input_source;
+    if (use_read) {
+	input_source = Gyoji::owned_new<Gyoji::misc::InputSourceFile>(input);
+    }
+    else {
+	input_source = Gyoji::owned_new<Gyoji::misc::InputSourceMmap>(input);
+    }
     
     LexContext lex_context(
 	ns2_context,
 	context,
-	input_source);
+	*input_source,
+	keep_trivia);
     
     yyscan_t scanner;
     yylex_init(&scanner);
-    yyset_extra(&lex_context, scanner);
-    
+    lex_context.scan_input(scanner);
+    close(input);
+
+    size_t token_count = 0;
     while (true) {
 	Gyoji::frontend::yacc::YaccParser::semantic_type lvalue;
 	int rc = yylex (&lvalue, scanner);
 	if (rc == 0) {
 	    break;
 	}
+	token_count++;
+	if (benchmark) {
+	    continue;
+	}
 	const Gyoji::owned<Gyoji::frontend::tree::Terminal> & token = lvalue.as<Gyoji::owned<Gyoji::frontend::tree::Terminal>>();
 	printf("%ld %ld : %d %s : %s\n",
 	       token->get_source_ref().get_line(),
@@ -65,6 +114,26 @@ int main(int argc, char **argv)
 	       token->get_fully_qualified_name().c_str()
 	    );
     }
+    yylex_destroy(scanner);
+
+    if (benchmark) {
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_time;
+	double seconds = elapsed.count();
+	const TokenStream & token_stream = context.get_token_stream();
+	size_t bytes = 0;
+	for (size_t i = 0; i < token_stream.get_token_count(); i++) {
+	    bytes += token_stream.get_token_value(i).size();
+	}
+	double megabytes = (double)bytes / (1024.0 * 1024.0);
+	printf("%s: %ld tokens (%ld with trivia), %ld bytes in %.6f seconds, %.2f MB/s\n",
+	       use_read ? "read" : "mmap",
+	       token_count,
+	       token_stream.get_token_count(),
+	       bytes,
+	       seconds,
+	       seconds > 0 ? megabytes / seconds : 0.0
+	    );
+    }
     
     return 0;
 }
@@ -32,6 +32,7 @@ void Gyoji::codegen::generate_code(
 }
 
 CodeGeneratorLLVMOptions::CodeGeneratorLLVMOptions()
+    : bounds_check(false)
 {}
 
 CodeGeneratorLLVMOptions::~CodeGeneratorLLVMOptions()
@@ -69,3 +70,11 @@ CodeGeneratorLLVMOptions::get_verbose() const
 void
 CodeGeneratorLLVMOptions::set_verbose(bool _verbose)
 { verbose = _verbose; }
+
+bool
+CodeGeneratorLLVMOptions::get_bounds_check() const
+{ return bounds_check; }
+
+void
+CodeGeneratorLLVMOptions::set_bounds_check(bool _bounds_check)
+{ bounds_check = _bounds_check; }
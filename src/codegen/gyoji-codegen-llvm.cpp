@@ -53,6 +53,9 @@ CodeGeneratorLLVMContext::CodeGeneratorLLVMContext(
     : compiler_context(_compiler_context)
     , mir(_mir)
     , options(_options)
+    , bounds_check_failed(nullptr)
+    , current_block_id(0)
+    , current_operation_index(0)
 {}
 CodeGeneratorLLVMContext::~CodeGeneratorLLVMContext()
 {}
@@ -78,11 +81,11 @@ CodeGeneratorLLVMContext::create_function(const Function & function)
     const std::vector<FunctionArgument> & function_arguments = function.get_arguments();
     
     for (const auto & semantic_arg : function_arguments) {
-	llvm::Type *atype = types[semantic_arg.get_type()->get_name()];
+	llvm::Type *atype = types[semantic_arg.get_type()->get_type_id()];
 	llvm_arguments.push_back(atype);
     }
     
-    llvm::Type* return_value_type = types[function.get_return_type()->get_name()];
+    llvm::Type* return_value_type = types[function.get_return_type()->get_type_id()];
 
     llvm::FunctionType *FT =
 	llvm::FunctionType::get(return_value_type, llvm_arguments, false);
@@ -140,11 +143,7 @@ CodeGeneratorLLVMContext::create_type_composite(const Gyoji::mir::Type *composit
     }
     
     llvm::Type *llvm_type = llvm::StructType::create(*TheContext, members, compositetype->get_name());
-    types.insert(std::pair<std::string, llvm::Type*>(
-		     compositetype->get_name(),
-		     llvm_type
-		     )
-	);
+    types[compositetype->get_type_id()] = llvm_type;
     return llvm_type;
 }
 
@@ -156,11 +155,7 @@ CodeGeneratorLLVMContext::create_type_pointer(const Gyoji::mir::Type *pointertyp
 	llvm::PointerType::get(create_type(pointer_target),
 			       0 // Address space (default to 0?  This seems unclean, llvm!)
 	    );
-    types.insert(std::pair<std::string, llvm::Type*>(
-		     pointertype->get_name(),
-		     llvm_type
-		     )
-	);
+    types[pointertype->get_type_id()] = llvm_type;
     return llvm_type;
 }
 
@@ -174,11 +169,7 @@ CodeGeneratorLLVMContext::create_type_reference(const Gyoji::mir::Type *referenc
 			       0 // Address space (default to 0?  This seems unclean, llvm!)
 	    );
 
-    types.insert(std::pair<std::string, llvm::Type*>(
-		     referencetype->get_name(),
-		     llvm_type
-		     )
-	);
+    types[referencetype->get_type_id()] = llvm_type;
     return llvm_type;
 }
 
@@ -192,11 +183,7 @@ CodeGeneratorLLVMContext::create_type_array(const Gyoji::mir::Type *array_type)
 	    );
     llvm::Type *llvm_array_type = llvm::ArrayType::get(llvm_element_type, array_type->get_array_length());
 
-    types.insert(std::pair<std::string, llvm::Type*>(
-		     array_type->get_name(),
-		     llvm_array_type
-		     )
-	);
+    types[array_type->get_type_id()] = llvm_array_type;
     return llvm_array_type;
 }
 
@@ -228,11 +215,7 @@ CodeGeneratorLLVMContext::create_type_function_pointer(const Gyoji::mir::Type *f
 	llvm::PointerType::get(llvm_function_type,
 			       0 // Address space (default to 0?  This seems unclean, llvm!)
 	    );
-    types.insert(std::pair<std::string, llvm::Type*>(
-		     fptr_type->get_name(),
-		     llvm_fptr_type
-		     )
-	);
+    types[fptr_type->get_type_id()] = llvm_fptr_type;
     return llvm_fptr_type;
 }
 
@@ -293,11 +276,7 @@ CodeGeneratorLLVMContext::create_type_primitive(const Type *primitive)
 	exit(1);
     }
     
-    types.insert(std::pair<std::string, llvm::Type*>(
-		     primitive->get_name(),
-		     llvm_type
-		     )
-	);
+    types[primitive->get_type_id()] = llvm_type;
     return llvm_type;
 }
 
@@ -309,9 +288,9 @@ CodeGeneratorLLVMContext::create_type(const Type * type)
     // This is not a duplicate definition because the
     // type resolver will already have checked for that
     // case and reject any truly duplicate types.
-    const auto it = types.find(type->get_name());
-    if (it != types.end()) {
-	return it->second;
+    llvm::Type *existing = types[type->get_type_id()];
+    if (existing != nullptr) {
+	return existing;
     }
     
     if (type->is_primitive()) {
@@ -343,6 +322,7 @@ CodeGeneratorLLVMContext::create_type(const Type * type)
 void
 CodeGeneratorLLVMContext::create_types(const MIR & _mir)
 {
+    types.resize(_mir.get_types().get_type_count(), nullptr);
     for (const auto & type_el : _mir.get_types().get_types()) {
 	const Type * type = type_el.second.get();
 	
@@ -465,7 +445,7 @@ CodeGeneratorLLVMContext::generate_operation_widen_numeric(
 	return;
     }
     llvm::Value *value_a = tmp_values[a];
-    llvm::Type *llvm_cast_type = types[operation.get_cast_type()->get_name()];
+    llvm::Type *llvm_cast_type = types[operation.get_cast_type()->get_type_id()];
     if (atype->is_integer()) {
 	llvm::Value *sum = Builder->CreateIntCast(value_a, llvm_cast_type, atype->is_signed());
 	tmp_values.insert(std::pair(operation.get_result(), sum));
@@ -477,6 +457,33 @@ CodeGeneratorLLVMContext::generate_operation_widen_numeric(
 }
 
 // Indirect access
+void
+CodeGeneratorLLVMContext::generate_bounds_check(
+    llvm::Value *index_value,
+    size_t array_length
+    )
+{
+    // All of the failed checks in a function
+    // share one block that traps.
+    llvm::Function *TheFunction = Builder->GetInsertBlock()->getParent();
+    if (bounds_check_failed == nullptr) {
+	bounds_check_failed = llvm::BasicBlock::Create(*TheContext, "bounds.failed", TheFunction);
+	llvm::IRBuilder<> FailB(bounds_check_failed);
+	llvm::Function *trap = llvm::Intrinsic::getDeclaration(TheModule.get(), llvm::Intrinsic::trap);
+	FailB.CreateCall(trap);
+	FailB.CreateUnreachable();
+    }
+
+    // The index is unsigned, so a single comparison
+    // against the length covers both ends of the array.
+    llvm::BasicBlock *in_bounds = llvm::BasicBlock::Create(*TheContext, "bounds.ok", TheFunction);
+    llvm::Value *length_value = llvm::ConstantInt::get(index_value->getType(), array_length);
+    llvm::Value *is_in_bounds = Builder->CreateICmpULT(index_value, length_value);
+    llvm::MDBuilder weights(*TheContext);
+    Builder->CreateCondBr(is_in_bounds, in_bounds, bounds_check_failed, weights.createBranchWeights(1 << 20, 1));
+    Builder->SetInsertPoint(in_bounds);
+}
+
 void
 CodeGeneratorLLVMContext::generate_operation_array_index(
     const Gyoji::mir::Function & mir_function,
@@ -488,12 +495,16 @@ CodeGeneratorLLVMContext::generate_operation_array_index(
     
     const Gyoji::mir::Type *mir_array_type = mir_function.tmpvar_get(array_tmpvar);
     const Gyoji::mir::Type *mir_array_element_type = mir_array_type->get_pointer_target();
-    llvm::Type *llvm_array_type = types[mir_array_type->get_name()];
-    llvm::Type *llvm_array_element_type = types[mir_array_element_type->get_name()];
+    llvm::Type *llvm_array_type = types[mir_array_type->get_type_id()];
+    llvm::Type *llvm_array_element_type = types[mir_array_element_type->get_type_id()];
 
     llvm::Value *array_lvalue = tmp_lvalues[array_tmpvar];
     llvm::Value *index_value = tmp_values[index_tmpvar];
 
+    if (options.get_bounds_check() && !ranges->is_index_in_bounds(current_block_id, current_operation_index)) {
+	generate_bounds_check(index_value, mir_array_type->get_array_length());
+    }
+
     std::vector<llvm::Value *> indices;
     indices.push_back(llvm::ConstantInt::get(llvm::Type::getInt32Ty(*TheContext), 0L));
     indices.push_back(index_value);
@@ -512,7 +523,7 @@ CodeGeneratorLLVMContext::generate_operation_dot(
     size_t a = operation.get_a();
     // The type is a class
     const Gyoji::mir::Type *mir_class_type = mir_function.tmpvar_get(a);
-    llvm::Type *llvm_class_type = types[mir_class_type->get_name()];
+    llvm::Type *llvm_class_type = types[mir_class_type->get_type_id()];
 
     const std::string & member_name = operation.get_member_name();
     const TypeMember *member = mir_class_type->member_get(member_name);
@@ -520,7 +531,7 @@ CodeGeneratorLLVMContext::generate_operation_dot(
     
     llvm::Value *value_a = tmp_lvalues[a];
     llvm::Value *result = Builder->CreateConstInBoundsGEP2_32(llvm_class_type, value_a, 0, member_index);
-    llvm::Value *value = Builder->CreateLoad(types[member->get_type()->get_name()], result);
+    llvm::Value *value = Builder->CreateLoad(types[member->get_type()->get_type_id()], result);
     
     tmp_lvalues.insert(std::pair(operation.get_result(), result));
     tmp_values.insert(std::pair(operation.get_result(), value));
@@ -533,9 +544,15 @@ CodeGeneratorLLVMContext::generate_operation_local_variable(
     const Gyoji::mir::OperationLocalVariable & operation
     )
 {
-    llvm::Type *type = types[operation.get_var_type()->get_name()];
-    llvm::Value *variable_ptr = local_variables[operation.get_symbol_name()];
+    llvm::Type *type = types[operation.get_var_type()->get_type_id()];
+    llvm::Value *variable_ptr = local_variables[operation.get_declaration_id()];
     tmp_lvalues.insert(std::pair(operation.get_result(), variable_ptr));
+    // There's nothing to load if the variable is
+    // only about to be assigned, and the storage may
+    // not even be live yet.
+    if (!liveness->is_tmpvar_read(operation.get_result())) {
+	return;
+    }
     llvm::Value *value = Builder->CreateLoad(type, variable_ptr);
     tmp_values.insert(std::pair(operation.get_result(), value));
 }
@@ -545,9 +562,17 @@ CodeGeneratorLLVMContext::generate_operation_local_declare(
     const Gyoji::mir::OperationLocalDeclare & operation
     )
 {
-    llvm::Type *type = types[operation.get_variable_type()->get_name()];
-    llvm::Value *value = Builder->CreateAlloca(type, nullptr, operation.get_variable());
-    local_variables[operation.get_variable()] = value;
+    // Every local gets its slot in the entry block, even
+    // when it is declared inside of a loop, so the frame
+    // has a fixed size.  The lifetime markers from the
+    // liveness analysis let the back-end share slots
+    // between locals that are never live at the same time.
+    llvm::Function *TheFunction = Builder->GetInsertBlock()->getParent();
+    llvm::IRBuilder<> TmpB(&TheFunction->getEntryBlock(),
+			   TheFunction->getEntryBlock().begin());
+    llvm::Type *type = types[operation.get_variable_type()->get_type_id()];
+    llvm::Value *value = TmpB.CreateAlloca(type, nullptr, operation.get_variable());
+    local_variables[operation.get_declaration_id()] = value;
 }
 void
 CodeGeneratorLLVMContext::generate_operation_local_undeclare(
@@ -748,7 +773,7 @@ CodeGeneratorLLVMContext::generate_operation_dereference(
 	exit(1);
     }
     const Gyoji::mir::Type *mir_pointer_target = mir_pointer_type->get_pointer_target();
-    llvm::Type *llvm_pointer_target = types[mir_pointer_target->get_name()];
+    llvm::Type *llvm_pointer_target = types[mir_pointer_target->get_type_id()];
 
     llvm::Value *value_a = tmp_values[a];
     llvm::Value *result = Builder->CreateLoad(llvm_pointer_target, value_a);
@@ -835,7 +860,7 @@ CodeGeneratorLLVMContext::generate_operation_sizeof_type(
     const Gyoji::mir::OperationSizeofType & operation
     )
 {
-    llvm::Type *llvm_type = types[operation.get_type()->get_name()];
+    llvm::Type *llvm_type = types[operation.get_type()->get_type_id()];
     llvm::Value * result = llvm::ConstantInt::get(llvm::Type::getInt64Ty(*TheContext), TheModule->getDataLayout().getTypeAllocSize(llvm_type));
     tmp_values.insert(std::pair(operation.get_result(), result));
 }
@@ -867,7 +892,7 @@ CodeGeneratorLLVMContext::generate_operation_add(
     llvm::Value *value_b = tmp_values[b];
 
     if (atype->is_pointer() && btype->is_integer()) {
-	llvm::Type *llvm_array_element_type = types[atype->get_pointer_target()->get_name()];
+	llvm::Type *llvm_array_element_type = types[atype->get_pointer_target()->get_type_id()];
 	std::vector<llvm::Value *> indices;
 	indices.push_back(value_b);
 	llvm::Value *addressofelement = Builder->CreateInBoundsGEP(llvm_array_element_type, value_a, indices);
@@ -918,7 +943,7 @@ CodeGeneratorLLVMContext::generate_operation_subtract(
     llvm::Value *value_b = tmp_values[b];
 
     if (atype->is_pointer() && btype->is_integer()) {
-	llvm::Type *llvm_array_element_type = types[atype->get_pointer_target()->get_name()];
+	llvm::Type *llvm_array_element_type = types[atype->get_pointer_target()->get_type_id()];
 	std::vector<llvm::Value *> indices;
 	llvm::Value * negative_index = Builder->CreateNeg(value_b);
 	indices.push_back(negative_index);
@@ -1306,7 +1331,7 @@ CodeGeneratorLLVMContext::generate_operation_comparison(
     
     const Gyoji::mir::Type *atype = mir_function.tmpvar_get(a);
     const Gyoji::mir::Type *btype = mir_function.tmpvar_get(b);
-    if (atype->get_name() != btype->get_name()) {
+    if (atype->get_type_id() != btype->get_type_id()) {
 	compiler_context
 	    .get_errors()
 	    .add_simple_error(
@@ -1447,11 +1472,13 @@ CodeGeneratorLLVMContext::generate_operation_assign(
 	(atype->is_reference() && btype->is_pointer()) ||
 	(atype->is_pointer() && btype->is_reference())
 	) {
-	llvm::Value * a_value = tmp_values[operation.get_a()];
 	llvm::Value * a_lvalue = tmp_lvalues[operation.get_a()];
 	llvm::Value * b_value = tmp_values[operation.get_b()];
-	/* nobody wants the result */ Builder->CreateStore(b_value, a_lvalue);
-	tmp_values.insert(std::pair(operation.get_result(), a_value));
+	if (!operation.is_dead_store()) {
+	    /* nobody wants the result */ Builder->CreateStore(b_value, a_lvalue);
+	}
+	// The value of 'a' is what was just stored.
+	tmp_values.insert(std::pair(operation.get_result(), b_value));
 	tmp_lvalues.insert(std::pair(operation.get_result(), a_lvalue));
     }
     // Generate the code for assigning
@@ -1460,7 +1487,7 @@ CodeGeneratorLLVMContext::generate_operation_assign(
 	// Iterate the fields of each one and emit the load and store
 	// for each field based on the index of the field element.
 
-	llvm::Type *a_llvm_type = types[atype->get_name()];
+	llvm::Type *a_llvm_type = types[atype->get_type_id()];
 	
 	OperationAnonymousStructure * op = (OperationAnonymousStructure*)mir_function.tmpvar_get_operation(operation.get_b());
 	const std::map<std::string, size_t> & anonymous_fields = op->get_fields();
@@ -1486,7 +1513,9 @@ CodeGeneratorLLVMContext::generate_operation_assign(
     else {
 	llvm::Value * a_lvalue = tmp_lvalues[operation.get_a()];
 	llvm::Value * b_value = tmp_values[operation.get_b()];
-	/* nobody wants the result */ Builder->CreateStore(b_value, a_lvalue);
+	if (!operation.is_dead_store()) {
+	    /* nobody wants the result */ Builder->CreateStore(b_value, a_lvalue);
+	}
 	
 	// TODO: Assigning an lvalue results in an lvalue.
 	const auto & b_lvalue = tmp_lvalues.find(operation.get_b());
@@ -1542,16 +1571,46 @@ CodeGeneratorLLVMContext::generate_operation_return_void(
     return value;
 }
 
+void
+CodeGeneratorLLVMContext::generate_live_range_marker(
+    const Gyoji::mir::LiveRangeMarker & marker
+    )
+{
+    // Markers may refer to a variable declared in a
+    // block we haven't generated yet.  Leaving out a
+    // marker only makes the slot live for longer.
+    const auto & it = local_variables.find(liveness->get_variable_declaration_id(marker.get_variable()));
+    if (it == local_variables.end()) {
+	return;
+    }
+    if (marker.get_type() == LiveRangeMarker::START) {
+	Builder->CreateLifetimeStart(it->second);
+    }
+    else {
+	Builder->CreateLifetimeEnd(it->second);
+    }
+}
+
 llvm::Value *
 CodeGeneratorLLVMContext::generate_basic_block(
     const Gyoji::mir::Function & mir_function,
+    size_t blockid,
     const Gyoji::mir::BasicBlock & mir_block
     )
 {
     llvm::Value *return_value = nullptr;
 
-    for (const auto & operation_el : mir_block.get_operations()) {
-	const Operation & operation = *operation_el;
+    const std::vector<LiveRangeMarker> & markers = liveness->get_markers(blockid);
+    size_t next_marker = 0;
+    const std::vector<Gyoji::owned<Operation>> & operations = mir_block.get_operations();
+    current_block_id = blockid;
+    for (size_t operation_index = 0; operation_index < operations.size(); operation_index++) {
+	const Operation & operation = *operations.at(operation_index);
+	current_operation_index = operation_index;
+	while (next_marker < markers.size() && markers.at(next_marker).get_operation_index() == operation_index) {
+	    generate_live_range_marker(markers.at(next_marker));
+	    next_marker++;
+	}
 	switch (operation.get_type()) {
         // Global symbols
 	case Operation::OP_FUNCTION_CALL:
@@ -1699,6 +1758,11 @@ CodeGeneratorLLVMContext::generate_function(const Gyoji::mir::Function & functio
     blocks.clear();
     tmp_values.clear();
     tmp_lvalues.clear();
+    liveness = Gyoji::owned_new<Liveness>(function);
+    if (options.get_bounds_check()) {
+	ranges = Gyoji::owned_new<ValueRanges>(function, *liveness);
+    }
+    bounds_check_failed = nullptr;
     
     // Transfer ownership of the prototype to the FunctionProtos map, but keep a
     // reference to it for use below.
@@ -1718,7 +1782,7 @@ CodeGeneratorLLVMContext::generate_function(const Gyoji::mir::Function & functio
 	llvm::IRBuilder<> TmpB(&TheFunction->getEntryBlock(),
 			       TheFunction->getEntryBlock().begin());
 	llvm::AllocaInst *argument_alloca = TmpB.CreateAlloca(
-	    types[function_argument.get_type()->get_name()],
+	    types[function_argument.get_type()->get_type_id()],
 	    nullptr,
 	    function_argument.get_name()
 	    );
@@ -1726,42 +1790,67 @@ CodeGeneratorLLVMContext::generate_function(const Gyoji::mir::Function & functio
 	llvm::Argument *arg = TheFunction->getArg(i);
 	Builder->CreateStore(arg, argument_alloca);
 	
-	// Add arguments to variable symbol table.
-	local_variables[function_argument.get_name()] = argument_alloca;
+	// Add arguments to variable symbol table.  Their
+	// declaration ids are their positions.
+	local_variables[i] = argument_alloca;
 	i++;
     }
 
+    // Lay the blocks out in reverse post-order so that
+    // straight-line code falls through and each block
+    // follows the blocks that dominate it.  Anything
+    // left over is unreachable and would already have
+    // been reported in the analysis phase, but we
+    // keep it so that every jump has a target.
+    const CFGInfo & cfg = function.get_cfg_info();
+    std::vector<size_t> block_order(cfg.get_reverse_post_order());
     for (const auto & block_it : function.get_blocks()) {
+	if (!cfg.is_reachable(block_it.first)) {
+	    block_order.push_back(block_it.first);
+	}
+    }
+
+    for (size_t blockid : block_order) {
 	// Skip empty blocks.
-	if (block_it.second->size() == 0) {
+	if (function.get_basic_block(blockid).size() == 0) {
 	    continue;
 	}
 	
-	std::string block_name = std::string("BB") + std::to_string(block_it.first);
+	std::string block_name = std::string("BB") + std::to_string(blockid);
 	llvm::BasicBlock *BB = llvm::BasicBlock::Create(*TheContext, block_name, TheFunction);
-	blocks[block_it.first] = BB;
+	blocks[blockid] = BB;
     }
     // Jump from the entry block into the first 'real' block.
     Builder->CreateBr(blocks[0]);
     
-    for (const auto & block_it : function.get_blocks()) {
+    for (size_t blockid : block_order) {
 	// Skip empty blocks.
 	// We've already verified in the analysis phase
 	// that if a block is unreachable, it's also empty.
-	if (block_it.second->size() == 0) {
+	const BasicBlock & mir_block = function.get_basic_block(blockid);
+	if (mir_block.size() == 0) {
 	    continue;
 	}
 	
 	// Create a new basic block to start insertion into.
-	llvm::BasicBlock *BB = blocks[block_it.first];
+	llvm::BasicBlock *BB = blocks[blockid];
 	Builder->SetInsertPoint(BB);
-	generate_basic_block(function, *block_it.second);
+	generate_basic_block(function, blockid, mir_block);
     }
     
     // Validate the generated code, checking for consistency.
     verifyFunction(*TheFunction);
+
+    if (options.get_bounds_check() && options.get_verbose()) {
+	fprintf(stderr, "Bounds checks in %s: %ld kept, %ld eliminated\n",
+		function.get_name().c_str(),
+		ranges->get_checks_kept(),
+		ranges->get_checks_eliminated());
+    }
     
     local_variables.clear();
+    ranges.reset();
+    liveness.reset();
 }
 
 
@@ -22,8 +22,10 @@
 #include "llvm/IR/Function.h"
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/Instructions.h"
+#include "llvm/IR/Intrinsics.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/LegacyPassManager.h"
+#include "llvm/IR/MDBuilder.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/Type.h"
 #include "llvm/IR/Verifier.h"
@@ -35,6 +37,8 @@
 #include "llvm/Target/TargetOptions.h"
 #include "llvm/TargetParser/Host.h"
 
+#include <unordered_map>
+
 namespace Gyoji::codegen {
     class CodeGeneratorLLVMContext {
     public:
@@ -57,12 +61,25 @@ namespace Gyoji::codegen {
 	const Gyoji::mir::MIR & mir;
 	const CodeGeneratorLLVMOptions & options;
 	
-	std::map<std::string, llvm::Type *> types;
+	// LLVM types indexed by the MIR TypeId.
+	std::vector<llvm::Type *> types;
 	std::map<std::string, llvm::Value *> local_lvalues;
-	std::map<std::string, llvm::Value *> local_variables;
+	// Storage of each local variable by its declaration id.
+	std::unordered_map<size_t, llvm::Value *> local_variables;
 	std::map<size_t, llvm::BasicBlock *> blocks;
 	std::map<size_t, llvm::Value *> tmp_values;
 	std::map<size_t, llvm::Value *> tmp_lvalues;
+	// Live ranges of the locals of the function
+	// being generated.
+	Gyoji::owned<Gyoji::mir::Liveness> liveness;
+	// Array accesses that need no bounds check,
+	// only worked out when bounds checks are on.
+	Gyoji::owned<Gyoji::mir::ValueRanges> ranges;
+	// Where failed bounds checks go, created
+	// the first time a function needs one.
+	llvm::BasicBlock *bounds_check_failed;
+	size_t current_block_id;
+	size_t current_operation_index;
 	
 	void create_types(const Gyoji::mir::MIR & mir);
 	llvm::Type *create_type(const Gyoji::mir::Type * type);
@@ -247,8 +264,16 @@ namespace Gyoji::codegen {
 	    const Gyoji::mir::OperationReturnVoid & operation
 	    );
 	
+	void generate_bounds_check(
+	    llvm::Value *index_value,
+	    size_t array_length
+	    );
+	void generate_live_range_marker(
+	    const Gyoji::mir::LiveRangeMarker & marker
+	    );
 	llvm::Value *generate_basic_block(
 	    const Gyoji::mir::Function & function,
+	    size_t blockid,
 	    const Gyoji::mir::BasicBlock & mir_block
 	    );
 
@@ -40,12 +40,22 @@ namespace Gyoji::codegen {
 
 	bool get_verbose() const;
 	void set_verbose(bool _verbose);
+
+	/**
+	 * Whether to check the index of each access to
+	 * a fixed-size array against the length of the
+	 * array, trapping if it is out of bounds.  Checks
+	 * that ValueRanges proves can never fail are left out.
+	 */
+	bool get_bounds_check() const;
+	void set_bounds_check(bool _bounds_check);
 	
     private:
 	bool output_llvm_ir;
 	std::string output_filename;
 	int optimization_level;
 	bool verbose;
+	bool bounds_check;
     };
     
     /**
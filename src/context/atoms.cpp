@@ -0,0 +1,65 @@
+/* Copyright 2025 Jonathan S. Arney
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      https://github.com/jarney/gyoji/blob/master/LICENSE
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#include <gyoji-context.hpp>
+
+using namespace Gyoji::context;
+
+AtomTable::AtomTable()
+{
+    intern("");
+}
+
+AtomTable::~AtomTable()
+{}
+
+Atom
+AtomTable::intern(std::string_view str)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    const auto & it = atoms_by_string.find(str);
+    if (it != atoms_by_string.end()) {
+	return it->second;
+    }
+    Atom atom = (Atom)strings.size();
+    strings.push_back(Gyoji::owned_new<std::string>(str));
+    atoms_by_string.insert(std::pair(std::string_view(*strings.back()), atom));
+    return atom;
+}
+
+bool
+AtomTable::find(std::string_view str, Atom & atom) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    const auto & it = atoms_by_string.find(str);
+    if (it == atoms_by_string.end()) {
+	return false;
+    }
+    atom = it->second;
+    return true;
+}
+
+const std::string &
+AtomTable::get_string(Atom atom) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return *strings.at(atom);
+}
+
+size_t
+AtomTable::size() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return strings.size();
+}
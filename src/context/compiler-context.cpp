@@ -18,6 +18,7 @@ using namespace Gyoji::context;
 
 CompilerContext::CompilerContext(std::string _filename)
 {
+    atoms = Gyoji::owned_new<AtomTable>();
     token_stream = Gyoji::owned_new<TokenStream>();
     errors = Gyoji::owned_new<Errors>(*token_stream);
     filenames.push_back(_filename);
@@ -37,6 +38,10 @@ TokenStream &
 CompilerContext::get_token_stream() const
 { return *token_stream; }
 
+AtomTable &
+CompilerContext::get_atoms() const
+{ return *atoms; }
+
 const std::string &
 CompilerContext::get_filename() const
 { return filenames.back(); }
@@ -15,6 +15,7 @@
 #include <gyoji-context/errors.hpp>
 #include <gyoji-context/token-stream.hpp>
 #include <gyoji-misc/jstring.hpp>
+#include <algorithm>
 
 using namespace Gyoji::context;
 using namespace Gyoji::misc;
@@ -22,37 +23,111 @@ using namespace Gyoji::misc;
 //////////////////////////////////////////////////
 Errors::Errors(TokenStream & _token_stream)
     : token_stream(_token_stream)
+    , error_limit(0)
+    , errors_dropped(0)
 {}
 Errors::~Errors()
 {}
 
+// Orders errors by the location of their first message.
+// Errors without any messages have no location, so they
+// come before all of the others.  Errors at the same
+// location are left for a stable sort to keep in order.
+static bool
+error_location_less(const Error & a, const Error & b)
+{
+    if (a.size() == 0 || b.size() == 0) {
+	return a.size() < b.size();
+    }
+    const SourceReference & a_ref = a.get(0).get_source_ref();
+    const SourceReference & b_ref = b.get(0).get_source_ref();
+    if (a_ref.get_filename() != b_ref.get_filename()) {
+	return a_ref.get_filename() < b_ref.get_filename();
+    }
+    if (a_ref.get_line() != b_ref.get_line()) {
+	return a_ref.get_line() < b_ref.get_line();
+    }
+    return a_ref.get_column() < b_ref.get_column();
+}
+
+static bool
+owned_error_location_less(const Gyoji::owned<Error> & a, const Gyoji::owned<Error> & b)
+{ return error_location_less(*a, *b); }
+
+static bool
+error_pointer_location_less(const Error *a, const Error *b)
+{ return error_location_less(*a, *b); }
+
 void
 Errors::print() const
 {
-    // TODO: Sort errors in ascending order by
-    // source reference line number, not by
-    // order of occurrence.
+    std::vector<const Error*> sorted;
     for (const auto & error : errors) {
-	error->print();
+	sorted.push_back(error.get());
+    }
+    std::stable_sort(sorted.begin(), sorted.end(), error_pointer_location_less);
+    for (const Error *error : sorted) {
+	error->print(token_stream);
+    }
+    if (errors_dropped != 0) {
+	fprintf(stderr, "Stopped after %ld errors, %ld more not shown.\n", error_limit, errors_dropped);
     }
 }
 
 void
 Errors::add_error(Gyoji::owned<Error> error)
 {
-    // TODO: Iterate the messages and resolve the context.
-    for (const auto & message : error->get_messages()) {
-	message->add_context(
-	    token_stream.context(
-		message->get_source_ref().get_line()-2,
-		message->get_source_ref().get_line()+1
-		)
-	    );
-	
+    std::lock_guard<std::mutex> lock(mutex);
+    if (error_limit != 0 && errors.size() >= error_limit) {
+	errors_dropped++;
+	return;
     }
     errors.push_back(std::move(error));
 }
 
+void
+Errors::merge(std::vector<Gyoji::owned<Errors>> & buffers)
+{
+    // Sorting the errors in buffer order keeps
+    // errors at the same location in buffer order.
+    std::vector<Gyoji::owned<Error>> merged;
+    size_t dropped = 0;
+    for (const auto & buffer : buffers) {
+	for (auto & error : buffer->errors) {
+	    merged.push_back(std::move(error));
+	}
+	buffer->errors.clear();
+	dropped += buffer->errors_dropped;
+	buffer->errors_dropped = 0;
+    }
+    std::stable_sort(merged.begin(), merged.end(), owned_error_location_less);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    errors_dropped += dropped;
+    for (auto & error : merged) {
+	if (error_limit != 0 && errors.size() >= error_limit) {
+	    errors_dropped++;
+	    continue;
+	}
+	errors.push_back(std::move(error));
+    }
+}
+
+void
+Errors::set_error_limit(size_t _error_limit)
+{ error_limit = _error_limit; }
+
+size_t
+Errors::get_error_limit() const
+{ return error_limit; }
+
+bool
+Errors::is_error_limit_reached() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return error_limit != 0 && errors.size() >= error_limit;
+}
+
 size_t
 Errors::size() const
 {
@@ -78,12 +153,12 @@ Error::Error(std::string _error_title)
 Error::~Error()
 {}
 void
-Error::print()
+Error::print(const TokenStream & token_stream) const
 {
     std::string filename = messages.size() > 0 ? messages.back()->get_source_ref().get_filename() : std::string("unknown filename");
     fprintf(stderr, "%s: Error: %s\n", filename.c_str(), error_title.c_str());
     for (const Gyoji::owned<ErrorMessage> & msg : messages) {
-	msg->print();
+	msg->print(token_stream);
     }
 }
 
@@ -129,18 +204,13 @@ ErrorMessage::ErrorMessage(
     const SourceReference & _src_ref,
     std::string _errormsg
     )
-    : context()
-    , src_ref(_src_ref)
+    : src_ref(_src_ref)
     , errormsg(_errormsg)
 {}
 
 ErrorMessage::~ErrorMessage()
 {}
 
-void
-ErrorMessage::add_context(const std::vector<std::pair<size_t, std::string>> & _context)
-{ context = _context; }
-
 const SourceReference & 
 ErrorMessage::get_source_ref() const
 { return src_ref; }
@@ -178,11 +248,23 @@ static void draw_arrow(size_t column, size_t length)
 }
 
 void
-ErrorMessage::print()
+ErrorMessage::print(const TokenStream & token_stream) const
 {
     size_t line = src_ref.get_line();
     size_t column = src_ref.get_column();
     size_t length = src_ref.get_length();
+    std::vector<std::pair<size_t, std::string>> context = token_stream.context(src_ref, 2, 1);
+    bool has_line = false;
+    for (const std::pair<size_t, std::string> & linepair : context) {
+	has_line = has_line || linepair.first == line;
+    }
+    if (!has_line) {
+	// There is no text for the line, for example when
+	// the error is found before the file is read, so
+	// only the location can be given.
+	fprintf(stderr, "%s:%ld: %s\n", src_ref.get_filename().c_str(), line, errormsg.c_str());
+	return;
+    }
     for (const std::pair<size_t, std::string> & linepair : context) {
 	fprintf(stderr, "%4ld: %s", linepair.first, linepair.second.c_str());
 	if (linepair.second.size() > 0) {
@@ -195,12 +277,12 @@ ErrorMessage::print()
 	    if (column < 40) {
 		std::string wrapped = wrap_text(80-column, std::string("|--") + errormsg);
 		std::string indented = indent_text(column+6, wrapped);
-		printf("%s\n", indented.c_str());
+		fprintf(stderr, "%s\n", indented.c_str());
 	    }
 	    else {
 		std::string wrapped = wrap_text(column, std::string("|--") + errormsg);
 		std::string indented = indent_text(6, wrapped);
-		printf("%s\n", indented.c_str());
+		fprintf(stderr, "%s\n", indented.c_str());
 	    }
 	}
     }
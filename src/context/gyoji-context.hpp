@@ -17,6 +17,7 @@
 #include <gyoji-context/errors.hpp>
 #include <gyoji-context/token-stream.hpp>
 #include <gyoji-context/source-reference.hpp>
+#include <gyoji-context/atoms.hpp>
 
 /**
  * @brief The context namespace deals with objects that
@@ -97,7 +98,17 @@ namespace Gyoji::context {
 	 * location where they were generated from.
 	 */
 	void add_filename(const std::string & _filename);
+
+	/**
+	 * This returns the table of interned identifiers
+	 * shared by every phase of the compilation.  Identifiers
+	 * are interned once as they are read and later phases
+	 * compare and hash the resulting atoms rather than
+	 * the strings themselves.
+	 */
+	AtomTable & get_atoms() const;
     private:
+	Gyoji::owned<AtomTable> atoms;
 	Gyoji::owned<Errors> errors;
 	Gyoji::owned<TokenStream> token_stream;
 	std::vector<std::string> filenames;
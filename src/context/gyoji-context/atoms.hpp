@@ -0,0 +1,114 @@
+/* Copyright 2025 Jonathan S. Arney
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      https://github.com/jarney/gyoji/blob/master/LICENSE
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#pragma once
+
+#include <gyoji-misc/pointers.hpp>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <mutex>
+#include <stdint.h>
+
+namespace Gyoji::context {
+    /**
+     * @brief Interned identifier.
+     *
+     * @details
+     * An atom is a small integer standing in for
+     * an identifier string.  The same string always
+     * interns to the same atom within an AtomTable, so
+     * identifiers can be compared and hashed as integers
+     * and the text is stored exactly once no matter how
+     * many places refer to it.
+     */
+    typedef uint32_t Atom;
+
+    /**
+     * @brief Compiler-wide string interner.
+     *
+     * @details
+     * This table hands out an Atom for each distinct
+     * identifier seen during compilation.  It is owned
+     * by the CompilerContext so that every phase, from the
+     * lexer through code-generation, shares the same atoms.
+     *
+     * Strings are never removed once interned, so the
+     * references returned by get_string() remain valid
+     * for the life of the table.  The table may be used
+     * from several threads at once, for example while
+     * functions are lowered in parallel.
+     */
+    class AtomTable {
+    public:
+	/**
+	 * @brief Create an empty table.
+	 *
+	 * @details
+	 * The empty string is always interned first,
+	 * so it is given atom zero.
+	 */
+	AtomTable();
+	/**
+	 * @brief Move along, nothing to see here.
+	 *
+	 * @details
+	 * Move along, nothing to see here.
+	 */
+	~AtomTable();
+
+	/**
+	 * @brief Intern a string.
+	 *
+	 * @details
+	 * Returns the atom for the given string, adding
+	 * it to the table if this is the first time
+	 * it has been seen.
+	 */
+	Atom intern(std::string_view str);
+
+	/**
+	 * @brief Look up a string without interning it.
+	 *
+	 * @details
+	 * Returns true and sets 'atom' if the string has
+	 * already been interned.  Returns false otherwise.
+	 * This is useful for lookups, since a string that was
+	 * never interned can't be the name of anything.
+	 */
+	bool find(std::string_view str, Atom & atom) const;
+
+	/**
+	 * @brief Text of an atom.
+	 *
+	 * @details
+	 * Returns the string that was interned to
+	 * produce this atom.
+	 */
+	const std::string & get_string(Atom atom) const;
+
+	/**
+	 * @brief Number of distinct strings interned.
+	 */
+	size_t size() const;
+    private:
+	// Each string is allocated separately so that
+	// it never moves and the views used as keys
+	// in atoms_by_string stay valid.
+	std::vector<Gyoji::owned<std::string>> strings;
+	std::unordered_map<std::string_view, Atom> atoms_by_string;
+	mutable std::mutex mutex;
+    };
+};
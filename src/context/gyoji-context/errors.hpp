@@ -18,6 +18,7 @@
 #include <vector>
 #include <map>
 #include <memory>
+#include <mutex>
 
 #include <gyoji-misc/pointers.hpp>
 #include <gyoji-context/source-reference.hpp>
@@ -27,6 +28,7 @@ namespace Gyoji::context {
     class Errors;
     class Error;
     class ErrorMessage;
+    class TokenStream;
     
     /**
      * @brief Message about a specific location in the code.
@@ -45,9 +47,12 @@ namespace Gyoji::context {
 	~ErrorMessage();
 	/**
 	 * Prints the specific error along with the associated
-	 * line of code and surrounding context.
+	 * line of code and surrounding context.  The context
+	 * is read from the token stream only when printing,
+	 * since most errors that are reported are never
+	 * printed at all.
 	 */
-	void print();
+	void print(const TokenStream & token_stream) const;
 	/**
 	 * Returns a SourceReference pointing to the specific
 	 * location where the error occurred.
@@ -57,18 +62,11 @@ namespace Gyoji::context {
 	 * Returns the specific message string for this message.
 	 */
 	const std::string & get_message() const;
-	/**
-	 * This is used to inject the surrounding lines of code
-	 * where the message occurred so that errors can be easily seen
-	 * in the surrounding context.
-	 */
-	void add_context(const std::vector<std::pair<size_t, std::string>> & _context);
 	/**
 	 * Returns the line number where the error message occurred.
 	 */
 	size_t get_line() const;
     private:
-	std::vector<std::pair<size_t, std::string>> context;
 	SourceReference src_ref;
 	std::string errormsg;
     };
@@ -150,7 +148,7 @@ namespace Gyoji::context {
 	 * and a little marker indicating the specific location
 	 * in that line where the error occurred.
 	 */
-	void print();
+	void print(const TokenStream & token_stream) const;
 	/**
 	 * This returns the number of messages associated
 	 * with this error.
@@ -168,8 +166,6 @@ namespace Gyoji::context {
 	std::vector<Gyoji::owned<ErrorMessage>> messages;
 	std::string error_title;
     };
-    
-    class TokenStream;
 
     /**
      * @brief Container for errors reported.
@@ -180,6 +176,13 @@ namespace Gyoji::context {
      * or code-generation layers.  Each error is associated with
      * one oe more messages with each message referencing the
      * specific SourceReference where the error occurred.
+     *
+     * Adding errors is safe to do from more than one
+     * thread, but work that runs in parallel should
+     * normally report into an Errors buffer of its own and
+     * have the buffers combined with merge() afterward so
+     * that the order of the errors does not depend on
+     * how the threads happened to be scheduled.
      */
     class Errors {
     public:
@@ -210,12 +213,42 @@ namespace Gyoji::context {
 	    std::string _error_title,
 	    std::string _error_message
 	    );
+	/**
+	 * Moves all of the errors out of each of the
+	 * buffers and adds them to this list.  The errors
+	 * are ordered by the source location of their first
+	 * message.  Errors at the same location keep the order
+	 * of the buffers they came from and, within a buffer,
+	 * the order they were reported in.  The buffers are
+	 * left empty.
+	 */
+	void merge(std::vector<Gyoji::owned<Errors>> & buffers);
 	/**
 	 * This is the main mechanism where errors are
 	 * reported in a human-readable way, pointing out the
-	 * context and specific location of the error.
+	 * context and specific location of the error.  The
+	 * errors are printed in order of the source location
+	 * of their first message rather than the order they
+	 * were reported in.
 	 */
 	void print() const;
+	/**
+	 * @brief Limits the number of errors kept.
+	 *
+	 * @details
+	 * Once this many errors have been reported, any more
+	 * are dropped and is_error_limit_reached() tells the
+	 * compiler to stop rather than go on to report errors
+	 * that mostly follow from the first ones.  Zero, the
+	 * default, means there is no limit.
+	 */
+	void set_error_limit(size_t _error_limit);
+	size_t get_error_limit() const;
+	/**
+	 * Returns true if as many errors as the limit
+	 * allows have been reported.
+	 */
+	bool is_error_limit_reached() const;
 	/**
 	 * This returns the number of errors reported so far.
 	 * We can remove this once get_errors_of_type() works.
@@ -248,6 +281,9 @@ namespace Gyoji::context {
 	std::vector<Gyoji::owned<Error>> errors;
 	std::map<ErrorId, std::vector<Error*>> errors_by_id;
 	const TokenStream & token_stream;
+	size_t error_limit;
+	size_t errors_dropped;
+	mutable std::mutex mutex;
     };
     
 };
@@ -15,8 +15,129 @@
 #pragma once
 
 #include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <stdint.h>
+#include <gyoji-misc/pointers.hpp>
 
 namespace Gyoji::context {
+    /**
+     * @brief A point in the source, as a single number.
+     *
+     * @details
+     * Every buffer of source text read by the compiler is
+     * given a range of locations in the SourceTable, so a
+     * location is just the position of a character counting
+     * across all of them.  Zero is never handed out, so it
+     * can be used to mean "nowhere".
+     */
+    typedef uint32_t SourceLocation;
+
+    class SourceBuffer;
+
+    /**
+     * @brief Maps source locations back to files, lines and columns.
+     *
+     * @details
+     * There is a single table for the whole process so that a
+     * SourceLocation means the same thing to every part of the
+     * compiler and can be handed between threads without any
+     * care.  Buffers are only ever added, never removed, so a
+     * location stays valid for as long as the process runs.
+     *
+     * The line and column of a location are only worked out
+     * when asked for, which is rare (printing an error or a
+     * debug dump), so the table is kept small rather than fast
+     * and every method holds a lock.
+     *
+     * The lexer tells the table about line markers such as
+     * those the preprocessor leaves behind (# 12 "foo.j"), so
+     * the line and file reported for a location are the ones
+     * the marker names rather than the place in the buffer.
+     * The physical line is still kept for the things that
+     * need to look at the text itself.
+     */
+    class SourceTable {
+    public:
+	/**
+	 * Returns the table shared by the whole process.
+	 */
+	static SourceTable & get_instance();
+
+	/**
+	 * Reserves a location for each character of a buffer
+	 * of the given size (and one more for the end of it)
+	 * and returns the location of its first character.
+	 */
+	SourceLocation add_buffer(const std::string & _filename, size_t _size);
+
+	/**
+	 * Makes up a location for the given file, line
+	 * and column when there is no text to point into.
+	 */
+	SourceLocation add_location(const std::string & _filename, size_t _line, size_t _column);
+
+	/**
+	 * Records that the given (physical) line of the buffer
+	 * starts at the given offset.  Lines must be recorded
+	 * in order and any lines skipped are taken to be empty.
+	 */
+	void add_line_start(SourceLocation _buffer, size_t _line, size_t _offset);
+
+	/**
+	 * Records that the line starting at the given offset of
+	 * the buffer is the given line of the given file and that
+	 * the lines after it follow on from there.
+	 */
+	void add_line_marker(SourceLocation _buffer, size_t _offset, const std::string & _filename, size_t _line);
+
+	const std::string & get_filename(SourceLocation _location) const;
+	size_t get_line(SourceLocation _location) const;
+	size_t get_column(SourceLocation _location) const;
+
+	/**
+	 * Returns the line of the location counting from the
+	 * start of its buffer, paying no heed to line markers.
+	 */
+	size_t get_physical_line(SourceLocation _location) const;
+
+	/**
+	 * Returns the number of lines recorded for the buffer.
+	 */
+	size_t get_line_count(SourceLocation _buffer) const;
+
+	/**
+	 * Returns the offset in the buffer at which the
+	 * given physical line of the buffer starts.
+	 */
+	size_t get_line_offset(SourceLocation _buffer, size_t _line) const;
+
+	/**
+	 * Returns an estimate of the number of bytes
+	 * of memory held by the table.
+	 */
+	size_t get_footprint() const;
+    private:
+	SourceTable();
+	~SourceTable();
+
+	size_t get_filename_id(const std::string & _filename);
+	const SourceBuffer *find_buffer(SourceLocation _location) const;
+	SourceBuffer *get_buffer(SourceLocation _buffer);
+
+	mutable std::mutex mutex;
+	SourceLocation next_location;
+	// Kept in order of their base, so the buffer
+	// holding a location is found by a binary search.
+	std::vector<Gyoji::owned<SourceBuffer>> buffers;
+	// A deque never moves what it holds, so references
+	// to these stay valid as more are added.
+	std::deque<std::string> filenames;
+	std::map<std::string, size_t> filename_ids;
+    };
+
     /**
      * @brief References a location in the source-file
      *
@@ -26,9 +147,21 @@ namespace Gyoji::context {
      * of the code so that the error handler has
      * a way to bring the source code to the context
      * of an error message.
+     *
+     * It holds only a SourceLocation and the length of
+     * what it refers to, so it is cheap to copy and is held
+     * by value.  The file, line and column are looked up in
+     * the SourceTable when they are asked for.
      */
     class SourceReference {
     public:
+	SourceReference(SourceLocation _location, size_t _length);
+	/**
+	 * Makes up a reference to the given line and column
+	 * of a file (see SourceTable::add_location).  This is
+	 * meant for things that have no text to point into,
+	 * since each one takes up a little of the table for good.
+	 */
 	SourceReference(
 	    const std::string & _filename,
 	    size_t _line,
@@ -36,18 +169,23 @@ namespace Gyoji::context {
 	    size_t _length
 	    );
 	SourceReference(const SourceReference & _other);
+	SourceReference & operator=(const SourceReference & _other);
 	/**
 	 * Move along, nothing to see here.
 	 */
 	~SourceReference();
+	SourceLocation get_location() const;
 	const std::string & get_filename() const;
 	size_t get_line() const;
 	size_t get_column() const;
 	size_t get_length() const;
+	/**
+	 * Returns the line counting from the start of the
+	 * buffer the location is in (see SourceTable).
+	 */
+	size_t get_physical_line() const;
     private:
-	const std::string & filename;
-	size_t line;
-	size_t column;
-	size_t length;
+	SourceLocation location;
+	uint32_t length;
     };
 };
@@ -14,10 +14,13 @@
  */
 #pragma once
 #include <string>
+#include <string_view>
 #include <vector>
-#include <map>
+#include <deque>
 #include <algorithm>
+#include <stdint.h>
 #include <gyoji-misc/pointers.hpp>
+#include <gyoji-misc/input-source.hpp>
 #include <gyoji-context/source-reference.hpp>
 
 namespace Gyoji::context {
@@ -51,23 +54,19 @@ namespace Gyoji::context {
      * have a lifetime at least as long as the error reporting
      * system because the errors hold references to the tokens
      * and their source references.
+     *
+     * The token itself is only a handle naming an entry
+     * in the token stream, which holds the data of all of
+     * the tokens (see TokenStream), so it is cheap to copy.
      */
     class Token {
     public:
 	/**
-	 * Creates a new token of the given type
-	 * and value with the line number and column
-	 * number where it was found in the input
-	 * stream.
+	 * Creates a handle for the token at the
+	 * given index of the token stream.
 	 */
-	Token(
-	    TokenID _typestr,
-	    std::string _value,
-	    const std::string & _filename,
-	    size_t _line,
-	    size_t _column,
-	    size_t _length
-	    );
+	Token(TokenStream & _token_stream, size_t _index);
+	Token(const Token & _other);
 	/**
 	 * Destructor, nothing fancy.
 	 */
@@ -81,26 +80,23 @@ namespace Gyoji::context {
 	 * the input and bypassing the grammar
 	 * entirely.
 	 */
-	const TokenID & get_type() const;
+	TokenID get_type() const;
 	/**
 	 * This is the literal value that was
 	 * found in the input stream and matched
-	 * one of the lexical rules.
+	 * one of the lexical rules.  It refers to
+	 * text owned by the token stream.
 	 */
-	const std::string & get_value() const;
+	std::string_view get_value() const;
 
-	const SourceReference & get_source_ref() const;
-	
-	friend TokenStream;
-    private:
 	/**
-	 * This is used internally by the lexer
-	 * to append data to a token.
+	 * Returns the place in the source-file where
+	 * the token was found.
 	 */
-	void append(std::string & value);
-	TokenID typestr;
-	std::string value;
-	SourceReference src_ref;
+	SourceReference get_source_ref() const;
+    private:
+	TokenStream & token_stream;
+	size_t index;
     };
 
     /**
@@ -116,6 +112,20 @@ namespace Gyoji::context {
      * that matched the token.  The token stream can be used to exactly reproduce
      * the input and is useful in constructing structured error messages where
      * it is useful to have some context of the original source file.
+     *
+     * The tokens are kept as parallel arrays rather than as
+     * one object each: the type of each token and the offset
+     * and length of its value in the source text (see set_text).
+     * The text is given a range of locations in the SourceTable,
+     * so the source reference of a token is simply the location
+     * of the text plus the offset of the token.  The line starts
+     * are kept in the SourceTable too, so a line of source is
+     * simply a slice of the text.  Values that don't lie in the
+     * text are copied and given a location of their own.
+     *
+     * Source references may be asked for from several threads
+     * at once, since functions are lowered in parallel, but
+     * tokens must only be added from one thread.
      */
     class TokenStream {
     public:
@@ -129,11 +139,72 @@ namespace Gyoji::context {
 	~TokenStream();
 	
 	/**
-	 * This returns a list of all of the tokens found during
-	 * the parse.  This is returned as an immutable list
-	 * of pointers owned by the token stream.
+	 * Returns the number of tokens found
+	 * during the parse.
+	 */
+	size_t get_token_count() const;
+
+	/**
+	 * Returns the token at the given index, counting
+	 * from the start of the input.
+	 */
+	Token get_token(size_t index);
+
+	/**
+	 * Returns the type of the token at the given index.
+	 */
+	TokenID get_token_type(size_t index) const;
+
+	/**
+	 * Returns the value of the token at the given index.
+	 */
+	std::string_view get_token_value(size_t index) const;
+
+	/**
+	 * Returns the place in the source-file where
+	 * the token at the given index was found.
+	 */
+	SourceReference get_token_source_ref(size_t index) const;
+
+	/**
+	 * @brief Hands the source text over to the token stream.
+	 *
+	 * @details
+	 * The lexer scans this text in place, so tokens taken
+	 * from it refer to it directly instead of holding a copy
+	 * of their value.  The token stream keeps the text
+	 * for as long as the tokens need it.  The text is
+	 * added to the SourceTable as a buffer read from
+	 * the given file.
+	 */
+	void set_text(const std::string & _filename, Gyoji::owned<Gyoji::misc::InputBuffer> _text);
+	/**
+	 * @brief Lets go of the tokens, keeping only the text.
+	 *
+	 * @details
+	 * Once the syntax tree has been lowered, nothing needs the
+	 * tokens themselves any more, only the text and its lines
+	 * to give context to error messages.  This frees the memory
+	 * held by the tokens so that it is not held through the
+	 * rest of the compilation.  Source references already made
+	 * stay valid, since they are decoded by the SourceTable.
+	 * The token stream is left empty and no tokens may be
+	 * added to it afterwards.
+	 */
+	void release_tokens();
+
+	/**
+	 * Returns the text given to set_text(), or nullptr if
+	 * there is none.  The parser scans parts of it again
+	 * when it parses function bodies it skipped earlier.
+	 */
+	Gyoji::misc::InputBuffer *get_text();
+
+	/**
+	 * Returns the location of the start of the text
+	 * in the SourceTable, or zero if there is none.
 	 */
-	const std::vector<Gyoji::owned<Token>> & get_tokens() const;
+	SourceLocation get_text_location() const;
 	
 	/**
 	 * Returns the most recent source reference found.
@@ -141,12 +212,13 @@ namespace Gyoji::context {
 	 * be the first token in the file and we will return
 	 * the most recent one.
 	 */
-	const SourceReference & get_current_source_ref() const;
+	SourceReference get_current_source_ref() const;
 	
 	/**
-	 * This returns the exact text of a single line of source-data.
-	 * This is useful in constructing the context for structured
-	 * error messages.
+	 * This returns the exact text of a single line of source-data,
+	 * counting lines from the start of the text and paying no heed
+	 * to line markers.  This is useful in constructing the context
+	 * for structured error messages.
 	 */
 	std::string get_line(size_t _line) const;
 	
@@ -155,10 +227,12 @@ namespace Gyoji::context {
 	 * matches a rule for a token.  It sets the token type (match rule)
 	 * as well as that data that matched the token and the source
 	 * line number and column where the token was found.
+	 * If the value is not part of the text given to
+	 * set_text, the token stream keeps a copy of it.
 	 */
-	const Token & add_token(
+	Token add_token(
 	    TokenID _typestr,
-	    std::string _value,
+	    std::string_view _value,
 	    const std::string & _filename,
 	    size_t _line,
 	    size_t _column
@@ -166,13 +240,20 @@ namespace Gyoji::context {
 	
 	/**
 	 * This returns a list of lines from the source file
-	 * starting with line_start and ending with line_end (inclusive).
+	 * around the line of the given source reference.
 	 * This is useful in providing context to structured errors.
-	 * @param line_start Start line number to retrieve.
-	 * @param line_end Last line number to retrieve.
+	 * Lines that nothing is known about are left out, so
+	 * the list is empty when there is no text for the file.
+	 * @param _src_ref Reference to the line to retrieve.
+	 * @param _before Number of lines to retrieve before it.
+	 * @param _after Number of lines to retrieve after it.
 	 * @return This returns a pair of line number and line text for the matched lines from the source file.
 	 */
-	std::vector<std::pair<size_t, std::string>> context(size_t line_start, size_t line_end) const;
+	std::vector<std::pair<size_t, std::string>> context(
+	    const SourceReference & _src_ref,
+	    size_t _before,
+	    size_t _after
+	    ) const;
 	
 	/**
 	 * This method is used to append a value to the
@@ -182,15 +263,71 @@ namespace Gyoji::context {
 	 * multi-line comments where a single rule may not
 	 * match the entire token, so it is broken up
 	 * into several match rules such as C-style
-	 * multi-line comments.
+	 * multi-line comments.  When the value follows the
+	 * token directly in the source text, the token is
+	 * simply extended to cover it.
 	 */
-	void append_token(std::string _value);
+	void append_token(std::string_view _value);
+
+	/**
+	 * @brief Records where a line starts in the text.
+	 *
+	 * @details
+	 * The start of each line is normally taken from the first
+	 * token found on it, but the lexer may leave out whitespace
+	 * and comments (see LexContext), so it tells the token
+	 * stream directly where each new line begins.  This has
+	 * no effect if the position is not in the text.
+	 */
+	void add_line_start(size_t _line, const char *_start);
+
+	/**
+	 * @brief Records a line marker found in the text.
+	 *
+	 * @details
+	 * The line starting at the given position of the text,
+	 * and those after it, are said to come from the given
+	 * line of the given file (see SourceTable).  This has
+	 * no effect if the position is not in the text.
+	 */
+	void add_line_marker(const char *_start, const std::string & _filename, size_t _line);
 
 	static const SourceReference & get_zero_source_ref();
 
+	/**
+	 * Returns an estimate of the number of bytes of
+	 * memory held by the tokens and the line index.
+	 * This is used to report the memory used by the
+	 * compiler and does not account for the overhead
+	 * of the memory allocator.
+	 */
+	size_t get_footprint() const;
+
     private:
-	
-	std::vector<Gyoji::owned<Token>> tokens;
-	std::map<size_t, std::vector<Token*>> tokens_by_lineno;
+	bool is_text(std::string_view _value) const;
+	bool is_copied(size_t index) const;
+	size_t get_length(size_t index) const;
+	SourceLocation get_token_location(size_t index) const;
+	void copy_token(size_t index, std::string _value);
+
+	Gyoji::owned<Gyoji::misc::InputBuffer> text;
+	SourceLocation text_location;
+	// The number of lines of the text whose
+	// start is known to the SourceTable.
+	size_t text_lines;
+	// The end of the furthest token read from the text.
+	uint32_t text_end;
+
+	// One entry for each token.  The offset is the
+	// position of the value in the text, or for a
+	// copied value, the index of the copy.
+	std::vector<uint16_t> types;
+	std::vector<uint32_t> offsets;
+	std::vector<uint32_t> lengths;
+
+	// A deque never moves what it holds, so string
+	// views of these stay valid as more are added.
+	std::deque<std::string> copies;
+	std::vector<SourceLocation> copy_locations;
     };
 };
@@ -14,10 +14,326 @@
  */
 
 #include <gyoji-context.hpp>
+#include <algorithm>
 
 using namespace Gyoji::context;
 
+namespace Gyoji::context {
+    /**
+     * @brief A buffer of source known to the SourceTable.
+     *
+     * @details
+     * This holds what is needed to turn a location inside of
+     * the buffer back into a file, line and column: the offset
+     * at which each line of the buffer starts and the line
+     * markers found in it.  A buffer with no text behind it
+     * is made for each location made up from a line and
+     * column directly, so it has a single location and
+     * a fixed line and column.
+     */
+    class SourceBuffer {
+    public:
+	SourceBuffer(
+	    SourceLocation _base,
+	    size_t _size,
+	    size_t _filename_id,
+	    bool _has_text,
+	    size_t _line,
+	    size_t _column
+	    );
+	/**
+	 * Move along, nothing to see here.
+	 */
+	~SourceBuffer();
 
+	SourceLocation base;
+	uint32_t size;
+	uint32_t filename_id;
+	bool has_text;
+	uint32_t line;
+	uint32_t column;
+
+	// Offset in the buffer at which each line starts,
+	// so line N starts at line_starts[N-1].
+	std::vector<uint32_t> line_starts;
+
+	// Offsets in the buffer from which lines are said
+	// to come from another file and line, in order.
+	std::vector<uint32_t> marker_offsets;
+	std::vector<uint32_t> marker_filename_ids;
+	std::vector<uint32_t> marker_lines;
+    };
+};
+
+// The file reported for a location
+// that is not in any buffer.
+static const std::string internal_filename("internal");
+
+static size_t
+buffer_physical_line(const SourceBuffer & buffer, size_t offset)
+{
+    if (!buffer.has_text) {
+	return buffer.line;
+    }
+    const auto & it = std::upper_bound(buffer.line_starts.begin(), buffer.line_starts.end(), offset);
+    size_t line = (size_t)(it - buffer.line_starts.begin());
+    return line == 0 ? 1 : line;
+}
+
+static size_t
+buffer_column(const SourceBuffer & buffer, size_t offset)
+{
+    if (!buffer.has_text) {
+	return buffer.column;
+    }
+    if (buffer.line_starts.empty()) {
+	return offset;
+    }
+    return offset - buffer.line_starts.at(buffer_physical_line(buffer, offset) - 1);
+}
+
+// Returns the index of the last line marker at or
+// before the offset, counting from one, or zero if
+// the offset is not after any marker.
+static size_t
+buffer_marker(const SourceBuffer & buffer, size_t offset)
+{
+    const auto & it = std::upper_bound(buffer.marker_offsets.begin(), buffer.marker_offsets.end(), offset);
+    return (size_t)(it - buffer.marker_offsets.begin());
+}
+
+static bool
+location_before_buffer(SourceLocation location, const Gyoji::owned<SourceBuffer> & buffer)
+{ return location < buffer->base; }
+
+SourceBuffer::SourceBuffer(
+    SourceLocation _base,
+    size_t _size,
+    size_t _filename_id,
+    bool _has_text,
+    size_t _line,
+    size_t _column
+    )
+    : base(_base)
+    , size((uint32_t)_size)
+    , filename_id((uint32_t)_filename_id)
+    , has_text(_has_text)
+    , line((uint32_t)_line)
+    , column((uint32_t)_column)
+{}
+SourceBuffer::~SourceBuffer()
+{}
+
+/////////////////////////////////////
+// SourceTable
+/////////////////////////////////////
+SourceTable::SourceTable()
+    : next_location(1)
+{}
+SourceTable::~SourceTable()
+{}
+
+SourceTable &
+SourceTable::get_instance()
+{
+    // Made on first use so that source references
+    // may be made by static initializers.
+    static SourceTable instance;
+    return instance;
+}
+
+size_t
+SourceTable::get_filename_id(const std::string & _filename)
+{
+    const auto & it = filename_ids.find(_filename);
+    if (it != filename_ids.end()) {
+	return it->second;
+    }
+    filenames.push_back(_filename);
+    filename_ids.insert(std::pair(_filename, filenames.size() - 1));
+    return filenames.size() - 1;
+}
+
+SourceLocation
+SourceTable::add_buffer(const std::string & _filename, size_t _size)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    SourceLocation base = next_location;
+    // One more for the end of the buffer, where
+    // the end of the input is found.
+    next_location += (SourceLocation)_size + 1;
+    buffers.push_back(Gyoji::owned_new<SourceBuffer>(base, _size, get_filename_id(_filename), true, 0, 0));
+    buffers.back()->line_starts.push_back(0);
+    return base;
+}
+
+SourceLocation
+SourceTable::add_location(const std::string & _filename, size_t _line, size_t _column)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    SourceLocation base = next_location;
+    next_location++;
+    buffers.push_back(Gyoji::owned_new<SourceBuffer>(base, 0, get_filename_id(_filename), false, _line, _column));
+    return base;
+}
+
+const SourceBuffer *
+SourceTable::find_buffer(SourceLocation _location) const
+{
+    const auto & it = std::upper_bound(buffers.begin(), buffers.end(), _location, location_before_buffer);
+    if (it == buffers.begin()) {
+	return nullptr;
+    }
+    const SourceBuffer *buffer = (it - 1)->get();
+    if (_location > buffer->base + buffer->size) {
+	return nullptr;
+    }
+    return buffer;
+}
+
+SourceBuffer *
+SourceTable::get_buffer(SourceLocation _buffer)
+{
+    const SourceBuffer *buffer = find_buffer(_buffer);
+    if (buffer == nullptr || buffer->base != _buffer || !buffer->has_text) {
+	return nullptr;
+    }
+    return const_cast<SourceBuffer*>(buffer);
+}
+
+void
+SourceTable::add_line_start(SourceLocation _buffer, size_t _line, size_t _offset)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    SourceBuffer *buffer = get_buffer(_buffer);
+    if (buffer == nullptr) {
+	return;
+    }
+    uint32_t line_start = std::max((uint32_t)_offset, buffer->line_starts.back());
+    while (buffer->line_starts.size() < _line) {
+	buffer->line_starts.push_back(line_start);
+    }
+}
+
+void
+SourceTable::add_line_marker(SourceLocation _buffer, size_t _offset, const std::string & _filename, size_t _line)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    SourceBuffer *buffer = get_buffer(_buffer);
+    if (buffer == nullptr) {
+	return;
+    }
+    // A function body parsed later on is scanned again,
+    // so markers already seen are left as they are.
+    if (!buffer->marker_offsets.empty() && buffer->marker_offsets.back() >= _offset) {
+	return;
+    }
+    buffer->marker_offsets.push_back((uint32_t)_offset);
+    buffer->marker_filename_ids.push_back((uint32_t)get_filename_id(_filename));
+    buffer->marker_lines.push_back((uint32_t)_line);
+}
+
+const std::string &
+SourceTable::get_filename(SourceLocation _location) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    const SourceBuffer *buffer = find_buffer(_location);
+    if (buffer == nullptr) {
+	return internal_filename;
+    }
+    size_t marker = buffer_marker(*buffer, _location - buffer->base);
+    if (marker == 0) {
+	return filenames.at(buffer->filename_id);
+    }
+    return filenames.at(buffer->marker_filename_ids.at(marker - 1));
+}
+
+size_t
+SourceTable::get_line(SourceLocation _location) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    const SourceBuffer *buffer = find_buffer(_location);
+    if (buffer == nullptr) {
+	return 1;
+    }
+    size_t offset = _location - buffer->base;
+    size_t line = buffer_physical_line(*buffer, offset);
+    size_t marker = buffer_marker(*buffer, offset);
+    if (marker == 0) {
+	return line;
+    }
+    size_t marker_line = buffer_physical_line(*buffer, buffer->marker_offsets.at(marker - 1));
+    return buffer->marker_lines.at(marker - 1) + (line - marker_line);
+}
+
+size_t
+SourceTable::get_column(SourceLocation _location) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    const SourceBuffer *buffer = find_buffer(_location);
+    if (buffer == nullptr) {
+	return 0;
+    }
+    return buffer_column(*buffer, _location - buffer->base);
+}
+
+size_t
+SourceTable::get_physical_line(SourceLocation _location) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    const SourceBuffer *buffer = find_buffer(_location);
+    if (buffer == nullptr) {
+	return 1;
+    }
+    return buffer_physical_line(*buffer, _location - buffer->base);
+}
+
+size_t
+SourceTable::get_line_count(SourceLocation _buffer) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    const SourceBuffer *buffer = find_buffer(_buffer);
+    if (buffer == nullptr || !buffer->has_text) {
+	return 0;
+    }
+    return buffer->line_starts.size();
+}
+
+size_t
+SourceTable::get_line_offset(SourceLocation _buffer, size_t _line) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    const SourceBuffer *buffer = find_buffer(_buffer);
+    if (buffer == nullptr || !buffer->has_text || _line == 0 || _line > buffer->line_starts.size()) {
+	return 0;
+    }
+    return buffer->line_starts.at(_line - 1);
+}
+
+size_t
+SourceTable::get_footprint() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t bytes = sizeof(SourceTable);
+    bytes += buffers.capacity() * sizeof(Gyoji::owned<SourceBuffer>);
+    for (const auto & buffer : buffers) {
+	bytes += sizeof(SourceBuffer);
+	bytes += buffer->line_starts.capacity() * sizeof(uint32_t);
+	bytes += buffer->marker_offsets.capacity() * sizeof(uint32_t) * 3;
+    }
+    for (const auto & filename : filenames) {
+	bytes += sizeof(std::string) + filename.capacity();
+    }
+    return bytes;
+}
+
+/////////////////////////////////////
+// SourceReference
+/////////////////////////////////////
+SourceReference::SourceReference(SourceLocation _location, size_t _length)
+    : location(_location)
+    , length((uint32_t)_length)
+{}
 
 SourceReference::SourceReference(
     const std::string & _filename,
@@ -25,29 +341,39 @@ SourceReference::SourceReference(
     size_t _column,
     size_t _length
     )
-    : filename(_filename)
-    , line(_line)
-    , column(_column)
-    , length(_length)
+    : location(SourceTable::get_instance().add_location(_filename, _line, _column))
+    , length((uint32_t)_length)
 {}
 SourceReference::SourceReference(const SourceReference & _other)
-    : filename(_other.filename)
-    , line(_other.line)
-    , column(_other.column)
+    : location(_other.location)
     , length(_other.length)
 {}
+SourceReference &
+SourceReference::operator=(const SourceReference & _other)
+{
+    location = _other.location;
+    length = _other.length;
+    return *this;
+}
 SourceReference::~SourceReference()
 {}
+
+SourceLocation
+SourceReference::get_location() const
+{ return location; }
+
 const std::string &
 SourceReference::get_filename() const
-{ return filename; }
+{ return SourceTable::get_instance().get_filename(location); }
 
 size_t SourceReference::get_line() const
-{ return line; }
+{ return SourceTable::get_instance().get_line(location); }
 
 size_t SourceReference::get_column() const
-{ return column; }
+{ return SourceTable::get_instance().get_column(location); }
 
 size_t SourceReference::get_length() const
 { return length; }
 
+size_t SourceReference::get_physical_line() const
+{ return SourceTable::get_instance().get_physical_line(location); }
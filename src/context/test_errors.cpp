@@ -14,6 +14,8 @@
  */
 #include <gyoji-context/errors.hpp>
 #include <gyoji-context/token-stream.hpp>
+#include <gyoji-misc/test.hpp>
+#include <string.h>
 
 using namespace Gyoji::context;
 
@@ -32,17 +34,84 @@ int main(int argc, char **argv)
     Errors errors(token_stream);
 
     {
-    SourceReference src_ref(std::string("asdf.h"), (size_t)3, (size_t)9, 8);
+    SourceReference src_ref(std::string("foo.j"), (size_t)3, (size_t)9, 8);
     Gyoji::owned<Error> error = Gyoji::owned_new<Error>("Syntax Error");
     error->add_message(src_ref, "Invalid namespace asdfsdf");
     errors.add_error(std::move(error));
     }
     {
-    SourceReference src_ref(std::string("asdf.h"), (size_t)5, (size_t)5, 1);
+    SourceReference src_ref(std::string("foo.j"), (size_t)5, (size_t)5, 1);
     Gyoji::owned<Error> error = Gyoji::owned_new<Error>("Syntax Error");
     error->add_message(src_ref, "Undeclared identifier y");
     errors.add_error(std::move(error));
     }
 
     errors.print();
+
+    {
+	// Context only comes from lines of the same file.
+	SourceReference src_ref(std::string("foo.j"), (size_t)3, (size_t)9, 8);
+	std::vector<std::pair<size_t, std::string>> context = token_stream.context(src_ref, 2, 1);
+	ASSERT_INT_EQUAL(4, context.size(), "Two lines before and one after");
+	ASSERT_INT_EQUAL(1, context.at(0).first, "Lines start at one");
+	ASSERT_STR_EQUAL("    a = asdfasdf::23;", context.at(2).second, "The line itself");
+	SourceReference elsewhere(std::string("asdf.h"), (size_t)3, (size_t)9, 8);
+	ASSERT_INT_EQUAL(0, token_stream.context(elsewhere, 2, 1).size(), "Nothing is known about asdf.h");
+    }
+
+    {
+	// Errors past the limit are dropped.
+	Errors limited(token_stream);
+	limited.set_error_limit(2);
+	SourceReference src_ref(std::string("asdf.h"), (size_t)3, (size_t)9, 8);
+	limited.add_simple_error(src_ref, "First", "First error");
+	ASSERT_FALSE(limited.is_error_limit_reached(), "Limit not reached with one error");
+	limited.add_simple_error(src_ref, "Second", "Second error");
+	ASSERT_TRUE(limited.is_error_limit_reached(), "Limit reached with two errors");
+	limited.add_simple_error(src_ref, "Third", "Third error");
+	ASSERT_INT_EQUAL(2, limited.size(), "Third error is dropped");
+
+	std::vector<Gyoji::owned<Errors>> buffers;
+	buffers.push_back(Gyoji::owned_new<Errors>(token_stream));
+	buffers.back()->add_simple_error(src_ref, "Fourth", "Fourth error");
+	limited.merge(buffers);
+	ASSERT_INT_EQUAL(2, limited.size(), "Merged errors are dropped too");
+	ASSERT_INT_EQUAL(0, buffers.back()->size(), "Buffer is emptied");
+    }
+    {
+	// Locations in a text are decoded through the source
+	// table and line markers change the line reported.
+	static char source[] = "# 10 \"bar.j\"\nx = 1;\ny = 2;\n\0\0";
+	TokenStream text_stream;
+	text_stream.set_text("marked.j", Gyoji::owned_new<Gyoji::misc::InputBuffer>(source, strlen(source)));
+	const char *line2 = strchr(source, '\n') + 1;
+	const char *line3 = strchr(line2, '\n') + 1;
+	text_stream.add_line_start(2, line2);
+	text_stream.add_line_marker(line2, "bar.j", 10);
+	text_stream.add_token(0, std::string_view(line2, 1), "marked.j", 2, 0);
+	text_stream.add_line_start(3, line3);
+	text_stream.add_token(0, std::string_view(line3 + 4, 1), "marked.j", 3, 4);
+
+	SourceReference x_ref = text_stream.get_token_source_ref(0);
+	ASSERT_STR_EQUAL("bar.j", x_ref.get_filename(), "Marker gives the file");
+	ASSERT_INT_EQUAL(10, x_ref.get_line(), "Marker gives the line");
+	ASSERT_INT_EQUAL(2, x_ref.get_physical_line(), "Physical line is kept");
+	ASSERT_INT_EQUAL(0, x_ref.get_column(), "Column of x");
+	SourceReference two_ref = text_stream.get_token_source_ref(1);
+	ASSERT_INT_EQUAL(11, two_ref.get_line(), "Lines follow on from the marker");
+	ASSERT_INT_EQUAL(4, two_ref.get_column(), "Column of 2");
+	ASSERT_INT_EQUAL(8, sizeof(SourceReference), "Source references are small");
+
+	// Lines and locations outlive the tokens.
+	text_stream.release_tokens();
+	ASSERT_INT_EQUAL(0, text_stream.get_token_count(), "Tokens are released");
+	ASSERT_STR_EQUAL("x = 1;\n", text_stream.get_line(2), "Lines are kept");
+	ASSERT_INT_EQUAL(11, two_ref.get_line(), "References are kept");
+
+	SourceReference made_up(std::string("made-up.j"), 7, 3, 1);
+	ASSERT_STR_EQUAL("made-up.j", made_up.get_filename(), "Made up file");
+	ASSERT_INT_EQUAL(7, made_up.get_line(), "Made up line");
+	ASSERT_INT_EQUAL(3, made_up.get_column(), "Made up column");
+    }
+    return 0;
 }
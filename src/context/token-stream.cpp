@@ -16,8 +16,13 @@
 
 using namespace Gyoji::context;
 
-static const std::string internal_filename("internal");
-static const SourceReference zero_source_ref(internal_filename, 1, 0, 0);
+// Location zero is not in any buffer, so it
+// is reported as the start of an internal file.
+static const SourceReference zero_source_ref(0, 0);
+
+// Set in the length of a token whose value
+// was copied rather than taken from the text.
+static const uint32_t copied_flag = 0x80000000u;
 
 const SourceReference &
 TokenStream::get_zero_source_ref()
@@ -26,15 +31,129 @@ TokenStream::get_zero_source_ref()
 }
 
 TokenStream::TokenStream()
+    : text_location(0)
+    , text_lines(0)
+    , text_end(0)
 {}
 
 TokenStream::~TokenStream()
 {}
 
-const std::vector<Gyoji::owned<Token>> &
-TokenStream::get_tokens() const
+size_t
+TokenStream::get_token_count() const
+{ return types.size(); }
+
+Token
+TokenStream::get_token(size_t index)
+{ return Token(*this, index); }
+
+TokenID
+TokenStream::get_token_type(size_t index) const
+{ return types.at(index); }
+
+bool
+TokenStream::is_copied(size_t index) const
+{ return (lengths.at(index) & copied_flag) != 0; }
+
+size_t
+TokenStream::get_length(size_t index) const
+{ return lengths.at(index) & ~copied_flag; }
+
+std::string_view
+TokenStream::get_token_value(size_t index) const
+{
+    if (is_copied(index)) {
+	return copies.at(offsets.at(index));
+    }
+    return std::string_view(text->get_data() + offsets.at(index), get_length(index));
+}
+
+SourceLocation
+TokenStream::get_token_location(size_t index) const
+{
+    if (is_copied(index)) {
+	return copy_locations.at(offsets.at(index));
+    }
+    return text_location + offsets.at(index);
+}
+
+SourceReference
+TokenStream::get_token_source_ref(size_t index) const
+{ return SourceReference(get_token_location(index), get_length(index)); }
+
+size_t
+TokenStream::get_footprint() const
+{
+    size_t bytes = sizeof(TokenStream);
+    bytes += types.capacity() * sizeof(uint16_t);
+    bytes += offsets.capacity() * sizeof(uint32_t);
+    bytes += lengths.capacity() * sizeof(uint32_t);
+    bytes += copy_locations.capacity() * sizeof(SourceLocation);
+    if (text) {
+	bytes += sizeof(Gyoji::misc::InputBuffer) + text->get_size();
+    }
+    for (const auto & copy : copies) {
+	bytes += sizeof(std::string) + copy.capacity();
+    }
+    return bytes;
+}
+
+void
+TokenStream::set_text(const std::string & _filename, Gyoji::owned<Gyoji::misc::InputBuffer> _text)
+{
+    text = std::move(_text);
+    text_location = SourceTable::get_instance().add_buffer(_filename, text->get_size());
+    text_lines = 1;
+}
+
+void
+TokenStream::release_tokens()
+{
+    // Swapping with empty containers hands
+    // their memory back rather than keeping it.
+    std::vector<uint16_t>().swap(types);
+    std::vector<uint32_t>().swap(offsets);
+    std::vector<uint32_t>().swap(lengths);
+    std::deque<std::string>().swap(copies);
+    std::vector<SourceLocation>().swap(copy_locations);
+}
+
+Gyoji::misc::InputBuffer *
+TokenStream::get_text()
+{ return text.get(); }
+
+SourceLocation
+TokenStream::get_text_location() const
+{ return text_location; }
+
+void
+TokenStream::add_line_start(size_t _line, const char *_start)
+{
+    if (!is_text(std::string_view(_start, 0)) || _line <= text_lines) {
+	return;
+    }
+    SourceTable::get_instance().add_line_start(text_location, _line, (size_t)(_start - text->get_data()));
+    text_lines = _line;
+}
+
+void
+TokenStream::add_line_marker(const char *_start, const std::string & _filename, size_t _line)
+{
+    if (!is_text(std::string_view(_start, 0))) {
+	return;
+    }
+    SourceTable::get_instance().add_line_marker(text_location, (size_t)(_start - text->get_data()), _filename, _line);
+}
+
+bool
+TokenStream::is_text(std::string_view _value) const
 {
-  return tokens;
+    if (!text) {
+	return false;
+    }
+    const char *start = text->get_data();
+    const char *end = start + text->get_size();
+    return _value.data() >= start && _value.data() + _value.size() <= end;
 }
 
 /**
@@ -43,100 +162,178 @@ TokenStream::get_tokens() const
  * be the first token in the file and we will return
  * the most recent one.
  */
-const SourceReference &
+SourceReference
 TokenStream::get_current_source_ref() const
 {
-    if (tokens.size() == 0) {
+    if (types.size() == 0) {
 	return zero_source_ref;
     }
-    return tokens.back()->get_source_ref();
+    return get_token_source_ref(types.size() - 1);
 }
 
 
 std::string TokenStream::get_line(size_t _line) const
 {
     std::string msg;
-    auto it = tokens_by_lineno.find(_line);
-    if (it == tokens_by_lineno.end()) {
+    const SourceTable & sources = SourceTable::get_instance();
+    size_t line_count = text ? sources.get_line_count(text_location) : 0;
+    if (text && _line >= 1 && _line <= line_count) {
+	uint32_t start = (uint32_t)sources.get_line_offset(text_location, _line);
+	uint32_t end;
+	if (_line < line_count) {
+	    end = (uint32_t)sources.get_line_offset(text_location, _line + 1);
+	}
+	else {
+	    // The last line ends with the last token
+	    // read, which may be short of the end of
+	    // the text if the parse stopped early.
+	    end = std::max(start, text_end);
+	}
+	msg.assign(text->get_data() + start, end - start);
 	return msg;
     }
-    const std::vector<Token *> & tokens = it->second;
-    for (Token* token : tokens) {
-	msg += token->get_value();
+    // Without any text, the line is made up from
+    // the copied tokens found on it.
+    for (size_t i = 0; i < types.size(); i++) {
+	if (!is_copied(i)) {
+	    continue;
+	}
+	if (sources.get_line(copy_locations.at(offsets[i])) == _line) {
+	    msg += copies.at(offsets[i]);
+	}
     }
     return msg;
 }
 
 std::vector<std::pair<size_t, std::string>>
-TokenStream::context(size_t line_start, size_t line_end) const
+TokenStream::context(const SourceReference & _src_ref, size_t _before, size_t _after) const
 {
     std::vector<std::pair<size_t, std::string>> ret;
-    line_start = (unsigned long)std::max((long)line_start, (long)0);
-    if (line_end < line_start) {
+    const SourceTable & sources = SourceTable::get_instance();
+    SourceLocation location = _src_ref.get_location();
+    if (text && location >= text_location && location <= text_location + text->get_size()) {
+	// The lines are taken from the text around the
+	// reference but are numbered as any line markers
+	// in the text say they should be.
+	size_t line = _src_ref.get_physical_line();
+	size_t line_count = sources.get_line_count(text_location);
+	size_t first = line > _before ? line - _before : 1;
+	for (size_t i = first; i <= line + _after && i <= line_count; i++) {
+	    size_t number = sources.get_line(text_location + (SourceLocation)sources.get_line_offset(text_location, i));
+	    ret.push_back(std::pair<size_t, std::string>(number, get_line(i)));
+	}
 	return ret;
     }
-    for (size_t i = line_start; i <= line_end; i++) {
-	std::string msg(get_line(i));
-	ret.push_back(std::pair<size_t, std::string>((size_t)i, msg));
+    // Without any text, the lines are made up from the
+    // copied tokens of the same file found on them.  Lines
+    // with nothing on them are left out, so there is no
+    // context at all for a file nothing was read from.
+    const std::string & filename = _src_ref.get_filename();
+    size_t line = _src_ref.get_line();
+    size_t first = line > _before ? line - _before : 1;
+    for (size_t i = first; i <= line + _after; i++) {
+	std::string msg;
+	for (size_t token = 0; token < types.size(); token++) {
+	    if (!is_copied(token)) {
+		continue;
+	    }
+	    SourceLocation token_location = copy_locations.at(offsets[token]);
+	    if (sources.get_line(token_location) == i && sources.get_filename(token_location) == filename) {
+		msg += copies.at(offsets[token]);
+	    }
+	}
+	if (msg.size() != 0) {
+	    ret.push_back(std::pair<size_t, std::string>(i, msg));
+	}
     }
     return ret;
 }
 
-const Token &
+Token
 TokenStream::add_token(
     TokenID _typestr,
-    std::string _value,
+    std::string_view _value,
     const std::string & _filename,
     size_t _line,
     size_t _column
     )
 {
-    Gyoji::owned<Token> token = Gyoji::owned_new<Token>(_typestr, _value, _filename, _line, _column, _value.size());
-    const Token & token_ref = *token;
-    tokens_by_lineno[_line].push_back(token.get());
-    tokens.push_back(std::move(token));
-    return token_ref;
+    size_t index = types.size();
+    types.push_back((uint16_t)_typestr);
+
+    if (!is_text(_value)) {
+	offsets.push_back((uint32_t)copies.size());
+	lengths.push_back((uint32_t)_value.size() | copied_flag);
+	copies.push_back(std::string(_value));
+	copy_locations.push_back(SourceTable::get_instance().add_location(_filename, _line, _column));
+	return Token(*this, index);
+    }
+    uint32_t offset = (uint32_t)(_value.data() - text->get_data());
+    offsets.push_back(offset);
+    lengths.push_back((uint32_t)_value.size());
+    text_end = std::max(text_end, offset + (uint32_t)_value.size());
+
+    // The first token found on a line tells us
+    // where in the text the line starts.
+    if (_line > text_lines) {
+	add_line_start(_line, _value.data() - std::min((size_t)offset, _column));
+    }
+    return Token(*this, index);
 }
 
 void
-TokenStream::append_token(std::string _value)
+TokenStream::copy_token(size_t index, std::string _value)
 {
-    if (tokens.empty()) return;
-    const auto & it = tokens.back();
-    it->append(_value);
+    // The copy keeps the location the
+    // token had in the text.
+    SourceLocation location = get_token_location(index);
+    offsets.at(index) = (uint32_t)copies.size();
+    lengths.at(index) = (uint32_t)_value.size() | copied_flag;
+    copies.push_back(_value);
+    copy_locations.push_back(location);
 }
 
-Token::Token(
-    TokenID _typestr,
-    std::string _value,
-    const std::string & _filename,
-    size_t _line,
-    size_t _column,
-    size_t _length
-    )
-    : typestr(_typestr)
-    , value(_value)
-    , src_ref(_filename, _line, _column, _length)
+void
+TokenStream::append_token(std::string_view _value)
+{
+    if (types.empty()) return;
+    size_t index = types.size() - 1;
+    if (!is_copied(index) &&
+	is_text(_value) &&
+	text->get_data() + offsets[index] + lengths[index] == _value.data()) {
+	lengths[index] += (uint32_t)_value.size();
+	text_end = std::max(text_end, offsets[index] + lengths[index]);
+	return;
+    }
+    std::string appended(get_token_value(index));
+    appended += _value;
+    copy_token(index, appended);
+}
+
+/////////////////////////////////////
+// Token
+/////////////////////////////////////
+Token::Token(TokenStream & _token_stream, size_t _index)
+    : token_stream(_token_stream)
+    , index(_index)
 {}
 
-Token::~Token()
+Token::Token(const Token & _other)
+    : token_stream(_other.token_stream)
+    , index(_other.index)
 {}
 
-static std::string no_type_string("No-type");
+Token::~Token()
+{}
 
-const TokenID &
+TokenID
 Token::get_type() const
-{ return typestr; }
+{ return token_stream.get_token_type(index); }
 
-const std::string &
+std::string_view
 Token::get_value() const
-{ return value; }
+{ return token_stream.get_token_value(index); }
 
-void
-Token::append(std::string & _value)
-{
-    value += _value;
-}
-const SourceReference &
+SourceReference
 Token::get_source_ref() const
-{ return src_ref; }
+{ return token_stream.get_token_source_ref(index); }
@@ -18,6 +18,9 @@
 #include <set>
 #include <algorithm>
 #include <iterator>
+#include <atomic>
+#include <thread>
+#include <functional>
 #include <stdio.h>
 
 using namespace Gyoji::mir;
@@ -28,22 +31,111 @@ using namespace Gyoji::frontend::namespaces;
 
 FunctionLowering::FunctionLowering(
     Gyoji::context::CompilerContext & _compiler_context,
-    const Gyoji::frontend::ParseResult & _parse_result,
+    Gyoji::frontend::ParseResult & _parse_result,
     Gyoji::mir::MIR & _mir,
-    Gyoji::frontend::lowering::TypeLowering & _type_lowering
+    size_t _threads
     )
     : compiler_context(_compiler_context)
     , parse_result(_parse_result)
     , mir(_mir)
-    , type_lowering(_type_lowering)
+    , threads(_threads)
 {}
 
 FunctionLowering::~FunctionLowering()
 {}
 
+// Each thread takes the next function that nobody has
+// started yet until there are none left.  Functions are
+// handed out in order, so once one has failed, there is
+// no need to lower any that come after it.
+static void
+lowering_worker(
+    std::atomic<size_t> & next_item,
+    std::atomic<size_t> & first_failed,
+    const std::vector<const FileStatementFunctionDefinition*> & definitions,
+    const TranslationUnit & translation_unit,
+    MIR & mir,
+    std::vector<Gyoji::owned<Errors>> & error_buffers,
+    std::vector<Gyoji::owned<Functions>> & function_buffers
+    )
+{
+    while (true) {
+	size_t item = next_item.fetch_add(1);
+	if (item >= definitions.size() || item > first_failed.load()) {
+	    break;
+	}
+	// Types found in the function report their
+	// errors along with the rest of the function's.
+	TypeLowering type_lowering(*error_buffers.at(item), translation_unit, mir);
+	FunctionDefinitionLowering function_def_lowering(
+	    *error_buffers.at(item),
+	    *function_buffers.at(item),
+	    *definitions.at(item),
+	    mir,
+	    type_lowering
+	    );
+	if (!function_def_lowering.lower()) {
+	    size_t failed = first_failed.load();
+	    while (item < failed && !first_failed.compare_exchange_weak(failed, item)) {
+	    }
+	}
+    }
+}
+
 bool FunctionLowering::lower()
 {
-    return extract_functions(parse_result.get_translation_unit().get_statements());
+    // The definitions are gathered (and any bodies the
+    // parser skipped are parsed) on this thread first,
+    // since the parser can only do one thing at a time.
+    definitions.clear();
+    if (!extract_functions(parse_result.get_translation_unit().get_statements())) {
+	return false;
+    }
+
+    size_t nitems = definitions.size();
+    std::vector<Gyoji::owned<Errors>> error_buffers;
+    std::vector<Gyoji::owned<Functions>> function_buffers;
+    for (size_t i = 0; i < nitems; i++) {
+	error_buffers.push_back(Gyoji::owned_new<Errors>(compiler_context.get_token_stream()));
+	function_buffers.push_back(Gyoji::owned_new<Functions>());
+    }
+
+    std::atomic<size_t> next_item(0);
+    std::atomic<size_t> first_failed(nitems);
+    size_t nthreads = std::min(threads, nitems);
+    if (nthreads <= 1) {
+	lowering_worker(next_item, first_failed, definitions, parse_result.get_translation_unit(), mir, error_buffers, function_buffers);
+    }
+    else {
+	std::vector<std::thread> pool;
+	for (size_t i = 0; i < nthreads; i++) {
+	    pool.push_back(
+		std::thread(
+		    lowering_worker,
+		    std::ref(next_item),
+		    std::ref(first_failed),
+		    std::cref(definitions),
+		    std::cref(parse_result.get_translation_unit()),
+		    std::ref(mir),
+		    std::ref(error_buffers),
+		    std::ref(function_buffers)
+		    )
+		);
+	}
+	for (auto & thread : pool) {
+	    thread.join();
+	}
+    }
+
+    // Anything lowered after the first failure is thrown
+    // away so that the result doesn't depend on how far
+    // the other threads got before they noticed it.
+    size_t nkept = std::min(first_failed.load() + 1, nitems);
+    error_buffers.resize(nkept);
+    function_buffers.resize(nkept);
+    compiler_context.get_errors().merge(error_buffers);
+    mir.get_functions().merge(function_buffers);
+    return first_failed.load() == nitems;
 }
 bool
 FunctionLowering::extract_from_namespace(
@@ -71,15 +163,14 @@ FunctionLowering::extract_functions(const std::vector<Gyoji::owned<FileStatement
 	    // This is the only place that functions can be extracted from.
 	    // We make this a separate object because we want convenient
 	    // access to certain pieces of context used in resolution.
-	    FunctionDefinitionLowering function_def_lowering(
-		compiler_context,
-		*std::get<Gyoji::owned<FileStatementFunctionDefinition>>(file_statement),
-		mir,
-		type_lowering
-		);
-	    if (!function_def_lowering.lower()) {
+	    const FileStatementFunctionDefinition & function_definition =
+		*std::get<Gyoji::owned<FileStatementFunctionDefinition>>(file_statement);
+	    // If the parser skipped the body, it is parsed now
+	    // that the function is needed.
+	    if (!Gyoji::frontend::Parser::parse_deferred_body(parse_result, function_definition.get_scope_body())) {
 		return false;
 	    }
+	    definitions.push_back(&function_definition);
 	}
 	else if (std::holds_alternative<Gyoji::owned<FileStatementGlobalDefinition>>(file_statement)) {
 	    // Nothing, no globals can exist here.
@@ -130,18 +221,23 @@ FunctionLowering::extract_functions(const std::vector<Gyoji::owned<FileStatement
 ////////////////////////////////////////////////
 
 FunctionDefinitionLowering::FunctionDefinitionLowering(
-    Gyoji::context::CompilerContext & _compiler_context,
+    Gyoji::context::Errors & _errors,
+    Gyoji::mir::Functions & _functions,
     const Gyoji::frontend::tree::FileStatementFunctionDefinition & _function_definition,
     Gyoji::mir::MIR & _mir,
     Gyoji::frontend::lowering::TypeLowering & _type_lowering
     )
-    : compiler_context(_compiler_context)
+    : errors(_errors)
+    , functions(_functions)
     , function_definition(_function_definition)
     , mir(_mir)
     , type_lowering(_type_lowering)
-    , scope_tracker(_function_definition.get_unsafe_modifier().is_unsafe(), _compiler_context)
+    , scope_tracker(_function_definition.get_unsafe_modifier().is_unsafe(), _mir.get_atoms(), _errors)
     , class_type(nullptr)
     , method(nullptr)
+    , this_declaration_id(0)
+    , has_return_void_block(false)
+    , return_void_block(0)
 {}
 FunctionDefinitionLowering::~FunctionDefinitionLowering()
 {}
@@ -168,8 +264,7 @@ FunctionDefinitionLowering::lower()
     if (maybe_class_type != nullptr) {
 	const auto & method_it = maybe_class_type->get_methods().find(entity->get_name());
 	if (method_it == maybe_class_type->get_methods().end()) {
-	    compiler_context
-		.get_errors()
+	    errors
 		.add_simple_error(
 		    function_definition.get_source_ref(),
 		    "Member function not declared.",
@@ -201,8 +296,7 @@ FunctionDefinitionLowering::lower()
     }
     
     if (return_type == nullptr) {
-	compiler_context
-	    .get_errors()
+	errors
 	    .add_simple_error(
 		function_definition.get_source_ref(),
 		"Return-value type not defined",
@@ -225,11 +319,11 @@ FunctionDefinitionLowering::lower()
     // leaking the 'this' pointer elsewhere, particularly in a destructor.
     if (is_method() && !is_static) {
 	class_pointer_type = mir.get_types().get_reference_to(class_type, function_definition.get_source_ref());
-	std::string this_arg_name("<this>");
-	FunctionArgument arg(this_arg_name, class_pointer_type,
+	FunctionArgument arg(mir.get_atoms(), mir.get_atoms().intern("<this>"), class_pointer_type,
 			     function_definition.get_source_ref(),
 			     function_definition.get_source_ref());
 	arguments.push_back(arg);
+	this_declaration_id = scope_tracker.declaration_reserve();
     }
     
     const auto & function_argument_list = function_definition.get_arguments();
@@ -254,8 +348,7 @@ FunctionDefinitionLowering::lower()
 		    member->get_source_ref(),
 		    std::string("Member variable declared here.")
 		    );
-		compiler_context
-		    .get_errors()
+		errors
 		    .add_error(std::move(error));
 		member_conflict_errors = true;
 	    }
@@ -263,7 +356,7 @@ FunctionDefinitionLowering::lower()
 	    
 	const Gyoji::mir::Type * mir_type = type_lowering.extract_from_type_specifier(function_definition_arg->get_type_specifier());
 	
-	FunctionArgument arg(name, mir_type,
+	FunctionArgument arg(mir.get_atoms(), mir.get_atoms().intern(name), mir_type,
 			     function_definition_arg->get_identifier().get_source_ref(),
 			     function_definition_arg->get_type_specifier().get_source_ref());
 	arguments.push_back(arg);
@@ -292,14 +385,13 @@ FunctionDefinitionLowering::lower()
 		    method->get_source_ref(),
 		    std::string("First declared here with ") + std::to_string(method->get_arguments().size() - (is_static ? 0 : 1) )
 		    );
-		compiler_context
-		    .get_errors()
+		errors
 		    .add_error(std::move(error));
 
 	    return false;
 	}
 	bool arg_error = false;
-	if (method->get_return_type()->get_name() != return_type->get_name()) {
+	if (method->get_return_type()->get_type_id() != return_type->get_type_id()) {
 	    Gyoji::owned<Gyoji::context::Error> error = Gyoji::owned_new<Gyoji::context::Error>("Return-value does not match declaration");
 	    error->add_message(
 		*return_type_source_ref,
@@ -309,8 +401,7 @@ FunctionDefinitionLowering::lower()
 		method->get_source_ref(),
 		std::string("Does not match declaration ") + method->get_return_type()->get_name()
 		);
-	    compiler_context
-		.get_errors()
+	    errors
 		.add_error(std::move(error));
 	    arg_error = true;
 	}
@@ -318,7 +409,7 @@ FunctionDefinitionLowering::lower()
 	for (size_t i = 0; i < arguments.size(); i++) {
 	    const FunctionArgument & fa = arguments.at(i);
 	    const Argument & ma = method->get_arguments().at(i);
-	    if (fa.get_type()->get_name() != ma.get_type()->get_name()) {
+	    if (fa.get_type()->get_type_id() != ma.get_type()->get_type_id()) {
 		Gyoji::owned<Gyoji::context::Error> error = Gyoji::owned_new<Gyoji::context::Error>("Method argument mismatch");
 		error->add_message(
 		    fa.get_type_source_ref(),
@@ -328,8 +419,7 @@ FunctionDefinitionLowering::lower()
 		    ma.get_source_ref(),
 		    std::string("First declared here as ") + ma.get_type()->get_name()
 		    );
-		compiler_context
-		    .get_errors()
+		errors
 		    .add_error(std::move(error));
 		arg_error = true;
 	    }
@@ -354,8 +444,7 @@ FunctionDefinitionLowering::lower()
 		    function_definition.get_source_ref(),
 		    std::string("Symbol ") + fully_qualified_function_name + std::string(" is not declared as a function.")
 		    );
-		compiler_context
-		    .get_errors()
+		errors
 		    .add_error(std::move(error));
 		return false;
 	    }
@@ -371,8 +460,7 @@ FunctionDefinitionLowering::lower()
 		    symbol_type->get_defined_source_ref(),
 		    std::string("First declared here with ") + std::to_string(function_arguments.size())
 		    );
-		compiler_context
-		    .get_errors()
+		errors
 		    .add_error(std::move(error));
 		
 		return false;
@@ -389,13 +477,12 @@ FunctionDefinitionLowering::lower()
 		    symbol_type->get_defined_source_ref(),
 		    std::string("Does not match previous declaration as ") + (symbol_type->is_unsafe() ? std::string("unsafe") : std::string("not unsafe"))
 		    );
-		compiler_context
-		    .get_errors()
+		errors
 		    .add_error(std::move(error));
 		arg_error = true;
 	    }
 	    
-	    if (symbol_type->get_return_type()->get_name() != return_type->get_name()) {
+	    if (symbol_type->get_return_type()->get_type_id() != return_type->get_type_id()) {
 		Gyoji::owned<Gyoji::context::Error> error = Gyoji::owned_new<Gyoji::context::Error>("Return-value does not match declaration");
 		error->add_message(
 		    *return_type_source_ref,
@@ -405,8 +492,7 @@ FunctionDefinitionLowering::lower()
 		    symbol_type->get_defined_source_ref(),
 		    std::string("Does not match declaration ") + return_type->get_name()
 		    );
-		compiler_context
-		    .get_errors()
+		errors
 		    .add_error(std::move(error));
 		arg_error = true;
 	    }
@@ -414,7 +500,7 @@ FunctionDefinitionLowering::lower()
 	    for (size_t i = 0; i < arguments.size(); i++) {
 		const FunctionArgument & fa = arguments.at(i);
 		const Argument & ma = function_arguments.at(i);
-		if (fa.get_type()->get_name() != ma.get_type()->get_name()) {
+		if (fa.get_type()->get_type_id() != ma.get_type()->get_type_id()) {
 		    Gyoji::owned<Gyoji::context::Error> error = Gyoji::owned_new<Gyoji::context::Error>("Method argument mismatch");
 		    error->add_message(
 			fa.get_type_source_ref(),
@@ -424,8 +510,7 @@ FunctionDefinitionLowering::lower()
 			ma.get_source_ref(),
 			std::string("First declared here as ") + ma.get_type()->get_name()
 			);
-		    compiler_context
-			.get_errors()
+		    errors
 			.add_error(std::move(error));
 		    arg_error = true;
 		}
@@ -478,8 +563,7 @@ FunctionDefinitionLowering::lower()
 	    // Insert the 'undeclare' operation to mark that
 	    // this variable is no longer in scope.
 	    location += undeclare_local(
-		unwind->get_variable_name(),
-		unwind->get_variable_type(),
+		*unwind->get_variable(),
 		basic_block_id,
 		location,
 		goto_operation->get_source_ref());
@@ -514,47 +598,68 @@ FunctionDefinitionLowering::lower()
     // and insert them if the function is 'void'.
     // If the function is not 'void', then
     // we need to raise an error for it.
-    const auto & blocks = function->get_blocks();
-    for (const auto & block_it : blocks) {
-	const BasicBlock & block = *block_it.second;
-	if (!block.contains_terminator()
-	    // A block is reachable if it is reachable from another block
-	    // OR it is the 'entry' block with ID 0.
-	    && (block.get_reachable_from().size() != 0 || block_it.first == 0)
-	    ) {
-	    if (return_type->is_void()) {
-		std::vector<std::string> unwind_scope = scope_tracker.get_variables_to_unwind_for_scope();
-		leave_scope(unwind_scope, function_definition.get_scope_body().get_source_ref());
-	
-		function->add_operation(
-		    block_it.first,
-		    Gyoji::owned_new<OperationReturnVoid>(
-			*return_type_source_ref
-			)
-		    );
-	    }
-	    else {
-		Gyoji::owned<Gyoji::context::Error> error = Gyoji::owned_new<Gyoji::context::Error>("Control reaches end of non-void function");
-		error->add_message(
-		    function_definition.get_scope_body().get_end_source_ref(),
-		    std::string("Function ")
-		    + fully_qualified_function_name
-		    + std::string(" returns ")
-		    + return_type->get_name()
-		    + std::string(" but is missing a return statement at the end of the function.")
-		    );
-		error->add_message(
-		    *return_type_source_ref,
-		    std::string("Return type defined here")
+    // Adding a return changes the shape of the
+    // graph, so gather the blocks that need one first.
+    std::vector<size_t> unterminated_blocks;
+    const CFGInfo & cfg = function->get_cfg_info();
+    for (const auto & block_it : function->get_blocks()) {
+	if (!block_it.second->contains_terminator() && cfg.is_reachable(block_it.first)) {
+	    unterminated_blocks.push_back(block_it.first);
+	}
+    }
+    for (size_t unterminated_block : unterminated_blocks) {
+	if (return_type->is_void()) {
+	    // Falling off the end of the function is the same
+	    // as a 'return', so it shares the cleanup of the
+	    // other returns unless it is the only way out.
+	    UnwindList unwind_root = scope_tracker.get_variables_to_unwind_for_root();
+	    if (unwind_root.get_first() != unwind_root.get_end() &&
+		(has_return_void_block || unterminated_blocks.size() > 1)) {
+		leave_scope_to(
+		    unterminated_block,
+		    unwind_root,
+		    get_return_void_block(*return_type_source_ref),
+		    function_definition.get_scope_body().get_source_ref()
 		    );
-		compiler_context
-		    .get_errors()
-		    .add_error(std::move(error));
+		continue;
 	    }
+	    current_block = unterminated_block;
+	    leave_scope(unwind_root, function_definition.get_scope_body().get_source_ref());
+	
+	    function->add_operation(
+		unterminated_block,
+		Gyoji::owned_new<OperationReturnVoid>(
+		    *return_type_source_ref
+		    )
+		);
+	}
+	else {
+	    Gyoji::owned<Gyoji::context::Error> error = Gyoji::owned_new<Gyoji::context::Error>("Control reaches end of non-void function");
+	    error->add_message(
+		function_definition.get_scope_body().get_end_source_ref(),
+		std::string("Function ")
+		+ fully_qualified_function_name
+		+ std::string(" returns ")
+		+ return_type->get_name()
+		+ std::string(" but is missing a return statement at the end of the function.")
+		);
+	    error->add_message(
+		*return_type_source_ref,
+		std::string("Return type defined here")
+		);
+	    errors
+		.add_error(std::move(error));
 	}
     }
-    
-    mir.get_functions().add_function(std::move(function));
+
+    // Flag the assignments whose value is never read
+    // so that code generation can leave them out.
+    Liveness liveness(*function);
+    for (const auto & dead_store : liveness.get_dead_stores()) {
+	function->mark_dead_store(dead_store.first, dead_store.second);
+    }
+
+    functions.add_function(std::move(function));
 
     return true;
 }
@@ -587,12 +692,11 @@ FunctionDefinitionLowering::extract_from_expression_primary_identifier(
 	// This block is obsolete, it should
 	// no longer be possible to get here, so we should
 	// confirm that fact and remove this block altogether.
-	compiler_context
-	    .get_errors()
+	errors
 	    .add_simple_error(
 		expression.get_source_ref(),
 		"Local variable could not be resolved: should not be reachable.",
-		std::string("Local variable ") + expression.get_identifier().get_value() + std::string(" was not found in this scope.")
+		std::string("Local variable ") + expression.get_identifier().get_name() + std::string(" was not found in this scope.")
 		);
 	return false;
     }
@@ -608,7 +712,9 @@ FunctionDefinitionLowering::extract_from_expression_primary_identifier(
 		Gyoji::owned_new<OperationLocalVariable>(
 		    expression.get_identifier().get_source_ref(),
 		    returned_tmpvar,
-		    local_variable_name,
+		    mir.get_atoms(),
+		    localvar->get_atom(),
+		    localvar->get_declaration_id(),
 		    localvar->get_type()
 		    )
 		);
@@ -629,7 +735,9 @@ FunctionDefinitionLowering::extract_from_expression_primary_identifier(
 		    Gyoji::owned_new<OperationLocalVariable>(
 			expression.get_identifier().get_source_ref(),
 			this_tmpvar,
-			"<this>",
+			mir.get_atoms(),
+			mir.get_atoms().intern("<this>"),
+			this_declaration_id,
 			class_pointer_type
 			)
 		    );
@@ -678,8 +786,7 @@ FunctionDefinitionLowering::extract_from_expression_primary_identifier(
 	// if we're doing a method call, it must be a method
 	// AND if it's not a method call, it must be a static function.
 	if (symbol == nullptr) {
-	    compiler_context
-		.get_errors()
+	    errors
 		.add_simple_error(
 		    expression.get_source_ref(),
 		    "Unresolved symbol",
@@ -689,8 +796,7 @@ FunctionDefinitionLowering::extract_from_expression_primary_identifier(
 	}
 
 	if (symbol->get_type() == Gyoji::mir::Symbol::SYMBOL_MEMBER_DESTRUCTOR) {
-	    compiler_context
-		.get_errors()
+	    errors
 		.add_simple_error(
 		    expression.get_source_ref(),
 		    "Explicit calls to destructors are not allowed.",
@@ -739,8 +845,7 @@ FunctionDefinitionLowering::extract_from_expression_primary_literal_char(
     bool escape_success = Gyoji::misc::string_c_unescape(string_unescaped, location, expression.get_value(), true);
     char c;
     if (!escape_success) {
-	compiler_context
-	    .get_errors()
+	errors
 	    .add_simple_error(
 		expression.get_source_ref(),
 		"Invalid Character Literal",
@@ -750,8 +855,7 @@ FunctionDefinitionLowering::extract_from_expression_primary_literal_char(
     }
     else {
 	if (string_unescaped.size() != 1) {
-	    compiler_context
-		.get_errors()
+	    errors
 		.add_simple_error(
 		    expression.get_source_ref(),
 		    "Invalid Character Literal",
@@ -795,8 +899,7 @@ FunctionDefinitionLowering::extract_from_expression_primary_literal_string(
     size_t location;
     bool escape_success = Gyoji::misc::string_c_unescape(string_unescaped, location, expression.get_value(), false);
     if (!escape_success) {
-	compiler_context
-	    .get_errors()
+	errors
 	    .add_simple_error(
 		expression.get_source_ref(),
 		"Invalid String Literal",
@@ -811,7 +914,12 @@ FunctionDefinitionLowering::extract_from_expression_primary_literal_string(
 
     
     
-    returned_tmpvar = function->tmpvar_define(mir.get_types().get_type("u8*"));
+    returned_tmpvar = function->tmpvar_define(
+	mir.get_types().get_pointer_to(
+	    mir.get_types().get_type("u8"),
+	    expression.get_source_ref()
+	    )
+	);
     function->add_operation(
 	current_block,
 	Gyoji::owned_new<OperationLiteralString>(
@@ -859,8 +967,7 @@ FunctionDefinitionLowering::create_constant_integer_one(
 	parse_result.i64_value = (long)1;
 	break;
     default:
-	compiler_context
-	    .get_errors()
+	errors
 	    .add_simple_error(
 		_src_ref,
 		"Compiler Bug! Invalid integer literal",
@@ -892,6 +999,7 @@ FunctionDefinitionLowering::create_constant_integer(
 	    parse_result.u8_value
 	    );
     }
+	break;
     case Type::TYPE_PRIMITIVE_u16:
     {
 	operation = Gyoji::owned_new<OperationLiteralInt>(
@@ -933,6 +1041,7 @@ FunctionDefinitionLowering::create_constant_integer(
 	    parse_result.i8_value
 	    );
     }
+	break;
     case Type::TYPE_PRIMITIVE_i16:
     {
 	operation = Gyoji::owned_new<OperationLiteralInt>(
@@ -965,8 +1074,7 @@ FunctionDefinitionLowering::create_constant_integer(
 	break;
 
     default:
-	compiler_context
-	    .get_errors()
+	errors
 	    .add_simple_error(
 		_src_ref,
 		"Compiler Bug! Invalid integer literal",
@@ -1008,7 +1116,7 @@ FunctionDefinitionLowering::extract_from_expression_primary_literal_int(
 {
     Gyoji::frontend::integers::ParseLiteralIntResult parse_result;
     const Terminal & literal_int_token = expression.get_literal_int_token();
-    bool parsed = parse_literal_int(compiler_context, mir.get_types(), literal_int_token, parse_result);
+    bool parsed = parse_literal_int(errors, mir.get_types(), literal_int_token, parse_result);
     if (!parsed || parse_result.parsed_type == nullptr) {
 	return false;
     }
@@ -1035,8 +1143,7 @@ FunctionDefinitionLowering::extract_from_expression_primary_literal_float(
 
 	float converted_value = strtof(source_cstring, &endptr);
 	if (endptr != (source_cstring + length)) {
-	    compiler_context
-		.get_errors()
+	    errors
 		.add_simple_error(
 		    expression.get_source_ref(),
 		    "Invalid floating-point literal",
@@ -1045,8 +1152,7 @@ FunctionDefinitionLowering::extract_from_expression_primary_literal_float(
 	    return false;
 	}
 	if (errno == ERANGE) {
-	    compiler_context
-		.get_errors()
+	    errors
 		.add_simple_error(
 		    expression.get_source_ref(),
 		    "Invalid floating-point literal",
@@ -1063,8 +1169,7 @@ FunctionDefinitionLowering::extract_from_expression_primary_literal_float(
     else {
 	double converted_value = strtod(source_cstring, &endptr);
 	if (endptr != (source_cstring + length)) {
-	    compiler_context
-		.get_errors()
+	    errors
 		.add_simple_error(
 		    expression.get_source_ref(),
 		    "Invalid floating-point literal",
@@ -1073,8 +1178,7 @@ FunctionDefinitionLowering::extract_from_expression_primary_literal_float(
 	    return false;
 	}
 	if (errno == ERANGE) {
-	    compiler_context
-		.get_errors()
+	    errors
 		.add_simple_error(
 		    expression.get_source_ref(),
 		    "Invalid floating-point literal",
@@ -1108,8 +1212,7 @@ FunctionDefinitionLowering::extract_from_expression_postfix_array_index(
 
     const Type *array_type = function->tmpvar_get(array_tmpvar);
     if (!array_type->is_array()) {
-	compiler_context
-	    .get_errors()
+	errors
 	    .add_simple_error(
 		expression.get_array().get_source_ref(),
 		"Array type must be an array type",
@@ -1120,8 +1223,7 @@ FunctionDefinitionLowering::extract_from_expression_postfix_array_index(
 
     const Type *index_type = function->tmpvar_get(index_tmpvar);
     if (index_type->get_type() != Type::TYPE_PRIMITIVE_u32) {
-	compiler_context
-	    .get_errors()
+	errors
 	    .add_simple_error(
 		expression.get_index().get_source_ref(),
 		"Array index must be an unsigned 32-bit (u32) type",
@@ -1177,8 +1279,7 @@ FunctionDefinitionLowering::check_function_call_signature(
 			   + std::to_string(function_pointer_args.size() - (is_method ? 1 : 0))
 			   + std::string(" arguments.")
 	    );
-	compiler_context
-	    .get_errors()
+	errors
 	    .add_error(std::move(error));
 	is_ok = false;
     }
@@ -1197,8 +1298,7 @@ FunctionDefinitionLowering::check_function_call_signature(
 			       (is_method ? std::string("Method ") : std::string("Function ") )
 			       + std::string("is declared as unsafe, but this is not inside a scope marked unsafe.")
 		);
-	    compiler_context
-		.get_errors()
+	    errors
 		.add_error(std::move(error));
 	    is_ok = false;
 	}
@@ -1210,7 +1310,7 @@ FunctionDefinitionLowering::check_function_call_signature(
 	const SourceReference & passed_src_ref = *passed_src_refs.at(i);
 	const Argument & arg = function_pointer_args.at(i);
 	const Type *required_type = arg.get_type();
-	if (required_type->get_name() != passed_type->get_name()) {
+	if (required_type->get_type_id() != passed_type->get_type_id()) {
 	    Gyoji::owned<Gyoji::context::Error> error = Gyoji::owned_new<Gyoji::context::Error>("Incorrect argument type passed to call");
 	    error->add_message(passed_src_ref,
 			       std::string("Passing type ")
@@ -1223,8 +1323,7 @@ FunctionDefinitionLowering::check_function_call_signature(
 			       std::string("Argument type was declared as ")
 			       + required_type->get_name()
 		);
-	    compiler_context
-		.get_errors()
+	    errors
 		.add_error(std::move(error));
 	    is_ok = false;
 	}
@@ -1261,8 +1360,7 @@ FunctionDefinitionLowering::extract_from_expression_postfix_function_call(
 
     const Type *call_type = function->tmpvar_get(function_type_tmpvar);
     if (call_type->get_type() != Type::TYPE_FUNCTION_POINTER) {
-	compiler_context
-	    .get_errors()
+	errors
 	    .add_simple_error(
 		expression.get_function().get_source_ref(),
 		"Called object is not a function.",
@@ -1295,7 +1393,9 @@ FunctionDefinitionLowering::extract_from_expression_postfix_function_call(
 		Gyoji::owned_new<OperationLocalVariable>(
 		    expression.get_source_ref(),
 		    this_tmpvar,
-		    "<this>",
+		    mir.get_atoms(),
+		    mir.get_atoms().intern("<this>"),
+		    this_declaration_id,
 		    class_pointer_type
 		    )
 		);
@@ -1366,8 +1466,7 @@ FunctionDefinitionLowering::extract_from_expression_postfix_dot(
     }
     
     if (class_type->get_type() != Type::TYPE_COMPOSITE) {
-	compiler_context
-	    .get_errors()
+	errors
 	    .add_simple_error(
 		expression.get_expression().get_source_ref(),
 		"Member access must be applied to a class.",
@@ -1397,8 +1496,7 @@ FunctionDefinitionLowering::extract_from_expression_postfix_dot(
 	std::string fully_qualified_function_name = class_type->get_name() + NS2Context::NAMESPACE_DELIMITER + member_name;
 	const Gyoji::mir::Symbol *symbol = mir.get_symbols().get_symbol(fully_qualified_function_name);
 	if (symbol == nullptr || symbol->get_type() != Gyoji::mir::Symbol::SYMBOL_MEMBER_METHOD) {
-	    compiler_context
-		.get_errors()
+	    errors
 		.add_simple_error(
 		    expression.get_expression().get_source_ref(),
 		    "Class method not found.",
@@ -1435,8 +1533,7 @@ FunctionDefinitionLowering::extract_from_expression_postfix_dot(
 	    );
 	return true;
     }
-    compiler_context
-	.get_errors()
+    errors
 	.add_simple_error(
 	    expression.get_expression().get_source_ref(),
 	    "Member or method not found.",
@@ -1458,8 +1555,7 @@ FunctionDefinitionLowering::extract_from_expression_postfix_arrow(
 
     const Type *classptr_type = function->tmpvar_get(classptr_tmpvar);
     if (classptr_type->get_type() != Type::TYPE_POINTER) {
-	compiler_context
-	    .get_errors()
+	errors
 	    .add_simple_error(
 		expression.get_expression().get_source_ref(),
 		"Arrow (->) operator must be used on a pointer to a class.",
@@ -1470,8 +1566,7 @@ FunctionDefinitionLowering::extract_from_expression_postfix_arrow(
     const Type *class_type = classptr_type->get_pointer_target();
     
     if (class_type->get_type() != Type::TYPE_COMPOSITE) {
-	compiler_context
-	    .get_errors()
+	errors
 	    .add_simple_error(
 		expression.get_expression().get_source_ref(),
 		"Arrow (->) access must be applied to a pointer to a class.",
@@ -1481,8 +1576,7 @@ FunctionDefinitionLowering::extract_from_expression_postfix_arrow(
     }
 
     if (!scope_tracker.is_unsafe()) {
-	compiler_context
-	    .get_errors()
+	errors
 	    .add_simple_error(
 		expression.get_expression().get_source_ref(),
 		"De-referencing pointers (->) must be done inside an 'unsafe' block.",
@@ -1507,8 +1601,7 @@ FunctionDefinitionLowering::extract_from_expression_postfix_arrow(
     const std::string & member_name = expression.get_identifier().get_name();
     const TypeMember *member = class_type->member_get(member_name);
     if (member == nullptr) {
-	compiler_context
-	    .get_errors()
+	errors
 	    .add_simple_error(
 		expression.get_expression().get_source_ref(),
 		"Attempt to access an undeclared member",
@@ -1656,8 +1749,7 @@ FunctionDefinitionLowering::extract_from_expression_unary_prefix(
     
     const Type *operand_type = function->tmpvar_get(operand_tmpvar);
     if (operand_type == nullptr) {
-	compiler_context
-	    .get_errors()
+	errors
 	    .add_simple_error(
 		expression.get_source_ref(),
 		"Compiler bug!  Please report this message(4)",
@@ -1708,8 +1800,7 @@ FunctionDefinitionLowering::extract_from_expression_unary_prefix(
         {
 	    bool is_ok = true;
 	    if (!operand_type->is_pointer() && !operand_type->is_reference()) {
-		compiler_context
-		    .get_errors()
+		errors
 		    .add_simple_error(
 			expression.get_expression().get_source_ref(),
 			"Cannot dereference non-pointer",
@@ -1718,8 +1809,7 @@ FunctionDefinitionLowering::extract_from_expression_unary_prefix(
 		is_ok = false;
 	    }
 	    if (!scope_tracker.is_unsafe() && !operand_type->is_reference()) {
-		compiler_context
-		    .get_errors()
+		errors
 		    .add_simple_error(
 			expression.get_expression().get_source_ref(),
 			"De-referencing pointers (*) must be done inside an 'unsafe' block.",
@@ -1781,8 +1871,7 @@ FunctionDefinitionLowering::extract_from_expression_unary_prefix(
     case ExpressionUnaryPrefix::LOGICAL_NOT:
         {
 	if (!function->tmpvar_get(operand_tmpvar)->is_bool()) {
-	    compiler_context
-		.get_errors()
+	    errors
 		.add_simple_error(
 		    expression.get_expression().get_source_ref(),
 		    "Logical not (!) must operate on 'bool' expressions.",
@@ -1802,8 +1891,7 @@ FunctionDefinitionLowering::extract_from_expression_unary_prefix(
 	}
         break;
     default:
-	compiler_context
-	    .get_errors()
+	errors
 	    .add_simple_error(
 		expression.get_expression().get_source_ref(),
 		"Compiler Bug!",
@@ -1921,8 +2009,7 @@ FunctionDefinitionLowering::numeric_widen_binary_operation(
 	    }
 	}
 	else {
-	    compiler_context
-		.get_errors()
+	    errors
 		.add_simple_error(
 		    _src_ref,
 		    "Type mismatch in binary operation",
@@ -1970,8 +2057,7 @@ FunctionDefinitionLowering::handle_binary_operation_arithmetic(
     // and has some rules about its use.
     if (atype->is_pointer()) {
 	if (!scope_tracker.is_unsafe()) {
-	    compiler_context
-		.get_errors()
+	    errors
 		.add_simple_error(
 		    _src_ref,
 		    "Pointer arithmetic should be inside an unsafe block",
@@ -1980,8 +2066,7 @@ FunctionDefinitionLowering::handle_binary_operation_arithmetic(
 	    return false;
 	}
 	if (type != Operation::OP_ADD && type != Operation::OP_SUBTRACT) {
-	    compiler_context
-		.get_errors()
+	    errors
 		.add_simple_error(
 		    _src_ref,
 		    "Pointer arithmetic must only be addition and subtraction of numeric values",
@@ -1991,8 +2076,7 @@ FunctionDefinitionLowering::handle_binary_operation_arithmetic(
 	}
 	
 	if (!btype->is_numeric()) {
-	    compiler_context
-		.get_errors()
+	    errors
 		.add_simple_error(
 		    _src_ref,
 		    "Type mismatch in binary operation",
@@ -2006,8 +2090,7 @@ FunctionDefinitionLowering::handle_binary_operation_arithmetic(
     // Check that both operands are numeric.
     else {
 	if (!atype->is_numeric() || !btype->is_numeric()) {
-	    compiler_context
-		.get_errors()
+	    errors
 		.add_simple_error(
 		    _src_ref,
 		    "Type mismatch in binary operation",
@@ -2018,8 +2101,7 @@ FunctionDefinitionLowering::handle_binary_operation_arithmetic(
 	// Special-case for modulo because it doesn't support floating-point types.
 	if (type == Operation::OP_MODULO) {
 	    if (atype->is_float() || btype->is_float()) {
-		compiler_context
-		    .get_errors()
+		errors
 		    .add_simple_error(
 			_src_ref,
 			"Type mismatch in binary operation",
@@ -2035,8 +2117,7 @@ FunctionDefinitionLowering::handle_binary_operation_arithmetic(
 	     (atype->is_integer() && btype->is_integer()) ||
 	     (atype->is_float() && btype->is_float())
 	     )) {
-	    compiler_context
-		.get_errors()
+	    errors
 		.add_simple_error(
 		    _src_ref,
 		    "Type mismatch in binary operation",
@@ -2089,8 +2170,7 @@ FunctionDefinitionLowering::handle_binary_operation_logical(
     const Type *btype = function->tmpvar_get(b_tmpvar);
     // Check that both operands are numeric.
     if (!atype->is_bool() || !btype->is_bool()) {
-	compiler_context
-	    .get_errors()
+	errors
 	    .add_simple_error(
 		_src_ref,
 		"Type mismatch in logical operation",
@@ -2124,8 +2204,7 @@ FunctionDefinitionLowering::handle_binary_operation_bitwise(
     const Type *btype = function->tmpvar_get(b_tmpvar);
     // Check that both operands are numeric.
     if (!atype->is_unsigned() || !btype->is_unsigned()) {
-	compiler_context
-	    .get_errors()
+	errors
 	    .add_simple_error(
 		_src_ref,
 		"Type mismatch in binary operation",
@@ -2176,8 +2255,7 @@ FunctionDefinitionLowering::handle_binary_operation_shift(
     const Type *btype = function->tmpvar_get(b_tmpvar);
     // Check that both operands are numeric.
     if (!atype->is_unsigned() || !btype->is_unsigned()) {
-	compiler_context
-	    .get_errors()
+	errors
 	    .add_simple_error(
 		_src_ref,
 		"Type mismatch in binary operation",
@@ -2226,9 +2304,8 @@ FunctionDefinitionLowering::handle_binary_operation_compare(
     const Type *atype = function->tmpvar_get(a_tmpvar);
     const Type *btype = function->tmpvar_get(b_tmpvar);
     // Check that both operands are the same type.
-    if (atype->get_name() != btype->get_name()) {
-	compiler_context
-	    .get_errors()
+    if (atype->get_type_id() != btype->get_type_id()) {
+	errors
 	    .add_simple_error(
 		_src_ref,
 		"Type mismatch in compare operation",
@@ -2237,8 +2314,7 @@ FunctionDefinitionLowering::handle_binary_operation_compare(
 	return false;
     }
     if (atype->is_void()) {
-	compiler_context
-	    .get_errors()
+	errors
 	    .add_simple_error(
 		_src_ref,
 		"Type mismatch in compare operation",
@@ -2247,8 +2323,7 @@ FunctionDefinitionLowering::handle_binary_operation_compare(
 	return false;
     }
     if (atype->is_composite()) {
-	compiler_context
-	    .get_errors()
+	errors
 	    .add_simple_error(
 		_src_ref,
 		"Type mismatch in compare operation",
@@ -2262,8 +2337,7 @@ FunctionDefinitionLowering::handle_binary_operation_compare(
 	!(type == Operation::OP_COMPARE_EQUAL ||
 	  type == Operation::OP_COMPARE_NOT_EQUAL)
 	) {
-	compiler_context
-	    .get_errors()
+	errors
 	    .add_simple_error(
 		_src_ref,
 		"Type mismatch in compare operation",
@@ -2313,13 +2387,12 @@ FunctionDefinitionLowering::handle_binary_operation_assignment(
     const Type *atype = function->tmpvar_get(a_tmpvar);
     const Type *btype = function->tmpvar_get(b_tmpvar);
     // Check that both operands are the same type.
-    if (atype->get_name() != btype->get_name()) {
+    if (atype->get_type_id() != btype->get_type_id()) {
 	// If we're assigning a reference to a pointer, we
 	// should allow it in some circumstances.
 	if (atype->is_reference() && btype->is_pointer()) {
 	    if (!scope_tracker.is_unsafe()) {
-		compiler_context
-		    .get_errors()
+		errors
 		    .add_simple_error(
 			_src_ref,
 			"Assigning a reference to a raw pointer must be done inside an 'unsafe' block",
@@ -2335,8 +2408,7 @@ FunctionDefinitionLowering::handle_binary_operation_assignment(
 	// Should we model anonymous structures as types for the purposes of assignment?
 	else if (atype->is_composite() && btype->is_anonymous()) {
 	    if (btype->get_members().size() != btype->get_members().size()) {
-		compiler_context
-		    .get_errors()
+		errors
 		    .add_simple_error(
 			_src_ref,
 			"Type mismatch in assignment operation, wrong number of fields.",
@@ -2348,8 +2420,7 @@ FunctionDefinitionLowering::handle_binary_operation_assignment(
 	    // codegen layer deal with making the copy.
 	}
 	else {
-	    compiler_context
-		.get_errors()
+	    errors
 		.add_simple_error(
 		    _src_ref,
 		    "Type mismatch in assignment operation",
@@ -2359,8 +2430,7 @@ FunctionDefinitionLowering::handle_binary_operation_assignment(
 	}
     }
     if (atype->is_void()) {
-	compiler_context
-	    .get_errors()
+	errors
 	    .add_simple_error(
 		_src_ref,
 		"Type mismatch in assignment operation",
@@ -2839,8 +2909,7 @@ FunctionDefinitionLowering::extract_from_expression_binary(
 	}
     }
     else {
-	compiler_context
-	    .get_errors()
+	errors
 	    .add_simple_error(
 		expression.get_source_ref(),
 		"Compiler bug! unknown binary operator",
@@ -2947,18 +3016,25 @@ FunctionDefinitionLowering::extract_from_expression(
 
 bool
 FunctionDefinitionLowering::local_declare_or_error(
+    size_t & declaration_id,
     const Gyoji::mir::Type *mir_type,
     const std::string & name,
     const SourceReference & source_ref
     )
 {
     scope_tracker.add_variable(name, mir_type, source_ref);
+    // If it was a duplicate, the error is already
+    // reported, so the earlier one will do.
+    const LocalVariable *variable = scope_tracker.get_variable(name);
+    declaration_id = variable->get_declaration_id();
     
     function->add_operation(
 	current_block,
 	Gyoji::owned_new<OperationLocalDeclare>(
 	    source_ref,
-	    name,
+	    mir.get_atoms(),
+	    variable->get_atom(),
+	    declaration_id,
 	    mir_type
 	    )
 	);
@@ -3009,14 +3085,23 @@ FunctionDefinitionLowering::extract_from_struct_initializer(
 
     std::string field_desc_str = Gyoji::misc::join(field_types, ", ");
     std::string anonymous_structure_type_name = std::string("<anonymous_structure>{") + field_desc_str + std::string("}");
-    Type *anonymous_structure_type = type_lowering.get_or_create(anonymous_structure_type_name, Type::TYPE_ANONYMOUS_STRUCTURE, false, struct_initializer_expression.get_source_ref());
-    if (!anonymous_structure_type->is_complete()) {
+    // The type is completed before it is defined since another
+    // function may be looking for the same one at the same time.
+    Type *anonymous_structure_type = mir.get_types().get_type(anonymous_structure_type_name);
+    if (anonymous_structure_type == nullptr) {
+	Gyoji::owned<Type> anonymous_structure_owned = Gyoji::owned_new<Type>(
+	    anonymous_structure_type_name,
+	    Type::TYPE_ANONYMOUS_STRUCTURE,
+	    false,
+	    struct_initializer_expression.get_source_ref()
+	    );
 	std::map<std::string, TypeMethod> methods; // No methods for anonymous types.
-	anonymous_structure_type->complete_composite_definition(
+	anonymous_structure_owned->complete_composite_definition(
 	    members,
 	    methods,
 	    struct_initializer_expression.get_source_ref()
 	    );
+	anonymous_structure_type = mir.get_types().define_type(std::move(anonymous_structure_owned));
     }
     
     // We model this as a 'void' type.
@@ -3050,7 +3135,9 @@ FunctionDefinitionLowering::extract_from_statement_variable_declaration(
     if (mir_type == nullptr) {
 	return false;
     }
+    size_t declaration_id;
     if (!local_declare_or_error(
+	    declaration_id,
 	    mir_type,
 	    statement.get_identifier().get_name(),
 	    statement.get_identifier().get_source_ref()
@@ -3072,7 +3159,9 @@ FunctionDefinitionLowering::extract_from_statement_variable_declaration(
 	Gyoji::owned_new<OperationLocalVariable>(
 	    statement.get_source_ref(),
 	    variable_tmpvar,
-	    statement.get_identifier().get_name(),
+	    mir.get_atoms(),
+	    mir.get_atoms().intern(statement.get_identifier().get_name()),
+	    declaration_id,
 	    mir_type
 	    )
 	);
@@ -3128,8 +3217,7 @@ FunctionDefinitionLowering::extract_from_statement_variable_declaration(
 		m->get_source_ref(),
 		"Member declared here"
 		);
-	    compiler_context
-		.get_errors()
+	    errors
 		.add_error(std::move(error));
 	    is_ok = false;
 	}
@@ -3144,8 +3232,7 @@ FunctionDefinitionLowering::extract_from_statement_variable_declaration(
 		mir_type->get_defined_source_ref(),
 		"Class declared here"
 		);
-	    compiler_context
-		.get_errors()
+	    errors
 		.add_error(std::move(error));
 	    is_ok = false;
 	}
@@ -3164,8 +3251,7 @@ FunctionDefinitionLowering::extract_from_statement_variable_declaration(
 	}
 	else if (initializer_expression.has_struct_expression()) {
 	    // This isn't valid for primitive types.
-	    compiler_context
-		.get_errors()
+	    errors
 		.add_simple_error(
 		    initializer_expression.get_source_ref(),
 		    "Primitive types may not be initialized with structures",
@@ -3206,8 +3292,7 @@ FunctionDefinitionLowering::extract_from_statement_ifelse(
     }
     // First, evaluate the expression to get our condition.
     if (!function->tmpvar_get(condition_tmpvar)->is_bool()) {
-	compiler_context
-	    .get_errors()
+	errors
 	    .add_simple_error(
 		statement.get_expression().get_source_ref(),
 		"Invalid condition in if statement.",
@@ -3339,8 +3424,7 @@ FunctionDefinitionLowering::extract_from_statement_while(
 	return false;
     }
     if (!function->tmpvar_get(condition_tmpvar)->is_bool()) {
-	compiler_context
-	    .get_errors()
+	errors
 	    .add_simple_error(
 		statement.get_expression().get_source_ref(),
 		"Invalid condition in while statement.",
@@ -3401,7 +3485,9 @@ FunctionDefinitionLowering::extract_from_statement_for(
     if (statement.is_declaration()) {
 	const Gyoji::mir::Type * mir_type = type_lowering.extract_from_type_specifier(statement.get_type_specifier());
 	
+	size_t declaration_id;
 	if (!local_declare_or_error(
+		declaration_id,
 		mir_type,
 		statement.get_identifier().get_name(),
 		statement.get_identifier().get_source_ref()
@@ -3415,7 +3501,9 @@ FunctionDefinitionLowering::extract_from_statement_for(
 	    Gyoji::owned_new<OperationLocalVariable>(
 		statement.get_identifier().get_source_ref(),
 		variable_tmpvar,
-		statement.get_identifier().get_name(),
+		mir.get_atoms(),
+		mir.get_atoms().intern(statement.get_identifier().get_name()),
+		declaration_id,
 		mir_type
 		)
 	    );
@@ -3534,8 +3622,7 @@ FunctionDefinitionLowering::extract_from_statement_switch(
     for (const auto & block_ptr : blocks) {
 	if (block_ptr->is_default()) {
 	    if (i != nblocks-1) {
-		compiler_context
-		    .get_errors()
+		errors
 		    .add_simple_error(
 			block_ptr->get_source_ref(),
 			"Default clause must be the last clause in a switch statement.",
@@ -3552,7 +3639,7 @@ FunctionDefinitionLowering::extract_from_statement_switch(
 		return false;
 	    }
 	    const Type *test_value_type = function->tmpvar_get(test_value_tmpvar);
-	    if (test_value_type->get_name() != switch_value_type->get_name()) {
+	    if (test_value_type->get_type_id() != switch_value_type->get_type_id()) {
 		Gyoji::owned<Gyoji::context::Error> error = Gyoji::owned_new<Gyoji::context::Error>("Case must match switch type");
 		error->add_message(
 		    block_ptr->get_source_ref(),
@@ -3562,8 +3649,7 @@ FunctionDefinitionLowering::extract_from_statement_switch(
 		    statement.get_expression().get_source_ref(),
 		    "Switch declared here."
 		    );
-		compiler_context
-		    .get_errors()
+		errors
 		    .add_error(std::move(error));
 		is_ok = false;
 	    }
@@ -3646,8 +3732,7 @@ FunctionDefinitionLowering::extract_from_statement_break(
     )
 {
     if (!scope_tracker.is_in_loop()) {
-	compiler_context
-	    .get_errors()
+	errors
 	    .add_simple_error(statement.get_source_ref(),
 			      "'break' statement not in loop or switch statement",
 			      "'break' keyword must appear inside a loop (for/while)"
@@ -3655,15 +3740,12 @@ FunctionDefinitionLowering::extract_from_statement_break(
 	return true;
     }
 
-    std::vector<std::string> unwind_break = scope_tracker.get_variables_to_unwind_for_break();
-    leave_scope(unwind_break, statement.get_source_ref());
-    
-    function->add_operation(
+    UnwindList unwind_break = scope_tracker.get_variables_to_unwind_for_break();
+    leave_scope_to(
 	current_block,
-	Gyoji::owned_new<OperationJump>(
-	    statement.get_source_ref(),
-	    scope_tracker.get_loop_break_blockid()
-	    )
+	unwind_break,
+	scope_tracker.get_loop_break_blockid(),
+	statement.get_source_ref()
 	);
     
     return true;
@@ -3675,8 +3757,7 @@ FunctionDefinitionLowering::extract_from_statement_continue(
     )
 {
     if (!scope_tracker.is_in_loop()) {
-	compiler_context
-	    .get_errors()
+	errors
 	    .add_simple_error(statement.get_source_ref(),
 			      "'continue' statement not in loop or switch statement",
 			      "'continue' keyword must appear inside a loop (for/while)"
@@ -3723,8 +3804,7 @@ FunctionDefinitionLowering::extract_from_statement_label(
 			       std::string("Duplicate label ") + label_name);
 	    error->add_message(label->get_source_ref(),
 			       "First declared here.");
-	    compiler_context
-		.get_errors()
+	    errors
 		.add_error(std::move(error));
 	    return true;
 	}
@@ -3781,10 +3861,17 @@ FunctionDefinitionLowering::extract_from_statement_return(
     const StatementReturn & statement
     )
 {
-    std::vector<std::string> unwind_root = scope_tracker.get_variables_to_unwind_for_root();
+    UnwindList unwind_root = scope_tracker.get_variables_to_unwind_for_root();
 
-    if (statement.is_void()) {
-	leave_scope(unwind_root, statement.get_source_ref());
+    if (statement.is_void() && unwind_root.get_first() != unwind_root.get_end()) {
+	leave_scope_to(
+	    current_block,
+	    unwind_root,
+	    get_return_void_block(statement.get_source_ref()),
+	    statement.get_source_ref()
+	    );
+    }
+    else if (statement.is_void()) {
 	function->add_operation(
 	    current_block,
 	    Gyoji::owned_new<OperationReturnVoid>(
@@ -3809,26 +3896,33 @@ FunctionDefinitionLowering::extract_from_statement_return(
     return true;
 }
 
+const Gyoji::mir::Symbol *
+FunctionDefinitionLowering::get_destructor(const Type *class_type)
+{
+    const auto & it = destructors.find(class_type);
+    if (it != destructors.end()) {
+	return it->second;
+    }
+    // Where to find the leaf-node "Foo" part of the class name????
+    std::string fully_qualified_function_name(class_type->get_name() + std::string("::~") + class_type->get_simple_name());
+    const Gyoji::mir::Symbol *symbol = mir.get_symbols().get_symbol(fully_qualified_function_name);
+    destructors.insert(std::pair(class_type, symbol));
+    return symbol;
+}
+
 size_t
 FunctionDefinitionLowering::undeclare_local(
-    const std::string & variable_name,
-    const Type *class_type,
+    const LocalVariable & variable,
     size_t basic_block_id,
     size_t location,
     const SourceReference & src_ref
     )
 {
 	size_t n = 0;
+	const Type *class_type = variable.get_type();
 	if (class_type->is_composite()) {
 	    // Look to see if a destructor is declared.
-	    //fprintf(stderr, "Looking for destructor for %s\n", class_type->get_name().c_str());
-	    //for (const auto & method : class_type->get_methods()) {
-	    //	fprintf(stderr, "    Method %s\n", method.first.c_str());
-	    //}
-	    // Where to find the leaf-node "Foo" part of the class name????
-	    std::string fully_qualified_function_name(class_type->get_name() + std::string("::~") + class_type->get_simple_name());
-	    
-	    const Gyoji::mir::Symbol *symbol = mir.get_symbols().get_symbol(fully_qualified_function_name);
+	    const Gyoji::mir::Symbol *symbol = get_destructor(class_type);
 	    if (symbol != nullptr) {
 		//fprintf(stderr, "Found destructor\n");
 		const Type *destructor_fptr_type = symbol->get_mir_type();
@@ -3844,7 +3938,9 @@ FunctionDefinitionLowering::undeclare_local(
 		    Gyoji::owned_new<OperationLocalVariable>(
 			src_ref,
 			variable_tmpvar,
-			variable_name,
+			mir.get_atoms(),
+			variable.get_atom(),
+			variable.get_declaration_id(),
 			class_type
 			)
 		    );
@@ -3878,7 +3974,7 @@ FunctionDefinitionLowering::undeclare_local(
 			src_ref,
 			destructor_fptr_tmpvar,
 			partial_operands,
-			fully_qualified_function_name
+			symbol->get_name()
 			)
 		    );
 		location++;
@@ -3908,7 +4004,9 @@ FunctionDefinitionLowering::undeclare_local(
 	    location,
 	    Gyoji::owned_new<OperationLocalUndeclare>(
 		src_ref,
-		variable_name
+		mir.get_atoms(),
+		variable.get_atom(),
+		variable.get_declaration_id()
 		)
 	    );
 	location++;
@@ -3918,18 +4016,92 @@ FunctionDefinitionLowering::undeclare_local(
 
 void
 FunctionDefinitionLowering::leave_scope(
-    std::vector<std::string> & unwind,
+    const UnwindList & unwind,
     const SourceReference & src_ref
     )
 {
     const BasicBlock & block = function->get_basic_block(current_block);
     size_t location = block.get_operations().size();
-    for (const auto & variable_name : unwind) {
-	const LocalVariable *localvar = scope_tracker.get_variable(variable_name);
-	const Type *class_type = localvar->get_type();
-	location += undeclare_local(variable_name, class_type, current_block, location, src_ref);
+    for (const LocalVariable *variable = unwind.get_first(); variable != unwind.get_end(); variable = variable->get_previous()) {
+	location += undeclare_local(*variable, current_block, location, src_ref);
     }
-    unwind.clear();
+}
+
+void
+FunctionDefinitionLowering::leave_scope_to(
+    size_t blockid,
+    const UnwindList & unwind,
+    size_t target_blockid,
+    const SourceReference & src_ref
+    )
+{
+    size_t cleanup_blockid = get_cleanup_block(unwind.get_first(), unwind.get_end(), target_blockid, src_ref);
+    function->add_operation(
+	blockid,
+	Gyoji::owned_new<OperationJump>(
+	    src_ref,
+	    cleanup_blockid
+	    )
+	);
+}
+
+size_t
+FunctionDefinitionLowering::get_cleanup_block(
+    const LocalVariable *variable,
+    const LocalVariable *end,
+    size_t target_blockid,
+    const SourceReference & src_ref
+    )
+{
+    if (variable == end) {
+	return target_blockid;
+    }
+    const auto key = std::pair(variable, target_blockid);
+    const auto & it = cleanup_blocks.find(key);
+    if (it != cleanup_blocks.end()) {
+	// Without this block, the exit would have
+	// had to repeat all of this unwinding.
+	function->add_shared_cleanup_operations(it->second.second);
+	return it->second.first;
+    }
+
+    // The variables declared before this one are unwound
+    // next, and another exit may already have made the
+    // blocks to do that.
+    size_t next_blockid = get_cleanup_block(variable->get_previous(), end, target_blockid, src_ref);
+    size_t operations = 0;
+    if (variable->get_previous() != end) {
+	operations = cleanup_blocks.at(std::pair(variable->get_previous(), target_blockid)).second;
+    }
+    
+    size_t blockid = function->add_block();
+    operations += undeclare_local(*variable, blockid, 0, src_ref);
+    function->add_operation(
+	blockid,
+	Gyoji::owned_new<OperationJump>(
+	    src_ref,
+	    next_blockid
+	    )
+	);
+    cleanup_blocks.insert(std::pair(key, std::pair(blockid, operations)));
+    return blockid;
+}
+
+size_t
+FunctionDefinitionLowering::get_return_void_block(const SourceReference & src_ref)
+{
+    if (has_return_void_block) {
+	return return_void_block;
+    }
+    return_void_block = function->add_block();
+    has_return_void_block = true;
+    function->add_operation(
+	return_void_block,
+	Gyoji::owned_new<OperationReturnVoid>(
+	    src_ref
+	    )
+	);
+    return return_void_block;
 }
 	    
 bool
@@ -4047,7 +4219,7 @@ FunctionDefinitionLowering::extract_from_statement_list(
     // the scope unwinding based on the end of
     // the function (if it is reachable)
     if (!current_block_terminated && automatic_unwind) {
-	std::vector<std::string> unwind_scope = scope_tracker.get_variables_to_unwind_for_scope();
+	UnwindList unwind_scope = scope_tracker.get_variables_to_unwind_for_scope();
 	// Get the type of the unwound variable.  If it's a class, call the destructor.
 	leave_scope(unwind_scope, statement_list.get_source_ref());
     }
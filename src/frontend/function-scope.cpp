@@ -79,6 +79,7 @@ ScopeOperation::ScopeOperation(
     )
     : type(_type)
     , source_ref(_source_ref)
+    , variable(nullptr)
 {}
 
 ScopeOperation::~ScopeOperation()
@@ -100,24 +101,26 @@ const FunctionPoint &
 ScopeOperation::get_goto_point() const
 { return *goto_point; }
 
+const LocalVariable *
+ScopeOperation::get_variable() const
+{ return variable; }
+
 const std::string &
 ScopeOperation::get_variable_name() const
-{ return variable_name; }
+{ return variable->get_name(); }
 
 const Gyoji::mir::Type *
 ScopeOperation::get_variable_type() const
-{ return variable_type; }
+{ return variable->get_type(); }
 
 Gyoji::owned<ScopeOperation>
 ScopeOperation::create_variable(
-    std::string _variable_name,
-    const Gyoji::mir::Type *_variable_type,
+    const LocalVariable *_variable,
     const Gyoji::context::SourceReference & _source_ref
     )
 {
     auto op = Gyoji::owned<ScopeOperation>(new ScopeOperation(ScopeOperation::VAR_DECL, _source_ref));
-    op->variable_name = _variable_name;
-    op->variable_type = _variable_type;
+    op->variable = _variable;
     return op;
 }
 Gyoji::owned<ScopeOperation>
@@ -168,6 +171,9 @@ Scope::Scope(bool _is_unsafe)
     , scope_is_unsafe(_is_unsafe)
     , loop_break_blockid(0)
     , loop_continue_blockid(0)
+    , last_variable(nullptr)
+    , unwind_start(nullptr)
+    , break_end(nullptr)
 {}
 
 Scope::Scope(
@@ -181,6 +187,9 @@ Scope::Scope(
     , scope_is_unsafe(_is_unsafe)
     , loop_break_blockid(_loop_break_blockid)
     , loop_continue_blockid(_loop_continue_blockid)
+    , last_variable(nullptr)
+    , unwind_start(nullptr)
+    , break_end(nullptr)
 {}
 
 Scope::~Scope()
@@ -220,21 +229,39 @@ size_t
 Scope::get_loop_continue_blockid() const
 { return loop_continue_blockid; }
 
-void
-Scope::add_variable(std::string name, const Gyoji::mir::Type *mir_type, const Gyoji::context::SourceReference & source_ref)
+const LocalVariable *
+Scope::add_variable(
+    std::string name,
+    Gyoji::context::Atom atom,
+    size_t declaration_id,
+    const Gyoji::mir::Type *mir_type,
+    const Gyoji::context::SourceReference & source_ref
+    )
 {
-    Gyoji::owned<LocalVariable> local_variable = Gyoji::owned_new<LocalVariable>(mir_type, source_ref);
-    variables.insert(std::pair(name, std::move(local_variable)));
-    variables_in_declaration_order.push_back(name);
+    Gyoji::owned<LocalVariable> local_variable = Gyoji::owned_new<LocalVariable>(name, atom, declaration_id, mir_type, source_ref, last_variable);
+    const LocalVariable *added = local_variable.get();
+    if (!variables.insert(std::pair(name, std::move(local_variable))).second) {
+	return nullptr;
+    }
+    last_variable = added;
+    return added;
 }
 
 const std::map<std::string, Gyoji::owned<LocalVariable>> &
 Scope::get_variables() const
 { return variables; }
 
-const std::vector<std::string> &
-Scope::get_variables_in_declaration_order() const
-{ return variables_in_declaration_order; }
+const LocalVariable *
+Scope::get_last_variable() const
+{ return last_variable; }
+
+const LocalVariable *
+Scope::get_unwind_start() const
+{ return unwind_start; }
+
+const LocalVariable *
+Scope::get_break_end() const
+{ return break_end; }
 
 Scope *
 Scope::get_parent() const
@@ -242,16 +269,32 @@ Scope::get_parent() const
 
 void
 Scope::set_parent(Scope *_parent)
-{ parent = _parent; }
+{
+    parent = _parent;
+    last_variable = parent->get_last_variable();
+    unwind_start = last_variable;
+    // A 'break' unwinds every loop scope it is
+    // directly inside of, so it ends where the
+    // outermost of them started.
+    if (scope_is_loop && parent->is_loop()) {
+	break_end = parent->get_break_end();
+    }
+    else {
+	break_end = unwind_start;
+    }
+}
 
 ///////////////////////////////////////////////////
 // ScopeTracker
 ///////////////////////////////////////////////////
 ScopeTracker::ScopeTracker(
     bool _root_is_unsafe,
-    const Gyoji::context::CompilerContext & _compiler_context)
+    Gyoji::context::AtomTable & _atoms,
+    Gyoji::context::Errors & _errors)
     : root(Gyoji::owned_new<Scope>(_root_is_unsafe))
-    , compiler_context(_compiler_context)
+    , atoms(_atoms)
+    , errors(_errors)
+    , declaration_count(0)
     , tracker_prior_point()
     , tracker_backward_edges()
     , tracker_flat()
@@ -393,6 +436,10 @@ ScopeTracker::add_goto(
     add_operation(std::move(op));
 }
 
+size_t
+ScopeTracker::declaration_reserve()
+{ return declaration_count++; }
+
 const LocalVariable *
 ScopeTracker::get_variable(std::string variable_name) const
 {
@@ -409,49 +456,24 @@ ScopeTracker::get_variable(std::string variable_name) const
     return nullptr;
 }
 
-std::vector<std::string>
+// The variables in scope are kept most recent first,
+// which is already the order to call the destructors in,
+// so each of these only has to say where to stop.
+UnwindList
 ScopeTracker::get_variables_to_unwind_for_root() const
-{
-    std::vector<std::string> variables_to_unwind;
-    const Scope *s = current;
-    while (s) {
-	// Reverse order because we want to
-	// call destructors in the reverse order of declaration.
-	auto & vars = s->get_variables_in_declaration_order();
-	for (std::vector<std::string>::const_reverse_iterator it = vars.rbegin(); it != vars.rend(); ++it) {
-	    variables_to_unwind.push_back(*it);
-	}
-	s = s->get_parent();
-    }
-    return variables_to_unwind;
-}
+{ return UnwindList(current->get_last_variable(), nullptr); }
 
-std::vector<std::string>
+UnwindList
 ScopeTracker::get_variables_to_unwind_for_scope() const
-{
-    std::vector<std::string> variables_to_unwind;
-    const Scope *s = current;
-    const auto & vars = s->get_variables_in_declaration_order();
-    for (std::vector<std::string>::const_reverse_iterator it = vars.rbegin(); it != vars.rend(); ++it) {
-	variables_to_unwind.push_back(*it);
-    }
-    return variables_to_unwind;
-}
+{ return UnwindList(current->get_last_variable(), current->get_unwind_start()); }
 
-std::vector<std::string>
+UnwindList
 ScopeTracker::get_variables_to_unwind_for_break() const
 {
-    std::vector<std::string> variables_to_unwind;
-    const Scope *s = current;
-    while (s && s->is_loop()) {
-	const auto & vars = s->get_variables_in_declaration_order();
-	for (std::vector<std::string>::const_reverse_iterator it = vars.rbegin(); it != vars.rend(); ++it) {
-	    variables_to_unwind.push_back(*it);
-	}
-	s = s->get_parent();
+    if (!current->is_loop()) {
+	return UnwindList(current->get_last_variable(), current->get_last_variable());
     }
-    return variables_to_unwind;
-
+    return UnwindList(current->get_last_variable(), current->get_break_end());
 }
 
 const Scope *
@@ -486,8 +508,7 @@ ScopeTracker::add_variable(std::string variable_name, const Gyoji::mir::Type *mi
 	error->add_message(maybe_existing->get_source_ref(),
 			   "First declared here.");
 	
-	compiler_context
-	    .get_errors()
+	errors
 	    .add_error(std::move(error));
 	return false;
     }
@@ -495,9 +516,9 @@ ScopeTracker::add_variable(std::string variable_name, const Gyoji::mir::Type *mi
     
     // Variable was not declared earlier, so we add it to
     // the current scope.
-    current->add_variable(variable_name, mir_type, source_ref);
+    const LocalVariable *local_variable = current->add_variable(variable_name, atoms.intern(variable_name), declaration_reserve(), mir_type, source_ref);
     
-    auto local_var_op = ScopeOperation::create_variable(variable_name, mir_type, source_ref);
+    auto local_var_op = ScopeOperation::create_variable(local_variable, source_ref);
     add_flat_op(local_var_op.get());
     add_operation(std::move(local_var_op));
 
@@ -595,8 +616,7 @@ ScopeTracker::check(
 	    Gyoji::owned<Gyoji::context::Error> error = Gyoji::owned_new<Gyoji::context::Error>("Goto for an un-defined label.");
 	    error->add_message(goto_operation->get_source_ref(),
 			       std::string("Goto label ") + goto_operation->get_goto_label() + " had an undefined destination.");
-	    compiler_context
-		.get_errors()
+	    errors
 		.add_error(std::move(error));
 	    ok = false;
 	    continue;
@@ -628,8 +648,7 @@ ScopeTracker::check(
 			       "Label declared here.");
 	    error->add_message(skipped_initializations.at(0)->get_source_ref(),
 			       "Skipped initialization occurs here.");
-	    compiler_context
-		.get_errors()
+	    errors
 		.add_error(std::move(error));
 	    ok = false;
 	}
@@ -653,7 +672,7 @@ ScopeOperation::dump(int indent) const
     switch (type) {
     case ScopeOperation::VAR_DECL:
     {
-	std::string var = pad + std::string("var ") + variable_name;
+	std::string var = pad + std::string("var ") + get_variable_name();
 	fprintf(stderr, "%s\n", var.c_str());
     }
 	break;
@@ -692,16 +711,36 @@ Scope::dump(int indent) const
 
 ///////////////////////////////////////////
 LocalVariable::LocalVariable(
+    std::string _name,
+    Gyoji::context::Atom _atom,
+    size_t _declaration_id,
     const Gyoji::mir::Type *_type,
-    const Gyoji::context::SourceReference & _source_ref
+    const Gyoji::context::SourceReference & _source_ref,
+    const LocalVariable *_previous
     )
-    : type(_type)
+    : name(_name)
+    , atom(_atom)
+    , declaration_id(_declaration_id)
+    , type(_type)
     , source_ref(_source_ref)
+    , previous(_previous)
 {}
 
 LocalVariable::~LocalVariable()
 {}
 
+const std::string &
+LocalVariable::get_name() const
+{ return name; }
+
+Gyoji::context::Atom
+LocalVariable::get_atom() const
+{ return atom; }
+
+size_t
+LocalVariable::get_declaration_id() const
+{ return declaration_id; }
+
 const Gyoji::mir::Type *
 LocalVariable::get_type() const
 { return type; }
@@ -709,6 +748,29 @@ LocalVariable::get_type() const
 const Gyoji::context::SourceReference &
 LocalVariable::get_source_ref() const
 { return source_ref; }
+
+const LocalVariable *
+LocalVariable::get_previous() const
+{ return previous; }
+
+/////////////////////////////////////
+// UnwindList
+/////////////////////////////////////
+UnwindList::UnwindList(const LocalVariable *_first, const LocalVariable *_end)
+    : first(_first)
+    , end(_end)
+{}
+
+UnwindList::~UnwindList()
+{}
+
+const LocalVariable *
+UnwindList::get_first() const
+{ return first; }
+
+const LocalVariable *
+UnwindList::get_end() const
+{ return end; }
  
 /////////////////////////////////////
 // FunctionLabel
@@ -718,14 +780,14 @@ FunctionLabel::FunctionLabel(
     )
     : resolved(false)
     , block_id(_block_id)
-    , src_ref(nullptr)
+    , src_ref(Gyoji::context::TokenStream::get_zero_source_ref())
 {}
 FunctionLabel::~FunctionLabel()
 {}
 
 const Gyoji::context::SourceReference &
 FunctionLabel::get_source_ref() const
-{ return *src_ref; }
+{ return src_ref; }
 
 size_t
 FunctionLabel::get_block() const
@@ -739,7 +801,7 @@ void
 FunctionLabel::resolve(const Gyoji::context::SourceReference & _src_ref)
 {
     resolved = true;
-    src_ref = &_src_ref;
+    src_ref = _src_ref;
 }
 
 ////////////////////////////////////////////////
@@ -17,11 +17,14 @@
 #include <functional>
 #include <list>
 #include <map>
+#include <set>
 #include <string>
+#include <string_view>
 #include <memory>
 #include <variant>
 
 #include <gyoji-misc/pointers.hpp>
+#include <gyoji-misc/arena.hpp>
 #include <gyoji-misc/input-source.hpp>
 #include <gyoji-context.hpp>
 #include <gyoji-mir.hpp>
@@ -35,6 +38,7 @@
 #include <gyoji-frontend/tree.hpp>
 #include <gyoji-frontend/parse-result.hpp>
 #include <gyoji-frontend/parser.hpp>
+#include <gyoji-frontend/preprocessor.hpp>
 #include <gyoji-frontend/type-lowering.hpp>
 #include <gyoji-frontend/function-lowering.hpp>
 #include <gyoji-frontend/lex-context.hpp>
@@ -45,13 +45,19 @@ namespace Gyoji::frontend::lowering {
      * statements inside the function definition and emits MIR code that matches
      * the intend.  In addition, rules for the validity of the program are
      * evaluated so that grossly invalid programs never make it to the MIR level.
-     * Semantic errors are reported through the CompilerContext in the form
-     * of context-aware messages that highlight where the error took place.
+     * Semantic errors are reported in the form of context-aware messages
+     * that highlight where the error took place.
+     *
+     * Several functions may be lowered at the same time (see FunctionLowering),
+     * so errors are reported into an Errors buffer belonging only to this
+     * function and the lowered function is added to a function table of its
+     * own rather than to the MIR.
      */
     class FunctionDefinitionLowering {
     public:
 	FunctionDefinitionLowering(
-	    Gyoji::context::CompilerContext & _compiler_context,
+	    Gyoji::context::Errors & _errors,
+	    Gyoji::mir::Functions & _functions,
 	    const Gyoji::frontend::tree::FileStatementFunctionDefinition & _function_definition,
 	    Gyoji::mir::MIR & _mir,
 	    TypeLowering & _type_lowering
@@ -74,7 +80,8 @@ namespace Gyoji::frontend::lowering {
 
     private:
 	// Private members
-	Gyoji::context::CompilerContext & compiler_context;
+	Gyoji::context::Errors & errors;
+	Gyoji::mir::Functions & functions;
 	const Gyoji::frontend::tree::FileStatementFunctionDefinition & function_definition;
 	Gyoji::mir::MIR & mir;
 	TypeLowering & type_lowering;
@@ -82,12 +89,33 @@ namespace Gyoji::frontend::lowering {
 	const Gyoji::mir::Type * class_type;
 	const Gyoji::mir::Type * class_pointer_type;
 	const Gyoji::mir::TypeMethod *method;
+	// Declaration id of the implicit 'this'
+	// argument if this is a method.
+	size_t this_declaration_id;
 
 	bool is_method() const;
 	
 	Gyoji::owned<Gyoji::mir::Function> function;
 	size_t current_block;
 
+	// The destructor of each class that has gone
+	// out of scope, or nullptr if it has none, so
+	// its name is only built and looked up once.
+	std::map<const Gyoji::mir::Type*, const Gyoji::mir::Symbol*> destructors;
+
+	// The cleanup blocks made so far, keyed by the first
+	// variable each one unwinds and the block it ends up
+	// at, along with the number of operations found in
+	// that cleanup block and the ones it jumps to.
+	std::map<
+	    std::pair<const LocalVariable*, size_t>,
+	    std::pair<size_t, size_t>
+	    > cleanup_blocks;
+	// The block that a void function returns from
+	// once it has been unwound, if there is one yet.
+	bool has_return_void_block;
+	size_t return_void_block;
+
 	// Private Methods
 
 	// Returns the current point in the current block
@@ -123,6 +151,7 @@ namespace Gyoji::frontend::lowering {
 	    );
 	
 	bool local_declare_or_error(
+	    size_t & declaration_id,
 	    const Gyoji::mir::Type *mir_type,
 	    const std::string & name,
 	    const Gyoji::context::SourceReference & source_ref
@@ -315,18 +344,59 @@ namespace Gyoji::frontend::lowering {
 	 * If there is an applicable destructor, it is called to
 	 * ensure any associated cleanup is done.
 	 */
+	const Gyoji::mir::Symbol *get_destructor(const Gyoji::mir::Type *class_type);
+
 	size_t undeclare_local(
-	    const std::string & variable_name,
-	    const Gyoji::mir::Type *class_type,
+	    const LocalVariable & variable,
 	    size_t basic_block_id,
 	    size_t location,
 	    const Gyoji::context::SourceReference & src_ref
 	    );
 
 	void leave_scope(
-	    std::vector<std::string> & unwind,
+	    const UnwindList & unwind,
 	    const Gyoji::context::SourceReference & src_ref
 	    );
+
+	/**
+	 * Leaves the given block for the target block, unwinding
+	 * the variables on the way.  Rather than placing the
+	 * unwinding in the block itself, this jumps into the
+	 * cleanup blocks for those variables, which are shared
+	 * by every exit unwinding the same variables to the
+	 * same target.
+	 */
+	void leave_scope_to(
+	    size_t blockid,
+	    const UnwindList & unwind,
+	    size_t target_blockid,
+	    const Gyoji::context::SourceReference & src_ref
+	    );
+
+	/**
+	 * Returns the cleanup block that unwinds the given
+	 * variable, then those declared before it up to
+	 * (but not including) the end, and then jumps to the
+	 * target block, making it if it doesn't exist yet.
+	 * The target decides where the unwinding ends, since
+	 * every exit to the same place leaves the same scopes.
+	 * The destructor calls and un-declarations in it refer
+	 * to each variable by its declaration id, so it unwinds
+	 * the same objects no matter which exit jumps to it,
+	 * even when other variables share their names.
+	 */
+	size_t get_cleanup_block(
+	    const LocalVariable *variable,
+	    const LocalVariable *end,
+	    size_t target_blockid,
+	    const Gyoji::context::SourceReference & src_ref
+	    );
+
+	/**
+	 * Returns the block that returns from a void function,
+	 * which the cleanup blocks for 'return' jump to.
+	 */
+	size_t get_return_void_block(const Gyoji::context::SourceReference & src_ref);
 	
 	bool extract_from_statement_list(
 	    bool automatic_unwind,
@@ -348,6 +418,15 @@ namespace Gyoji::frontend::lowering {
      * This process is mainly performed by using one
      * FunctionDefinitionLowering for each function found in
      * the translation unit.
+     *
+     * The functions are independent of one another, so they
+     * are lowered by a pool of threads, each taking the next
+     * function that nobody has started yet.  Each function
+     * reports its errors into a buffer and adds itself to a
+     * function table of its own, and the buffers are merged
+     * into the compiler context and the MIR once all of the
+     * functions are done.  The result is the same no matter
+     * how many threads are used.
      */
     class FunctionLowering {
     public:
@@ -356,15 +435,17 @@ namespace Gyoji::frontend::lowering {
 	 * Constructs a function resolver using the
 	 * compiler context, parse result, and an MIR
 	 * to act as the destination of the parse.
-	 * This makes use of the TypeLowering which will
-	 * already have been used to extract type information
-	 * from the translation unit.
+	 * The types of the translation unit must already
+	 * have been lowered into the MIR (see TypeLowering).
+	 * Up to the given number of threads are used to
+	 * lower the functions.  A thread count of zero or one
+	 * lowers everything on the calling thread.
 	 */
 	FunctionLowering(
 	    Gyoji::context::CompilerContext & _compiler_context,
-	    const Gyoji::frontend::ParseResult & _parse_result,
+	    Gyoji::frontend::ParseResult & _parse_result,
 	    Gyoji::mir::MIR & _mir,
-	    TypeLowering & _type_lowering
+	    size_t _threads
 	    );
 	
 	/**
@@ -378,14 +459,20 @@ namespace Gyoji::frontend::lowering {
 	/**
 	 * Iterates all of the functions in the translation unit
 	 * given by the parse result and lowers each one of them,
-	 * inserting the results into the MIR.
+	 * inserting the results into the MIR.  If a function
+	 * can't be lowered, the functions after it are left
+	 * out, just as if they were lowered one at a time.
 	 */
 	bool lower();
     private:
 	Gyoji::context::CompilerContext & compiler_context;
-	const Gyoji::frontend::ParseResult & parse_result;
+	Gyoji::frontend::ParseResult & parse_result;
 	Gyoji::mir::MIR & mir;
-	TypeLowering & type_lowering;
+	size_t threads;
+
+	// The function definitions to lower,
+	// in the order they appear in the source.
+	std::vector<const Gyoji::frontend::tree::FileStatementFunctionDefinition*> definitions;
 	
 	bool extract_from_class_definition(const Gyoji::frontend::tree::ClassDefinition & definition);
 	bool extract_from_namespace(
@@ -88,8 +88,7 @@ namespace Gyoji::frontend::lowering {
 	~ScopeOperation();
 
 	static Gyoji::owned<ScopeOperation> create_variable(
-	    std::string _variable_name,
-	    const Gyoji::mir::Type *_variable_type,
+	    const LocalVariable *_variable,
 	    const Gyoji::context::SourceReference & _source_ref
 	    );
 	static Gyoji::owned<ScopeOperation> create_label(
@@ -113,6 +112,7 @@ namespace Gyoji::frontend::lowering {
 	const std::string & get_goto_label() const;
 	const FunctionPoint & get_goto_point() const;
 	
+	const LocalVariable *get_variable() const;
 	const std::string & get_variable_name() const;
 	const Gyoji::mir::Type *get_variable_type() const;
 	const Scope *get_child() const;
@@ -127,10 +127,9 @@ namespace Gyoji::frontend::lowering {
 	    );
 	ScopeOperationType type;
 
-	const Gyoji::context::SourceReference & source_ref;
+	Gyoji::context::SourceReference source_ref;
 
-	const Gyoji::mir::Type *variable_type;
-	std::string variable_name;
+	const LocalVariable *variable;
 	
 	std::string label_name;
 	
@@ -140,11 +139,27 @@ namespace Gyoji::frontend::lowering {
 	Gyoji::owned<Scope> child;
     };
 
+    /**
+     * @brief A variable declared in a scope.
+     * @details
+     * Each variable also links to the variable declared
+     * just before it that is still in scope, whether in
+     * the same scope or one of its ancestors.  Following
+     * these links from the most recent variable gives the
+     * variables in the order they must be unwound.  Since
+     * a variable never changes once declared, the scopes
+     * all share one list, each one only adding to the front
+     * of the list of its parent (see UnwindList).
+     */
     class LocalVariable {
     public:
 	LocalVariable(
+	    std::string _name,
+	    Gyoji::context::Atom _atom,
+	    size_t _declaration_id,
 	    const Gyoji::mir::Type *_type,
-	    const Gyoji::context::SourceReference & _source_ref
+	    const Gyoji::context::SourceReference & _source_ref,
+	    const LocalVariable *_previous
 	    );
 	/**
 	 * @brief Move along, nothing to see here.
@@ -153,11 +168,59 @@ namespace Gyoji::frontend::lowering {
 	 * Move along, nothing to see here.
 	 */
 	~LocalVariable();
+	const std::string & get_name() const;
+	Gyoji::context::Atom get_atom() const;
+	/**
+	 * Identifies this declaration in the MIR
+	 * (see Gyoji::mir::OperationLocalDeclare::get_declaration_id()),
+	 * since other variables in the function may have the
+	 * same name.
+	 */
+	size_t get_declaration_id() const;
 	const Gyoji::mir::Type *get_type() const;
 	const Gyoji::context::SourceReference & get_source_ref() const;
+	/**
+	 * Returns the variable declared just before this
+	 * one that is still in scope, or nullptr if this is
+	 * the first variable of the function.
+	 */
+	const LocalVariable *get_previous() const;
     private:
+	std::string name;
+	Gyoji::context::Atom atom;
+	size_t declaration_id;
 	const Gyoji::mir::Type *type;
-	const Gyoji::context::SourceReference & source_ref;
+	Gyoji::context::SourceReference source_ref;
+	const LocalVariable *previous;
+    };
+
+    /**
+     * @brief Variables to unwind when leaving one or more scopes.
+     * @details
+     * This is the part of the list of variables in scope
+     * (see LocalVariable) from the most recently declared
+     * variable up to, but not including, the last variable
+     * that stays in scope.  Walking it from get_first()
+     * through get_previous() until get_end() gives the
+     * variables in the order their destructors must be
+     * called.  Making one copies nothing, so it costs the
+     * same no matter how deeply the scopes are nested.
+     */
+    class UnwindList {
+    public:
+	UnwindList(const LocalVariable *_first, const LocalVariable *_end);
+	/**
+	 * @brief Move along, nothing to see here.
+	 *
+	 * @details
+	 * Move along, nothing to see here.
+	 */
+	~UnwindList();
+	const LocalVariable *get_first() const;
+	const LocalVariable *get_end() const;
+    private:
+	const LocalVariable *first;
+	const LocalVariable *end;
     };
 
     /**
@@ -227,14 +290,47 @@ namespace Gyoji::frontend::lowering {
 	
 	size_t get_loop_continue_blockid() const;
 
-	void add_variable(std::string name, const Gyoji::mir::Type *mir_type, const Gyoji::context::SourceReference & source_ref);
+	/**
+	 * Declares a variable in this scope, returning
+	 * the new variable, or nullptr if one with the same
+	 * name was already declared here.
+	 */
+	const LocalVariable *add_variable(
+	    std::string name,
+	    Gyoji::context::Atom atom,
+	    size_t declaration_id,
+	    const Gyoji::mir::Type *mir_type,
+	    const Gyoji::context::SourceReference & source_ref
+	    );
     
 	const std::map<std::string, Gyoji::owned<LocalVariable>> & get_variables() const;
 
-	const std::vector<std::string> & get_variables_in_declaration_order() const;
+	/**
+	 * Returns the most recently declared variable in
+	 * scope, which may belong to an ancestor.
+	 */
+	const LocalVariable *get_last_variable() const;
+
+	/**
+	 * Returns the last variable that was in scope
+	 * when this scope was entered.
+	 */
+	const LocalVariable *get_unwind_start() const;
+
+	/**
+	 * For a loop, returns the last variable in scope
+	 * outside of this loop and any loops directly
+	 * around it, which is where a 'break' stops unwinding.
+	 */
+	const LocalVariable *get_break_end() const;
 
 	Scope *get_parent() const;
 	
+	/**
+	 * Sets the parent of this scope.  The scope starts
+	 * out with the variables of the parent in scope, so
+	 * this should be done before any are declared here.
+	 */
 	void set_parent(Scope *_parent);
 	
     private:
@@ -251,7 +347,9 @@ namespace Gyoji::frontend::lowering {
 	
 	std::vector<Gyoji::owned<ScopeOperation>> operations;
 	std::map<std::string, Gyoji::owned<LocalVariable>> variables;
-	std::vector<std::string> variables_in_declaration_order;
+	const LocalVariable *last_variable;
+	const LocalVariable *unwind_start;
+	const LocalVariable *break_end;
     };
 
     /**
@@ -294,7 +392,7 @@ namespace Gyoji::frontend::lowering {
     private:
 	bool resolved;
 	size_t block_id;
-	const Gyoji::context::SourceReference * src_ref;
+	Gyoji::context::SourceReference src_ref;
     };
 
     /**
@@ -325,9 +423,15 @@ namespace Gyoji::frontend::lowering {
      */
     class ScopeTracker {
     public:
+	/**
+	 * Variable names are interned in the given atom
+	 * table as they are declared so that the lowering
+	 * can refer to them without looking them up again.
+	 */
 	ScopeTracker(
 	    bool _root_is_unsafe,
-	    const Gyoji::context::CompilerContext & _compiler_context
+	    Gyoji::context::AtomTable & _atoms,
+	    Gyoji::context::Errors & _errors
 	    );
 	/**
 	 * @brief Move along, nothing to see here.
@@ -400,8 +504,17 @@ namespace Gyoji::frontend::lowering {
 
 	/**
 	 * Defines a variable in the current scope.
+	 * Each variable gets the next declaration id
+	 * in the order they are defined.
 	 */
 	bool add_variable(std::string variable_name, const Gyoji::mir::Type *mir_type, const Gyoji::context::SourceReference & source_ref);
+
+	/**
+	 * Takes the next declaration id for a variable
+	 * that is never looked up by name, like the
+	 * implicit 'this' argument of a method.
+	 */
+	size_t declaration_reserve();
 	
 	void dump() const;
 
@@ -460,16 +573,21 @@ namespace Gyoji::frontend::lowering {
 	 * to unwind (in order) to get back
 	 * to the root (like for a return).
 	 */
-	std::vector<std::string> get_variables_to_unwind_for_root() const;
+	UnwindList get_variables_to_unwind_for_root() const;
 
 	/**
 	 * Returns the list of variables
-	 * to unwind (in order) to get back
-	 * to the root (like for a return).
+	 * to unwind (in order) to leave
+	 * the current scope.
 	 */
-	std::vector<std::string> get_variables_to_unwind_for_scope() const;
+	UnwindList get_variables_to_unwind_for_scope() const;
 	
-	std::vector<std::string> get_variables_to_unwind_for_break() const;
+	/**
+	 * Returns the list of variables
+	 * to unwind (in order) to break
+	 * out of the current loop.
+	 */
+	UnwindList get_variables_to_unwind_for_break() const;
 
         /**
 	 * Returns the list of variables
@@ -492,7 +610,9 @@ namespace Gyoji::frontend::lowering {
 
 	Gyoji::owned<Scope> root;
 	Scope *current;
-	const Gyoji::context::CompilerContext & compiler_context;
+	Gyoji::context::AtomTable & atoms;
+	Gyoji::context::Errors & errors;
+	size_t declaration_count;
 	
 	// Labels that actually have a definition.
 	std::map<std::string, Gyoji::owned<FunctionLabel>> labels;
@@ -20,15 +20,72 @@
 namespace Gyoji::frontend::yacc {
     class LexContext {
     public:
+	/**
+	 * Creates the state of the lexer for one input.
+	 * When _keep_trivia is false, whitespace and comments
+	 * are skipped without making tokens or non-syntax
+	 * nodes for them, so the input can no longer be
+	 * reproduced from the tokens or the syntax tree.
+	 * Lines and columns are counted either way.
+	 */
 	LexContext(
 	    Gyoji::frontend::namespaces::NS2Context &_ns2_context,
 	    Gyoji::context::CompilerContext & _compiler_context,
-	    Gyoji::misc::InputSource &_input_source);
+	    Gyoji::misc::InputSource &_input_source,
+	    bool _keep_trivia);
 	~LexContext();
+	/**
+	 * @brief Points the scanner at the whole of the input.
+	 *
+	 * @details
+	 * Reads all of the input at once (for a memory-mapped
+	 * file this costs nothing) and has the scanner work
+	 * on it in place rather than asking for it a piece at
+	 * a time.  The text is handed to the token stream,
+	 * whose tokens refer to it, so it lives as long as
+	 * the compiler context.  This must be called after
+	 * the scanner has been initialized and before the
+	 * first token is read.  If the input can't be read,
+	 * the error is reported and the scanner is given
+	 * no input at all.
+	 */
+	void scan_input(void *scanner);
+	/**
+	 * @brief Points the scanner at a function body read earlier.
+	 *
+	 * @details
+	 * Has the scanner work in place on the text of a function
+	 * body that was skipped when the input was first scanned.
+	 * The text must be part of the text held by the token stream
+	 * so that the tokens read from it refer to it as well, and
+	 * the caller must have put two NUL bytes after it (flex
+	 * needs them to scan a buffer without copying it).  The
+	 * first token read is DEFERRED_BODY_START, which tells the
+	 * grammar that it is reading statements and not a whole
+	 * translation unit.
+	 */
+	void scan_deferred_body(void *scanner, char *body, size_t size, size_t _line, size_t _column);
 	Gyoji::frontend::namespaces::NS2Context& ns2_context;
 	Gyoji::misc::InputSource & input_source;
 	Gyoji::context::CompilerContext & compiler_context;
 	size_t line;
 	size_t column;
+	bool keep_trivia;
+
+	// Set by the grammar once it has read the opening
+	// brace of a function body that should be skipped.
+	bool defer_body;
+	// Set to read DEFERRED_BODY_START before anything else.
+	bool start_deferred_body;
+	// Where the body being skipped starts and
+	// how deeply its braces are nested so far.
+	const char *deferred_start;
+	size_t deferred_line;
+	size_t deferred_column;
+	size_t deferred_depth;
+	
+	// Whitespace and comments read since the last
+	// terminal, waiting to be attached to the next one.
+	std::vector<Gyoji::owned<Gyoji::frontend::tree::TerminalNonSyntax>> non_syntax_data;
     };
 };
@@ -16,10 +16,12 @@
 #include <memory>
 #include <list>
 #include <map>
+#include <unordered_map>
 #include <vector>
 
 #include <gyoji-misc/pointers.hpp>
 #include <gyoji-context/source-reference.hpp>
+#include <gyoji-context/atoms.hpp>
 
 namespace Gyoji::frontend::namespaces {
     
@@ -70,8 +72,19 @@ namespace Gyoji::frontend::namespaces {
 	    ENTITY_TYPE_LABEL
 	} EntityType;
 	
+	/**
+	 * Creates a new entity whose name is the given
+	 * atom in the atom table.  Entities added beneath
+	 * this one intern their names in the same table
+	 * and count every entity added in the same
+	 * generation counter, which the NS2Context uses
+	 * to know when names it has already resolved
+	 * might resolve differently.
+	 */
 	NS2Entity(
-	    std::string _name,
+	    Gyoji::context::AtomTable & _atoms,
+	    size_t & _generation,
+	    Gyoji::context::Atom _name,
 	    EntityType _type,
 	    NS2Entity *parent,
 	    const Gyoji::context::SourceReference & _source_ref
@@ -91,6 +104,11 @@ namespace Gyoji::frontend::namespaces {
 	 * needed.
 	 */
 	const std::string & get_name() const;
+
+	/**
+	 * Returns the interned atom of the 'simple' name.
+	 */
+	Gyoji::context::Atom get_name_atom() const;
 	
 	std::string get_fully_qualified_name() const;
 
@@ -126,6 +144,14 @@ namespace Gyoji::frontend::namespaces {
 	NS2Entity* add_entity(std::string _name, Gyoji::owned<NS2Entity> _entity);
 	
 	NS2Entity *get_entity(std::string _name) const;
+
+	/**
+	 * Finds the entity directly inside this one
+	 * with the given interned name.  This is the
+	 * fast path used by the lexer, which interns
+	 * each identifier once as it is read.
+	 */
+	NS2Entity *get_entity(Gyoji::context::Atom _name) const;
 	
 	const Gyoji::context::SourceReference & get_source_ref() const;
 
@@ -133,11 +159,19 @@ namespace Gyoji::frontend::namespaces {
 
 	
     private:
-	std::string name;
+	Gyoji::context::AtomTable & atoms;
+	size_t & generation;
+	Gyoji::context::Atom name;
 	EntityType type;
 	NS2Entity *parent;
-	const Gyoji::context::SourceReference & source_ref;
-	std::map<std::string, Gyoji::owned<NS2Entity>> elements;
+	Gyoji::context::SourceReference source_ref;
+	std::map<Gyoji::context::Atom, Gyoji::owned<NS2Entity>> elements;
+
+	NS2Entity* add_child(
+	    std::string _name,
+	    EntityType _type,
+	    const Gyoji::context::SourceReference & _source_ref
+	    );
     };
     
     class NS2SearchPaths {
@@ -160,6 +194,22 @@ namespace Gyoji::frontend::namespaces {
 	NS2Entity *get_name(std::string name);
 
 	const std::vector<std::pair<std::string, NS2Entity*>> & get_aliases() const;
+
+	/**
+	 * Looks up a name already resolved from this
+	 * level of the namespace stack.  Returns false
+	 * if the name has not been resolved here since
+	 * the given generation of the namespaces.  A name
+	 * that resolved to nothing is remembered too,
+	 * in which case the entity returned is nullptr.
+	 */
+	bool get_resolved(Gyoji::context::Atom name, size_t _generation, NS2Entity* & entity);
+	/**
+	 * Remembers what a name resolved to from this
+	 * level of the namespace stack in the given
+	 * generation of the namespaces.
+	 */
+	void add_resolved(Gyoji::context::Atom name, size_t _generation, NS2Entity* entity);
     private:
 	/**
 	 * This is the list of names and associated aliases
@@ -178,8 +228,28 @@ namespace Gyoji::frontend::namespaces {
 	 * to what aliases are currently defined.
 	 */
 	std::map<std::string, NS2Entity*> alias_map;
+
+	/**
+	 * Names resolved from this level of the stack.
+	 * Each level has its own, so entering a namespace
+	 * starts with nothing resolved and leaving it
+	 * throws away what was resolved inside it.  Adding
+	 * a 'using' or any new entity can change what a name
+	 * resolves to, so these are forgotten whenever that
+	 * happens.
+	 */
+	std::unordered_map<Gyoji::context::Atom, NS2Entity*> resolved;
+	size_t resolved_generation;
     };
     
+    /**
+     * A copy of the namespace stack of a context
+     * (see NS2Context::namespace_save) holding, for each
+     * level, the namespace and the 'using' aliases
+     * that were active in it.
+     */
+    typedef std::vector<std::pair<NS2Entity*, std::vector<std::pair<std::string, NS2Entity*>>>> NS2Stack;
+    
     /**
      * This is the context used for namespace
      * resolution.  It consists of a 'stack' structure
@@ -191,7 +261,13 @@ namespace Gyoji::frontend::namespaces {
      */
     class NS2Context {
     public:
-	NS2Context();
+	/**
+	 * Creates a namespace context containing only
+	 * the primitive types.  Names are interned
+	 * in the given atom table, which is normally
+	 * the one owned by the CompilerContext.
+	 */
+	NS2Context(Gyoji::context::AtomTable & _atoms);
 	~NS2Context();
 
 	/**
@@ -227,6 +303,18 @@ namespace Gyoji::frontend::namespaces {
 	
 	NS2Entity* namespace_find(std::string name) const;
 
+	/**
+	 * Resolve a name that has already been interned.
+	 * This gives the same answer as namespace_find()
+	 * given the name as a string, but remembers the
+	 * answer for the current level of the namespace stack
+	 * so that the lexer can classify each identifier it
+	 * sees again with a single lookup.  Simple names are
+	 * resolved by comparing atoms instead of splitting and
+	 * comparing strings.
+	 */
+	NS2Entity* namespace_find(Gyoji::context::Atom name) const;
+
 	NS2Entity *get_current() const;
         /**
 	 * Pushes our namespace resolution context
@@ -234,11 +322,36 @@ namespace Gyoji::frontend::namespaces {
 	 */
 	void namespace_push(NS2Entity *ns);
 	void namespace_pop();
+
+	/**
+	 * @brief Copies the namespace stack.
+	 *
+	 * @details
+	 * The parser uses this to remember the namespaces
+	 * and 'using' aliases in effect where a function body
+	 * starts so that the body can be parsed later on
+	 * (see namespace_restore) as though it had been
+	 * parsed where it appears.
+	 */
+	NS2Stack namespace_save() const;
+	/**
+	 * Replaces the namespace stack with
+	 * one saved by namespace_save().
+	 */
+	void namespace_restore(const NS2Stack & saved);
 	
 	void dump() const;
 	
 	static const std::string NAMESPACE_DELIMITER;
     private:
+	Gyoji::context::AtomTable & atoms;
+
+	/**
+	 * Counts the entities added anywhere
+	 * in the namespaces so that names resolved
+	 * before one was added are resolved again.
+	 */
+	size_t generation;
 
 	/**
 	 * This is the 'root' namespace
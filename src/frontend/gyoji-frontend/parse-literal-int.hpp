@@ -35,7 +35,7 @@ namespace Gyoji::frontend::integers {
     } ParseLiteralIntResult;
 
     bool parse_literal_int(
-	const Gyoji::context::CompilerContext & compiler_context,
+	Gyoji::context::Errors & errors,
 	const Gyoji::mir::Types & types,
 	const Gyoji::frontend::tree::Terminal & literal_int_token,
 	ParseLiteralIntResult & result
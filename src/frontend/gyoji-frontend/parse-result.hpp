@@ -124,6 +124,15 @@ namespace Gyoji::frontend {
 	 * representation of the input.
 	 */
 	const Gyoji::frontend::tree::TranslationUnit & get_translation_unit() const;
+
+	/**
+	 * Returns an estimate of the number of bytes of memory
+	 * held by the parse tree.  Each node is counted at the
+	 * size of the SyntaxNode base class plus its list of
+	 * children, so this is a lower bound that is useful
+	 * for comparing one build against another.
+	 */
+	size_t get_syntax_tree_footprint() const;
 	
 	/**
 	 * This returns the token stream associated with the parse.
@@ -139,6 +148,12 @@ namespace Gyoji::frontend {
 	 * Returns the compiler context that this was parsed for.
 	 */
 	const Gyoji::context::CompilerContext & get_compiler_context() const;
+
+	/**
+	 * Returns true if there are function bodies
+	 * left to parse (see Parser::parse_deferred_body).
+	 */
+	bool has_deferred_bodies() const;
 	
 	friend Gyoji::frontend::yacc::YaccParser;
 	friend Gyoji::frontend::yacc::LexContext;
@@ -193,10 +208,33 @@ namespace Gyoji::frontend {
 	 * This is used internally by the YACC grammar to return the parse tree.
 	 */
 	void set_translation_unit(Gyoji::owned<Gyoji::frontend::tree::TranslationUnit> tu);
+
+	/**
+	 * Used by the YACC grammar to record a function
+	 * body that was skipped along with the namespaces
+	 * in effect where it starts.
+	 */
+	void add_deferred_body(Gyoji::frontend::tree::ScopeBody & scope_body);
+
+	/**
+	 * Used by the YACC grammar to return the
+	 * statements of a deferred body once parsed.
+	 */
+	void set_deferred_statements(Gyoji::owned<Gyoji::frontend::tree::StatementList> statements);
 	
 	Gyoji::context::CompilerContext & compiler_context;
+
+	// How the input was parsed, so that deferred
+	// bodies are parsed the same way later on.
+	bool keep_trivia;
+	bool defer_bodies;
 	
 	Gyoji::owned<Gyoji::frontend::namespaces::NS2Context> ns2_context;
+
+	// The syntax tree is allocated from this arena, so it
+	// must be declared before (and so destroyed after)
+	// the translation unit.
+	Gyoji::misc::Arena arena;
 	
 	Gyoji::owned<Gyoji::frontend::tree::TranslationUnit> translation_unit;
 
@@ -212,6 +250,21 @@ namespace Gyoji::frontend {
 	 * and that is the symbol used in the "fully_qualified" name.
 	 */
 	std::map<std::string, Symbol> symbol_table;
+
+	// The namespaces in effect at the start
+	// of the function body being skipped.
+	Gyoji::frontend::namespaces::NS2Stack deferred_namespaces;
+
+	// The function bodies not parsed yet and
+	// the namespaces to parse each of them in.
+	std::map<
+	    const Gyoji::frontend::tree::ScopeBody*,
+	    std::pair<Gyoji::frontend::tree::ScopeBody*, Gyoji::frontend::namespaces::NS2Stack>
+	    > deferred_bodies;
+
+	// The statements of the deferred body
+	// being parsed, set by the grammar.
+	Gyoji::owned<Gyoji::frontend::tree::StatementList> deferred_statements;
 	
 	// We probably need a 'symbol table' which keeps track of global
 	// variables and functions.  The index would be the 'symbol name'
@@ -52,11 +52,50 @@ namespace Gyoji::frontend {
 	 *                           primitive types.
 	 *
 	 * @param _input_source      This is the source from which to read data.
+	 *
+	 * @param _keep_trivia       When true, whitespace and comments are kept
+	 *                           in the token stream and attached to the
+	 *                           syntax tree so that the input can be reproduced
+	 *                           exactly, as the formatters need.  A compiler
+	 *                           has no use for them and can leave them out.
+	 *
+	 * @param _defer_bodies      When true, the statements of function
+	 *                           bodies are skipped over and only their
+	 *                           text is kept, so that tools that only need
+	 *                           the declarations get them quickly.  Each body
+	 *                           is parsed when it is asked for
+	 *                           (see parse_deferred_body).
 	 */
 	static Gyoji::owned<ParseResult> parse(
 	    Gyoji::context::CompilerContext & _compiler_context,
-	    Gyoji::misc::InputSource & _input_source
+	    Gyoji::misc::InputSource & _input_source,
+	    bool _keep_trivia,
+	    bool _defer_bodies
+	    );
+
+	/**
+	 * @brief Parses a function body that was skipped.
+	 *
+	 * @details
+	 * Parses the statements of a body skipped by a
+	 * parse with _defer_bodies set, in the namespaces
+	 * in effect where the body appears, and gives them
+	 * to the body.  This does nothing for a body that
+	 * was not skipped or has been parsed already.
+	 * Returns false if the body has syntax errors,
+	 * which are reported through the compiler context.
+	 */
+	static bool parse_deferred_body(
+	    ParseResult & _parse_result,
+	    const Gyoji::frontend::tree::ScopeBody & _scope_body
 	    );
+
+	/**
+	 * Parses all of the function bodies that were
+	 * skipped, returning false if any of them
+	 * has syntax errors.
+	 */
+	static bool parse_deferred_bodies(ParseResult & _parse_result);
 	
 	/**
 	 * This function parses the input code and produces an MIR
@@ -73,6 +112,23 @@ namespace Gyoji::frontend {
 	    Gyoji::misc::InputSource & _input_source,
 	    bool verbose
 	    );
+
+	/**
+	 * This lowers the result of an earlier parse into
+	 * the MIR.  It is the second half of parse_to_mir()
+	 * and is provided separately so that callers can
+	 * look at the parse result, for example to measure
+	 * it, before it is lowered and thrown away.  Function
+	 * bodies that were skipped are parsed as each function
+	 * is lowered.  The functions are lowered by up to the
+	 * given number of threads.
+	 */
+	static Gyoji::owned<Gyoji::mir::MIR> lower_to_mir(
+	    Gyoji::context::CompilerContext & _compiler_context,
+	    ParseResult & _parse_result,
+	    bool verbose,
+	    size_t threads
+	    );
     };
     
 };
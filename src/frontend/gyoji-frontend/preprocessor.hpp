@@ -0,0 +1,175 @@
+/* Copyright 2025 Jonathan S. Arney
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      https://github.com/jarney/gyoji/blob/master/LICENSE
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#ifndef _GYOJI_INTERNAL
+#error "This header is intended to be used internally as a part of the Gyoji front-end.  Please include frontend.hpp instead."
+#endif
+#pragma once
+
+/*!
+ *  \addtogroup Frontend
+ *  @{
+ */
+namespace Gyoji::frontend {
+    class PreprocessorMacro;
+    class PreprocessorFile;
+    class PreprocessorConditional;
+
+    /**
+     * @brief Built-in preprocessor for Gyoji source files.
+     *
+     * @details
+     * This handles the C-style directives that Gyoji sources use
+     * without running an outside preprocessor:
+     *
+     * - #include "file" and #include <file>, searching the directory
+     *   of the including file (for "file" only) and then each of the
+     *   include directories in the order they were added.
+     * - #define and #undef of object-like and function-like macros,
+     *   including the # and ## operators, and the expansion of
+     *   macros in the text.  The arguments of a function-like macro
+     *   must be on the same line as its name.
+     * - #if, #ifdef, #ifndef, #elif, #else and #endif, where #if takes
+     *   an integer expression and defined(NAME).
+     * - #line, #error and #pragma once.  Other pragmas are ignored.
+     *
+     * The result is the text of the file with the included files in
+     * place of the #include directives.  Lines taken up by directives
+     * or left out by a condition are left empty, so the lines of
+     * each file stay where they were, and line markers (# 12 "foo.j")
+     * are written wherever the text moves from one file to another.
+     * The lexer passes the markers on to the SourceTable, so errors
+     * are reported against the file and line they came from.
+     *
+     * Files are read once for the whole process and kept in memory,
+     * since the same headers are included over and over.  A file
+     * whose contents are all inside of an #ifndef NAME ... #endif
+     * pair is remembered as guarded by NAME and is skipped without
+     * being scanned again when it is included while NAME is defined,
+     * as is a file that has said #pragma once.
+     */
+    class Preprocessor {
+    public:
+	/**
+	 * Creates a preprocessor that reports its
+	 * errors through the given compiler context.
+	 */
+	Preprocessor(Gyoji::context::CompilerContext & _compiler_context);
+	/**
+	 * Move along, nothing to see here.
+	 */
+	~Preprocessor();
+
+	/**
+	 * Adds a directory to the end of the list of
+	 * directories searched for included files.
+	 */
+	void add_include_directory(const std::string & _directory);
+
+	/**
+	 * Defines an object-like macro as if by
+	 * #define _name _value at the start of the input.
+	 */
+	void define(const std::string & _name, const std::string & _value);
+
+	/**
+	 * @brief Preprocesses the given file.
+	 *
+	 * @details
+	 * Returns true and places the preprocessed text in
+	 * _output if there were no errors.  Otherwise the
+	 * errors are reported through the compiler context
+	 * and false is returned.
+	 */
+	bool preprocess(const std::string & _filename, std::string & _output);
+
+	/**
+	 * @brief Returns the files the preprocessor read.
+	 *
+	 * @details
+	 * This is the file given to preprocess() followed by
+	 * each file it included, directly or not, in the order
+	 * they were first found, for writing the dependencies
+	 * of the file for a build system.  A file is listed
+	 * even if it was skipped because of its include guard
+	 * or #pragma once.  When _user_only is set, files
+	 * included as <file> are left out, along with the
+	 * files they include in turn.
+	 */
+	std::vector<std::string> get_dependencies(bool _user_only) const;
+
+    private:
+	bool process_file(PreprocessorFile & _file, size_t _depth);
+	bool process_directive(
+	    PreprocessorFile & _file,
+	    std::string_view _directive,
+	    size_t _lines,
+	    std::vector<PreprocessorConditional> & _conditionals,
+	    size_t _depth
+	    );
+	bool process_include(
+	    PreprocessorFile & _file,
+	    std::string_view _operand,
+	    size_t _lines,
+	    size_t _depth
+	    );
+	bool process_define(std::string_view _operand);
+	bool evaluate_condition(std::string_view _expression, bool & _result);
+
+	PreprocessorFile *find_include(
+	    const PreprocessorFile & _from,
+	    const std::string & _name,
+	    bool _quoted
+	    );
+
+	void expand_text(std::string_view _text, const std::vector<std::string> & _disabled, std::string & _out);
+	size_t expand_identifier(
+	    std::string_view _name,
+	    std::string_view _text,
+	    size_t _after,
+	    const std::vector<std::string> & _disabled,
+	    std::string & _out
+	    );
+	void substitute(
+	    const PreprocessorMacro & _macro,
+	    const std::vector<std::string_view> & _arguments,
+	    const std::vector<std::string> & _disabled,
+	    std::string & _out
+	    );
+
+	void add_error(std::string _title, std::string _message);
+	void add_line_marker(size_t _line, const std::string & _filename);
+
+	Gyoji::context::CompilerContext & compiler_context;
+	std::vector<std::string> include_directories;
+	std::map<std::string, Gyoji::owned<PreprocessorMacro>, std::less<>> macros;
+	std::set<std::string> once_files;
+
+	// Each file found, and whether it was included as
+	// <file> or from a file that was.
+	std::vector<std::pair<std::string, bool>> dependencies;
+	std::set<std::string> dependency_paths;
+	bool in_system_file;
+
+	// Where the preprocessor is, for error
+	// messages, __FILE__ and __LINE__.
+	std::string current_filename;
+	size_t current_line;
+
+	std::string *output;
+    };
+
+};
+
+/*! @} End of Doxygen Groups*/
@@ -65,10 +65,18 @@ namespace Gyoji::frontend::ast {
      * type "Terminal" indicating that it is a "terminal"
      * symbol of the grammer which corresponds to a parsed
      * token from the lexer (gyoji.l).
+     *
+     * Nodes and their lists of children are placed in the
+     * arena owned by the ParseResult while parsing, so
+     * the whole tree is released at once with it.
      */
-    class SyntaxNode {
+    class SyntaxNode : public Gyoji::misc::ArenaAllocated {
     public:
 	typedef std::variant<GYOJI_SYNTAX_NODE_VARIANT_LIST> specific_type_t;
+	typedef std::vector<
+	    std::reference_wrapper<const SyntaxNode>,
+	    Gyoji::misc::ArenaAllocator<std::reference_wrapper<const SyntaxNode>>
+	    > children_t;
 	
 	/**
 	 * Create a new syntax node of the given type holding
@@ -85,7 +93,7 @@ namespace Gyoji::frontend::ast {
 	 * This method returns a reference to an immutable array
 	 * of children of this node.
 	 */
-	const std::vector<std::reference_wrapper<const SyntaxNode>> & get_children() const;
+	const children_t & get_children() const;
 	
 	/**
 	 * This method returns an immutable reference to
@@ -133,15 +141,18 @@ namespace Gyoji::frontend::ast {
 	// This list does NOT own its children, so
 	// the class deriving from this one must
 	// agree to own the pointers separately.
-	std::vector<std::reference_wrapper<const SyntaxNode>> children; 
-	const Gyoji::context::SourceReference & source_ref;
+	children_t children;
+	Gyoji::context::SourceReference source_ref;
 	
     protected:
 	// Children are owned by their parents, so this is
 	// private and can only be called by the
 	// deriving class.
 	void add_child(const SyntaxNode & node);
-	void prepend_child(const SyntaxNode & node);
+	// Puts a new child in the place of one added
+	// earlier, for a node whose contents are only
+	// filled in after it was made.
+	void replace_child(const SyntaxNode & old_node, const SyntaxNode & new_node);
 	
 	Gyoji::context::TokenID type;
 	specific_type_t data;
@@ -118,6 +118,7 @@ namespace Gyoji::frontend::tree {
     const Gyoji::context::TokenID TERMINAL_file_metadata = 87;
 
     const Gyoji::context::TokenID TERMINAL_STATIC = 88;
+    const Gyoji::context::TokenID TERMINAL_DEFERRED_BODY = 89;
     
     // Syntax Non-terminals
     const Gyoji::context::TokenID NONTERMINAL_access_modifier = 200;
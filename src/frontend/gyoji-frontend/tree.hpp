@@ -41,7 +41,7 @@ namespace Gyoji::frontend::tree {
      * meaningful error messaging with context surrounding
      * the error.
      */
-    class TerminalNonSyntax {
+    class TerminalNonSyntax : public Gyoji::misc::ArenaAllocated {
     public:
 	typedef enum {
 	    /**
@@ -87,11 +87,11 @@ namespace Gyoji::frontend::tree {
 	 * This method provides access to the raw input
 	 * for the type of non-syntax data available.
 	 */
-	const std::string & get_data() const;
+	std::string_view get_data() const;
 	
     private:
 	Type type;
-	const Gyoji::context::Token & token;
+	Gyoji::context::Token token;
     };
 
     //! Represents tokens from the lexer used to represent keywords and identifiers found in the source.
@@ -153,12 +153,12 @@ namespace Gyoji::frontend::tree {
 	 * Returns the type of the correspinding
 	 * lexer token.
 	 */
-	const Gyoji::context::TokenID & get_type() const;
+	Gyoji::context::TokenID get_type() const;
 	/**
 	 * Returns the matched data from the input
 	 * that matched the token.
 	 */
-	const std::string & get_value() const;
+	std::string_view get_value() const;
 	
 	/**
 	 * Returns a reference to the place in the source-file
@@ -186,14 +186,17 @@ namespace Gyoji::frontend::tree {
 	// in this vector.  It may be returned to access it,
 	// but these are owned pointers, so they must only
 	// be de-referenced and never assigned to
-	std::vector<Gyoji::owned<TerminalNonSyntax>> non_syntax;
+	std::vector<
+	    Gyoji::owned<TerminalNonSyntax>,
+	    Gyoji::misc::ArenaAllocator<Gyoji::owned<TerminalNonSyntax>>
+	    > non_syntax;
 
 	void set_ns2_entity(Gyoji::frontend::namespaces::NS2Entity *_ns_entity);
 	Gyoji::frontend::namespaces::NS2Entity *get_ns2_entity() const;
 	
 	
     private:
-	const Gyoji::context::Token & token;
+	Gyoji::context::Token token;
 	std::string fully_qualified_name;
 	IdentifierType identifier_type;
 	// Tells us whether this is a namespace name, an entity, or what.
@@ -1566,7 +1569,7 @@ namespace Gyoji::frontend::tree {
 	 * Destructor, nothing special.
 	 */
 	~StatementLabel();
-	const std::string & get_name() const;
+	std::string get_name() const;
 	const Gyoji::context::SourceReference & get_name_source_ref() const;
     private:
 	Gyoji::owned<Terminal> label_token;
@@ -1584,7 +1587,7 @@ namespace Gyoji::frontend::tree {
 	 * Destructor, nothing special.
 	 */
 	~StatementGoto();
-	const std::string & get_label() const;
+	std::string get_label() const;
 	const Gyoji::context::SourceReference & get_label_source_ref() const;
     private:
 	Gyoji::owned<Terminal> goto_token;
@@ -1696,14 +1699,46 @@ namespace Gyoji::frontend::tree {
 	    Gyoji::owned<StatementList> statement_list,
 	    Gyoji::owned<Terminal> brace_r_token
 	    );
+	/**
+	 * Creates the body of a function that has not
+	 * been parsed yet.  The deferred token holds the
+	 * text between the braces until the body is parsed
+	 * by Parser::parse_deferred_body().  Until then, the
+	 * body has no statements.
+	 */
+	ScopeBody(
+	    Gyoji::owned<Terminal> brace_l_token,
+	    Gyoji::owned<Terminal> deferred_token,
+	    Gyoji::owned<Terminal> brace_r_token
+	    );
 	/**
 	 * Destructor, nothing special.
 	 */
 	~ScopeBody();
 	const StatementList & get_statements() const;
 	const Gyoji::context::SourceReference & get_end_source_ref() const;
+
+	/**
+	 * Returns true if the statements of
+	 * this body have not been parsed yet.
+	 */
+	bool is_deferred() const;
+	/**
+	 * Returns the terminal holding the text
+	 * of a body that has not been parsed yet.
+	 * This may only be called if is_deferred()
+	 * returns true.
+	 */
+	const Terminal & get_deferred_token() const;
+	/**
+	 * Gives a deferred body the statements
+	 * parsed from its text, after which it
+	 * is no longer deferred.
+	 */
+	void set_statements(Gyoji::owned<StatementList> _statement_list);
     private:
 	Gyoji::owned<Terminal> brace_l_token;
+	Gyoji::owned<Terminal> deferred_token;
 	Gyoji::owned<StatementList> statement_list;
 	Gyoji::owned<Terminal> brace_r_token;
     };
@@ -2057,7 +2092,7 @@ namespace Gyoji::frontend::tree {
 	 */
 	~TypeDefinition();
 	const AccessModifier & get_access_modifier() const;
-	const std::string & get_name() const;
+	std::string get_name() const;
 	const Gyoji::context::SourceReference & get_name_source_ref() const;
 	const TypeSpecifier & get_type_specifier() const;
     private:
@@ -2080,7 +2115,7 @@ namespace Gyoji::frontend::tree {
 	 * Destructor, nothing special.
 	 */
 	~EnumDefinitionValue();
-	const std::string & get_name() const;
+	std::string get_name() const;
 	const Gyoji::context::SourceReference & get_name_source_ref() const;
 	const Expression & get_expression() const;
     private:
@@ -2120,10 +2155,10 @@ namespace Gyoji::frontend::tree {
 	 */
 	~EnumDefinition();
 	const AccessModifier & get_access_modifier() const;
-	const std::string & get_type_name() const;
+	std::string get_type_name() const;
 	const Gyoji::context::SourceReference & get_type_name_source_ref() const;
 	
-	const std::string & get_name() const;
+	std::string get_name() const;
 	const Gyoji::context::SourceReference & get_name_source_ref() const;
 	
 	const EnumDefinitionValueList & get_value_list() const;
@@ -2180,7 +2215,7 @@ namespace Gyoji::frontend::tree {
         /**
 	 * Returns the string literal exactly as it appeared in the source-file.
 	 */
-	const std::string & get_value() const;
+	std::string_view get_value() const;
 	const Terminal & get_literal_int_token() const;
 	const Gyoji::context::SourceReference & get_value_source_ref() const;
     private:
@@ -2738,7 +2773,7 @@ namespace Gyoji::frontend::tree {
 	const AccessModifier & get_access_modifier() const;
 	const UnsafeModifier & get_unsafe_modifier() const;
 	const TypeSpecifier & get_type_specifier() const;
-	const std::string & get_name() const;
+	std::string get_name() const;
 	const Gyoji::context::SourceReference & get_name_source_ref() const;
 	const GlobalInitializer & get_global_initializer() const;
     private:
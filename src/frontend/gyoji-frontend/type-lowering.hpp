@@ -34,8 +34,14 @@ namespace Gyoji::frontend::lowering {
      */
     class TypeLowering {
     public:
+	/**
+	 * Errors are reported into the given list.  While
+	 * functions are lowered, each one uses a type lowering
+	 * of its own that reports into that function's errors
+	 * (see FunctionLowering).
+	 */
 	TypeLowering(
-	    Gyoji::context::CompilerContext & _compiler_context,
+	    Gyoji::context::Errors & _errors,
 	    const Gyoji::frontend::tree::TranslationUnit & _translation_unit,
 	    Gyoji::mir::MIR & _mir);
 	/**
@@ -63,16 +69,9 @@ namespace Gyoji::frontend::lowering {
 	 */
 	const Gyoji::mir::Type * extract_from_type_specifier(const Gyoji::frontend::tree::TypeSpecifier & type_specifier);
 
-	Gyoji::mir::Type *get_or_create(
-	    std::string pointer_name,
-	    Gyoji::mir::Type::TypeType type_type,
-	    bool complete,
-	    const Gyoji::context::SourceReference & source_ref
-	    );
-
     private:
 	Gyoji::mir::MIR & mir;
-	Gyoji::context::CompilerContext & compiler_context;
+	Gyoji::context::Errors & errors;
 	const Gyoji::frontend::tree::TranslationUnit & translation_unit;
 	
 	const Gyoji::mir::Type* extract_from_type_specifier_simple(const Gyoji::frontend::tree::TypeSpecifierSimple & type_specifier);
@@ -155,6 +155,8 @@
 %token <Gyoji::owned<Gyoji::frontend::tree::Terminal>> BRACKET_R
 %token <Gyoji::owned<Gyoji::frontend::tree::Terminal>> BRACKET_L
 %token <Gyoji::owned<Gyoji::frontend::tree::Terminal>> BRACE_R
+%token <Gyoji::owned<Gyoji::frontend::tree::Terminal>> DEFERRED_BODY
+%token DEFERRED_BODY_START
 %token <Gyoji::owned<Gyoji::frontend::tree::Terminal>> SEMICOLON
 %token <Gyoji::owned<Gyoji::frontend::tree::Terminal>> COLON
 %token <Gyoji::owned<Gyoji::frontend::tree::Terminal>> QUESTIONMARK
@@ -203,6 +205,8 @@
 %nterm <Gyoji::owned<Gyoji::frontend::tree::Terminal>> access_modifier;
 
 %nterm <Gyoji::owned<Gyoji::frontend::tree::ScopeBody>> scope_body;
+%nterm <Gyoji::owned<Gyoji::frontend::tree::ScopeBody>> function_body;
+%nterm <Gyoji::owned<Gyoji::frontend::tree::Terminal>> function_body_start;
 %nterm <Gyoji::owned<Gyoji::frontend::tree::StatementList>> statement_list;
 %nterm <Gyoji::owned<Gyoji::frontend::tree::Statement>> statement;
 %nterm <Gyoji::owned<Gyoji::frontend::tree::StatementVariableDeclaration>> statement_variable_declaration;
@@ -332,6 +336,16 @@
 %%
 
 /*** Rules Section ***/
+parse_start
+        : translation_unit {
+        }
+        // A function body that was skipped is
+        // parsed later on by itself.
+        | DEFERRED_BODY_START statement_list YYEOF {
+                return_data.set_deferred_statements(std::move($2));
+        }
+        ;
+
 translation_unit
         : opt_file_statement_list YYEOF {
           $$ = Gyoji::owned_new<Gyoji::frontend::tree::TranslationUnit>(std::move($1), std::move($2));
@@ -356,11 +370,19 @@ file_statement_list
           $$ = Gyoji::owned_new<Gyoji::frontend::tree::FileStatementList>(return_data.compiler_context.get_token_stream().get_current_source_ref());
           $$->add_statement(std::move($1));
           PRINT_NONTERMINALS($$);
+          // Any more errors would only be dropped,
+          // so there's no point in going on.
+          if (return_data.compiler_context.get_errors().is_error_limit_reached()) {
+              YYABORT;
+          }
         }
         | file_statement_list file_statement {
           $$ = std::move($1);
           $$->add_statement(std::move($2));
           PRINT_NONTERMINALS($$);
+          if (return_data.compiler_context.get_errors().is_error_limit_reached()) {
+              YYABORT;
+          }
         }
         ;
 
@@ -441,8 +463,8 @@ file_statement
 
 file_statement_global_definition
         : opt_access_modifier opt_unsafe type_specifier IDENTIFIER opt_global_initializer SEMICOLON {
-	        std::string global_name = $4->get_value();
-		NS2Entity *ns2_entity = return_data.identifier_get_or_create($4->get_value(), true, $4->get_source_ref());
+	        std::string global_name($4->get_value());
+		NS2Entity *ns2_entity = return_data.identifier_get_or_create(std::string($4->get_value()), true, $4->get_source_ref());
 		$4->set_ns2_entity(ns2_entity);
 	
 	        $$ = Gyoji::owned_new<Gyoji::frontend::tree::FileStatementGlobalDefinition>(
@@ -580,7 +602,7 @@ access_modifier
 
 namespace_declaration
         : opt_access_modifier NAMESPACE IDENTIFIER {
-		Gyoji::frontend::namespaces::NS2Entity *ns = return_data.namespace_get_or_create($3->get_value(), $3->get_source_ref());
+		Gyoji::frontend::namespaces::NS2Entity *ns = return_data.namespace_get_or_create(std::string($3->get_value()), $3->get_source_ref());
 		$3->set_ns2_entity(ns);
 		return_data.ns2_context->namespace_push(ns);
 		
@@ -593,7 +615,7 @@ namespace_declaration
                 PRINT_NONTERMINALS($$);
         }
         | opt_access_modifier NAMESPACE NAMESPACE_NAME {
-		Gyoji::frontend::namespaces::NS2Entity *ns = return_data.ns2_context->namespace_find($3->get_value());
+		Gyoji::frontend::namespaces::NS2Entity *ns = return_data.ns2_context->namespace_find(std::string($3->get_value()));
 		return_data.ns2_context->namespace_push(ns);
 		
                 $$ = Gyoji::owned_new<Gyoji::frontend::tree::NamespaceDeclaration>(
@@ -635,7 +657,7 @@ opt_as
 
 file_statement_using
         : opt_access_modifier USING NAMESPACE NAMESPACE_NAME opt_as SEMICOLON {
-                std::string namespace_name = $4->get_value();
+                std::string namespace_name($4->get_value());
                 std::string as_name = $5->get_using_name();
 		NS2Entity *entity = return_data.ns2_context->namespace_find(namespace_name);
 		if (entity == nullptr) {
@@ -657,7 +679,7 @@ file_statement_using
                 PRINT_NONTERMINALS($$);
         }
         | opt_access_modifier USING NAMESPACE TYPE_NAME opt_as SEMICOLON {
-                std::string namespace_name = $4->get_value();
+                std::string namespace_name($4->get_value());
                 std::string as_name = $5->get_using_name();
 
 		NS2Entity *entity = return_data.ns2_context->namespace_find(namespace_name);
@@ -687,7 +709,7 @@ file_statement_using
 // a type instead of an identifier.
 class_decl_start
         : opt_access_modifier CLASS IDENTIFIER opt_class_argument_list {
-		NS2Entity *ns2_entity = return_data.class_get_or_create($3->get_value(), $3->get_source_ref());
+		NS2Entity *ns2_entity = return_data.class_get_or_create(std::string($3->get_value()), $3->get_source_ref());
 		$3->set_ns2_entity(ns2_entity);
 		return_data.ns2_context->namespace_push(ns2_entity);
                 $$ = Gyoji::owned_new<Gyoji::frontend::tree::ClassDeclStart>(
@@ -729,7 +751,7 @@ opt_class_argument_list
 // types scoped private in the class.
 class_argument_list
         : IDENTIFIER {
-                NS2Entity *ns2_entity = return_data.identifier_get_or_create($1->get_value(), true, $1->get_source_ref());
+                NS2Entity *ns2_entity = return_data.identifier_get_or_create(std::string($1->get_value()), true, $1->get_source_ref());
 		$1->set_ns2_entity(ns2_entity);
                 $$ = Gyoji::owned_new<Gyoji::frontend::tree::ClassArgumentList>(
                                                                                   std::move($1)
@@ -737,7 +759,7 @@ class_argument_list
                 PRINT_NONTERMINALS($$);
         }
         | class_argument_list COMMA IDENTIFIER {
-                NS2Entity *ns2_entity = return_data.identifier_get_or_create($3->get_value(), true, $3->get_source_ref());
+                NS2Entity *ns2_entity = return_data.identifier_get_or_create(std::string($3->get_value()), true, $3->get_source_ref());
 		$3->set_ns2_entity(ns2_entity);
                 $$ = std::move($1);
                 $$->add_argument(std::move($2), std::move($3));
@@ -773,7 +795,7 @@ class_definition
 
 type_definition
         : opt_access_modifier TYPEDEF type_specifier IDENTIFIER SEMICOLON {
-                Gyoji::frontend::namespaces::NS2Entity *ns2_entity = return_data.type_get_or_create($4->get_value(), $4->get_source_ref());
+                Gyoji::frontend::namespaces::NS2Entity *ns2_entity = return_data.type_get_or_create(std::string($4->get_value()), $4->get_source_ref());
                 $4->set_ns2_entity(ns2_entity);
                 $$ = Gyoji::owned_new<Gyoji::frontend::tree::TypeDefinition>(
                                                                                std::move($1),
@@ -790,7 +812,7 @@ type_definition
 
 enum_definition
         : opt_access_modifier ENUM TYPE_NAME IDENTIFIER BRACE_L opt_enum_value_list BRACE_R SEMICOLON {
-                Gyoji::frontend::namespaces::NS2Entity *ns2_entity = return_data.type_get_or_create($4->get_value(), $4->get_source_ref());
+                Gyoji::frontend::namespaces::NS2Entity *ns2_entity = return_data.type_get_or_create(std::string($4->get_value()), $4->get_source_ref());
 		$4->set_ns2_entity(ns2_entity);
                 $$ = Gyoji::owned_new<Gyoji::frontend::tree::EnumDefinition>(
                                                                                 std::move($1),
@@ -832,7 +854,7 @@ enum_value_list
 
 enum_value
         : IDENTIFIER ASSIGNMENT expression_primary SEMICOLON {
-                Gyoji::frontend::namespaces::NS2Entity *ns2_entity = return_data.type_get_or_create($1->get_value(), $1->get_source_ref());
+                Gyoji::frontend::namespaces::NS2Entity *ns2_entity = return_data.type_get_or_create(std::string($1->get_value()), $1->get_source_ref());
 		$1->set_ns2_entity(ns2_entity);
                 $$ = Gyoji::owned_new<Gyoji::frontend::tree::EnumDefinitionValue>(
                                                                                     std::move($1),
@@ -877,7 +899,7 @@ file_statement_function_declaration
 
 function_decl_start
         : opt_access_modifier opt_unsafe type_specifier IDENTIFIER {
-                NS2Entity *ns2_entity = return_data.identifier_get_or_create($4->get_value(), true, $4->get_source_ref());
+                NS2Entity *ns2_entity = return_data.identifier_get_or_create(std::string($4->get_value()), true, $4->get_source_ref());
 		if (ns2_entity == nullptr) {
 		    return -1;
 		}
@@ -892,7 +914,7 @@ function_decl_start
         }
         // Destructors
         | opt_access_modifier opt_unsafe IDENTIFIER {
-                NS2Entity *ns2_entity = return_data.identifier_get_or_create($3->get_value(), true, $3->get_source_ref());
+                NS2Entity *ns2_entity = return_data.identifier_get_or_create(std::string($3->get_value()), true, $3->get_source_ref());
 		if (ns2_entity == nullptr) {
 		    return -1;
 		}
@@ -912,7 +934,7 @@ function_decl_start
 
         // This one would put the tilde at the beginning which isn't what we want either.
 //        | opt_access_modifier opt_unsafe TILDE IDENTIFIER {
-//                NS2Entity *ns2_entity = return_data.identifier_get_or_create($4->get_value(), true, $4->get_source_ref());
+//                NS2Entity *ns2_entity = return_data.identifier_get_or_create(std::string($4->get_value()), true, $4->get_source_ref());
 //		if (ns2_entity == nullptr) {
 //		    return -1;
 //		}
@@ -926,7 +948,7 @@ function_decl_start
 //        }
         // This doesn't do it and introduces a Shift/Reduce conflict.
 //        | opt_access_modifier opt_unsafe TYPE_NAME TILDE IDENTIFIER {
-//                NS2Entity *ns2_entity = return_data.identifier_get_or_create($5->get_value(), true, $5->get_source_ref());
+//                NS2Entity *ns2_entity = return_data.identifier_get_or_create(std::string($5->get_value()), true, $5->get_source_ref());
 //		if (ns2_entity == nullptr) {
 //		    return -1;
 //		}
@@ -941,7 +963,7 @@ function_decl_start
         ;
 
 file_statement_function_definition
-        : function_decl_start PAREN_L opt_function_definition_arg_list PAREN_R scope_body {
+        : function_decl_start PAREN_L opt_function_definition_arg_list PAREN_R function_body {
 	        // This is the point at which we need to fully-qualify our symbol name
 	        // because it may be in a namespace and we need to find it unambiguously
 	        // in a possibly large namespace.  We don't want the MIR or code-gen layers
@@ -1015,7 +1037,7 @@ function_definition_arg_list
         ;
 function_definition_arg
         : type_specifier IDENTIFIER {
-                NS2Entity *ns2_entity = return_data.identifier_get_or_create($2->get_value(), true, $2->get_source_ref());
+                NS2Entity *ns2_entity = return_data.identifier_get_or_create(std::string($2->get_value()), true, $2->get_source_ref());
 	        $2->set_ns2_entity(ns2_entity);
                 $$ = Gyoji::owned_new<Gyoji::frontend::tree::FunctionDefinitionArg>(
 		    std::move($1),
@@ -1036,6 +1058,41 @@ scope_body
         }
         ;
 
+function_body
+        : function_body_start statement_list BRACE_R {
+                $$ = Gyoji::owned_new<Gyoji::frontend::tree::ScopeBody>(
+                                                                           std::move($1),
+                                                                           std::move($2),
+                                                                           std::move($3)
+                                                                           );
+                PRINT_NONTERMINALS($$);
+        }
+        | function_body_start DEFERRED_BODY BRACE_R {
+                $$ = Gyoji::owned_new<Gyoji::frontend::tree::ScopeBody>(
+                                                                           std::move($1),
+                                                                           std::move($2),
+                                                                           std::move($3)
+                                                                           );
+                return_data.add_deferred_body(*$$);
+                PRINT_NONTERMINALS($$);
+        }
+        ;
+
+function_body_start
+        : BRACE_L {
+                // This is reduced as soon as the brace is read, before
+                // the lexer reads anything from the body, so the lexer
+                // can still be told to skip over it.  The body is then
+                // parsed later on in the namespaces in effect here.
+                if (return_data.defer_bodies) {
+                    LexContext *lex_context = (LexContext*)yyget_extra(scanner);
+                    lex_context->defer_body = true;
+                    return_data.deferred_namespaces = return_data.ns2_context->namespace_save();
+                }
+                $$ = std::move($1);
+        }
+        ;
+
 statement_list
         : /**/ {
                 $$ = Gyoji::owned_new<Gyoji::frontend::tree::StatementList>(return_data.compiler_context.get_token_stream().get_current_source_ref());
@@ -1172,7 +1229,7 @@ struct_field_expression
 
 statement_variable_declaration
         : type_specifier IDENTIFIER initializer_expression SEMICOLON {
-                NS2Entity *ns2_entity = return_data.identifier_get_or_create($2->get_value(), true, $2->get_source_ref());
+                NS2Entity *ns2_entity = return_data.identifier_get_or_create(std::string($2->get_value()), true, $2->get_source_ref());
 	        $2->set_ns2_entity(ns2_entity);
                 $$ = Gyoji::owned_new<Gyoji::frontend::tree::StatementVariableDeclaration>(
 		    std::move($1),
@@ -1205,7 +1262,7 @@ statement_expression
         ;
 statement_goto
         : GOTO IDENTIFIER SEMICOLON {
-                NS2Entity *ns2_entity = return_data.identifier_get_or_create($2->get_value(), true, $2->get_source_ref());
+                NS2Entity *ns2_entity = return_data.identifier_get_or_create(std::string($2->get_value()), true, $2->get_source_ref());
 		$2->set_ns2_entity(ns2_entity);
                 $$ = Gyoji::owned_new<Gyoji::frontend::tree::StatementGoto>(
                                                                                std::move($1),
@@ -1235,7 +1292,7 @@ statement_continue
         ;
 statement_label
         : LABEL IDENTIFIER COLON {
-                NS2Entity *ns2_entity = return_data.identifier_get_or_create($2->get_value(), true, $2->get_source_ref());
+                NS2Entity *ns2_entity = return_data.identifier_get_or_create(std::string($2->get_value()), true, $2->get_source_ref());
 		$2->set_ns2_entity(ns2_entity);
                 $$ = Gyoji::owned_new<Gyoji::frontend::tree::StatementLabel>(
                                                                                 std::move($1),
@@ -1332,7 +1389,7 @@ statement_for
                 PRINT_NONTERMINALS($$);
         }
         | FOR PAREN_L type_specifier IDENTIFIER ASSIGNMENT expression SEMICOLON expression SEMICOLON expression PAREN_R scope_body {
-                NS2Entity *ns2_entity = return_data.identifier_get_or_create($4->get_value(), true, $4->get_source_ref());
+                NS2Entity *ns2_entity = return_data.identifier_get_or_create(std::string($4->get_value()), true, $4->get_source_ref());
 		$2->set_ns2_entity(ns2_entity);
                 // This variation is a declaration and assignment
                 $$ = Gyoji::owned_new<Gyoji::frontend::tree::StatementFor>(
@@ -1457,7 +1514,7 @@ expression_primary
 
 expression_primary_identifier
         : IDENTIFIER {
-                NS2Entity *ns2_entity = return_data.identifier_get_or_create($1->get_value(), true, $1->get_source_ref());
+                NS2Entity *ns2_entity = return_data.identifier_get_or_create(std::string($1->get_value()), true, $1->get_source_ref());
 		$1->set_ns2_entity(ns2_entity);
 #if DEBUG_NONTERMINALS
 		// Useful for debugging identifer/scope stuff.
@@ -2366,7 +2423,7 @@ class_member_declaration
         : opt_access_modifier opt_unsafe type_specifier IDENTIFIER SEMICOLON {
                 // Member Variable
 	        $4->set_identifier_type(Gyoji::frontend::tree::Terminal::IDENTIFIER_LOCAL_SCOPE);
-		NS2Entity *entity = return_data.identifier_get_or_create($4->get_value(), false, $4->get_source_ref());
+		NS2Entity *entity = return_data.identifier_get_or_create(std::string($4->get_value()), false, $4->get_source_ref());
 		$4->set_ns2_entity(entity);
                 auto expr = Gyoji::owned_new<Gyoji::frontend::tree::ClassMemberDeclarationVariable>(
                                                                                                        std::move($1),
@@ -2381,7 +2438,7 @@ class_member_declaration
         }
         | STATIC opt_access_modifier opt_unsafe type_specifier IDENTIFIER PAREN_L opt_function_definition_arg_list PAREN_R SEMICOLON {
 	        $5->set_identifier_type(Gyoji::frontend::tree::Terminal::IDENTIFIER_GLOBAL_SCOPE);
-		NS2Entity *entity = return_data.identifier_get_or_create($5->get_value(), false, $5->get_source_ref());
+		NS2Entity *entity = return_data.identifier_get_or_create(std::string($5->get_value()), false, $5->get_source_ref());
 		$5->set_ns2_entity(entity);
 	        auto expr = Gyoji::owned_new<Gyoji::frontend::tree::ClassMemberDeclarationMethodStatic>(
                                                                                                      std::move($1),
@@ -2401,7 +2458,7 @@ class_member_declaration
 	| opt_access_modifier opt_unsafe type_specifier IDENTIFIER PAREN_L opt_function_definition_arg_list PAREN_R SEMICOLON {
                 // Method
 	        $4->set_identifier_type(Gyoji::frontend::tree::Terminal::IDENTIFIER_LOCAL_SCOPE);
-		NS2Entity *entity = return_data.identifier_get_or_create($4->get_value(), false, $4->get_source_ref());
+		NS2Entity *entity = return_data.identifier_get_or_create(std::string($4->get_value()), false, $4->get_source_ref());
 		$4->set_ns2_entity(entity);
                 auto expr = Gyoji::owned_new<Gyoji::frontend::tree::ClassMemberDeclarationMethod>(
                                                                                                      std::move($1),
@@ -18,19 +18,64 @@
 #undef _GYOJI_INTERNAL
 #include <gyoji.l.hpp>
 #include <gyoji.y.hpp>
+#include <gyoji-misc/input-source-string.hpp>
+#include <errno.h>
+#include <string.h>
 
 using namespace Gyoji::frontend::yacc;
 
 LexContext::LexContext(
     Gyoji::frontend::namespaces::NS2Context &_ns2_context,
     Gyoji::context::CompilerContext & _compiler_context,
-    Gyoji::misc::InputSource &_input_source)
+    Gyoji::misc::InputSource &_input_source,
+    bool _keep_trivia)
     : ns2_context(_ns2_context)
     , input_source(_input_source)
     , compiler_context(_compiler_context)
     , line(1)
     , column(0)
+    , keep_trivia(_keep_trivia)
+    , defer_body(false)
+    , start_deferred_body(false)
+    , deferred_start(nullptr)
+    , deferred_line(0)
+    , deferred_column(0)
+    , deferred_depth(0)
 {}
 
 LexContext::~LexContext()
 {}
+
+void
+LexContext::scan_input(void *scanner)
+{
+    Gyoji::owned<Gyoji::misc::InputBuffer> text = input_source.read_all();
+    if (!text) {
+	compiler_context
+	    .get_errors()
+	    .add_simple_error(
+		Gyoji::context::SourceReference(compiler_context.get_filename(), 1, 0, 0),
+		"Could not read input",
+		std::string("Reading the input failed: ") + strerror(errno)
+		);
+	// Scan nothing rather than part of the input.
+	std::string empty;
+	Gyoji::misc::InputSourceString empty_source(empty);
+	text = empty_source.read_all();
+    }
+    // The scanner needs two NUL bytes after the text,
+    // and they are included in the size given to it.
+    yy_scan_buffer(text->get_data(), text->get_size() + 2, scanner);
+    compiler_context.get_token_stream().set_text(compiler_context.get_filename(), std::move(text));
+    yyset_extra(this, scanner);
+}
+
+void
+LexContext::scan_deferred_body(void *scanner, char *body, size_t size, size_t _line, size_t _column)
+{
+    yy_scan_buffer(body, size + 2, scanner);
+    line = _line;
+    column = _column;
+    start_deferred_body = true;
+    yyset_extra(this, scanner);
+}
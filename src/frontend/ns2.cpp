@@ -24,12 +24,16 @@ using namespace Gyoji::frontend::namespaces;
 // NS2Entity
 ///////////////////////////////////////////////////
 NS2Entity::NS2Entity(
-    std::string _name,
+    Gyoji::context::AtomTable & _atoms,
+    size_t & _generation,
+    Gyoji::context::Atom _name,
     EntityType _type,
     NS2Entity* _parent,
     const Gyoji::context::SourceReference & _source_ref
     )
-    : name(_name)
+    : atoms(_atoms)
+    , generation(_generation)
+    , name(_name)
     , type(_type)
     , parent(_parent)
     , source_ref(_source_ref)
@@ -40,7 +44,11 @@ NS2Entity::~NS2Entity()
 
 const std::string &
 NS2Entity::get_name() const
-{ return name;}
+{ return atoms.get_string(name); }
+
+Gyoji::context::Atom
+NS2Entity::get_name_atom() const
+{ return name; }
 
 std::string
 NS2Entity::get_fully_qualified_name() const
@@ -70,57 +78,46 @@ NS2Entity::get_source_ref() const
 { return source_ref; }
 
 NS2Entity*
-NS2Entity::add_identifier(
+NS2Entity::add_child(
     std::string _name,
+    EntityType _type,
     const Gyoji::context::SourceReference & _source_ref
     )
 {
-    const auto & it = elements.find(_name);
+    Gyoji::context::Atom atom = atoms.intern(_name);
+    const auto & it = elements.find(atom);
     if (it != elements.end()) {
 	fprintf(stderr, "Identifier already defined in namespace %s\n", _name.c_str());
 	return nullptr;
     }
     
-    Gyoji::owned<NS2Entity> entity = Gyoji::owned_new<NS2Entity>(_name, NS2Entity::ENTITY_TYPE_IDENTIFIER, this, _source_ref);
+    Gyoji::owned<NS2Entity> entity = Gyoji::owned_new<NS2Entity>(atoms, generation, atom, _type, this, _source_ref);
     NS2Entity *ret = entity.get();
-    elements.insert(std::pair(_name, std::move(entity)));
+    elements.insert(std::pair(atom, std::move(entity)));
+    generation++;
     return ret;
 }
 
 NS2Entity*
-NS2Entity::add_type(
+NS2Entity::add_identifier(
     std::string _name,
     const Gyoji::context::SourceReference & _source_ref
     )
-{
-    const auto & it = elements.find(_name);
-    if (it != elements.end()) {
-	fprintf(stderr, "Identifier already defined in namespace %s\n", _name.c_str());
-	return nullptr;
-    }
+{ return add_child(_name, NS2Entity::ENTITY_TYPE_IDENTIFIER, _source_ref); }
 
-    Gyoji::owned<NS2Entity> entity = Gyoji::owned_new<NS2Entity>(_name, NS2Entity::ENTITY_TYPE_TYPE, this, _source_ref);
-    NS2Entity *ret = entity.get();
-    elements.insert(std::pair(_name, std::move(entity)));
-    return ret;
-}
+NS2Entity*
+NS2Entity::add_type(
+    std::string _name,
+    const Gyoji::context::SourceReference & _source_ref
+    )
+{ return add_child(_name, NS2Entity::ENTITY_TYPE_TYPE, _source_ref); }
 
 NS2Entity*
 NS2Entity::add_class(
     std::string _name,
     const Gyoji::context::SourceReference & _source_ref
     )
-{
-    const auto & it = elements.find(_name);
-    if (it != elements.end()) {
-	fprintf(stderr, "Identifier already defined in namespace %s\n", _name.c_str());
-	return nullptr;
-    }
-    Gyoji::owned<NS2Entity> entity = Gyoji::owned_new<NS2Entity>(_name, NS2Entity::ENTITY_TYPE_CLASS, this, _source_ref);
-    NS2Entity *ret = entity.get();
-    elements.insert(std::pair(_name, std::move(entity)));
-    return ret;
-}
+{ return add_child(_name, NS2Entity::ENTITY_TYPE_CLASS, _source_ref); }
 
 NS2Entity*
 NS2Entity::add_namespace(
@@ -128,14 +125,28 @@ NS2Entity::add_namespace(
     const Gyoji::context::SourceReference & _source_ref
     )
 {
-    Gyoji::owned<NS2Entity> entity = Gyoji::owned_new<NS2Entity>(_namespace, NS2Entity::ENTITY_TYPE_NAMESPACE, this, _source_ref);
+    Gyoji::context::Atom atom = atoms.intern(_namespace);
+    Gyoji::owned<NS2Entity> entity = Gyoji::owned_new<NS2Entity>(atoms, generation, atom, NS2Entity::ENTITY_TYPE_NAMESPACE, this, _source_ref);
     NS2Entity *ret = entity.get();
-    elements.insert(std::pair(_namespace, std::move(entity)));
+    elements.insert(std::pair(atom, std::move(entity)));
+    generation++;
     return ret;
 }
 
 NS2Entity *
 NS2Entity::get_entity(std::string _name) const
+{
+    // A name that was never interned can't
+    // be the name of anything in the namespace.
+    Gyoji::context::Atom atom;
+    if (!atoms.find(_name, atom)) {
+	return nullptr;
+    }
+    return get_entity(atom);
+}
+
+NS2Entity *
+NS2Entity::get_entity(Gyoji::context::Atom _name) const
 {
     const auto & it = elements.find(_name);
     if (it == elements.end()) {
@@ -148,7 +159,8 @@ NS2Entity*
 NS2Entity::add_entity(std::string _name, Gyoji::owned<NS2Entity> _entity)
 {
     NS2Entity *ret = _entity.get();
-    elements.insert(std::pair(_name, std::move(_entity)));
+    elements.insert(std::pair(atoms.intern(_name), std::move(_entity)));
+    generation++;
     return ret;
 }
 
@@ -165,7 +177,7 @@ NS2Entity::dump(int indent) const
     std::string end = pad + std::string("}");
     fprintf(stderr, "%s\n", start.c_str());
     for (const auto & el : elements) {
-	std::string name = el.first;
+	std::string name = atoms.get_string(el.first);
 	const NS2Entity *entity = el.second.get();
 
 	std::string typestr;
@@ -200,6 +212,7 @@ NS2Entity::dump(int indent) const
 // NS2Context
 ///////////////////////////////////////////////////
 NS2SearchPaths::NS2SearchPaths()
+    : resolved_generation(0)
 {}
 
 NS2SearchPaths::~NS2SearchPaths()
@@ -210,6 +223,8 @@ NS2SearchPaths::add_using(std::string name, NS2Entity *alias)
 {
     aliases.push_back(std::pair(name, alias));
     alias_map.insert(std::pair(name, alias));
+    // Names may now be found through the alias.
+    resolved.clear();
 }
 
 NS2Entity *
@@ -226,6 +241,32 @@ const std::vector<std::pair<std::string, NS2Entity*>> &
 NS2SearchPaths::get_aliases() const
 { return aliases; }
 
+bool
+NS2SearchPaths::get_resolved(Gyoji::context::Atom name, size_t _generation, NS2Entity* & entity)
+{
+    if (resolved_generation != _generation) {
+	resolved.clear();
+	resolved_generation = _generation;
+	return false;
+    }
+    const auto & it = resolved.find(name);
+    if (it == resolved.end()) {
+	return false;
+    }
+    entity = it->second;
+    return true;
+}
+
+void
+NS2SearchPaths::add_resolved(Gyoji::context::Atom name, size_t _generation, NS2Entity* entity)
+{
+    if (resolved_generation != _generation) {
+	resolved.clear();
+	resolved_generation = _generation;
+    }
+    resolved.insert(std::pair(name, entity));
+}
+
 ///////////////////////////////////////////////////
 // NS2Context
 ///////////////////////////////////////////////////
@@ -233,9 +274,13 @@ NS2SearchPaths::get_aliases() const
 static std::string internal_filename("builtin");
 static const Gyoji::context::SourceReference zero_source_ref(internal_filename, 1, 0, 0);
 
-NS2Context::NS2Context()
-    : root(Gyoji::owned_new<NS2Entity>(
-	       "root",
+NS2Context::NS2Context(Gyoji::context::AtomTable & _atoms)
+    : atoms(_atoms)
+    , generation(0)
+    , root(Gyoji::owned_new<NS2Entity>(
+	       atoms,
+	       generation,
+	       atoms.intern("root"),
 	       NS2Entity::ENTITY_TYPE_NAMESPACE,
 	       nullptr,
 	       zero_source_ref
@@ -353,6 +398,45 @@ NS2Context::namespace_find(std::string name) const
     return nullptr;
 }
 
+NS2Entity*
+NS2Context::namespace_find(Gyoji::context::Atom name) const
+{
+    NS2SearchPaths & current = *stack.back().second;
+    NS2Entity *found = nullptr;
+    if (current.get_resolved(name, generation, found)) {
+	return found;
+    }
+
+    const std::string & name_string = atoms.get_string(name);
+    if (name_string.find(':') != std::string::npos) {
+	found = namespace_find(name_string);
+	current.add_resolved(name, generation, found);
+	return found;
+    }
+
+    // Same search as above, but a simple name can never
+    // start with an alias prefix, so each alias namespace
+    // is searched for the name as-is.
+    for (size_t i = 0; i < stack.size(); i++) {
+	const auto & it = stack.at(stack.size() - 1 - i);
+	found = it.first->get_entity(name);
+	if (found != nullptr) {
+	    break;
+	}
+	for (const auto & alias : it.second->get_aliases()) {
+	    found = alias.second->get_entity(name);
+	    if (found != nullptr) {
+		break;
+	    }
+	}
+	if (found != nullptr) {
+	    break;
+	}
+    }
+    current.add_resolved(name, generation, found);
+    return found;
+}
+
 NS2Entity *
 NS2Context::get_current() const
 { return stack.back().first; }
@@ -386,6 +470,29 @@ NS2Context::namespace_pop()
     stack.pop_back();
 }
 
+NS2Stack
+NS2Context::namespace_save() const
+{
+    NS2Stack saved;
+    for (const auto & level : stack) {
+	saved.push_back(std::pair(level.first, level.second->get_aliases()));
+    }
+    return saved;
+}
+
+void
+NS2Context::namespace_restore(const NS2Stack & saved)
+{
+    stack.clear();
+    for (const auto & level : saved) {
+	Gyoji::owned<NS2SearchPaths> search_paths = Gyoji::owned_new<NS2SearchPaths>();
+	for (const auto & alias : level.second) {
+	    search_paths->add_using(alias.first, alias.second);
+	}
+	stack.push_back(std::pair(level.first, std::move(search_paths)));
+    }
+}
+
 void
 NS2Context::dump() const
 {
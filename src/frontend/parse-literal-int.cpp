@@ -29,7 +29,7 @@ static std::string i32_type("i32");
 static std::string i64_type("i64");
 
 bool Gyoji::frontend::integers::parse_literal_int(
-    const Gyoji::context::CompilerContext & compiler_context,
+    Gyoji::context::Errors & errors,
     const Gyoji::mir::Types & types,
     const Gyoji::frontend::tree::Terminal & literal_int_token,
     ParseLiteralIntResult & result
@@ -49,7 +49,7 @@ bool Gyoji::frontend::integers::parse_literal_int(
 
     bool sign_positive = true;
 
-    const std::string & token_value = literal_int_token.get_value();
+    std::string token_value(literal_int_token.get_value());
     size_t len = token_value.size();
     if (Gyoji::misc::endswith(token_value, u8_type)) {
 	integer_part = token_value.substr(0, len - u8_type.size());
@@ -113,8 +113,7 @@ bool Gyoji::frontend::integers::parse_literal_int(
     // if it's a negative number, it is
     // consistent with the signedness of the type.
     if (!sign_positive && type_part->is_unsigned()) {
-	compiler_context
-	    .get_errors()
+	errors
 	    .add_simple_error(
 		literal_int_token.get_source_ref(),
 		"Integer literal type mismatch",
@@ -157,8 +156,7 @@ bool Gyoji::frontend::integers::parse_literal_int(
     {
 	unsigned long number = strtoul(source_cstring, &endptr, radix);
 	if (endptr != (source_cstring + length)) {
-	    compiler_context
-		.get_errors()
+	    errors
 		.add_simple_error(
 		    literal_int_token.get_source_ref(),
 		    "Invalid integer literal",
@@ -167,8 +165,7 @@ bool Gyoji::frontend::integers::parse_literal_int(
 	    return false;
 	}
 	if (errno == ERANGE || number >= 256) {
-	    compiler_context
-		.get_errors()
+	    errors
 		.add_simple_error(
 		    literal_int_token.get_source_ref(),
 		    "Invalid integer literal",
@@ -184,8 +181,7 @@ bool Gyoji::frontend::integers::parse_literal_int(
     {
 	unsigned long number = strtoul(source_cstring, &endptr, radix);
 	if (endptr != (source_cstring + length)) {
-	    compiler_context
-		.get_errors()
+	    errors
 		.add_simple_error(
 		    literal_int_token.get_source_ref(),
 		    "Invalid integer literal",
@@ -194,8 +190,7 @@ bool Gyoji::frontend::integers::parse_literal_int(
 	    return false;
 	}
 	if (errno == ERANGE || number > 0xffff) {
-	    compiler_context
-		.get_errors()
+	    errors
 		.add_simple_error(
 		    literal_int_token.get_source_ref(),
 		    "Invalid integer literal",
@@ -212,8 +207,7 @@ bool Gyoji::frontend::integers::parse_literal_int(
     {
 	unsigned long number = strtoull(source_cstring, &endptr, radix);
 	if (endptr != (source_cstring + length)) {
-	    compiler_context
-		.get_errors()
+	    errors
 		.add_simple_error(
 		    literal_int_token.get_source_ref(),
 		    "Invalid integer literal",
@@ -222,8 +216,7 @@ bool Gyoji::frontend::integers::parse_literal_int(
 	    return false;
 	}
 	if (errno == ERANGE || number > 0xffffffff) {
-	    compiler_context
-		.get_errors()
+	    errors
 		.add_simple_error(
 		    literal_int_token.get_source_ref(),
 		    "Invalid integer literal",
@@ -240,8 +233,7 @@ bool Gyoji::frontend::integers::parse_literal_int(
     {
 	unsigned long number = strtoull(source_cstring, &endptr, radix);
 	if (endptr != (source_cstring + length)) {
-	    compiler_context
-		.get_errors()
+	    errors
 		.add_simple_error(
 		    literal_int_token.get_source_ref(),
 		    "Invalid integer literal",
@@ -250,8 +242,7 @@ bool Gyoji::frontend::integers::parse_literal_int(
 	    return false;
 	}
 	if (errno == ERANGE) {
-	    compiler_context
-		.get_errors()
+	    errors
 		.add_simple_error(
 		    literal_int_token.get_source_ref(),
 		    "Invalid integer literal",
@@ -270,8 +261,7 @@ bool Gyoji::frontend::integers::parse_literal_int(
     {
 	long number = strtol(source_cstring, &endptr, radix);
 	if (endptr != (source_cstring + length)) {
-	    compiler_context
-		.get_errors()
+	    errors
 		.add_simple_error(
 		    literal_int_token.get_source_ref(),
 		    "Invalid integer literal",
@@ -281,8 +271,7 @@ bool Gyoji::frontend::integers::parse_literal_int(
 	}
 	number = sign_positive ? number : -number;
 	if (errno == ERANGE || number < -128 || number > 127) {
-	    compiler_context
-		.get_errors()
+	    errors
 		.add_simple_error(
 		    literal_int_token.get_source_ref(),
 		    "Invalid integer literal",
@@ -298,8 +287,7 @@ bool Gyoji::frontend::integers::parse_literal_int(
     {
 	long number = strtol(source_cstring, &endptr, radix);
 	if (endptr != (source_cstring + length)) {
-	    compiler_context
-		.get_errors()
+	    errors
 		.add_simple_error(
 		    literal_int_token.get_source_ref(),
 		    "Invalid integer literal",
@@ -309,8 +297,7 @@ bool Gyoji::frontend::integers::parse_literal_int(
 	}
 	number = sign_positive ? number : -number;
 	if (errno == ERANGE || number < -32768 || number > 32767) {
-	    compiler_context
-		.get_errors()
+	    errors
 		.add_simple_error(
 		    literal_int_token.get_source_ref(),
 		    "Invalid integer literal",
@@ -327,8 +314,7 @@ bool Gyoji::frontend::integers::parse_literal_int(
     {
 	long number = strtoll(source_cstring, &endptr, radix);
 	if (endptr != (source_cstring + length)) {
-	    compiler_context
-		.get_errors()
+	    errors
 		.add_simple_error(
 		    literal_int_token.get_source_ref(),
 		    "Invalid integer literal",
@@ -338,8 +324,7 @@ bool Gyoji::frontend::integers::parse_literal_int(
 	}
 	number = sign_positive ? number : -number;
 	if (errno == ERANGE || number < -2147483648 || number > 2147483647) {
-	    compiler_context
-		.get_errors()
+	    errors
 		.add_simple_error(
 		    literal_int_token.get_source_ref(),
 		    "Invalid integer literal",
@@ -356,8 +341,7 @@ bool Gyoji::frontend::integers::parse_literal_int(
     {
 	long number = strtoll(source_cstring, &endptr, radix);
 	if (endptr != (source_cstring + length)) {
-	    compiler_context
-		.get_errors()
+	    errors
 		.add_simple_error(
 		    literal_int_token.get_source_ref(),
 		    "Invalid integer literal",
@@ -367,8 +351,7 @@ bool Gyoji::frontend::integers::parse_literal_int(
 	}
 	number = sign_positive ? number : -number;
 	if (errno == ERANGE) {
-	    compiler_context
-		.get_errors()
+	    errors
 		.add_simple_error(
 		    literal_int_token.get_source_ref(),
 		    "Invalid integer literal",
@@ -383,8 +366,7 @@ bool Gyoji::frontend::integers::parse_literal_int(
 	break;
 
     default:
-	compiler_context
-	    .get_errors()
+	errors
 	    .add_simple_error(
 		literal_int_token.get_source_ref(),
 		"Compiler Bug! Invalid integer literal",
@@ -27,6 +27,8 @@ ParseResult::ParseResult(
     Gyoji::owned<NS2Context>  _ns2_context
     )
     : compiler_context(_compiler_context)
+    , keep_trivia(true)
+    , defer_bodies(false)
     , ns2_context(std::move(_ns2_context))
     , translation_unit(nullptr)
 {}
@@ -54,6 +56,30 @@ bool
 ParseResult::has_translation_unit() const
 { return translation_unit.get() != nullptr; }
 
+size_t
+ParseResult::get_syntax_tree_footprint() const
+{
+    if (!has_translation_unit()) {
+	return 0;
+    }
+    // Walk the tree with an explicit stack because
+    // deeply nested expressions make for a deep tree.
+    size_t bytes = 0;
+    std::vector<const Gyoji::frontend::ast::SyntaxNode*> stack;
+    stack.push_back(&translation_unit->get_syntax_node());
+    while (stack.size() != 0) {
+	const Gyoji::frontend::ast::SyntaxNode *node = stack.back();
+	stack.pop_back();
+	const auto & children = node->get_children();
+	bytes += sizeof(Gyoji::frontend::ast::SyntaxNode);
+	bytes += children.capacity() * sizeof(std::reference_wrapper<const Gyoji::frontend::ast::SyntaxNode>);
+	for (const Gyoji::frontend::ast::SyntaxNode & child : children) {
+	    stack.push_back(&child);
+	}
+    }
+    return bytes;
+}
+
 bool
 ParseResult::has_errors() const
 {
@@ -75,6 +101,28 @@ ParseResult::set_translation_unit(Gyoji::owned<TranslationUnit> _translation_uni
     translation_unit = std::move(_translation_unit);
 }
 
+bool
+ParseResult::has_deferred_bodies() const
+{ return deferred_bodies.size() != 0; }
+
+void
+ParseResult::add_deferred_body(ScopeBody & scope_body)
+{
+    deferred_bodies.insert(
+	std::pair(
+	    &scope_body,
+	    std::pair(&scope_body, std::move(deferred_namespaces))
+	    )
+	);
+    deferred_namespaces.clear();
+}
+
+void
+ParseResult::set_deferred_statements(Gyoji::owned<StatementList> statements)
+{
+    deferred_statements = std::move(statements);
+}
+
 void
 ParseResult::symbol_define(std::string _symbol, const SourceReference &src_ref)
 {
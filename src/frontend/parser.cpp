@@ -26,17 +26,49 @@ using namespace Gyoji::frontend::lowering;
 using namespace Gyoji::frontend::namespaces;
 using namespace Gyoji::frontend::yacc;
 
+namespace Gyoji::frontend {
+    /**
+     * Skipped function bodies are scanned from
+     * the text read in the first place, so the
+     * lexer is given an input with nothing in it.
+     */
+    class InputSourceEmpty : public Gyoji::misc::InputSource {
+    public:
+	InputSourceEmpty();
+	~InputSourceEmpty();
+	void read(char *buf, int &result, int max_size);
+    };
+};
+
+InputSourceEmpty::InputSourceEmpty()
+{}
+
+InputSourceEmpty::~InputSourceEmpty()
+{}
+
+void
+InputSourceEmpty::read(char *buf, int &result, int max_size)
+{ result = 0; }
+
 Gyoji::owned<ParseResult>
 Parser::parse(
     Gyoji::context::CompilerContext & _compiler_context,
-    Gyoji::misc::InputSource & _input_source
+    Gyoji::misc::InputSource & _input_source,
+    bool _keep_trivia,
+    bool _defer_bodies
     )
 {
-    auto ns2_context = Gyoji::owned_new<Gyoji::frontend::namespaces::NS2Context>();
+    auto ns2_context = Gyoji::owned_new<Gyoji::frontend::namespaces::NS2Context>(_compiler_context.get_atoms());
     Gyoji::owned<ParseResult> result = Gyoji::owned_new<ParseResult>(
 	_compiler_context,
 	std::move(ns2_context)
 	);
+    result->keep_trivia = _keep_trivia;
+    result->defer_bodies = _defer_bodies;
+    
+    // Everything made while parsing belongs to the
+    // syntax tree, so it goes in the arena of the result.
+    Gyoji::misc::ArenaScope arena_scope(result->arena);
     
     yyscan_t scanner;
     yylex_init(&scanner);
@@ -44,8 +76,9 @@ Parser::parse(
     LexContext lex_context(
 	*result->ns2_context,
 	_compiler_context,
-	_input_source);
-    yyset_extra(&lex_context, scanner);
+	_input_source,
+	_keep_trivia);
+    lex_context.scan_input(scanner);
     
     yacc::YaccParser parser { scanner, *result };
     parser.parse();
@@ -54,6 +87,92 @@ Parser::parse(
     return result;
 }
 
+bool
+Parser::parse_deferred_body(
+    ParseResult & _parse_result,
+    const ScopeBody & _scope_body
+    )
+{
+    const auto & it = _parse_result.deferred_bodies.find(&_scope_body);
+    if (it == _parse_result.deferred_bodies.end()) {
+	return true;
+    }
+    ScopeBody & scope_body = *it->second.first;
+    NS2Stack body_namespaces = std::move(it->second.second);
+    _parse_result.deferred_bodies.erase(it);
+
+    Gyoji::misc::InputBuffer *text = _parse_result.compiler_context.get_token_stream().get_text();
+    if (text == nullptr) {
+	return false;
+    }
+    const Terminal & deferred_token = scope_body.get_deferred_token();
+    std::string_view body_text = deferred_token.get_value();
+    SourceReference body_source_ref = deferred_token.get_source_ref();
+
+    // The body is scanned in place, so the two bytes after
+    // it (the closing brace and whatever follows it) are
+    // replaced with the NUL bytes the scanner needs until
+    // it is done.  The text always ends with two NUL bytes,
+    // so these are still part of it.
+    char *body = text->get_data() + (body_text.data() - text->get_data());
+    size_t size = body_text.size();
+    char saved[2] = { body[size], body[size+1] };
+    body[size] = '\0';
+    body[size+1] = '\0';
+
+    NS2Context & ns2_context = *_parse_result.ns2_context;
+    NS2Stack namespaces = ns2_context.namespace_save();
+    ns2_context.namespace_restore(body_namespaces);
+
+    Gyoji::misc::ArenaScope arena_scope(_parse_result.arena);
+
+    yyscan_t scanner;
+    yylex_init(&scanner);
+
+    InputSourceEmpty input_source;
+    LexContext lex_context(
+	ns2_context,
+	_parse_result.compiler_context,
+	input_source,
+	_parse_result.keep_trivia);
+    // The lexer counts the lines of the text itself, so it
+    // starts from the line in the text rather than the one
+    // any line marker before the body says it is.
+    lex_context.scan_deferred_body(
+	scanner,
+	body,
+	size,
+	body_source_ref.get_physical_line(),
+	body_source_ref.get_column());
+
+    yacc::YaccParser parser { scanner, _parse_result };
+    int rc = parser.parse();
+    yylex_destroy(scanner);
+
+    body[size] = saved[0];
+    body[size+1] = saved[1];
+    ns2_context.namespace_restore(namespaces);
+
+    if (rc != 0 || !_parse_result.deferred_statements) {
+	_parse_result.deferred_statements.reset();
+	return false;
+    }
+    scope_body.set_statements(std::move(_parse_result.deferred_statements));
+    return true;
+}
+
+bool
+Parser::parse_deferred_bodies(ParseResult & _parse_result)
+{
+    bool ok = true;
+    while (_parse_result.deferred_bodies.size() != 0) {
+	if (!parse_deferred_body(_parse_result, *_parse_result.deferred_bodies.begin()->first)) {
+	    ok = false;
+	}
+    }
+    return ok;
+}
+
 Gyoji::owned<MIR>
 Parser::parse_to_mir(
     Gyoji::context::CompilerContext & _compiler_context,
@@ -62,15 +181,26 @@ Parser::parse_to_mir(
     )
 {
     
+    Gyoji::owned<ParseResult> parse_result = parse(_compiler_context, _input_source, false, false);
+    return lower_to_mir(_compiler_context, *parse_result, verbose, 1);
+}
+
+Gyoji::owned<MIR>
+Parser::lower_to_mir(
+    Gyoji::context::CompilerContext & _compiler_context,
+    ParseResult & parse_result,
+    bool verbose,
+    size_t threads
+    )
+{
     // We don't need to report an error at this point
     // because lack of a translation unit means
     // that our caller should not even have called us
     // and should report a syntax error at the
     // higher level.
-    Gyoji::owned<ParseResult> parse_result = parse(_compiler_context, _input_source);
-    Gyoji::owned<MIR> mir = Gyoji::owned_new<MIR>();
+    Gyoji::owned<MIR> mir = Gyoji::owned_new<MIR>(_compiler_context.get_atoms());
     
-    if (!parse_result->has_translation_unit()) {
+    if (!parse_result.has_translation_unit()) {
 	// It's harmless to return an empty mir
 	// to the next stages
 	return mir;
@@ -85,8 +215,8 @@ Parser::parse_to_mir(
     }
     // First, resolve all of the type definitions.
     // Also at this stage, we resolve the function declarations.
-    TypeLowering type_lowering(_compiler_context,
-			       parse_result->get_translation_unit(),
+    TypeLowering type_lowering(_compiler_context.get_errors(),
+			       parse_result.get_translation_unit(),
 			       *mir);
     type_lowering.lower();
 
@@ -96,9 +226,9 @@ Parser::parse_to_mir(
 	fprintf(stderr, "============================\n");
     }
     FunctionLowering function_lowering(_compiler_context,
-				       *parse_result,
+				       parse_result,
 				       *mir,
-				       type_lowering);
+				       threads);
     function_lowering.lower();
     
     return mir;
@@ -0,0 +1,1398 @@
+/* Copyright 2025 Jonathan S. Arney
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      https://github.com/jarney/gyoji/blob/master/LICENSE
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#include <gyoji-frontend.hpp>
+#include <algorithm>
+#include <mutex>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace Gyoji::context;
+using namespace Gyoji::frontend;
+
+// Files including each other without a guard
+// would otherwise go on until the stack runs out.
+static const size_t max_include_depth = 200;
+
+namespace Gyoji::frontend {
+    /**
+     * @brief A macro made by #define.
+     *
+     * @details
+     * The body is kept as it was written and is only
+     * split up into tokens when the macro is expanded.
+     */
+    class PreprocessorMacro {
+    public:
+	PreprocessorMacro();
+	/**
+	 * Move along, nothing to see here.
+	 */
+	~PreprocessorMacro();
+
+	bool function_like;
+	std::vector<std::string> parameters;
+	std::string body;
+    };
+
+    /**
+     * @brief A file read by the preprocessor.
+     *
+     * @details
+     * Files are read once and kept for the rest of the process
+     * (see get_cached_file).  Along with the contents, this holds
+     * the name of the macro that guards the whole of the file,
+     * once the file has been scanned and found to have one.
+     */
+    class PreprocessorFile {
+    public:
+	PreprocessorFile(std::string _path, bool _exists, std::string & _contents);
+	/**
+	 * Move along, nothing to see here.
+	 */
+	~PreprocessorFile();
+
+	std::string path;
+	bool exists;
+	std::string contents;
+	// Only read or written with the file cache locked,
+	// since files are shared by every preprocessor.
+	std::string guard;
+    };
+
+    /**
+     * @brief An #if (or #ifdef, #ifndef) that hasn't been closed yet.
+     */
+    class PreprocessorConditional {
+    public:
+	PreprocessorConditional(size_t _line, bool _parent_active, bool _active);
+	/**
+	 * Move along, nothing to see here.
+	 */
+	~PreprocessorConditional();
+
+	// The line of the #if, for errors.
+	size_t line;
+	// Whether the text around the #if is kept at all.
+	bool parent_active;
+	// Whether the text of the current branch is kept.
+	bool active;
+	// Whether any branch so far has been kept.
+	bool taken;
+	bool seen_else;
+    };
+
+    /**
+     * @brief Evaluates the expression of an #if.
+     *
+     * @details
+     * The expression has had its macros expanded already,
+     * so any identifier left in it is taken to be zero.
+     */
+    class PreprocessorExpression {
+    public:
+	PreprocessorExpression(std::string_view _text);
+	/**
+	 * Move along, nothing to see here.
+	 */
+	~PreprocessorExpression();
+	/**
+	 * Returns false if the expression is not valid.
+	 */
+	bool evaluate(long long & _value);
+    private:
+	bool parse_conditional(long long & _value);
+	bool parse_binary(int _precedence, long long & _value);
+	bool parse_unary(long long & _value);
+	bool parse_primary(long long & _value);
+	void skip_space();
+	int peek_operator(std::string_view & _op) const;
+
+	std::string_view text;
+	size_t position;
+    };
+};
+
+//////////////////////////////////////////////
+// Scanning helpers
+//////////////////////////////////////////////
+static bool
+is_space(char c)
+{ return c == ' ' || c == '\t' || c == '\r' || c == '\f' || c == '\v'; }
+
+static bool
+is_identifier_start(char c)
+{ return isalpha((unsigned char)c) || c == '_'; }
+
+static bool
+is_identifier_char(char c)
+{ return isalnum((unsigned char)c) || c == '_'; }
+
+static std::string_view
+trim(std::string_view text)
+{
+    size_t start = 0;
+    while (start < text.size() && is_space(text[start])) {
+	start++;
+    }
+    size_t end = text.size();
+    while (end > start && is_space(text[end-1])) {
+	end--;
+    }
+    return text.substr(start, end - start);
+}
+
+// Returns the identifier at the start of the
+// text, or an empty string if there isn't one.
+static std::string_view
+leading_identifier(std::string_view text)
+{
+    if (text.empty() || !is_identifier_start(text[0])) {
+	return std::string_view();
+    }
+    size_t end = 1;
+    while (end < text.size() && is_identifier_char(text[end])) {
+	end++;
+    }
+    return text.substr(0, end);
+}
+
+// Returns the position just past the string or
+// character literal that starts at the given position.
+static size_t
+skip_literal(std::string_view text, size_t position)
+{
+    char quote = text[position];
+    position++;
+    while (position < text.size()) {
+	char c = text[position];
+	if (c == '\\') {
+	    position += 2;
+	    continue;
+	}
+	position++;
+	if (c == quote) {
+	    break;
+	}
+    }
+    return std::min(position, text.size());
+}
+
+// Returns the position of the '#' if the
+// line is a directive, or npos if it isn't.
+static size_t
+directive_start(std::string_view line)
+{
+    size_t start = 0;
+    while (start < line.size() && is_space(line[start])) {
+	start++;
+    }
+    if (start < line.size() && line[start] == '#') {
+	return start;
+    }
+    return std::string_view::npos;
+}
+
+// Follows the comments through a line of text so that the
+// start of the next line is known to be in a comment or not.
+// Also says whether there is anything but comments and
+// whitespace on the line.
+static void
+scan_comments(std::string_view line, bool & in_comment, bool & has_code)
+{
+    size_t i = 0;
+    while (i < line.size()) {
+	if (in_comment) {
+	    size_t close = line.find("*/", i);
+	    if (close == std::string_view::npos) {
+		return;
+	    }
+	    in_comment = false;
+	    i = close + 2;
+	    continue;
+	}
+	char c = line[i];
+	if (c == '/' && i + 1 < line.size() && line[i+1] == '/') {
+	    return;
+	}
+	if (c == '/' && i + 1 < line.size() && line[i+1] == '*') {
+	    in_comment = true;
+	    i += 2;
+	    continue;
+	}
+	if (c == '"' || c == '\'') {
+	    has_code = true;
+	    i = skip_literal(line, i);
+	    continue;
+	}
+	if (!is_space(c)) {
+	    has_code = true;
+	}
+	i++;
+    }
+}
+
+// Takes the comments out of a directive, leaving a space
+// in place of each one.  A comment that isn't closed on the
+// directive's line goes on into the text after it.
+static std::string
+strip_comments(std::string_view directive, bool & in_comment)
+{
+    std::string stripped;
+    size_t i = 0;
+    while (i < directive.size()) {
+	char c = directive[i];
+	if (c == '/' && i + 1 < directive.size() && directive[i+1] == '/') {
+	    break;
+	}
+	if (c == '/' && i + 1 < directive.size() && directive[i+1] == '*') {
+	    size_t close = directive.find("*/", i + 2);
+	    if (close == std::string_view::npos) {
+		in_comment = true;
+		break;
+	    }
+	    stripped.push_back(' ');
+	    i = close + 2;
+	    continue;
+	}
+	if (c == '"' || c == '\'') {
+	    size_t end = skip_literal(directive, i);
+	    stripped.append(directive.substr(i, end - i));
+	    i = end;
+	    continue;
+	}
+	stripped.push_back(c);
+	i++;
+    }
+    return stripped;
+}
+
+static void
+stringify(std::string_view argument, std::string & out)
+{
+    out.push_back('"');
+    for (char c : argument) {
+	if (c == '"' || c == '\\') {
+	    out.push_back('\\');
+	}
+	out.push_back(c);
+    }
+    out.push_back('"');
+}
+
+//////////////////////////////////////////////
+// File cache
+//////////////////////////////////////////////
+static std::mutex &
+get_file_cache_mutex()
+{
+    static std::mutex file_cache_mutex;
+    return file_cache_mutex;
+}
+
+static bool
+read_file(const std::string & path, std::string & contents)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd == -1) {
+	return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+	close(fd);
+	return false;
+    }
+    contents.resize((size_t)st.st_size);
+    size_t size = 0;
+    while (size < contents.size()) {
+	ssize_t result = ::read(fd, contents.data() + size, contents.size() - size);
+	if (result <= 0) {
+	    break;
+	}
+	size += (size_t)result;
+    }
+    contents.resize(size);
+    close(fd);
+    return true;
+}
+
+// Returns the file with the given path, reading it the first
+// time it is asked for.  Files that don't exist are remembered
+// too, since the same include directories are searched for
+// each file included.
+static PreprocessorFile &
+get_cached_file(const std::string & path)
+{
+    static std::map<std::string, Gyoji::owned<PreprocessorFile>> file_cache;
+
+    std::lock_guard<std::mutex> lock(get_file_cache_mutex());
+    const auto & it = file_cache.find(path);
+    if (it != file_cache.end()) {
+	return *it->second;
+    }
+    std::string contents;
+    bool exists = read_file(path, contents);
+    Gyoji::owned<PreprocessorFile> file = Gyoji::owned_new<PreprocessorFile>(path, exists, contents);
+    PreprocessorFile & ret = *file;
+    file_cache.insert(std::pair(path, std::move(file)));
+    return ret;
+}
+
+static std::string
+get_file_guard(const PreprocessorFile & file)
+{
+    std::lock_guard<std::mutex> lock(get_file_cache_mutex());
+    return file.guard;
+}
+
+static void
+set_file_guard(PreprocessorFile & file, const std::string & guard)
+{
+    std::lock_guard<std::mutex> lock(get_file_cache_mutex());
+    file.guard = guard;
+}
+
+//////////////////////////////////////////////
+// PreprocessorMacro
+//////////////////////////////////////////////
+PreprocessorMacro::PreprocessorMacro()
+    : function_like(false)
+{}
+PreprocessorMacro::~PreprocessorMacro()
+{}
+
+//////////////////////////////////////////////
+// PreprocessorFile
+//////////////////////////////////////////////
+PreprocessorFile::PreprocessorFile(std::string _path, bool _exists, std::string & _contents)
+    : path(_path)
+    , exists(_exists)
+{
+    contents.swap(_contents);
+}
+PreprocessorFile::~PreprocessorFile()
+{}
+
+//////////////////////////////////////////////
+// PreprocessorConditional
+//////////////////////////////////////////////
+PreprocessorConditional::PreprocessorConditional(size_t _line, bool _parent_active, bool _active)
+    : line(_line)
+    , parent_active(_parent_active)
+    , active(_active)
+    , taken(_active)
+    , seen_else(false)
+{}
+PreprocessorConditional::~PreprocessorConditional()
+{}
+
+//////////////////////////////////////////////
+// PreprocessorExpression
+//////////////////////////////////////////////
+PreprocessorExpression::PreprocessorExpression(std::string_view _text)
+    : text(_text)
+    , position(0)
+{}
+PreprocessorExpression::~PreprocessorExpression()
+{}
+
+bool
+PreprocessorExpression::evaluate(long long & _value)
+{
+    if (!parse_conditional(_value)) {
+	return false;
+    }
+    skip_space();
+    return position == text.size();
+}
+
+void
+PreprocessorExpression::skip_space()
+{
+    while (position < text.size() && is_space(text[position])) {
+	position++;
+    }
+}
+
+// Returns the precedence of the binary operator
+// at the current position, or zero if there isn't one.
+int
+PreprocessorExpression::peek_operator(std::string_view & _op) const
+{
+    static const std::pair<const char*, int> operators[] = {
+	{ "||", 1 }, { "&&", 2 },
+	{ "==", 6 }, { "!=", 6 }, { "<=", 7 }, { ">=", 7 },
+	{ "<<", 8 }, { ">>", 8 },
+	{ "|", 3 }, { "^", 4 }, { "&", 5 },
+	{ "<", 7 }, { ">", 7 },
+	{ "+", 9 }, { "-", 9 },
+	{ "*", 10 }, { "/", 10 }, { "%", 10 },
+    };
+    std::string_view rest = text.substr(position);
+    for (const auto & op : operators) {
+	std::string_view candidate(op.first);
+	if (rest.substr(0, candidate.size()) == candidate) {
+	    _op = candidate;
+	    return op.second;
+	}
+    }
+    return 0;
+}
+
+bool
+PreprocessorExpression::parse_conditional(long long & _value)
+{
+    if (!parse_binary(1, _value)) {
+	return false;
+    }
+    skip_space();
+    if (position >= text.size() || text[position] != '?') {
+	return true;
+    }
+    position++;
+    long long if_true;
+    long long if_false;
+    if (!parse_conditional(if_true)) {
+	return false;
+    }
+    skip_space();
+    if (position >= text.size() || text[position] != ':') {
+	return false;
+    }
+    position++;
+    if (!parse_conditional(if_false)) {
+	return false;
+    }
+    _value = _value ? if_true : if_false;
+    return true;
+}
+
+bool
+PreprocessorExpression::parse_binary(int _precedence, long long & _value)
+{
+    if (!parse_unary(_value)) {
+	return false;
+    }
+    while (true) {
+	skip_space();
+	std::string_view op;
+	int precedence = peek_operator(op);
+	if (precedence == 0 || precedence < _precedence) {
+	    return true;
+	}
+	position += op.size();
+	long long rhs;
+	if (!parse_binary(precedence + 1, rhs)) {
+	    return false;
+	}
+	if (op == "||") _value = _value || rhs;
+	else if (op == "&&") _value = _value && rhs;
+	else if (op == "==") _value = _value == rhs;
+	else if (op == "!=") _value = _value != rhs;
+	else if (op == "<=") _value = _value <= rhs;
+	else if (op == ">=") _value = _value >= rhs;
+	else if (op == "<<") _value = _value << rhs;
+	else if (op == ">>") _value = _value >> rhs;
+	else if (op == "|") _value = _value | rhs;
+	else if (op == "^") _value = _value ^ rhs;
+	else if (op == "&") _value = _value & rhs;
+	else if (op == "<") _value = _value < rhs;
+	else if (op == ">") _value = _value > rhs;
+	else if (op == "+") _value = _value + rhs;
+	else if (op == "-") _value = _value - rhs;
+	else if (op == "*") _value = _value * rhs;
+	else {
+	    if (rhs == 0) {
+		return false;
+	    }
+	    _value = (op == "/") ? _value / rhs : _value % rhs;
+	}
+    }
+}
+
+bool
+PreprocessorExpression::parse_unary(long long & _value)
+{
+    skip_space();
+    if (position >= text.size()) {
+	return false;
+    }
+    char c = text[position];
+    if (c == '!' || c == '~' || c == '-' || c == '+') {
+	position++;
+	if (!parse_unary(_value)) {
+	    return false;
+	}
+	if (c == '!') _value = !_value;
+	else if (c == '~') _value = ~_value;
+	else if (c == '-') _value = -_value;
+	return true;
+    }
+    return parse_primary(_value);
+}
+
+bool
+PreprocessorExpression::parse_primary(long long & _value)
+{
+    char c = text[position];
+    if (c == '(') {
+	position++;
+	if (!parse_conditional(_value)) {
+	    return false;
+	}
+	skip_space();
+	if (position >= text.size() || text[position] != ')') {
+	    return false;
+	}
+	position++;
+	return true;
+    }
+    if (isdigit((unsigned char)c)) {
+	int base = 10;
+	if (c == '0' && position + 1 < text.size()) {
+	    char radix = (char)tolower((unsigned char)text[position+1]);
+	    if (radix == 'x') base = 16;
+	    else if (radix == 'b') base = 2;
+	    else if (radix == 'o') base = 8;
+	    else if (isdigit((unsigned char)radix)) base = 8;
+	    position += (base == 8 && radix != 'o') ? 1 : (base == 10 ? 0 : 2);
+	}
+	_value = 0;
+	while (position < text.size()) {
+	    char d = (char)tolower((unsigned char)text[position]);
+	    if (d == '_') {
+		position++;
+		continue;
+	    }
+	    int digit = isdigit((unsigned char)d) ? d - '0' : (d >= 'a' && d <= 'f') ? d - 'a' + 10 : -1;
+	    if (digit < 0 || digit >= base) {
+		break;
+	    }
+	    _value = _value * base + digit;
+	    position++;
+	}
+	// Suffixes such as u32 or UL say nothing about the value.
+	while (position < text.size() && is_identifier_char(text[position])) {
+	    position++;
+	}
+	return true;
+    }
+    if (c == '\'') {
+	size_t end = skip_literal(text, position);
+	std::string_view literal = text.substr(position + 1, end - position - 2);
+	position = end;
+	if (literal.size() == 1) {
+	    _value = (unsigned char)literal[0];
+	    return true;
+	}
+	if (literal.size() == 2 && literal[0] == '\\') {
+	    switch (literal[1]) {
+	    case 'n': _value = '\n'; break;
+	    case 't': _value = '\t'; break;
+	    case 'r': _value = '\r'; break;
+	    case '0': _value = 0; break;
+	    default: _value = (unsigned char)literal[1]; break;
+	    }
+	    return true;
+	}
+	return false;
+    }
+    if (is_identifier_start(c)) {
+	while (position < text.size() && is_identifier_char(text[position])) {
+	    position++;
+	}
+	_value = 0;
+	return true;
+    }
+    return false;
+}
+
+//////////////////////////////////////////////
+// Preprocessor
+//////////////////////////////////////////////
+Preprocessor::Preprocessor(Gyoji::context::CompilerContext & _compiler_context)
+    : compiler_context(_compiler_context)
+    , in_system_file(false)
+    , current_line(0)
+    , output(nullptr)
+{}
+
+Preprocessor::~Preprocessor()
+{}
+
+void
+Preprocessor::add_include_directory(const std::string & _directory)
+{ include_directories.push_back(_directory); }
+
+void
+Preprocessor::define(const std::string & _name, const std::string & _value)
+{
+    Gyoji::owned<PreprocessorMacro> macro = Gyoji::owned_new<PreprocessorMacro>();
+    macro->body = _value;
+    macros.insert_or_assign(_name, std::move(macro));
+}
+
+void
+Preprocessor::add_error(std::string _title, std::string _message)
+{
+    SourceReference src_ref(current_filename, current_line, 0, 1);
+    compiler_context.get_errors().add_simple_error(src_ref, _title, _message);
+}
+
+void
+Preprocessor::add_line_marker(size_t _line, const std::string & _filename)
+{
+    output->append("# ");
+    output->append(std::to_string(_line));
+    output->append(" \"");
+    output->append(_filename);
+    output->append("\"\n");
+}
+
+bool
+Preprocessor::preprocess(const std::string & _filename, std::string & _output)
+{
+    current_filename = _filename;
+    current_line = 0;
+    PreprocessorFile & file = get_cached_file(_filename);
+    if (!file.exists) {
+	add_error("Cannot open file", std::string("Cannot open file ") + _filename);
+	return false;
+    }
+    dependencies.push_back(std::pair(file.path, false));
+    dependency_paths.insert(file.path);
+    output = &_output;
+    output->clear();
+    output->reserve(file.contents.size());
+    bool ok = process_file(file, 0);
+    output = nullptr;
+    return ok;
+}
+
+std::vector<std::string>
+Preprocessor::get_dependencies(bool _user_only) const
+{
+    std::vector<std::string> ret;
+    for (const auto & dependency : dependencies) {
+	if (_user_only && dependency.second) {
+	    continue;
+	}
+	ret.push_back(dependency.first);
+    }
+    return ret;
+}
+
+bool
+Preprocessor::process_file(PreprocessorFile & _file, size_t _depth)
+{
+    // Whether the file is all inside of one #ifndef, so that
+    // it can be skipped when included again (see get_file_guard).
+    enum {
+	GUARD_START,
+	GUARD_OPEN,
+	GUARD_CLOSED,
+	GUARD_NONE
+    } guard_state = GUARD_START;
+    std::string guard;
+
+    const std::string & text = _file.contents;
+    std::vector<PreprocessorConditional> conditionals;
+    std::vector<std::string> disabled;
+    bool in_comment = false;
+    bool ok = true;
+
+    current_filename = _file.path;
+    current_line = 1;
+    size_t position = 0;
+    while (position < text.size()) {
+	size_t end = std::min(text.find('\n', position), text.size());
+	std::string_view line(text.data() + position, end - position);
+	bool active = conditionals.empty() || conditionals.back().active;
+
+	size_t hash = in_comment ? std::string_view::npos : directive_start(line);
+	if (hash != std::string_view::npos) {
+	    // A directive goes on to the next line
+	    // when its line ends with a backslash.
+	    std::string joined(line.substr(hash + 1));
+	    size_t lines = 1;
+	    while (true) {
+		while (!joined.empty() && joined.back() == '\r') {
+		    joined.pop_back();
+		}
+		if (joined.empty() || joined.back() != '\\' || end >= text.size()) {
+		    break;
+		}
+		joined.pop_back();
+		position = end + 1;
+		end = std::min(text.find('\n', position), text.size());
+		joined.append(text, position, end - position);
+		lines++;
+	    }
+	    std::string directive = strip_comments(joined, in_comment);
+	    std::string_view name = leading_identifier(trim(directive));
+	    size_t depth_before = conditionals.size();
+
+	    if (!process_directive(_file, directive, lines, conditionals, _depth)) {
+		ok = false;
+	    }
+
+	    if (guard_state == GUARD_START) {
+		guard_state = GUARD_NONE;
+		if (name == "ifndef" && depth_before == 0 && conditionals.size() == 1) {
+		    guard = std::string(leading_identifier(trim(trim(directive).substr(name.size()))));
+		    guard_state = guard.empty() ? GUARD_NONE : GUARD_OPEN;
+		}
+	    }
+	    else if (guard_state == GUARD_OPEN) {
+		if (depth_before == 1 && (name == "else" || name == "elif")) {
+		    guard_state = GUARD_NONE;
+		}
+		else if (depth_before == 1 && conditionals.empty()) {
+		    guard_state = GUARD_CLOSED;
+		}
+	    }
+	    else if (guard_state == GUARD_CLOSED) {
+		guard_state = GUARD_NONE;
+	    }
+	    current_line += lines;
+	    position = end + 1;
+	    continue;
+	}
+
+	if (active) {
+	    if (macros.empty()) {
+		output->append(line);
+	    }
+	    else if (in_comment) {
+		// The start of the line is the end of a comment
+		// from an earlier line, which is left as it is.
+		size_t close = line.find("*/");
+		size_t comment_end = close == std::string_view::npos ? line.size() : close + 2;
+		output->append(line.substr(0, comment_end));
+		expand_text(line.substr(comment_end), disabled, *output);
+	    }
+	    else {
+		expand_text(line, disabled, *output);
+	    }
+	}
+	output->push_back('\n');
+
+	bool has_code = false;
+	scan_comments(line, in_comment, has_code);
+	if (has_code && (guard_state == GUARD_START || guard_state == GUARD_CLOSED)) {
+	    guard_state = GUARD_NONE;
+	}
+	current_line++;
+	position = end + 1;
+    }
+
+    if (!conditionals.empty()) {
+	current_line = conditionals.back().line;
+	add_error("Unterminated conditional", "This #if has no matching #endif");
+	ok = false;
+    }
+    if (guard_state == GUARD_CLOSED) {
+	set_file_guard(_file, guard);
+    }
+    return ok;
+}
+
+bool
+Preprocessor::process_directive(
+    PreprocessorFile & _file,
+    std::string_view _directive,
+    size_t _lines,
+    std::vector<PreprocessorConditional> & _conditionals,
+    size_t _depth
+    )
+{
+    std::string_view directive = trim(_directive);
+    std::string_view name = leading_identifier(directive);
+    std::string_view operand = trim(directive.substr(name.size()));
+    bool active = _conditionals.empty() || _conditionals.back().active;
+
+    // Most directives leave their lines empty.
+    if (name != "include" && name != "line") {
+	output->append(_lines, '\n');
+    }
+
+    if (name == "if" || name == "ifdef" || name == "ifndef") {
+	bool result = false;
+	bool ok = true;
+	if (active) {
+	    if (name == "if") {
+		ok = evaluate_condition(operand, result);
+	    }
+	    else {
+		std::string_view macro_name = leading_identifier(operand);
+		if (macro_name.empty()) {
+		    add_error("Invalid preprocessor directive", std::string("#") + std::string(name) + std::string(" needs the name of a macro"));
+		    ok = false;
+		}
+		result = macros.find(macro_name) != macros.end();
+		if (name == "ifndef") {
+		    result = !result;
+		}
+	    }
+	}
+	_conditionals.push_back(PreprocessorConditional(current_line, active, active && result));
+	return ok;
+    }
+    if (name == "elif" || name == "else" || name == "endif") {
+	if (_conditionals.empty()) {
+	    add_error("Invalid preprocessor directive", std::string("#") + std::string(name) + std::string(" without #if"));
+	    return false;
+	}
+	PreprocessorConditional & conditional = _conditionals.back();
+	if (name == "endif") {
+	    _conditionals.pop_back();
+	    return true;
+	}
+	if (conditional.seen_else) {
+	    add_error("Invalid preprocessor directive", std::string("#") + std::string(name) + std::string(" after #else"));
+	    return false;
+	}
+	if (name == "else") {
+	    conditional.seen_else = true;
+	    conditional.active = conditional.parent_active && !conditional.taken;
+	    conditional.taken = true;
+	    return true;
+	}
+	conditional.active = false;
+	if (conditional.parent_active && !conditional.taken) {
+	    bool result = false;
+	    if (!evaluate_condition(operand, result)) {
+		return false;
+	    }
+	    conditional.active = result;
+	    conditional.taken = result;
+	}
+	return true;
+    }
+
+    // Anything else in text that is left out is ignored.
+    if (!active) {
+	if (name == "include" || name == "line") {
+	    output->append(_lines, '\n');
+	}
+	return true;
+    }
+    if (name.empty()) {
+	if (!directive.empty()) {
+	    add_error("Invalid preprocessor directive", std::string("Invalid preprocessor directive #") + std::string(directive));
+	    return false;
+	}
+	return true;
+    }
+    if (name == "include") {
+	return process_include(_file, operand, _lines, _depth);
+    }
+    if (name == "define") {
+	return process_define(operand);
+    }
+    if (name == "undef") {
+	std::string_view macro_name = leading_identifier(operand);
+	const auto & it = macros.find(macro_name);
+	if (it != macros.end()) {
+	    macros.erase(it);
+	}
+	return true;
+    }
+    if (name == "line") {
+	// The lexer follows the line markers, so this
+	// is passed on as one (see SourceTable).
+	std::string expanded;
+	expand_text(operand, std::vector<std::string>(), expanded);
+	std::string_view rest = trim(expanded);
+	size_t digits = 0;
+	while (digits < rest.size() && isdigit((unsigned char)rest[digits])) {
+	    digits++;
+	}
+	if (digits == 0) {
+	    output->append(_lines, '\n');
+	    add_error("Invalid preprocessor directive", "#line needs a line number");
+	    return false;
+	}
+	size_t line = (size_t)strtoul(std::string(rest.substr(0, digits)).c_str(), nullptr, 10);
+	std::string_view filename = trim(rest.substr(digits));
+	if (filename.size() >= 2 && filename.front() == '"' && filename.back() == '"') {
+	    add_line_marker(line, std::string(filename.substr(1, filename.size() - 2)));
+	}
+	else {
+	    add_line_marker(line, current_filename);
+	}
+	return true;
+    }
+    if (name == "error") {
+	add_error("Preprocessor error", std::string("#error ") + std::string(operand));
+	return false;
+    }
+    if (name == "pragma") {
+	if (leading_identifier(operand) == "once") {
+	    once_files.insert(_file.path);
+	}
+	return true;
+    }
+    add_error("Invalid preprocessor directive", std::string("Unknown preprocessor directive #") + std::string(name));
+    return false;
+}
+
+bool
+Preprocessor::process_include(
+    PreprocessorFile & _file,
+    std::string_view _operand,
+    size_t _lines,
+    size_t _depth
+    )
+{
+    // The name may also be given by a macro.
+    std::string expanded;
+    std::string_view operand = _operand;
+    if (!operand.empty() && operand[0] != '"' && operand[0] != '<') {
+	expand_text(_operand, std::vector<std::string>(), expanded);
+	operand = trim(expanded);
+    }
+    bool quoted = !operand.empty() && operand[0] == '"';
+    size_t close = std::string_view::npos;
+    if (quoted) {
+	close = operand.find('"', 1);
+    }
+    else if (!operand.empty() && operand[0] == '<') {
+	close = operand.find('>', 1);
+    }
+    if (close == std::string_view::npos) {
+	output->append(_lines, '\n');
+	add_error("Invalid preprocessor directive", "#include expects \"FILENAME\" or <FILENAME>");
+	return false;
+    }
+    std::string name(operand.substr(1, close - 1));
+
+    PreprocessorFile *included = find_include(_file, name, quoted);
+    if (included == nullptr) {
+	output->append(_lines, '\n');
+	add_error("Include file not found", std::string("Cannot find include file ") + name);
+	return false;
+    }
+
+    bool system = in_system_file || !quoted;
+    if (dependency_paths.insert(included->path).second) {
+	dependencies.push_back(std::pair(included->path, system));
+    }
+
+    // A file that is guarded or said #pragma once
+    // has nothing more to give, so it isn't read again.
+    std::string guard = get_file_guard(*included);
+    if (once_files.find(included->path) != once_files.end() ||
+	(!guard.empty() && macros.find(guard) != macros.end())) {
+	output->append(_lines, '\n');
+	return true;
+    }
+    if (_depth >= max_include_depth) {
+	output->append(_lines, '\n');
+	add_error("Include nested too deeply", std::string("Too many nested includes including ") + name);
+	return false;
+    }
+
+    std::string saved_filename = current_filename;
+    size_t saved_line = current_line;
+    bool saved_system = in_system_file;
+    in_system_file = system;
+    add_line_marker(1, included->path);
+    bool ok = process_file(*included, _depth + 1);
+    current_filename = saved_filename;
+    current_line = saved_line;
+    in_system_file = saved_system;
+    add_line_marker(current_line + _lines, current_filename);
+    return ok;
+}
+
+PreprocessorFile *
+Preprocessor::find_include(
+    const PreprocessorFile & _from,
+    const std::string & _name,
+    bool _quoted
+    )
+{
+    if (!_name.empty() && _name[0] == '/') {
+	PreprocessorFile & file = get_cached_file(_name);
+	return file.exists ? &file : nullptr;
+    }
+    // A quoted name is looked for next to the
+    // including file before the include directories.
+    if (_quoted) {
+	size_t slash = _from.path.rfind('/');
+	std::string path = slash == std::string::npos ?
+	    _name :
+	    _from.path.substr(0, slash + 1) + _name;
+	PreprocessorFile & file = get_cached_file(path);
+	if (file.exists) {
+	    return &file;
+	}
+    }
+    for (const std::string & directory : include_directories) {
+	std::string path = directory;
+	if (!path.empty() && path.back() != '/') {
+	    path.push_back('/');
+	}
+	path += _name;
+	PreprocessorFile & file = get_cached_file(path);
+	if (file.exists) {
+	    return &file;
+	}
+    }
+    return nullptr;
+}
+
+bool
+Preprocessor::process_define(std::string_view _operand)
+{
+    std::string_view name = leading_identifier(_operand);
+    if (name.empty()) {
+	add_error("Invalid preprocessor directive", "#define needs the name of a macro");
+	return false;
+    }
+    Gyoji::owned<PreprocessorMacro> macro = Gyoji::owned_new<PreprocessorMacro>();
+    size_t position = name.size();
+    // Only a parenthesis right after the name
+    // makes a function-like macro.
+    if (position < _operand.size() && _operand[position] == '(') {
+	macro->function_like = true;
+	position++;
+	while (true) {
+	    while (position < _operand.size() && is_space(_operand[position])) {
+		position++;
+	    }
+	    if (position < _operand.size() && _operand[position] == ')' && macro->parameters.empty()) {
+		position++;
+		break;
+	    }
+	    std::string_view parameter = leading_identifier(_operand.substr(position));
+	    if (parameter.empty()) {
+		add_error("Invalid preprocessor directive", std::string("Invalid parameters for macro ") + std::string(name));
+		return false;
+	    }
+	    macro->parameters.push_back(std::string(parameter));
+	    position += parameter.size();
+	    while (position < _operand.size() && is_space(_operand[position])) {
+		position++;
+	    }
+	    if (position < _operand.size() && _operand[position] == ',') {
+		position++;
+		continue;
+	    }
+	    if (position < _operand.size() && _operand[position] == ')') {
+		position++;
+		break;
+	    }
+	    add_error("Invalid preprocessor directive", std::string("Invalid parameters for macro ") + std::string(name));
+	    return false;
+	}
+    }
+    macro->body = std::string(trim(_operand.substr(position)));
+    macros.insert_or_assign(std::string(name), std::move(macro));
+    return true;
+}
+
+bool
+Preprocessor::evaluate_condition(std::string_view _expression, bool & _result)
+{
+    // 'defined' is worked out before any
+    // macros are expanded.
+    std::string replaced;
+    size_t i = 0;
+    while (i < _expression.size()) {
+	std::string_view identifier = leading_identifier(_expression.substr(i));
+	if (identifier.empty()) {
+	    if (isdigit((unsigned char)_expression[i])) {
+		while (i < _expression.size() && is_identifier_char(_expression[i])) {
+		    replaced.push_back(_expression[i]);
+		    i++;
+		}
+		continue;
+	    }
+	    replaced.push_back(_expression[i]);
+	    i++;
+	    continue;
+	}
+	i += identifier.size();
+	if (identifier != "defined") {
+	    replaced.append(identifier);
+	    continue;
+	}
+	std::string_view rest = trim(_expression.substr(i));
+	bool parenthesized = !rest.empty() && rest[0] == '(';
+	if (parenthesized) {
+	    rest = trim(rest.substr(1));
+	}
+	std::string_view macro_name = leading_identifier(rest);
+	if (macro_name.empty()) {
+	    add_error("Invalid preprocessor expression", "'defined' needs the name of a macro");
+	    return false;
+	}
+	rest = trim(rest.substr(macro_name.size()));
+	if (parenthesized) {
+	    if (rest.empty() || rest[0] != ')') {
+		add_error("Invalid preprocessor expression", "Missing ')' after 'defined'");
+		return false;
+	    }
+	    rest = rest.substr(1);
+	}
+	i = _expression.size() - rest.size();
+	replaced.append(macros.find(macro_name) != macros.end() ? " 1 " : " 0 ");
+    }
+
+    std::string expanded;
+    expand_text(replaced, std::vector<std::string>(), expanded);
+    PreprocessorExpression expression(expanded);
+    long long value = 0;
+    if (!expression.evaluate(value)) {
+	add_error("Invalid preprocessor expression", std::string("Cannot evaluate #if ") + std::string(_expression));
+	return false;
+    }
+    _result = value != 0;
+    return true;
+}
+
+void
+Preprocessor::expand_text(std::string_view _text, const std::vector<std::string> & _disabled, std::string & _out)
+{
+    size_t i = 0;
+    while (i < _text.size()) {
+	char c = _text[i];
+	if (c == '/' && i + 1 < _text.size() && _text[i+1] == '/') {
+	    _out.append(_text.substr(i));
+	    return;
+	}
+	if (c == '/' && i + 1 < _text.size() && _text[i+1] == '*') {
+	    size_t close = _text.find("*/", i + 2);
+	    size_t end = close == std::string_view::npos ? _text.size() : close + 2;
+	    _out.append(_text.substr(i, end - i));
+	    i = end;
+	    continue;
+	}
+	if (c == '"' || c == '\'') {
+	    size_t end = skip_literal(_text, i);
+	    _out.append(_text.substr(i, end - i));
+	    i = end;
+	    continue;
+	}
+	if (isdigit((unsigned char)c)) {
+	    // Numbers such as 12u32 are left whole so
+	    // that their suffix isn't taken for a macro.
+	    size_t end = i;
+	    while (end < _text.size() && (is_identifier_char(_text[end]) || _text[end] == '.')) {
+		end++;
+	    }
+	    _out.append(_text.substr(i, end - i));
+	    i = end;
+	    continue;
+	}
+	if (is_identifier_start(c)) {
+	    std::string_view name = leading_identifier(_text.substr(i));
+	    i = expand_identifier(name, _text, i + name.size(), _disabled, _out);
+	    continue;
+	}
+	_out.push_back(c);
+	i++;
+    }
+}
+
+size_t
+Preprocessor::expand_identifier(
+    std::string_view _name,
+    std::string_view _text,
+    size_t _after,
+    const std::vector<std::string> & _disabled,
+    std::string & _out
+    )
+{
+    const auto & it = macros.find(_name);
+    if (it == macros.end()) {
+	if (_name == "__LINE__") {
+	    _out.append(std::to_string(current_line));
+	}
+	else if (_name == "__FILE__") {
+	    stringify(current_filename, _out);
+	}
+	else {
+	    _out.append(_name);
+	}
+	return _after;
+    }
+    // A macro isn't expanded again inside of its own expansion.
+    if (std::find(_disabled.begin(), _disabled.end(), _name) != _disabled.end()) {
+	_out.append(_name);
+	return _after;
+    }
+    const PreprocessorMacro & macro = *it->second;
+    std::vector<std::string> disabled(_disabled);
+    disabled.push_back(std::string(_name));
+
+    if (!macro.function_like) {
+	expand_text(macro.body, disabled, _out);
+	return _after;
+    }
+
+    // A function-like macro is only called when
+    // its name is followed by a parenthesis.
+    size_t position = _after;
+    while (position < _text.size() && is_space(_text[position])) {
+	position++;
+    }
+    if (position >= _text.size() || _text[position] != '(') {
+	_out.append(_name);
+	return _after;
+    }
+    position++;
+    std::vector<std::string_view> arguments;
+    size_t depth = 0;
+    size_t start = position;
+    while (true) {
+	if (position >= _text.size()) {
+	    add_error("Invalid macro call", std::string("The arguments of macro ") + std::string(_name) + std::string(" must end on the same line"));
+	    _out.append(_name);
+	    return _after;
+	}
+	char c = _text[position];
+	if (c == '"' || c == '\'') {
+	    position = skip_literal(_text, position);
+	    continue;
+	}
+	if (c == '(') {
+	    depth++;
+	}
+	else if (c == ')') {
+	    if (depth == 0) {
+		arguments.push_back(trim(_text.substr(start, position - start)));
+		position++;
+		break;
+	    }
+	    depth--;
+	}
+	else if (c == ',' && depth == 0) {
+	    arguments.push_back(trim(_text.substr(start, position - start)));
+	    start = position + 1;
+	}
+	position++;
+    }
+    // A macro without parameters is called
+    // with a single empty argument.
+    if (macro.parameters.empty() && arguments.size() == 1 && arguments[0].empty()) {
+	arguments.clear();
+    }
+    if (arguments.size() != macro.parameters.size()) {
+	add_error("Invalid macro call",
+		  std::string("Macro ") + std::string(_name) +
+		  std::string(" takes ") + std::to_string(macro.parameters.size()) +
+		  std::string(" arguments but was given ") + std::to_string(arguments.size()));
+	_out.append(_name);
+	return _after;
+    }
+    std::string substituted;
+    substitute(macro, arguments, _disabled, substituted);
+    expand_text(substituted, disabled, _out);
+    return position;
+}
+
+void
+Preprocessor::substitute(
+    const PreprocessorMacro & _macro,
+    const std::vector<std::string_view> & _arguments,
+    const std::vector<std::string> & _disabled,
+    std::string & _out
+    )
+{
+    const std::string & body = _macro.body;
+    // Set after a ## so that the next parameter
+    // is pasted as it was given.
+    bool paste_next = false;
+    size_t i = 0;
+    while (i < body.size()) {
+	char c = body[i];
+	if (c == '"' || c == '\'') {
+	    size_t end = skip_literal(body, i);
+	    _out.append(body, i, end - i);
+	    i = end;
+	    paste_next = false;
+	    continue;
+	}
+	if (c == '#' && i + 1 < body.size() && body[i+1] == '#') {
+	    while (!_out.empty() && is_space(_out.back())) {
+		_out.pop_back();
+	    }
+	    i += 2;
+	    while (i < body.size() && is_space(body[i])) {
+		i++;
+	    }
+	    paste_next = true;
+	    continue;
+	}
+	if (c == '#') {
+	    size_t next = i + 1;
+	    while (next < body.size() && is_space(body[next])) {
+		next++;
+	    }
+	    std::string_view parameter = leading_identifier(std::string_view(body).substr(next));
+	    const auto & it = std::find(_macro.parameters.begin(), _macro.parameters.end(), parameter);
+	    if (!parameter.empty() && it != _macro.parameters.end()) {
+		stringify(_arguments.at((size_t)(it - _macro.parameters.begin())), _out);
+		i = next + parameter.size();
+		paste_next = false;
+		continue;
+	    }
+	}
+	if (is_identifier_start(c)) {
+	    std::string_view identifier = leading_identifier(std::string_view(body).substr(i));
+	    i += identifier.size();
+	    const auto & it = std::find(_macro.parameters.begin(), _macro.parameters.end(), identifier);
+	    if (it == _macro.parameters.end()) {
+		_out.append(identifier);
+		paste_next = false;
+		continue;
+	    }
+	    std::string_view argument = _arguments.at((size_t)(it - _macro.parameters.begin()));
+	    // Arguments next to ## are pasted as they were
+	    // given, the rest have their macros expanded first.
+	    size_t next = i;
+	    while (next < body.size() && is_space(body[next])) {
+		next++;
+	    }
+	    bool paste_after = next + 1 < body.size() && body[next] == '#' && body[next+1] == '#';
+	    if (paste_next || paste_after) {
+		_out.append(argument);
+	    }
+	    else {
+		expand_text(argument, _disabled, _out);
+	    }
+	    paste_next = false;
+	    continue;
+	}
+	if (isdigit((unsigned char)c)) {
+	    size_t end = i;
+	    while (end < body.size() && (is_identifier_char(body[end]) || body[end] == '.')) {
+		end++;
+	    }
+	    _out.append(body, i, end - i);
+	    i = end;
+	    paste_next = false;
+	    continue;
+	}
+	_out.push_back(c);
+	if (!is_space(c)) {
+	    paste_next = false;
+	}
+	i++;
+    }
+}
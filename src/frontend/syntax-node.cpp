@@ -36,11 +36,16 @@ SyntaxNode::add_child(const SyntaxNode & node)
     children.push_back(node);
 }
 void
-SyntaxNode::prepend_child(const SyntaxNode & node)
+SyntaxNode::replace_child(const SyntaxNode & old_node, const SyntaxNode & new_node)
 {
-    children.insert(children.begin(), node);
+    for (auto & child : children) {
+	if (&child.get() == &old_node) {
+	    child = new_node;
+	    return;
+	}
+    }
 }
-const std::vector<std::reference_wrapper<const SyntaxNode>> &
+const SyntaxNode::children_t &
 SyntaxNode::get_children() const
 {
     return children;
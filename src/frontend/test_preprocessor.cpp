@@ -0,0 +1,231 @@
+/* Copyright 2025 Jonathan S. Arney
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      https://github.com/jarney/gyoji/blob/master/LICENSE
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#include <gyoji-frontend.hpp>
+#include <gyoji-misc/test.hpp>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+using namespace Gyoji::frontend;
+
+static std::string test_directory;
+
+static void
+write_file(const std::string & name, const std::string & contents)
+{
+    std::string path = test_directory + "/" + name;
+    FILE *file = fopen(path.c_str(), "w");
+    fwrite(contents.c_str(), 1, contents.size(), file);
+    fclose(file);
+}
+
+static std::vector<std::string> dependencies;
+static std::vector<std::string> user_dependencies;
+static std::string rendered_errors;
+
+// Prints the errors to a file in place of
+// stderr so that we can see what was printed.
+static std::string
+render_errors(const Gyoji::context::Errors & errors)
+{
+    std::string path = test_directory + "/errors.txt";
+    fflush(stderr);
+    int saved_stderr = dup(2);
+    int output = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    dup2(output, 2);
+    close(output);
+    errors.print();
+    fflush(stderr);
+    dup2(saved_stderr, 2);
+    close(saved_stderr);
+
+    std::string rendered;
+    FILE *file = fopen(path.c_str(), "r");
+    char buffer[256];
+    size_t length;
+    while ((length = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+	rendered.append(buffer, length);
+    }
+    fclose(file);
+    return rendered;
+}
+
+static bool
+preprocess(const std::string & name, std::string & output)
+{
+    Gyoji::context::CompilerContext context(name);
+    Preprocessor preprocessor(context);
+    preprocessor.add_include_directory(test_directory + "/include");
+    bool ok = preprocessor.preprocess(test_directory + "/" + name, output);
+    dependencies = preprocessor.get_dependencies(false);
+    user_dependencies = preprocessor.get_dependencies(true);
+    rendered_errors.clear();
+    if (context.has_errors()) {
+	rendered_errors = render_errors(context.get_errors());
+	fputs(rendered_errors.c_str(), stderr);
+    }
+    return ok;
+}
+
+static size_t
+count(const std::string & text, const std::string & what)
+{
+    size_t found = 0;
+    size_t position = text.find(what);
+    while (position != std::string::npos) {
+	found++;
+	position = text.find(what, position + 1);
+    }
+    return found;
+}
+
+int main(int argc, char **argv)
+{
+    char directory_template[] = "/tmp/test_preprocessor_XXXXXX";
+    ASSERT_TRUE(mkdtemp(directory_template) != nullptr, "Could not make a temporary directory");
+    test_directory = directory_template;
+    std::string include_directory = test_directory + "/include";
+    mkdir(include_directory.c_str(), 0700);
+
+    write_file("include/guarded.j",
+	       "// Guarded header\n"
+	       "#ifndef GUARDED_J\n"
+	       "#define GUARDED_J\n"
+	       "u32 guarded_function();\n"
+	       "#endif\n");
+    write_file("include/once.j",
+	       "#pragma once\n"
+	       "u32 once_function();\n");
+    write_file("include/unguarded.j",
+	       "u32 unguarded_function();\n");
+    write_file("local.j",
+	       "u32 local_function();\n");
+
+    {
+	write_file("includes.j",
+		   "#include <guarded.j>\n"
+		   "#include <guarded.j>\n"
+		   "#include <once.j>\n"
+		   "#include <once.j>\n"
+		   "#include <unguarded.j>\n"
+		   "#include <unguarded.j>\n"
+		   "#include \"local.j\"\n"
+		   "u32 main();\n");
+	std::string output;
+	ASSERT_TRUE(preprocess("includes.j", output), "Includes should be found");
+	ASSERT_INT_EQUAL(1, count(output, "u32 guarded_function"), "Guarded file should be included once");
+	ASSERT_INT_EQUAL(1, count(output, "once_function"), "#pragma once file should be included once");
+	ASSERT_INT_EQUAL(2, count(output, "unguarded_function"), "Unguarded file should be included each time");
+	ASSERT_INT_EQUAL(1, count(output, "local_function"), "Quoted include should be found next to the file");
+	ASSERT_INT_EQUAL(1, count(output, "# 1 \"" + include_directory + "/guarded.j\"\n"), "Line marker for the included file");
+	ASSERT_INT_EQUAL(1, count(output, "\"\nu32 main();\n"), "Line after the includes follows a line marker");
+	ASSERT_INT_EQUAL(1, count(output, "# 8 \"" + test_directory + "/includes.j\"\n"), "Line marker back to the including file");
+
+	ASSERT_INT_EQUAL(5, dependencies.size(), "Each file read is a dependency once");
+	ASSERT_STR_EQUAL(test_directory + "/includes.j", dependencies.at(0), "The file itself comes first");
+	ASSERT_STR_EQUAL(include_directory + "/guarded.j", dependencies.at(1), "Dependencies in the order found");
+	ASSERT_STR_EQUAL(test_directory + "/local.j", dependencies.at(4), "Quoted include is a dependency");
+	ASSERT_INT_EQUAL(2, user_dependencies.size(), "Files included as <file> are left out");
+	ASSERT_STR_EQUAL(test_directory + "/local.j", user_dependencies.at(1), "Quoted include is a user dependency");
+    }
+    {
+	write_file("macros.j",
+		   "#define SIZE 16u32\n"
+		   "#define MAX(a, b) ((a) > (b) ? (a) : (b))\n"
+		   "#define NAME(x) #x\n"
+		   "#define PASTE(a, b) a ## b\n"
+		   "#define RECURSE RECURSE + 1\n"
+		   "u32 a = SIZE;\n"
+		   "u32 b = MAX(SIZE, 4u32);\n"
+		   "u8* c = NAME(hello);\n"
+		   "u32 PASTE(foo, bar) = RECURSE;\n"
+		   "u32 d = MAX;\n"
+		   "// SIZE in a comment\n"
+		   "u8* e = \"SIZE\";\n"
+		   "u32 f = 0SIZE;\n"
+		   "#undef SIZE\n"
+		   "u32 g = SIZE;\n"
+		   "u32 h = __LINE__;\n");
+	std::string output;
+	ASSERT_TRUE(preprocess("macros.j", output), "Macros should expand");
+	ASSERT_INT_EQUAL(1, count(output, "u32 a = 16u32;\n"), "Object-like macro");
+	ASSERT_INT_EQUAL(1, count(output, "u32 b = ((16u32) > (4u32) ? (16u32) : (4u32));\n"), "Function-like macro");
+	ASSERT_INT_EQUAL(1, count(output, "u8* c = \"hello\";\n"), "Stringified argument");
+	ASSERT_INT_EQUAL(1, count(output, "u32 foobar = RECURSE + 1;\n"), "Pasted arguments and no recursion");
+	ASSERT_INT_EQUAL(1, count(output, "u32 d = MAX;\n"), "Function-like macro without arguments");
+	ASSERT_INT_EQUAL(1, count(output, "// SIZE in a comment\n"), "Comments are left alone");
+	ASSERT_INT_EQUAL(1, count(output, "u8* e = \"SIZE\";\n"), "Strings are left alone");
+	ASSERT_INT_EQUAL(1, count(output, "u32 f = 0SIZE;\n"), "Numbers are left alone");
+	ASSERT_INT_EQUAL(1, count(output, "u32 g = SIZE;\n"), "Undefined macro");
+	ASSERT_INT_EQUAL(1, count(output, "u32 h = 16;\n"), "Line number");
+	ASSERT_INT_EQUAL(16, count(output, "\n"), "Lines are kept");
+    }
+    {
+	write_file("conditionals.j",
+		   "#define VERSION 3\n"
+		   "#if VERSION >= 2 && defined(VERSION)\n"
+		   "u32 version_two;\n"
+		   "#elif VERSION == 1\n"
+		   "u32 version_one;\n"
+		   "#else\n"
+		   "u32 no_version;\n"
+		   "#endif\n"
+		   "#ifdef MISSING\n"
+		   "u32 missing;\n"
+		   "#include <does-not-exist.j>\n"
+		   "#else\n"
+		   "u32 not_missing;\n"
+		   "#endif\n"
+		   "#if (0x10 >> 4) * 3 - 1 == 2 ? !UNKNOWN : 0\n"
+		   "u32 arithmetic;\n"
+		   "#endif\n"
+		   "/*\n"
+		   "#error inside a comment\n"
+		   "*/\n");
+	std::string output;
+	ASSERT_TRUE(preprocess("conditionals.j", output), "Conditionals should evaluate");
+	ASSERT_INT_EQUAL(1, count(output, "version_two"), "#if taken");
+	ASSERT_INT_EQUAL(0, count(output, "version_one"), "#elif not taken");
+	ASSERT_INT_EQUAL(0, count(output, "no_version"), "#else not taken");
+	ASSERT_INT_EQUAL(0, count(output, "u32 missing"), "#ifdef not taken");
+	ASSERT_INT_EQUAL(1, count(output, "not_missing"), "#else taken");
+	ASSERT_INT_EQUAL(1, count(output, "arithmetic"), "Expression evaluated");
+	ASSERT_INT_EQUAL(20, count(output, "\n"), "Lines are kept");
+    }
+    {
+	write_file("errors.j",
+		   "#include <does-not-exist.j>\n"
+		   "#if 1\n");
+	std::string output;
+	ASSERT_FALSE(preprocess("errors.j", output), "Missing include and #endif are errors");
+    }
+    {
+	write_file("error-directive.j",
+		   "#error This is an error\n");
+	std::string output;
+	ASSERT_FALSE(preprocess("error-directive.j", output), "#error is an error");
+	// Nothing has been read into the token stream
+	// yet, so there are no lines to show around it.
+	std::string filename = test_directory + "/error-directive.j";
+	ASSERT_STR_EQUAL(
+	    filename + ": Error: Preprocessor error\n"
+	    + filename + ":1: #error This is an error\n",
+	    rendered_errors,
+	    "Only the location of the error is printed");
+    }
+
+    printf("PASSED\n");
+    return 0;
+}
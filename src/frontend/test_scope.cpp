@@ -69,7 +69,7 @@ int test_jump_backward_ok()
 {
     Gyoji::context::CompilerContext context("Some name");
     
-    ScopeTracker tracker(false, context);
+    ScopeTracker tracker(false, context.get_atoms(), context.get_errors());
 
     tracker.add_variable("argc", nullptr, zero_source_ref);
     tracker.add_variable("argv", nullptr, zero_source_ref);
@@ -104,7 +104,7 @@ int test_jump_forward_ok()
 {
     Gyoji::context::CompilerContext context("Some name");
     
-    ScopeTracker tracker(false, context);
+    ScopeTracker tracker(false, context.get_atoms(), context.get_errors());
 
     tracker.add_variable("argc", nullptr, zero_source_ref);
     tracker.add_variable("argv", nullptr, zero_source_ref);
@@ -154,7 +154,7 @@ int test_jump_backward_skip_initialization()
 {
     Gyoji::context::CompilerContext context("Some name");
     
-    ScopeTracker tracker(false, context);
+    ScopeTracker tracker(false, context.get_atoms(), context.get_errors());
 
     tracker.add_variable("argc", nullptr, zero_source_ref);
     tracker.add_variable("argv", nullptr, zero_source_ref);
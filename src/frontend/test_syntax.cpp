@@ -23,7 +23,7 @@ using namespace Gyoji::frontend::namespaces;
 
 static
 Gyoji::owned<ParseResult>
-parse(std::string & path, CompilerContext & compiler_context, std::string base_filename)
+parse(std::string & path, CompilerContext & compiler_context, std::string base_filename, bool defer_bodies)
 {
     std::string filename = path + std::string("/") + base_filename;
     
@@ -35,7 +35,9 @@ parse(std::string & path, CompilerContext & compiler_context, std::string base_f
     Gyoji::misc::InputSourceFile input_source(input);
     Gyoji::owned<ParseResult> parse_result =
 	Parser::parse(compiler_context,
-		      input_source
+		      input_source,
+		      false,
+		      defer_bodies
 	    );
 
     close(input);
@@ -55,7 +57,7 @@ int main(int argc, char **argv)
     {
 	const char *filename = "tests/llvm-decl-var.j";
 	CompilerContext context(filename);
-	auto parse_result = parse(path, context, filename);
+	auto parse_result = parse(path, context, filename, false);
 	ASSERT_FALSE(context.has_errors(), "tests/llvm-decl-var.j had an unexpected syntax error");
 	ASSERT_NOT_NULL(parse_result, "Parse of known-good thing should not be null");
 	ASSERT_TRUE(parse_result->has_translation_unit(), "We should have a translation unit");
@@ -65,7 +67,7 @@ int main(int argc, char **argv)
     {
 	const char *filename = "tests/syntax-empty.j";
 	CompilerContext context(filename);
-	auto parse_result = parse(path, context, filename);
+	auto parse_result = parse(path, context, filename, false);
 	ASSERT_FALSE(context.has_errors(), "tests/syntax-empty.j had an unexpected syntax error");
 	ASSERT_NOT_NULL(parse_result, "Empty file should parse");
 	ASSERT_TRUE(parse_result->has_translation_unit(), "We should have a translation unit");
@@ -75,7 +77,7 @@ int main(int argc, char **argv)
     {
 	const char *filename = "tests/syntax-invalid-garbage.j";
 	CompilerContext context(filename);
-	auto parse_result = parse(path, context, filename);
+	auto parse_result = parse(path, context, filename, false);
 	ASSERT_TRUE(parse_result->has_errors(), "We expect a syntax error in this file");
 	ASSERT_INT_EQUAL(1, parse_result->get_errors().size(), "We should have exactly one error");
 	ASSERT_INT_EQUAL(1, parse_result->get_errors().get(0).size(), "That error should have exactly one message");
@@ -86,7 +88,7 @@ int main(int argc, char **argv)
     {
 	const char *filename = "tests/syntax-typedef.j";
 	CompilerContext context(filename);
-	auto parse_result = parse(path, context, filename);
+	auto parse_result = parse(path, context, filename, false);
 	ASSERT_FALSE(context.has_errors(), "tests/syntax-typedef.j had an unexpected syntax error");
 	ASSERT_NOT_NULL(parse_result, "File should parse correctly.");
 	ASSERT_TRUE(parse_result->has_translation_unit(), "We should have a translation unit");
@@ -135,7 +137,7 @@ int main(int argc, char **argv)
     {
 	const char *filename = "tests/syntax-access-qualifier.j";
 	CompilerContext context(filename);
-	auto parse_result = parse(path, context, filename);
+	auto parse_result = parse(path, context, filename, false);
 	ASSERT_FALSE(context.has_errors(), "tests/syntax-access-qualifier.j had an unexpected syntax error");
 	ASSERT_NOT_NULL(parse_result, "File should parse correctly.");
 	ASSERT_TRUE(parse_result->has_translation_unit(), "We should have a translation unit");
@@ -187,7 +189,7 @@ int main(int argc, char **argv)
     {
 	const char *filename = "tests/syntax-pointer.j";
 	CompilerContext context(filename);
-	auto parse_result = parse(path, context, filename);
+	auto parse_result = parse(path, context, filename, false);
 	ASSERT_FALSE(context.has_errors(), "tests/syntax-pointer.j had an unexpected syntax error");
 	ASSERT_NOT_NULL(parse_result, "File should parse correctly.");
 	ASSERT_TRUE(parse_result->has_translation_unit(), "We should have a translation unit");
@@ -241,7 +243,7 @@ int main(int argc, char **argv)
     {
 	const char *filename = "tests/syntax-function-declaration.j";
 	CompilerContext context(filename);
-	auto parse_result = parse(path, context, filename);
+	auto parse_result = parse(path, context, filename, false);
 	ASSERT_FALSE(context.has_errors(), "tests/syntax-function-declaration.j had an unexpected syntax error");
 	ASSERT_NOT_NULL(parse_result, "File should parse correctly.");
 	ASSERT_TRUE(parse_result->has_translation_unit(), "We should have a translation unit");
@@ -274,7 +276,7 @@ int main(int argc, char **argv)
     {
 	const char *filename = "tests/syntax-function-definition.j";
 	CompilerContext context(filename);
-	auto parse_result = parse(path, context, filename);
+	auto parse_result = parse(path, context, filename, false);
 	ASSERT_FALSE(context.has_errors(), "tests/syntax-function-definition.j had an unexpected syntax error");
 	ASSERT_NOT_NULL(parse_result, "File should parse correctly.");
 	ASSERT_TRUE(parse_result->has_translation_unit(), "We should have a translation unit");
@@ -289,7 +291,7 @@ int main(int argc, char **argv)
     {
 	const char *filename = "tests/syntax-function-unsafe-block.j";
 	CompilerContext context(filename);
-	auto parse_result = parse(path, context, filename);
+	auto parse_result = parse(path, context, filename, false);
 	ASSERT_FALSE(context.has_errors(), "tests/syntax-function-unsafe-block.j had an unexpected syntax error");
 	ASSERT_NOT_NULL(parse_result, "File should parse correctly.");
 	ASSERT_TRUE(parse_result->has_translation_unit(), "We should have a translation unit");
@@ -314,6 +316,62 @@ int main(int argc, char **argv)
 	}
     }
     
+    // The same function with its body skipped
+    // and then parsed when asked for.
+    {
+	const char *filename = "tests/syntax-function-unsafe-block.j";
+	CompilerContext context(filename);
+	auto parse_result = parse(path, context, filename, true);
+	ASSERT_FALSE(context.has_errors(), "tests/syntax-function-unsafe-block.j had an unexpected syntax error");
+	ASSERT_NOT_NULL(parse_result, "File should parse correctly.");
+	ASSERT_TRUE(parse_result->has_translation_unit(), "We should have a translation unit");
+	ASSERT_TRUE(parse_result->has_deferred_bodies(), "The function body should be deferred");
+	
+	const auto & statement_type = parse_result->get_translation_unit().get_statements().at(0)->get_statement();
+	const auto & function_definition = std::get<Gyoji::owned<FileStatementFunctionDefinition>>(statement_type);
+	const auto & scope_body = function_definition->get_scope_body();
+	ASSERT_TRUE(scope_body.is_deferred(), "The body should not be parsed yet");
+	ASSERT_INT_EQUAL(0, scope_body.get_statements().get_statements().size(), "A deferred body has no statements");
+	
+	ASSERT_TRUE(Parser::parse_deferred_body(*parse_result, scope_body), "The deferred body should parse");
+	ASSERT_FALSE(context.has_errors(), "The deferred body had an unexpected syntax error");
+	ASSERT_FALSE(scope_body.is_deferred(), "The body should now be parsed");
+	ASSERT_FALSE(parse_result->has_deferred_bodies(), "There should be nothing left to parse");
+	ASSERT_INT_EQUAL(2, scope_body.get_statements().get_statements().size(), "There should be 2 statements in this function");
+	ASSERT_INT_EQUAL(4, scope_body.get_statements().get_source_ref().get_line(), "The statements should start on line 4");
+	
+	const auto & statement_2 = scope_body.get_statements().get_statements().at(1)->get_statement();
+	ASSERT_TRUE(std::holds_alternative<Gyoji::owned<StatementBlock>>(statement_2), "This should be a block statement.");
+	const auto & statement_block = std::get<Gyoji::owned<StatementBlock>>(statement_2);
+	ASSERT_INT_EQUAL(1, statement_block->get_scope_body().get_statements().get_statements().size(), "This unsafe block should have a single statement");
+	ASSERT_INT_EQUAL(6, statement_block->get_source_ref().get_line(), "The unsafe block should be on line 6");
+    }
+
+    // Braces and escaped quotes inside of literals
+    // don't end a skipped body early.
+    {
+	const char *filename = "tests/syntax-deferred-literals.j";
+	CompilerContext context(filename);
+	auto parse_result = parse(path, context, filename, true);
+	ASSERT_FALSE(context.has_errors(), "tests/syntax-deferred-literals.j had an unexpected syntax error");
+	ASSERT_NOT_NULL(parse_result, "File should parse correctly.");
+	ASSERT_TRUE(parse_result->has_translation_unit(), "We should have a translation unit");
+	ASSERT_INT_EQUAL(3, parse_result->get_translation_unit().get_statements().size(), "A declaration and two functions");
+
+	ASSERT_TRUE(Parser::parse_deferred_bodies(*parse_result), "The deferred bodies should parse");
+	ASSERT_FALSE(context.has_errors(), "The deferred bodies had an unexpected syntax error");
+
+	const auto & main_statement = parse_result->get_translation_unit().get_statements().at(1)->get_statement();
+	const auto & main_definition = std::get<Gyoji::owned<FileStatementFunctionDefinition>>(main_statement);
+	ASSERT_INT_EQUAL(6, main_definition->get_scope_body().get_statements().get_statements().size(), "There should be 6 statements in main");
+
+	const auto & after_statement = parse_result->get_translation_unit().get_statements().at(2)->get_statement();
+	ASSERT_TRUE(std::holds_alternative<Gyoji::owned<FileStatementFunctionDefinition>>(after_statement), "The second function is found after the first body");
+	const auto & after_definition = std::get<Gyoji::owned<FileStatementFunctionDefinition>>(after_statement);
+	ASSERT_INT_EQUAL(1, after_definition->get_scope_body().get_statements().get_statements().size(), "There should be 1 statement in after");
+	ASSERT_INT_EQUAL(15, after_definition->get_scope_body().get_statements().get_source_ref().get_line(), "The statements of after should start on line 15");
+    }
+    
     printf("PASSED\n");
     
     return 0;
@@ -13,7 +13,7 @@
  *  limitations under the License.
  */
 #include <gyoji-frontend.hpp>
-#include <gyoji-misc/input-source-file.hpp>
+#include <gyoji-misc/input-source-mmap.hpp>
 #include <gyoji-misc/test.hpp>
 
 using namespace Gyoji::context;
@@ -41,11 +41,13 @@ parse(std::string & filename, CompilerContext & context)
 	return nullptr;
     }
     
-    Gyoji::misc::InputSourceFile input_source(input);
+    Gyoji::misc::InputSourceMmap input_source(input);
     Gyoji::owned<ParseResult> parse_result = 
 	Parser::parse(
 	    context,
-	    input_source
+	    input_source,
+	    true,
+	    false
 	    );
     close(input);
     if (parse_result->has_errors()) {
@@ -72,8 +74,10 @@ int main(int argc, char **argv)
 	return 1;
     }
     
-    for (const Gyoji::owned<Token> & token : result->get_token_stream().get_tokens()) {
-	printf("%s", token->get_value().c_str());
+    const TokenStream & token_stream = result->get_token_stream();
+    for (size_t i = 0; i < token_stream.get_token_count(); i++) {
+	std::string_view value = token_stream.get_token_value(i);
+	printf("%.*s", (int)value.size(), value.data());
     }
     
     return 0;
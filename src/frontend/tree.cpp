@@ -32,15 +32,15 @@ Terminal::Terminal(const Token & _token)
 {}
 Terminal::~Terminal()
 {}
-const TokenID &
+TokenID
 Terminal::get_type() const
 { return token.get_type(); }
-const std::string &
+std::string_view
 Terminal::get_value() const
 { return token.get_value(); }
 const SourceReference &
 Terminal::get_terminal_source_ref() const
-{ return token.get_source_ref(); }
+{ return get_source_ref(); }
 
 std::string
 Terminal::get_fully_qualified_name() const
@@ -48,7 +48,7 @@ Terminal::get_fully_qualified_name() const
     if (identifier_type == IDENTIFIER_GLOBAL_SCOPE) {
 	return ns2_entity->get_fully_qualified_name();
     }
-    return token.get_value();
+    return std::string(token.get_value());
 }
 std::string
 Terminal::get_name() const
@@ -56,7 +56,7 @@ Terminal::get_name() const
     if (identifier_type == IDENTIFIER_GLOBAL_SCOPE) {
 	return ns2_entity->get_name();
     }
-    return token.get_value();
+    return std::string(token.get_value());
 }
 const Terminal::IdentifierType &
 Terminal::get_identifier_type() const
@@ -93,7 +93,7 @@ TerminalNonSyntax::get_type() const
 {
     return type;
 }
-const std::string &
+std::string_view
 TerminalNonSyntax::get_data() const
 {
     return token.get_value();
@@ -1142,9 +1142,9 @@ StatementLabel::StatementLabel(
 }
 StatementLabel::~StatementLabel()
 {}
-const std::string &
+std::string
 StatementLabel::get_name() const
-{ return identifier_token->get_value(); }
+{ return std::string(identifier_token->get_value()); }
 const SourceReference &
 StatementLabel::get_name_source_ref() const
 { return identifier_token->get_source_ref(); }
@@ -1166,9 +1166,9 @@ StatementGoto::StatementGoto(
 }
 StatementGoto::~StatementGoto()
 {}
-const std::string &
+std::string
 StatementGoto::get_label() const
-{ return identifier_token->get_value(); }
+{ return std::string(identifier_token->get_value()); }
 const SourceReference &
 StatementGoto::get_label_source_ref() const
 { return identifier_token->get_source_ref(); }
@@ -1277,6 +1277,7 @@ ScopeBody::ScopeBody(
     )
     : SyntaxNode(NONTERMINAL_scope_body, this, _brace_l_token->get_source_ref())
     , brace_l_token(std::move(_brace_l_token))
+    , deferred_token(nullptr)
     , statement_list(std::move(_statement_list))
     , brace_r_token(std::move(_brace_r_token))
 {
@@ -1284,6 +1285,21 @@ ScopeBody::ScopeBody(
     add_child(*statement_list);
     add_child(*brace_r_token);
 }
+ScopeBody::ScopeBody(
+    Gyoji::owned<Terminal> _brace_l_token,
+    Gyoji::owned<Terminal> _deferred_token,
+    Gyoji::owned<Terminal> _brace_r_token
+    )
+    : SyntaxNode(NONTERMINAL_scope_body, this, _brace_l_token->get_source_ref())
+    , brace_l_token(std::move(_brace_l_token))
+    , deferred_token(std::move(_deferred_token))
+    , statement_list(Gyoji::owned_new<StatementList>(deferred_token->get_source_ref()))
+    , brace_r_token(std::move(_brace_r_token))
+{
+    add_child(*brace_l_token);
+    add_child(*deferred_token);
+    add_child(*brace_r_token);
+}
 ScopeBody::~ScopeBody()
 {}
 const StatementList &
@@ -1292,6 +1308,19 @@ ScopeBody::get_statements() const
 const SourceReference &
 ScopeBody::get_end_source_ref() const
 { return brace_r_token->get_terminal_source_ref(); }
+bool
+ScopeBody::is_deferred() const
+{ return deferred_token.get() != nullptr; }
+const Terminal &
+ScopeBody::get_deferred_token() const
+{ return *deferred_token; }
+void
+ScopeBody::set_statements(Gyoji::owned<StatementList> _statement_list)
+{
+    statement_list = std::move(_statement_list);
+    replace_child(*deferred_token, *statement_list);
+    deferred_token.reset();
+}
 
 ///////////////////////////////////////////////////
 FileStatementFunctionDefinition::FileStatementFunctionDefinition(
@@ -1377,7 +1406,7 @@ ArrayLength::is_array() const
 }
 size_t
 ArrayLength::get_size() const
-{ return (size_t)atol(literal_int_token->get_value().c_str());}
+{ return (size_t)atol(std::string(literal_int_token->get_value()).c_str());}
 const Gyoji::context::SourceReference &
 ArrayLength::get_size_source_ref() const
 { return literal_int_token->get_source_ref(); }
@@ -1418,7 +1447,9 @@ ClassArgumentList::ClassArgumentList(Gyoji::owned<Terminal> _argument)
     , paren_l(nullptr)
     , paren_r(nullptr)
 {
-    add_child(*_argument);
+    // The children are added once the list is complete
+    // (see add_parens) so that the opening bracket
+    // doesn't have to be put in front of them.
     argument_list.push_back(std::move(_argument));
 }
 ClassArgumentList::ClassArgumentList(const Gyoji::context::SourceReference & _source_ref)
@@ -1433,9 +1464,15 @@ void
 ClassArgumentList::add_parens(Gyoji::owned<Terminal> _paren_l, Gyoji::owned<Terminal> _paren_r)
 {
     paren_l = std::move(_paren_l);
-    prepend_child(*paren_l);
-    
     paren_r = std::move(_paren_r);
+
+    add_child(*paren_l);
+    for (size_t i = 0; i < argument_list.size(); i++) {
+	if (i > 0) {
+	    add_child(*comma_list.at(i-1));
+	}
+	add_child(*argument_list.at(i));
+    }
     add_child(*paren_r);
 }
 
@@ -1777,9 +1814,9 @@ TypeDefinition::~TypeDefinition()
 const AccessModifier &
 TypeDefinition::get_access_modifier() const
 { return *access_modifier; }
-const std::string &
+std::string
 TypeDefinition::get_name() const
-{ return identifier_token->get_value(); }
+{ return std::string(identifier_token->get_value()); }
 const SourceReference &
 TypeDefinition::get_name_source_ref() const
 { return identifier_token->get_source_ref(); }
@@ -1807,9 +1844,9 @@ EnumDefinitionValue::EnumDefinitionValue(
 }
 EnumDefinitionValue::~EnumDefinitionValue()
 {}
-const std::string &
+std::string
 EnumDefinitionValue::get_name() const
-{ return identifier_token->get_value(); }
+{ return std::string(identifier_token->get_value()); }
 const SourceReference &
 EnumDefinitionValue::get_name_source_ref() const
 { return identifier_token->get_source_ref(); }
@@ -1870,15 +1907,15 @@ EnumDefinition::~EnumDefinition()
 const AccessModifier &
 EnumDefinition::get_access_modifier() const
 { return *access_modifier; }
-const std::string &
+std::string
 EnumDefinition::get_type_name() const
-{ return type_name_token->get_value(); }
+{ return std::string(type_name_token->get_value()); }
 const SourceReference &
 EnumDefinition::get_type_name_source_ref() const
 { return type_name_token->get_source_ref(); }
-const std::string &
+std::string
 EnumDefinition::get_name() const
-{ return identifier_token->get_value(); }
+{ return std::string(identifier_token->get_value()); }
 const SourceReference &
 EnumDefinition::get_name_source_ref() const
 { return identifier_token->get_source_ref(); }
@@ -1930,7 +1967,7 @@ ExpressionPrimaryLiteralInt::ExpressionPrimaryLiteralInt(
 
 ExpressionPrimaryLiteralInt::~ExpressionPrimaryLiteralInt()
 {}
-const std::string &
+std::string_view
 ExpressionPrimaryLiteralInt::get_value() const
 { return literal_token->get_value(); }
 
@@ -1958,9 +1995,9 @@ ExpressionPrimaryLiteralChar::get_value() const
     // Remove the leading and trailing single quote (')
     // before passing it down to the semantics
     // layer.
-    const std::string & token_value = literal_token->get_value();
+    std::string_view token_value = literal_token->get_value();
     size_t size = token_value.size();
-    return token_value.substr(1, size-2);
+    return std::string(token_value.substr(1, size-2));
 }
 const SourceReference &
 ExpressionPrimaryLiteralChar::get_value_source_ref() const
@@ -1989,19 +2026,16 @@ ExpressionPrimaryLiteralString::get_value() const
 {
     std::string retstring;
     // Strip the leading and trailing " from the string
-    const std::string & token_value = literal_token->get_value();
+    std::string_view token_value = literal_token->get_value();
     size_t size = token_value.size();
-    std::string firstpart = token_value.substr(1, size-2);
-
-    retstring = firstpart;
+    retstring = token_value.substr(1, size-2);
 
     // Do the same thing with the remaining
     // strings and append them to the literal.
     for (const auto & next_token : additional_strings) {
-	const std::string & next_token_value = next_token->get_value();
+	std::string_view next_token_value = next_token->get_value();
 	size = next_token_value.size();
-	std::string nextpart = next_token_value.substr(1, size-2);
-	retstring += nextpart;
+	retstring += next_token_value.substr(1, size-2);
     }
     
     return retstring;
@@ -2028,7 +2062,7 @@ ExpressionPrimaryLiteralFloat::ExpressionPrimaryLiteralFloat(
 {
     add_child(*literal_token);
 
-    const std::string & token_value = literal_token->get_value();
+    std::string token_value(literal_token->get_value());
     size_t len = token_value.size();
     if (Gyoji::misc::endswith(token_value, f32_type)) {
 	float_part = token_value.substr(0, len - f32_type.size());
@@ -2571,9 +2605,9 @@ FileStatementGlobalDefinition::get_unsafe_modifier() const
 const TypeSpecifier &
 FileStatementGlobalDefinition::get_type_specifier() const
 { return *type_specifier; }
-const std::string &
+std::string
 FileStatementGlobalDefinition::get_name() const
-{ return name->get_value(); }
+{ return std::string(name->get_value()); }
 const SourceReference &
 FileStatementGlobalDefinition::get_name_source_ref() const
 { return name->get_source_ref(); }
@@ -24,11 +24,11 @@ using namespace Gyoji::frontend::lowering;
 using namespace Gyoji::frontend::namespaces;
 
 TypeLowering::TypeLowering(
-    Gyoji::context::CompilerContext & _compiler_context,
+    Gyoji::context::Errors & _errors,
     const Gyoji::frontend::tree::TranslationUnit & _translation_unit,
     Gyoji::mir::MIR & _mir)
     : mir(_mir)
-    , compiler_context(_compiler_context)
+    , errors(_errors)
     , translation_unit(_translation_unit)
 {}
 TypeLowering::~TypeLowering()
@@ -53,21 +53,6 @@ TypeLowering::extract_from_class_declaration(const ClassDeclaration & declaratio
     mir.get_types().define_type(std::move(type));
 }
 
-Type *
-TypeLowering::get_or_create(std::string pointer_name, Type::TypeType type_type, bool complete, const SourceReference & source_ref)
-{
-    Type *pointer_type = mir.get_types().get_type(pointer_name);
-    if (pointer_type != nullptr) {
-	return pointer_type;
-    }
-    else {
-	Gyoji::owned<Type> pointer_type_created = Gyoji::owned_new<Type>(pointer_name, type_type, complete, source_ref);
-	pointer_type = pointer_type_created.get();
-	mir.get_types().define_type(std::move(pointer_type_created));
-	return pointer_type;
-    }
-}
-
 const Type*
 TypeLowering::extract_from_type_specifier_simple(const TypeSpecifierSimple & type_specifier)
 {
@@ -75,14 +60,13 @@ TypeLowering::extract_from_type_specifier_simple(const TypeSpecifierSimple & typ
     if (type_name.is_expression()) {
 	auto error = Gyoji::owned_new<Gyoji::context::Error>("Could not resolve type");
 	error->add_message(type_name.get_name_source_ref(), "Specifying types from expressions is not yet supported.");
-	compiler_context.get_errors().add_error(std::move(error));
+	errors.add_error(std::move(error));
 	return nullptr;
     }
     std::string name = type_name.get_name();
     const Type *type = mir.get_types().get_type(name);
     if (type == nullptr) {
-	compiler_context
-	    .get_errors()
+	errors
 	    .add_simple_error(type_name.get_name_source_ref(),
 			      "Could not find type",
 			      std::string("Could not resolve type ") + name
@@ -95,8 +79,7 @@ TypeLowering::extract_from_type_specifier_simple(const TypeSpecifierSimple & typ
 const Type*
 TypeLowering::extract_from_type_specifier_template(const TypeSpecifierTemplate & type_specifier)
 {
-    compiler_context
-	.get_errors()
+    errors
 	.add_simple_error(type_specifier.get_source_ref(),
 			  "Could not find type",
 			  "Template types are not supported yet."
@@ -109,33 +92,22 @@ TypeLowering::extract_from_type_specifier_function_pointer(const TypeSpecifierFu
 {
     const Type *return_type = extract_from_type_specifier(type_specifier.get_return_type());
 
-    std::vector<std::string> arg_list;
     std::vector<Argument> fptr_arguments;
 
     for (const auto & type_specifier : type_specifier.get_args().get_arguments()) {
 	const Type *argument_type = extract_from_type_specifier(*type_specifier);
 	Argument arg(argument_type, type_specifier->get_source_ref());
 	fptr_arguments.push_back(arg);
-	arg_list.push_back(argument_type->get_name());
     }
     
 //    bool is_unsafe = method_unsafe_modifier.is_unsafe();
     bool is_unsafe = false;
-    std::string arg_string = Gyoji::misc::join(arg_list, ",");
-    std::string unsafe_str = is_unsafe ? std::string("unsafe") : std::string("");
-    std::string pointer_name = return_type->get_name() + std::string("(") + unsafe_str + std::string("*)") + std::string("(") + arg_string + std::string(")");
-    Type *fptr_type = get_or_create(pointer_name, Type::TYPE_FUNCTION_POINTER, false, type_specifier.get_source_ref());
-    
-    if (!fptr_type->is_complete()) {
-	fptr_type->complete_function_pointer_definition(
-	    return_type,
-	    fptr_arguments,
-	    is_unsafe,
-	    type_specifier.get_source_ref()
-	    );
-    }
-    
-    return fptr_type;
+    return mir.get_types().get_function_pointer_to(
+	return_type,
+	fptr_arguments,
+	is_unsafe,
+	type_specifier.get_source_ref()
+	);
 }
 
 const Type*
@@ -143,8 +115,7 @@ TypeLowering::extract_from_type_specifier_pointer_to(const TypeSpecifierPointerT
 {
     const Type *pointer_target = extract_from_type_specifier(type_specifier.get_type_specifier());
     if (pointer_target == nullptr) {
-	compiler_context
-	    .get_errors()
+	errors
 	    .add_simple_error(type_specifier.get_source_ref(),
 			      "Could not find type",
 			      "Could not resolve target of pointer"
@@ -160,8 +131,7 @@ TypeLowering::extract_from_type_specifier_reference_to(const TypeSpecifierRefere
 {
     const Type *pointer_target = extract_from_type_specifier(type_specifier.get_type_specifier());
     if (pointer_target == nullptr) {
-	compiler_context
-	    .get_errors()
+	errors
 	    .add_simple_error(type_specifier.get_source_ref(),
 			      "Could not find type",
 			      "Could not resolve target of reference"
@@ -177,8 +147,7 @@ TypeLowering::extract_from_type_specifier_array(const TypeSpecifierArray & type_
 {
     const Type *pointer_target = extract_from_type_specifier(type_specifier.get_type_specifier());
     if (pointer_target == nullptr) {
-	compiler_context
-	    .get_errors()
+	errors
 	    .add_simple_error(type_specifier.get_literal_int_token().get_source_ref(),
 			      "Could not parse type of array elements.",
 			      "Array element type could not be parsed."
@@ -187,10 +156,9 @@ TypeLowering::extract_from_type_specifier_array(const TypeSpecifierArray & type_
     }
     
     Gyoji::frontend::integers::ParseLiteralIntResult parse_result;
-    bool parsed = parse_literal_int(compiler_context, mir.get_types(), type_specifier.get_literal_int_token(), parse_result);
+    bool parsed = parse_literal_int(errors, mir.get_types(), type_specifier.get_literal_int_token(), parse_result);
     if (!parsed || parse_result.parsed_type == nullptr) {
-	compiler_context
-	    .get_errors()
+	errors
 	    .add_simple_error(type_specifier.get_literal_int_token().get_source_ref(),
 			      "Array size invalid",
 			      "Could not parse array size."
@@ -198,8 +166,7 @@ TypeLowering::extract_from_type_specifier_array(const TypeSpecifierArray & type_
 	return nullptr;
     }
     if (parse_result.parsed_type->get_type() != Type::TYPE_PRIMITIVE_u32) {
-	compiler_context
-	    .get_errors()
+	errors
 	    .add_simple_error(type_specifier.get_literal_int_token().get_source_ref(),
 			      "Array size invalid",
 			      "Array size must be an unsigned 32-bit integer (u32) constant.  Sizes may not be computed at runtime."
@@ -241,8 +208,7 @@ TypeLowering::extract_from_type_specifier(const TypeSpecifier & type_specifier)
 	
     }
     
-    compiler_context
-	.get_errors()
+    errors
 	.add_simple_error(type_specifier.get_source_ref(),
 			  "Compiler bug!  Please report this message(2)",
 			  "Unknown TypeSpecifier type in variant (compiler bug)"
@@ -264,7 +230,6 @@ TypeLowering::extract_from_class_method_types(
     const Gyoji::context::SourceReference & source_ref
     )
 {
-    std::vector<std::string> arg_list;
     std::vector<Argument> fptr_arguments;
     // First, pass the 'this' pointer
     // to the function.
@@ -274,7 +239,6 @@ TypeLowering::extract_from_class_method_types(
 	Argument arg_this(this_type, source_ref);
     
 	fptr_arguments.push_back(arg_this);
-	arg_list.push_back(this_type->get_name());
     }
 	    
     const std::vector<Gyoji::owned<FunctionDefinitionArg>> & function_definition_args = 
@@ -283,7 +247,6 @@ TypeLowering::extract_from_class_method_types(
 	const Type *argument_type = extract_from_type_specifier(function_definition_arg->get_type_specifier());
 	Argument arg(argument_type, function_definition_arg->get_source_ref());
 	fptr_arguments.push_back(arg);
-	arg_list.push_back(argument_type->get_name());
     }
     
     TypeMethod method(
@@ -298,19 +261,12 @@ TypeLowering::extract_from_class_method_types(
     methods.insert(std::pair(simple_name, method));
     
     bool is_unsafe = method_unsafe_modifier.is_unsafe();
-    std::string arg_string = Gyoji::misc::join(arg_list, ",");
-    std::string unsafe_str = is_unsafe ? std::string("unsafe") : std::string("");
-    std::string pointer_name = method_return_type->get_name() + std::string("(") + unsafe_str + std::string("*)") + std::string("(") + arg_string + std::string(")");
-    Type *fptr_type = get_or_create(pointer_name, Type::TYPE_FUNCTION_POINTER, false, source_ref);
-    
-    if (!fptr_type->is_complete()) {
-	fptr_type->complete_function_pointer_definition(
-	    method_return_type,
-	    fptr_arguments,
-	    is_unsafe,
-	    source_ref
-	    );
-    }
+    const Type *fptr_type = mir.get_types().get_function_pointer_to(
+	method_return_type,
+	fptr_arguments,
+	is_unsafe,
+	source_ref
+	);
     //fprintf(stderr, "Defining symbol %s\n", fully_qualified_name.c_str());
     
     mir.get_symbols().define_symbol(
@@ -336,8 +292,7 @@ TypeLowering::extract_from_class_members(Type & class_type, const ClassDefinitio
 	    const auto & member_variable = std::get<Gyoji::owned<ClassMemberDeclarationVariable>>(class_member_type);
 	    
 	    if (member_variable->get_unsafe_modifier().is_unsafe()) {
-		compiler_context
-		    .get_errors()
+		errors
 		    .add_simple_error(member_variable->get_type_specifier().get_source_ref(),
 				      "Member variables cannot be declared inherently unsafe.",
 				      std::string("Member variable ") + member_variable->get_name() + std::string(" cannot be declared unsafe.  This would not have any valid meaning.")
@@ -345,8 +300,7 @@ TypeLowering::extract_from_class_members(Type & class_type, const ClassDefinitio
 	    }
 	    const Type *member_type = extract_from_type_specifier(member_variable->get_type_specifier());
 	    if (member_type == nullptr) {
-		compiler_context
-		    .get_errors()
+		errors
 		    .add_simple_error(member_variable->get_type_specifier().get_source_ref(),
 				      "Could not find type",
 				      std::string("Could not extract type of member variable ") + member_variable->get_name()
@@ -364,8 +318,7 @@ TypeLowering::extract_from_class_members(Type & class_type, const ClassDefinitio
 				       std::string(" was already defined"));
 		    error->add_message(existing_member_it->second->get_source_ref(),
 				       "Originally defined here.");
-		    compiler_context
-			.get_errors()
+		    errors
 			.add_error(std::move(error));
 		}
 		else {
@@ -424,8 +377,7 @@ TypeLowering::extract_from_class_members(Type & class_type, const ClassDefinitio
 	    const auto & member_method = std::get<Gyoji::owned<ClassMemberDeclarationDestructor>>(class_member_type);
 
 	    if (member_method->get_arguments().get_arguments().size() != 0) {
-		compiler_context
-		    .get_errors()
+		errors
 		    .add_simple_error(
 			member_method->get_source_ref(),
 			"Destructors may not have arguments",
@@ -495,8 +447,7 @@ TypeLowering::extract_from_class_definition(const ClassDefinition & definition)
 	    error->add_message(definition.get_name_source_ref(),
 			       "Re-declared here"
 		);
-	    compiler_context
-		.get_errors()
+	    errors
 		.add_error(std::move(error));
 	}
 	
@@ -532,8 +483,7 @@ TypeLowering::extract_from_enum_definition(const EnumDefinition & enum_definitio
 	error->add_message(enum_definition.get_name_source_ref(),
 			   "Re-declared here"
 	    );
-	compiler_context
-	    .get_errors()
+	errors
 	    .add_error(std::move(error));
     }
 }
@@ -571,8 +521,7 @@ TypeLowering::extract_from_type_definition(const TypeDefinition & type_definitio
 	error->add_message(type_definition.get_name_source_ref(),
 			   "Re-declared here"
 	    );
-	compiler_context
-	    .get_errors()
+	errors
 	    .add_error(std::move(error));
     }
 }
@@ -605,11 +554,9 @@ TypeLowering::extract_from_function_specifications(
 //////
 // Define the type of a function pointer.
 //////
-    std::vector<std::string> arg_list;
     std::vector<Argument> fptr_arguments;
     const auto & function_definition_args = function_argument_list.get_arguments();
     if (is_method) {
-	arg_list.push_back(class_pointer_type->get_name());
 	fptr_arguments.push_back(
 	    Argument(class_pointer_type, name.get_source_ref())
 	    );
@@ -617,25 +564,17 @@ TypeLowering::extract_from_function_specifications(
     for (const auto & function_definition_arg : function_definition_args) {
 	std::string name = function_definition_arg->get_identifier().get_fully_qualified_name();
 	const Type * t = extract_from_type_specifier(function_definition_arg->get_type_specifier());
-	arg_list.push_back(t->get_name());
 	fptr_arguments.push_back(
 	    Argument(t, function_definition_arg->get_type_specifier().get_source_ref())
 	    );
     }
     bool is_unsafe = unsafe_modifier.is_unsafe();
-    std::string arg_string = Gyoji::misc::join(arg_list, ",");
-    std::string unsafe_str = is_unsafe ? std::string("unsafe") : std::string("");
-    std::string pointer_name = return_type->get_name() + std::string("(") + unsafe_str + std::string("*)") + std::string("(") + arg_string + std::string(")");
-    Type *pointer_type = get_or_create(pointer_name, Type::TYPE_FUNCTION_POINTER, false, name.get_source_ref());
-
-    if (!pointer_type->is_complete()) {
-	pointer_type->complete_function_pointer_definition(
-	    return_type,
-	    fptr_arguments,
-	    is_unsafe,
-	    name.get_source_ref()
-	    );
-    }
+    const Type *pointer_type = mir.get_types().get_function_pointer_to(
+	return_type,
+	fptr_arguments,
+	is_unsafe,
+	name.get_source_ref()
+	);
 //////
 // Now that the type has been defined, we can
 // define the symbol for this specific function.
@@ -661,8 +600,7 @@ TypeLowering::extract_from_function_definition(const FileStatementFunctionDefini
 	return_type = extract_from_type_specifier(function_definition.get_return_type());
 	return_type_source_ref = &function_definition.get_return_type().get_source_ref();
 	if (return_type == nullptr) {
-	    compiler_context
-		.get_errors()
+	    errors
 		.add_simple_error(function_definition.get_return_type().get_source_ref(),
 				  "Compiler bug!  Please report this message(3)",
 				  "Function pointer type declared with invalid type"
@@ -693,8 +631,7 @@ TypeLowering::extract_from_function_declaration(const FileStatementFunctionDecla
 	return_type = extract_from_type_specifier(function_declaration.get_return_type());
 	return_type_source_ref = &function_declaration.get_return_type().get_source_ref();
 	if (return_type == nullptr) {
-	    compiler_context
-		.get_errors()
+	    errors
 		.add_simple_error(function_declaration.get_return_type().get_source_ref(),
 				  "Compiler bug!  Please report this message(3)",
 				  "Function pointer type declared with invalid type"
@@ -753,8 +690,7 @@ TypeLowering::extract_types(const std::vector<Gyoji::owned<FileStatement>> & sta
 	    // Nothing, no statements can be declared inside here.
 	}
 	else {
-	    compiler_context
-		.get_errors()
+	    errors
 		.add_simple_error(statement->get_source_ref(),
 				  "Compiler bug!  Please report this message(1)",
 				  "Unknown statement type in variant, extracting statements from file (compiler bug)"
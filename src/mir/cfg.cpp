@@ -0,0 +1,247 @@
+/* Copyright 2025 Jonathan S. Arney
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      https://github.com/jarney/gyoji/blob/master/LICENSE
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#include <gyoji-mir/cfg.hpp>
+#include <gyoji-mir/functions.hpp>
+
+using namespace Gyoji::mir;
+
+/////////////////////////////////////
+// CFGInfo
+/////////////////////////////////////
+CFGInfo::CFGInfo(const Function & function)
+    : block_limit(0)
+{
+    const auto & blocks = function.get_blocks();
+    if (blocks.size() != 0) {
+	block_limit = blocks.rbegin()->first + 1;
+    }
+
+    present.resize(block_limit, false);
+    reachable.resize(block_limit, false);
+    successors.resize(block_limit);
+    predecessors.resize(block_limit);
+    rpo_index.resize(block_limit, block_limit);
+    immediate_dominator.resize(block_limit, block_limit);
+    loop_header.resize(block_limit, false);
+    loop_depth.resize(block_limit, 0);
+
+    for (const auto & block_it : blocks) {
+	present[block_it.first] = true;
+    }
+    for (const auto & block_it : blocks) {
+	// Edges to blocks that don't exist can only come
+	// from a bug in lowering, so we leave them out
+	// of the graph rather than index past the tables.
+	for (size_t to : block_it.second->get_connections()) {
+	    if (to < block_limit && present[to]) {
+		successors[block_it.first].push_back(to);
+	    }
+	}
+    }
+
+    calculate_reverse_post_order();
+
+    // Only edges leaving reachable blocks count
+    // as predecessors.  Walking in reverse post-order
+    // also keeps each predecessor list in a stable order.
+    for (size_t from : reverse_post_order) {
+	for (size_t to : successors[from]) {
+	    predecessors[to].push_back(from);
+	}
+    }
+
+    calculate_dominators();
+    calculate_loops();
+}
+
+CFGInfo::~CFGInfo()
+{}
+
+void
+CFGInfo::calculate_reverse_post_order()
+{
+    if (block_limit == 0 || !present[0]) {
+	return;
+    }
+
+    // Iterative depth-first search so that deeply nested
+    // functions can't exhaust the stack.  Each entry is
+    // the block and the index of the next successor to visit.
+    std::vector<size_t> post_order;
+    std::vector<std::pair<size_t, size_t>> stack;
+    reachable[0] = true;
+    stack.push_back(std::pair(0, 0));
+    while (stack.size() != 0) {
+	auto & top = stack.back();
+	const std::vector<size_t> & next = successors[top.first];
+	if (top.second < next.size()) {
+	    size_t to = next[top.second];
+	    top.second++;
+	    if (!reachable[to]) {
+		reachable[to] = true;
+		stack.push_back(std::pair(to, 0));
+	    }
+	    continue;
+	}
+	post_order.push_back(top.first);
+	stack.pop_back();
+    }
+
+    reverse_post_order.assign(post_order.rbegin(), post_order.rend());
+    for (size_t i = 0; i < reverse_post_order.size(); i++) {
+	rpo_index[reverse_post_order[i]] = i;
+    }
+}
+
+void
+CFGInfo::calculate_dominators()
+{
+    // This is the iterative algorithm of Cooper, Harvey, and Kennedy
+    // from "A Simple, Fast Dominance Algorithm".  It converges
+    // in very few passes when blocks are visited in reverse post-order.
+    if (reverse_post_order.size() == 0) {
+	return;
+    }
+    size_t entry = reverse_post_order[0];
+    immediate_dominator[entry] = entry;
+
+    bool changed = true;
+    while (changed) {
+	changed = false;
+	for (size_t i = 1; i < reverse_post_order.size(); i++) {
+	    size_t block = reverse_post_order[i];
+	    size_t new_idom = block_limit;
+	    for (size_t pred : predecessors[block]) {
+		if (immediate_dominator[pred] == block_limit) {
+		    continue;
+		}
+		if (new_idom == block_limit) {
+		    new_idom = pred;
+		    continue;
+		}
+		// Walk both fingers up the tree until they meet.
+		size_t finger1 = pred;
+		size_t finger2 = new_idom;
+		while (finger1 != finger2) {
+		    while (rpo_index[finger1] > rpo_index[finger2]) {
+			finger1 = immediate_dominator[finger1];
+		    }
+		    while (rpo_index[finger2] > rpo_index[finger1]) {
+			finger2 = immediate_dominator[finger2];
+		    }
+		}
+		new_idom = finger1;
+	    }
+	    if (immediate_dominator[block] != new_idom) {
+		immediate_dominator[block] = new_idom;
+		changed = true;
+	    }
+	}
+    }
+}
+
+void
+CFGInfo::calculate_loops()
+{
+    // Gather the bodies of the natural loops, merging
+    // all of the back-edges that share a header into
+    // a single loop so it only counts once toward
+    // the depth of the blocks inside it.
+    for (size_t header : reverse_post_order) {
+	std::vector<size_t> worklist;
+	for (size_t pred : predecessors[header]) {
+	    if (dominates(header, pred)) {
+		worklist.push_back(pred);
+	    }
+	}
+	if (worklist.size() == 0) {
+	    continue;
+	}
+	loop_header[header] = true;
+
+	std::vector<bool> in_loop(block_limit, false);
+	in_loop[header] = true;
+	loop_depth[header]++;
+	while (worklist.size() != 0) {
+	    size_t block = worklist.back();
+	    worklist.pop_back();
+	    if (in_loop[block]) {
+		continue;
+	    }
+	    in_loop[block] = true;
+	    loop_depth[block]++;
+	    for (size_t pred : predecessors[block]) {
+		if (!in_loop[pred]) {
+		    worklist.push_back(pred);
+		}
+	    }
+	}
+    }
+}
+
+size_t
+CFGInfo::get_block_limit() const
+{ return block_limit; }
+
+bool
+CFGInfo::has_block(size_t blockid) const
+{ return blockid < block_limit && present[blockid]; }
+
+bool
+CFGInfo::is_reachable(size_t blockid) const
+{ return blockid < block_limit && reachable[blockid]; }
+
+const std::vector<size_t> &
+CFGInfo::get_successors(size_t blockid) const
+{ return successors.at(blockid); }
+
+const std::vector<size_t> &
+CFGInfo::get_predecessors(size_t blockid) const
+{ return predecessors.at(blockid); }
+
+const std::vector<size_t> &
+CFGInfo::get_reverse_post_order() const
+{ return reverse_post_order; }
+
+size_t
+CFGInfo::get_rpo_index(size_t blockid) const
+{ return rpo_index.at(blockid); }
+
+size_t
+CFGInfo::get_immediate_dominator(size_t blockid) const
+{ return immediate_dominator.at(blockid); }
+
+bool
+CFGInfo::dominates(size_t a, size_t b) const
+{
+    if (!is_reachable(a) || !is_reachable(b)) {
+	return false;
+    }
+    // Walk up the dominator tree from 'b'.  Dominators
+    // always come earlier in the reverse post-order, so
+    // we can stop as soon as we pass 'a'.
+    while (rpo_index[b] > rpo_index[a]) {
+	b = immediate_dominator[b];
+    }
+    return a == b;
+}
+
+bool
+CFGInfo::is_loop_header(size_t blockid) const
+{ return loop_header.at(blockid); }
+
+size_t
+CFGInfo::get_loop_depth(size_t blockid) const
+{ return loop_depth.at(blockid); }
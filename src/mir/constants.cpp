@@ -0,0 +1,668 @@
+/* Copyright 2025 Jonathan S. Arney
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      https://github.com/jarney/gyoji/blob/master/LICENSE
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#include <gyoji-mir.hpp>
+
+using namespace Gyoji::mir;
+
+namespace Gyoji::mir {
+
+    // Where a tmpvar is in the lattice of values.
+    // Tmpvars only ever move down from UNKNOWN
+    // to CONSTANT to VARYING.
+    typedef enum {
+	LATTICE_UNKNOWN,
+	LATTICE_CONSTANT,
+	LATTICE_VARYING
+    } LatticeState;
+
+    class LatticeValue {
+    public:
+	LatticeValue();
+	LatticeValue(LatticeState _state, uint64_t _value);
+	LatticeValue(const LatticeValue & other);
+	~LatticeValue();
+	LatticeValue & operator=(const LatticeValue & other);
+	LatticeState state;
+	uint64_t value;
+    };
+
+    // Solves for the values of the tmpvars and the
+    // reachable blocks using two worklists: one of
+    // blocks that have just become reachable and one
+    // of tmpvars whose value has just changed.
+    class ConstantSolver {
+    public:
+	ConstantSolver(const Function & _function);
+	~ConstantSolver();
+	void solve();
+	const std::vector<LatticeValue> & get_values() const;
+	const std::vector<bool> & get_executable() const;
+    private:
+	const Function & function;
+	std::vector<LatticeValue> values;
+	std::vector<bool> executable;
+	// For each tmpvar, the (block, operation index)
+	// of each operation that reads it.
+	std::vector<std::vector<std::pair<size_t, size_t>>> uses;
+	std::vector<size_t> block_worklist;
+	std::vector<size_t> tmpvar_worklist;
+
+	void reach(size_t blockid);
+	void visit(const Operation & operation);
+	void set_value(size_t tmpvar, const LatticeValue & value);
+	LatticeValue evaluate(const Operation & operation) const;
+	LatticeValue evaluate_binary(const OperationBinary & operation) const;
+    };
+
+};
+
+// Number of bits we track for a type,
+// or zero if it isn't an integer or a bool.
+static size_t
+value_width(const Type *type)
+{
+    if (type->is_bool()) {
+	return 1;
+    }
+    if (type->is_integer()) {
+	return 8 * type->get_primitive_size();
+    }
+    return 0;
+}
+
+static uint64_t
+width_mask(size_t width)
+{
+    if (width >= 64) {
+	return ~((uint64_t)0);
+    }
+    return (((uint64_t)1) << width) - 1;
+}
+
+static int64_t
+sign_extend(uint64_t value, size_t width)
+{
+    if (width >= 64) {
+	return (int64_t)value;
+    }
+    uint64_t sign = ((uint64_t)1) << (width - 1);
+    return (int64_t)((value ^ sign) - sign);
+}
+
+static bool
+literal_int_value(const OperationLiteralInt & literal, uint64_t & value)
+{
+    switch (literal.get_literal_type()) {
+    case Type::TYPE_PRIMITIVE_u8:
+	value = literal.get_literal_u8();
+	return true;
+    case Type::TYPE_PRIMITIVE_u16:
+	value = literal.get_literal_u16();
+	return true;
+    case Type::TYPE_PRIMITIVE_u32:
+	value = literal.get_literal_u32();
+	return true;
+    case Type::TYPE_PRIMITIVE_u64:
+	value = literal.get_literal_u64();
+	return true;
+    case Type::TYPE_PRIMITIVE_i8:
+	value = (uint64_t)(int64_t)literal.get_literal_i8();
+	return true;
+    case Type::TYPE_PRIMITIVE_i16:
+	value = (uint64_t)(int64_t)literal.get_literal_i16();
+	return true;
+    case Type::TYPE_PRIMITIVE_i32:
+	value = (uint64_t)(int64_t)literal.get_literal_i32();
+	return true;
+    case Type::TYPE_PRIMITIVE_i64:
+	value = (uint64_t)literal.get_literal_i64();
+	return true;
+    default:
+	return false;
+    }
+}
+
+// Builds the literal operation that loads the
+// given value into the result with the given type.
+static Gyoji::owned<Operation>
+make_literal(
+    const Gyoji::context::SourceReference & src_ref,
+    size_t result,
+    const Type *type,
+    uint64_t value
+    )
+{
+    Type::TypeType literal_type = type->get_type();
+    switch (literal_type) {
+    case Type::TYPE_PRIMITIVE_u8:
+	return Gyoji::owned_new<OperationLiteralInt>(src_ref, result, literal_type, (unsigned char)value);
+    case Type::TYPE_PRIMITIVE_u16:
+	return Gyoji::owned_new<OperationLiteralInt>(src_ref, result, literal_type, (unsigned short)value);
+    case Type::TYPE_PRIMITIVE_u32:
+	return Gyoji::owned_new<OperationLiteralInt>(src_ref, result, literal_type, (unsigned int)value);
+    case Type::TYPE_PRIMITIVE_u64:
+	return Gyoji::owned_new<OperationLiteralInt>(src_ref, result, literal_type, (unsigned long)value);
+    case Type::TYPE_PRIMITIVE_i8:
+	return Gyoji::owned_new<OperationLiteralInt>(src_ref, result, literal_type, (char)sign_extend(value, 8));
+    case Type::TYPE_PRIMITIVE_i16:
+	return Gyoji::owned_new<OperationLiteralInt>(src_ref, result, literal_type, (short)sign_extend(value, 16));
+    case Type::TYPE_PRIMITIVE_i32:
+	return Gyoji::owned_new<OperationLiteralInt>(src_ref, result, literal_type, (int)sign_extend(value, 32));
+    case Type::TYPE_PRIMITIVE_i64:
+	return Gyoji::owned_new<OperationLiteralInt>(src_ref, result, literal_type, (long)value);
+    default:
+	return Gyoji::owned_new<OperationLiteralBool>(src_ref, result, value != 0);
+    }
+}
+
+static bool
+is_literal(const Operation & operation)
+{
+    return operation.get_type() == Operation::OP_LITERAL_INT ||
+	operation.get_type() == Operation::OP_LITERAL_CHAR ||
+	operation.get_type() == Operation::OP_LITERAL_BOOL;
+}
+
+/////////////////////////////////////
+// LatticeValue
+/////////////////////////////////////
+LatticeValue::LatticeValue()
+    : state(LATTICE_UNKNOWN)
+    , value(0)
+{}
+
+LatticeValue::LatticeValue(LatticeState _state, uint64_t _value)
+    : state(_state)
+    , value(_value)
+{}
+
+LatticeValue::LatticeValue(const LatticeValue & other)
+    : state(other.state)
+    , value(other.value)
+{}
+
+LatticeValue::~LatticeValue()
+{}
+
+LatticeValue &
+LatticeValue::operator=(const LatticeValue & other)
+{
+    state = other.state;
+    value = other.value;
+    return *this;
+}
+
+/////////////////////////////////////
+// ConstantSolver
+/////////////////////////////////////
+ConstantSolver::ConstantSolver(const Function & _function)
+    : function(_function)
+{
+    const CFGInfo & cfg = function.get_cfg_info();
+    size_t tmpvars = function.tmpvar_count();
+    values.resize(tmpvars);
+    executable.resize(cfg.get_block_limit(), false);
+    uses.resize(tmpvars);
+
+    // A tmpvar is only worth tracking if exactly one operation
+    // produces it.  Anything else (there should be nothing else)
+    // is assumed to vary.
+    std::vector<size_t> definitions(tmpvars, 0);
+    for (const auto & block_it : function.get_blocks()) {
+	const std::vector<Gyoji::owned<Operation>> & operations = block_it.second->get_operations();
+	for (size_t i = 0; i < operations.size(); i++) {
+	    const Operation & operation = *operations.at(i);
+	    if (operation.has_result() && operation.get_result() < tmpvars) {
+		definitions[operation.get_result()]++;
+	    }
+	    const std::vector<size_t> & operands = operation.get_operands();
+	    for (size_t j = 0; j < operation.get_tmpvar_operand_count(); j++) {
+		if (operands.at(j) < tmpvars) {
+		    uses[operands.at(j)].push_back(std::pair(block_it.first, i));
+		}
+	    }
+	}
+    }
+    for (size_t tmpvar = 0; tmpvar < tmpvars; tmpvar++) {
+	if (definitions[tmpvar] != 1 || value_width(function.tmpvar_get(tmpvar)) == 0) {
+	    values[tmpvar].state = LATTICE_VARYING;
+	}
+    }
+}
+
+ConstantSolver::~ConstantSolver()
+{}
+
+const std::vector<LatticeValue> &
+ConstantSolver::get_values() const
+{ return values; }
+
+const std::vector<bool> &
+ConstantSolver::get_executable() const
+{ return executable; }
+
+void
+ConstantSolver::reach(size_t blockid)
+{
+    if (blockid >= executable.size() || executable[blockid]) {
+	return;
+    }
+    if (!function.get_cfg_info().has_block(blockid)) {
+	return;
+    }
+    executable[blockid] = true;
+    block_worklist.push_back(blockid);
+}
+
+void
+ConstantSolver::set_value(size_t tmpvar, const LatticeValue & value)
+{
+    LatticeValue & current = values[tmpvar];
+    if (value.state == current.state &&
+	(value.state != LATTICE_CONSTANT || value.value == current.value)) {
+	return;
+    }
+    if (value.state < current.state) {
+	// Values never move back up the lattice.
+	return;
+    }
+    if (value.state == current.state) {
+	// Two different constants
+	// means it isn't constant.
+	current = LatticeValue(LATTICE_VARYING, 0);
+    }
+    else {
+	current = value;
+    }
+    tmpvar_worklist.push_back(tmpvar);
+}
+
+void
+ConstantSolver::visit(const Operation & operation)
+{
+    if (operation.get_type() == Operation::OP_JUMP) {
+	reach(((const OperationJump &)operation).get_jump_block());
+	return;
+    }
+    if (operation.get_type() == Operation::OP_JUMP_CONDITIONAL) {
+	const OperationJumpConditional & jump = (const OperationJumpConditional &)operation;
+	const LatticeValue & condition = values[jump.get_operands().at(0)];
+	if (condition.state == LATTICE_CONSTANT) {
+	    reach(condition.value != 0 ? jump.get_if_block() : jump.get_else_block());
+	}
+	else if (condition.state == LATTICE_VARYING) {
+	    reach(jump.get_if_block());
+	    reach(jump.get_else_block());
+	}
+	return;
+    }
+    if (!operation.has_result() || values[operation.get_result()].state == LATTICE_VARYING) {
+	return;
+    }
+    set_value(operation.get_result(), evaluate(operation));
+}
+
+void
+ConstantSolver::solve()
+{
+    if (!function.get_cfg_info().has_block(0)) {
+	return;
+    }
+    reach(0);
+    while (true) {
+	while (block_worklist.size() != 0 || tmpvar_worklist.size() != 0) {
+	    if (block_worklist.size() != 0) {
+		size_t blockid = block_worklist.back();
+		block_worklist.pop_back();
+		for (const auto & operation : function.get_basic_block(blockid).get_operations()) {
+		    visit(*operation);
+		}
+		continue;
+	    }
+	    size_t tmpvar = tmpvar_worklist.back();
+	    tmpvar_worklist.pop_back();
+	    for (const auto & use : uses[tmpvar]) {
+		if (executable[use.first]) {
+		    visit(*function.get_basic_block(use.first).get_operations().at(use.second));
+		}
+	    }
+	}
+
+	// A condition that is still unknown was produced
+	// somewhere that can't be reached, which the front-end
+	// should never do.  Rather than drop both branches,
+	// assume it could go either way and carry on.
+	bool stuck = false;
+	for (size_t blockid = 0; blockid < executable.size(); blockid++) {
+	    if (!executable[blockid]) {
+		continue;
+	    }
+	    for (const auto & operation : function.get_basic_block(blockid).get_operations()) {
+		if (operation->get_type() != Operation::OP_JUMP_CONDITIONAL) {
+		    continue;
+		}
+		size_t condition = operation->get_operands().at(0);
+		if (values[condition].state == LATTICE_UNKNOWN) {
+		    set_value(condition, LatticeValue(LATTICE_VARYING, 0));
+		    stuck = true;
+		}
+	    }
+	}
+	if (!stuck) {
+	    break;
+	}
+    }
+}
+
+LatticeValue
+ConstantSolver::evaluate(const Operation & operation) const
+{
+    const LatticeValue varying(LATTICE_VARYING, 0);
+    const LatticeValue unknown(LATTICE_UNKNOWN, 0);
+    size_t width = value_width(function.tmpvar_get(operation.get_result()));
+    uint64_t mask = width_mask(width);
+
+    switch (operation.get_type()) {
+    case Operation::OP_LITERAL_INT:
+	{
+	    uint64_t value;
+	    if (!literal_int_value((const OperationLiteralInt &)operation, value)) {
+		return varying;
+	    }
+	    return LatticeValue(LATTICE_CONSTANT, value & mask);
+	}
+    case Operation::OP_LITERAL_CHAR:
+	return LatticeValue(LATTICE_CONSTANT, ((unsigned char)((const OperationLiteralChar &)operation).get_literal_char()) & mask);
+    case Operation::OP_LITERAL_BOOL:
+	return LatticeValue(LATTICE_CONSTANT, ((const OperationLiteralBool &)operation).get_literal_bool() ? 1 : 0);
+    case Operation::OP_WIDEN_SIGNED:
+    case Operation::OP_WIDEN_UNSIGNED:
+    case Operation::OP_NEGATE:
+    case Operation::OP_BITWISE_NOT:
+    case Operation::OP_LOGICAL_NOT:
+	{
+	    size_t a = ((const OperationUnary &)operation).get_a();
+	    const LatticeValue & value_a = values[a];
+	    if (value_a.state != LATTICE_CONSTANT) {
+		return value_a.state == LATTICE_UNKNOWN ? unknown : varying;
+	    }
+	    const Type *atype = function.tmpvar_get(a);
+	    switch (operation.get_type()) {
+	    case Operation::OP_WIDEN_SIGNED:
+	    case Operation::OP_WIDEN_UNSIGNED:
+		if (atype->is_signed()) {
+		    return LatticeValue(LATTICE_CONSTANT, ((uint64_t)sign_extend(value_a.value, value_width(atype))) & mask);
+		}
+		return LatticeValue(LATTICE_CONSTANT, value_a.value & mask);
+	    case Operation::OP_NEGATE:
+		return LatticeValue(LATTICE_CONSTANT, (0 - value_a.value) & mask);
+	    case Operation::OP_BITWISE_NOT:
+		return LatticeValue(LATTICE_CONSTANT, (~value_a.value) & mask);
+	    default:
+		return LatticeValue(LATTICE_CONSTANT, value_a.value == 0 ? 1 : 0);
+	    }
+	}
+    case Operation::OP_ADD:
+    case Operation::OP_SUBTRACT:
+    case Operation::OP_MULTIPLY:
+    case Operation::OP_DIVIDE:
+    case Operation::OP_MODULO:
+    case Operation::OP_LOGICAL_AND:
+    case Operation::OP_LOGICAL_OR:
+    case Operation::OP_BITWISE_AND:
+    case Operation::OP_BITWISE_OR:
+    case Operation::OP_BITWISE_XOR:
+    case Operation::OP_SHIFT_LEFT:
+    case Operation::OP_SHIFT_RIGHT:
+    case Operation::OP_COMPARE_LESS:
+    case Operation::OP_COMPARE_GREATER:
+    case Operation::OP_COMPARE_LESS_EQUAL:
+    case Operation::OP_COMPARE_GREATER_EQUAL:
+    case Operation::OP_COMPARE_NOT_EQUAL:
+    case Operation::OP_COMPARE_EQUAL:
+	return evaluate_binary((const OperationBinary &)operation);
+    default:
+	// Loads, calls, addresses, and everything
+	// else can't be known when compiling.
+	return varying;
+    }
+}
+
+LatticeValue
+ConstantSolver::evaluate_binary(const OperationBinary & operation) const
+{
+    const LatticeValue varying(LATTICE_VARYING, 0);
+    const LatticeValue unknown(LATTICE_UNKNOWN, 0);
+    Operation::OperationType type = operation.get_type();
+    const LatticeValue & value_a = values[operation.get_a()];
+    const LatticeValue & value_b = values[operation.get_b()];
+
+    // Both sides are always evaluated, so
+    // 'false && x' is false and 'true || x'
+    // is true whatever 'x' turns out to be.
+    if (type == Operation::OP_LOGICAL_AND || type == Operation::OP_LOGICAL_OR) {
+	uint64_t absorbing = type == Operation::OP_LOGICAL_AND ? 0 : 1;
+	if ((value_a.state == LATTICE_CONSTANT && value_a.value == absorbing) ||
+	    (value_b.state == LATTICE_CONSTANT && value_b.value == absorbing)) {
+	    return LatticeValue(LATTICE_CONSTANT, absorbing);
+	}
+    }
+    if (value_a.state == LATTICE_UNKNOWN || value_b.state == LATTICE_UNKNOWN) {
+	return unknown;
+    }
+    if (value_a.state == LATTICE_VARYING || value_b.state == LATTICE_VARYING) {
+	return varying;
+    }
+
+    const Type *atype = function.tmpvar_get(operation.get_a());
+    size_t awidth = value_width(atype);
+    size_t width = value_width(function.tmpvar_get(operation.get_result()));
+    uint64_t mask = width_mask(width);
+    bool is_signed = atype->is_signed();
+    uint64_t a = value_a.value;
+    uint64_t b = value_b.value;
+    int64_t sa = sign_extend(a, awidth);
+    int64_t sb = sign_extend(b, awidth);
+
+    switch (type) {
+    case Operation::OP_ADD:
+	return LatticeValue(LATTICE_CONSTANT, (a + b) & mask);
+    case Operation::OP_SUBTRACT:
+	return LatticeValue(LATTICE_CONSTANT, (a - b) & mask);
+    case Operation::OP_MULTIPLY:
+	return LatticeValue(LATTICE_CONSTANT, (a * b) & mask);
+    case Operation::OP_DIVIDE:
+    case Operation::OP_MODULO:
+	// Leave these to trap at run-time
+	// just as they would without folding.
+	if (b == 0) {
+	    return varying;
+	}
+	if (is_signed) {
+	    if (sb == -1 && sa == sign_extend(((uint64_t)1) << (awidth - 1), awidth)) {
+		return varying;
+	    }
+	    int64_t result = type == Operation::OP_DIVIDE ? sa / sb : sa % sb;
+	    return LatticeValue(LATTICE_CONSTANT, ((uint64_t)result) & mask);
+	}
+	return LatticeValue(LATTICE_CONSTANT, (type == Operation::OP_DIVIDE ? a / b : a % b) & mask);
+    case Operation::OP_LOGICAL_AND:
+	return LatticeValue(LATTICE_CONSTANT, (a != 0 && b != 0) ? 1 : 0);
+    case Operation::OP_LOGICAL_OR:
+	return LatticeValue(LATTICE_CONSTANT, (a != 0 || b != 0) ? 1 : 0);
+    case Operation::OP_BITWISE_AND:
+	return LatticeValue(LATTICE_CONSTANT, (a & b) & mask);
+    case Operation::OP_BITWISE_OR:
+	return LatticeValue(LATTICE_CONSTANT, (a | b) & mask);
+    case Operation::OP_BITWISE_XOR:
+	return LatticeValue(LATTICE_CONSTANT, (a ^ b) & mask);
+    case Operation::OP_SHIFT_LEFT:
+    case Operation::OP_SHIFT_RIGHT:
+	if (b >= awidth) {
+	    return varying;
+	}
+	return LatticeValue(LATTICE_CONSTANT, (type == Operation::OP_SHIFT_LEFT ? a << b : a >> b) & mask);
+    case Operation::OP_COMPARE_LESS:
+	return LatticeValue(LATTICE_CONSTANT, (is_signed ? sa < sb : a < b) ? 1 : 0);
+    case Operation::OP_COMPARE_GREATER:
+	return LatticeValue(LATTICE_CONSTANT, (is_signed ? sa > sb : a > b) ? 1 : 0);
+    case Operation::OP_COMPARE_LESS_EQUAL:
+	return LatticeValue(LATTICE_CONSTANT, (is_signed ? sa <= sb : a <= b) ? 1 : 0);
+    case Operation::OP_COMPARE_GREATER_EQUAL:
+	return LatticeValue(LATTICE_CONSTANT, (is_signed ? sa >= sb : a >= b) ? 1 : 0);
+    case Operation::OP_COMPARE_NOT_EQUAL:
+	return LatticeValue(LATTICE_CONSTANT, a != b ? 1 : 0);
+    case Operation::OP_COMPARE_EQUAL:
+	return LatticeValue(LATTICE_CONSTANT, a == b ? 1 : 0);
+    default:
+	return varying;
+    }
+}
+
+/////////////////////////////////////
+// ConstantPropagation
+/////////////////////////////////////
+ConstantPropagation::ConstantPropagation(Function & _function)
+    : function(_function)
+    , operations_folded(0)
+    , branches_resolved(0)
+    , blocks_removed(0)
+    , operations_removed(0)
+{
+    ConstantSolver solver(function);
+    solver.solve();
+
+    const std::vector<LatticeValue> & solution = solver.get_values();
+    constant.resize(solution.size(), false);
+    values.resize(solution.size(), 0);
+    for (size_t tmpvar = 0; tmpvar < solution.size(); tmpvar++) {
+	if (solution[tmpvar].state == LATTICE_CONSTANT) {
+	    constant[tmpvar] = true;
+	    values[tmpvar] = solution[tmpvar].value;
+	}
+    }
+    executable = solver.get_executable();
+}
+
+ConstantPropagation::~ConstantPropagation()
+{}
+
+bool
+ConstantPropagation::is_constant(size_t tmpvar) const
+{ return tmpvar < constant.size() && constant[tmpvar]; }
+
+uint64_t
+ConstantPropagation::get_constant(size_t tmpvar) const
+{ return values.at(tmpvar); }
+
+bool
+ConstantPropagation::is_executable(size_t blockid) const
+{ return blockid < executable.size() && executable[blockid]; }
+
+void
+ConstantPropagation::fold()
+{
+    std::vector<size_t> unreachable;
+    for (const auto & block_it : function.get_blocks()) {
+	size_t blockid = block_it.first;
+	if (!is_executable(blockid)) {
+	    unreachable.push_back(blockid);
+	    continue;
+	}
+	const std::vector<Gyoji::owned<Operation>> & operations = block_it.second->get_operations();
+	for (size_t i = 0; i < operations.size(); i++) {
+	    const Operation & operation = *operations.at(i);
+	    if (operation.get_type() == Operation::OP_JUMP_CONDITIONAL) {
+		const OperationJumpConditional & jump = (const OperationJumpConditional &)operation;
+		size_t condition = jump.get_operands().at(0);
+		if (!is_constant(condition)) {
+		    continue;
+		}
+		size_t target = get_constant(condition) != 0 ? jump.get_if_block() : jump.get_else_block();
+		function.replace_operation(
+		    blockid,
+		    i,
+		    Gyoji::owned_new<OperationJump>(operation.get_source_ref(), target)
+		    );
+		branches_resolved++;
+		continue;
+	    }
+	    if (!operation.has_result() || !is_constant(operation.get_result()) || is_literal(operation)) {
+		continue;
+	    }
+	    size_t result = operation.get_result();
+	    function.replace_operation(
+		blockid,
+		i,
+		make_literal(operation.get_source_ref(), result, function.tmpvar_get(result), get_constant(result))
+		);
+	    operations_folded++;
+	}
+    }
+
+    for (size_t blockid : unreachable) {
+	function.remove_block(blockid);
+	blocks_removed++;
+    }
+
+    // Every constant is now a literal with no operands, so
+    // removing the ones nobody reads can't leave any other
+    // constant without readers.
+    std::vector<size_t> readers(function.tmpvar_count(), 0);
+    for (const auto & block_it : function.get_blocks()) {
+	for (const auto & operation : block_it.second->get_operations()) {
+	    const std::vector<size_t> & operands = operation->get_operands();
+	    for (size_t j = 0; j < operation->get_tmpvar_operand_count(); j++) {
+		if (operands.at(j) < readers.size()) {
+		    readers[operands.at(j)]++;
+		}
+	    }
+	}
+    }
+    for (const auto & block_it : function.get_blocks()) {
+	const std::vector<Gyoji::owned<Operation>> & operations = block_it.second->get_operations();
+	std::vector<bool> remove(operations.size(), false);
+	bool any = false;
+	for (size_t i = 0; i < operations.size(); i++) {
+	    const Operation & operation = *operations.at(i);
+	    if (operation.has_result() &&
+		is_constant(operation.get_result()) &&
+		readers[operation.get_result()] == 0) {
+		remove[i] = true;
+		any = true;
+		operations_removed++;
+	    }
+	}
+	if (any) {
+	    function.remove_operations(block_it.first, remove);
+	}
+    }
+}
+
+size_t
+ConstantPropagation::get_operations_folded() const
+{ return operations_folded; }
+
+size_t
+ConstantPropagation::get_branches_resolved() const
+{ return branches_resolved; }
+
+size_t
+ConstantPropagation::get_blocks_removed() const
+{ return blocks_removed; }
+
+size_t
+ConstantPropagation::get_operations_removed() const
+{ return operations_removed; }
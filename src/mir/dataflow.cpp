@@ -0,0 +1,210 @@
+/* Copyright 2025 Jonathan S. Arney
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      https://github.com/jarney/gyoji/blob/master/LICENSE
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#include <gyoji-mir.hpp>
+
+using namespace Gyoji::mir;
+using Gyoji::misc::BitSet;
+
+//////////////////////////////////////////////
+// DataFlowProblem
+//////////////////////////////////////////////
+DataFlowProblem::DataFlowProblem(Direction _direction, Meet _meet, size_t _facts)
+    : direction(_direction)
+    , meet(_meet)
+    , facts(_facts)
+{}
+
+DataFlowProblem::~DataFlowProblem()
+{}
+
+DataFlowProblem::Direction
+DataFlowProblem::get_direction() const
+{ return direction; }
+
+DataFlowProblem::Meet
+DataFlowProblem::get_meet() const
+{ return meet; }
+
+size_t
+DataFlowProblem::get_facts() const
+{ return facts; }
+
+void
+DataFlowProblem::boundary(BitSet & facts) const
+{}
+
+//////////////////////////////////////////////
+// DataFlow
+//////////////////////////////////////////////
+DataFlow::DataFlow(const Function & _function, const DataFlowProblem & _problem)
+    : function(_function)
+    , problem(_problem)
+    , gen(_problem.get_facts())
+    , kill(_problem.get_facts())
+    , empty(_problem.get_facts())
+{
+    solve();
+}
+
+DataFlow::~DataFlow()
+{}
+
+void
+DataFlow::solve()
+{
+    const CFGInfo & cfg = function.get_cfg_info();
+    size_t nfacts = problem.get_facts();
+    bool forward = problem.get_direction() == DataFlowProblem::FORWARD;
+    bool must = problem.get_meet() == DataFlowProblem::MUST;
+
+    // Blocks are visited in reverse post-order for forward
+    // problems and in post-order for backward ones so that,
+    // outside of loops, every block is visited after all
+    // of the blocks that flow into it.
+    const std::vector<size_t> & rpo = cfg.get_reverse_post_order();
+    std::vector<size_t> order;
+    if (forward) {
+	order = rpo;
+    }
+    else {
+	order.assign(rpo.rbegin(), rpo.rend());
+    }
+    std::vector<size_t> order_index(cfg.get_block_limit(), 0);
+    for (size_t i = 0; i < order.size(); i++) {
+	order_index[order[i]] = i;
+    }
+
+    // Summarize each block as a single gen and kill set
+    // by composing the effects of its operations.
+    std::vector<BitSet> block_gen(cfg.get_block_limit());
+    std::vector<BitSet> block_kill(cfg.get_block_limit());
+    for (size_t blockid : order) {
+	BitSet & bgen = block_gen[blockid];
+	BitSet & bkill = block_kill[blockid];
+	bgen.resize(nfacts);
+	bkill.resize(nfacts);
+	const std::vector<Gyoji::owned<Operation>> & operations = function.get_basic_block(blockid).get_operations();
+	for (size_t i = 0; i < operations.size(); i++) {
+	    size_t operation_index = forward ? i : operations.size() - 1 - i;
+	    gen.clear();
+	    kill.clear();
+	    problem.effect(blockid, operation_index, *operations.at(operation_index), gen, kill);
+	    bgen.subtract(kill);
+	    bgen.union_with(gen);
+	    bkill.union_with(kill);
+	    bkill.subtract(gen);
+	}
+    }
+
+    in.resize(cfg.get_block_limit());
+    out.resize(cfg.get_block_limit());
+    for (size_t blockid = 0; blockid < cfg.get_block_limit(); blockid++) {
+	in[blockid].resize(nfacts);
+	out[blockid].resize(nfacts);
+    }
+    // Before anything is known, 'must' problems start
+    // out assuming every fact holds and 'may' problems
+    // assume that none do.
+    if (must) {
+	for (size_t blockid : order) {
+	    out[blockid].fill();
+	}
+    }
+
+    BitSet boundary(nfacts);
+    problem.boundary(boundary);
+    BitSet facts(nfacts);
+    BitSet pending(order.size());
+    pending.fill();
+    for (size_t i = pending.find_next(0); i < pending.size(); i = pending.find_next(0)) {
+	pending.reset(i);
+	size_t blockid = order[i];
+
+	// Facts flow in from the predecessors of a forward
+	// problem and from the successors of a backward one.
+	// The function boundary counts as one more of
+	// these for the entry or exit blocks.
+	const std::vector<size_t> & flows_from = forward
+	    ? cfg.get_predecessors(blockid)
+	    : cfg.get_successors(blockid);
+	bool at_boundary = forward
+	    ? (i == 0)
+	    : (flows_from.size() == 0);
+	if (must) {
+	    facts.fill();
+	    if (at_boundary) {
+		facts.intersect_with(boundary);
+	    }
+	    for (size_t from : flows_from) {
+		facts.intersect_with(out[from]);
+	    }
+	}
+	else {
+	    facts.clear();
+	    if (at_boundary) {
+		facts.union_with(boundary);
+	    }
+	    for (size_t from : flows_from) {
+		facts.union_with(out[from]);
+	    }
+	}
+	in[blockid] = facts;
+
+	facts.subtract(block_kill[blockid]);
+	facts.union_with(block_gen[blockid]);
+	if (facts != out[blockid]) {
+	    out[blockid] = facts;
+	    const std::vector<size_t> & flows_to = forward
+		? cfg.get_successors(blockid)
+		: cfg.get_predecessors(blockid);
+	    for (size_t to : flows_to) {
+		pending.set(order_index[to]);
+	    }
+	}
+    }
+}
+
+const BitSet &
+DataFlow::get_in(size_t blockid) const
+{
+    if (blockid >= in.size()) {
+	return empty;
+    }
+    return in[blockid];
+}
+
+const BitSet &
+DataFlow::get_out(size_t blockid) const
+{
+    if (blockid >= out.size()) {
+	return empty;
+    }
+    return out[blockid];
+}
+
+void
+DataFlow::apply(
+    size_t block_id,
+    size_t operation_index,
+    const Operation & operation,
+    BitSet & facts
+    ) const
+{
+    gen.clear();
+    kill.clear();
+    problem.effect(block_id, operation_index, operation, gen, kill);
+    facts.subtract(kill);
+    facts.union_with(gen);
+}
@@ -34,6 +34,17 @@ Functions::add_function(Gyoji::owned<Function> _function)
     functions.push_back(std::move(_function));
 }
 
+void
+Functions::merge(std::vector<Gyoji::owned<Functions>> & buffers)
+{
+    for (auto & buffer : buffers) {
+	for (auto & function : buffer->functions) {
+	    functions.push_back(std::move(function));
+	}
+	buffer->functions.clear();
+    }
+}
+
 const std::vector<Gyoji::owned<Function>> &
 Functions::get_functions() const
 { return functions; }
@@ -60,6 +71,7 @@ Function::Function(
     , return_type(_return_type)
     , arguments(_arguments)
     , m_is_unsafe(_is_unsafe)
+    , shared_cleanup_operations(0)
     , source_ref(_source_ref)
     , blockid(0)
 {
@@ -88,6 +100,14 @@ bool
 Function::is_unsafe() const
 { return m_is_unsafe; }
 
+size_t
+Function::get_shared_cleanup_operations() const
+{ return shared_cleanup_operations; }
+
+void
+Function::add_shared_cleanup_operations(size_t operations)
+{ shared_cleanup_operations += operations; }
+
 const BasicBlock &
 Function::get_basic_block(size_t blockid) const
 {
@@ -98,30 +118,116 @@ Function::get_basic_block(size_t blockid) const
 void
 Function::add_operation(size_t block_id, Gyoji::owned<Operation> operation)
 {
-    tmpvar_operations[operation->get_result()] = operation.get();
+    if (operation->has_result()) {
+	tmpvar_operations[operation->get_result()] = operation.get();
+    }
     const auto & it = blocks.find(block_id);
     if (it == blocks.end()) {
 	return;
     }
+    if (operation->is_terminating()) {
+	invalidate_cfg_info();
+    }
     it->second->add_operation(std::move(operation));
 }
 
 void
 Function::insert_operation(size_t block_id, size_t operation_index, Gyoji::owned<Operation> operation)
 {
-    tmpvar_operations[operation->get_result()] = operation.get();
+    if (operation->has_result()) {
+	tmpvar_operations[operation->get_result()] = operation.get();
+    }
     const auto & it = blocks.find(block_id);
     if (it == blocks.end()) {
 	return;
     }
+    if (operation->is_terminating()) {
+	invalidate_cfg_info();
+    }
     it->second->insert_operation(operation_index, std::move(operation));
 }
 
+// Forget the operation as the producer of its
+// result if it's the one we have recorded.
+void
+Function::tmpvar_forget_operation(const Operation & operation)
+{
+    if (!operation.has_result()) {
+	return;
+    }
+    const auto & it = tmpvar_operations.find(operation.get_result());
+    if (it != tmpvar_operations.end() && it->second == &operation) {
+	tmpvar_operations.erase(it);
+    }
+}
+
+void
+Function::mark_dead_store(size_t block_id, size_t operation_index)
+{
+    const auto & it = blocks.find(block_id);
+    if (it == blocks.end()) {
+	return;
+    }
+    it->second->mark_dead_store(operation_index);
+}
+
+void
+Function::replace_operation(size_t block_id, size_t operation_index, Gyoji::owned<Operation> operation)
+{
+    const auto & it = blocks.find(block_id);
+    if (it == blocks.end()) {
+	return;
+    }
+    if (operation->has_result()) {
+	tmpvar_operations[operation->get_result()] = operation.get();
+    }
+    if (operation->is_terminating()) {
+	invalidate_cfg_info();
+    }
+    Gyoji::owned<Operation> old_operation = it->second->replace_operation(operation_index, std::move(operation));
+    tmpvar_forget_operation(*old_operation);
+}
+
+void
+Function::remove_operations(size_t block_id, const std::vector<bool> & remove)
+{
+    const auto & it = blocks.find(block_id);
+    if (it == blocks.end()) {
+	return;
+    }
+    const std::vector<Gyoji::owned<Operation>> & operations = it->second->get_operations();
+    for (size_t i = 0; i < operations.size() && i < remove.size(); i++) {
+	if (!remove[i]) {
+	    continue;
+	}
+	if (operations.at(i)->is_terminating()) {
+	    invalidate_cfg_info();
+	}
+	tmpvar_forget_operation(*operations.at(i));
+    }
+    it->second->remove_operations(remove);
+}
+
+void
+Function::remove_block(size_t block_id)
+{
+    const auto & it = blocks.find(block_id);
+    if (it == blocks.end()) {
+	return;
+    }
+    for (const auto & operation : it->second->get_operations()) {
+	tmpvar_forget_operation(*operation);
+    }
+    blocks.erase(it);
+    invalidate_cfg_info();
+}
+
 
 size_t
 Function::add_block()
 {
     blocks[blockid] = Gyoji::owned_new<BasicBlock>();
+    invalidate_cfg_info();
     size_t blockid_created = blockid;
     blockid++;
     return blockid_created;
@@ -145,6 +251,10 @@ Function::tmpvar_get_operation(size_t tmpvar) const
     return it->second;
 }
 
+size_t
+Function::tmpvar_count() const
+{ return tmpvars.size(); }
+
 size_t
 Function::tmpvar_define(const Type* type)
 {
@@ -160,71 +270,45 @@ Function::tmpvar_duplicate(size_t tempvar_id)
 void
 Function::calculate_block_reachability()
 {
-    // This map encodes the relationship between a block
-    // and the blocks it is connected to.
-    std::map<size_t, std::vector<size_t>> edges;
-
-    // This is the working list of blocks we're
-    // examining.
-    std::map<size_t, size_t> open_list;
-    std::map<size_t, size_t> closed_list;
-
-    // This is a map of blockid:blockid
-    // for the unreachable blocks.
-    std::map<size_t, size_t> unreachable;
-
-    // Build a graph with the 'edges'.
-    for (const auto & block : blocks) {
-	// Everything starts out as unreachable.
-	unreachable.insert(std::pair(block.first, block.first));
-	std::vector connections_to = block.second->get_connections();
-	edges.insert(std::pair(block.first, connections_to));
-    }
-    // We start with only one element on the open list,
-    // that is the 'start' or 'entry' block.
-    
-    open_list.insert(std::pair(0, 0));
-    // With each iteration, we look for
-    // blocks we connect to.  Once we find them,
-    // we take them off the unreachable list.
-    while (open_list.size() != 0) {
-	size_t current = open_list.begin()->first;
-	open_list.erase(current);
-	unreachable.erase(current);
-	const auto & connections_to  = edges[current];
-	for (size_t to : connections_to) {
-	    blocks[to]->add_reachable_from(current);
-	    
-	    // Only add it back to the open list
-	    // if it wasn't found on the closed list
-	    // becuase we've reached it already.
-	    if (closed_list.find(to) == closed_list.end()) {
-		open_list.insert(std::pair(to, to));
-	    }
+    const CFGInfo & cfg = get_cfg_info();
+
+    std::vector<size_t> cull;
+    for (const auto & block_it : blocks) {
+	if (cfg.is_reachable(block_it.first)) {
+	    continue;
 	}
-	closed_list.insert(std::pair(current, current));
-    }
-    for (const auto & unreach : unreachable) {
 	// This is unreachable in the sense that the
 	// basic blocks are not a connected graph.
-	// If this happens, then there is a bug in the 'lowering'
-	// code which should prevent this from being constructed
-	// in this way.
-	const BasicBlock & block = get_basic_block(unreach.first);
-
 	// If this block is empty, we will already have
 	// reported that as an error, so we don't need to
 	// do that again.
-	const auto & operations = block.get_operations();
-	if (operations.size() == 0) {
+	if (block_it.second->size() == 0) {
 	    // Cull it from the block list
 	    // becuase it's empty and unreachable.
-	    blocks.erase(unreach.first);
+	    cull.push_back(block_it.first);
 	}
     }
+    for (size_t blockid : cull) {
+	blocks.erase(blockid);
+    }
+    if (cull.size() != 0) {
+	invalidate_cfg_info();
+    }
+}
 
+const CFGInfo &
+Function::get_cfg_info() const
+{
+    if (!cfg_info) {
+	cfg_info = Gyoji::owned_new<CFGInfo>(*this);
+    }
+    return *cfg_info;
 }
 
+void
+Function::invalidate_cfg_info()
+{ cfg_info.reset(); }
+
 void
 Function::iterate_operations(OperationVisitor & visitor) const
 {
@@ -320,14 +404,6 @@ BasicBlock::get_connections() const
     std::vector<size_t> empty_edges;
     return empty_edges;
 }
-const std::vector<size_t> &
-BasicBlock::get_reachable_from() const
-{ return reachable_from; }
-
-void
-BasicBlock::add_reachable_from(size_t other_block)
-{ reachable_from.push_back(other_block); }
-
 size_t
 BasicBlock::size() const
 { return operations.size(); }
@@ -338,24 +414,55 @@ BasicBlock::insert_operation(size_t position, Gyoji::owned<Operation> operation)
     operations.insert(operations.begin() + position, std::move(operation));
 }
 
+Gyoji::owned<Operation>
+BasicBlock::replace_operation(size_t position, Gyoji::owned<Operation> operation)
+{
+    Gyoji::owned<Operation> old_operation = std::move(operations.at(position));
+    operations.at(position) = std::move(operation);
+    return old_operation;
+}
+
+void
+BasicBlock::mark_dead_store(size_t position)
+{ operations.at(position)->set_dead_store(true); }
+
+void
+BasicBlock::remove_operations(const std::vector<bool> & remove)
+{
+    size_t kept = 0;
+    for (size_t i = 0; i < operations.size(); i++) {
+	if (i < remove.size() && remove[i]) {
+	    continue;
+	}
+	if (kept != i) {
+	    operations.at(kept) = std::move(operations.at(i));
+	}
+	kept++;
+    }
+    operations.resize(kept);
+}
+
 
 /////////////////////////////////////
 // FunctionArgument
 /////////////////////////////////////
 FunctionArgument::FunctionArgument(
-    std::string & _name,
+    const Gyoji::context::AtomTable & _atoms,
+    Gyoji::context::Atom _name,
     const Type * _type,
     const Gyoji::context::SourceReference & _name_source_ref,
     const Gyoji::context::SourceReference & _type_source_ref
     )
-    : name(_name)
+    : name_atom(_name)
+    , name(_atoms.get_string(_name))
     , type(_type)
     , name_source_ref(_name_source_ref)
     , type_source_ref(_type_source_ref)
 {}
 
 FunctionArgument::FunctionArgument(const FunctionArgument & _other)
-    : name(_other.name)
+    : name_atom(_other.name_atom)
+    , name(_other.name)
     , type(_other.type)
     , name_source_ref(_other.name_source_ref)
     , type_source_ref(_other.type_source_ref)
@@ -368,6 +475,10 @@ const std::string &
 FunctionArgument::get_name() const
 { return name; }
 
+Gyoji::context::Atom
+FunctionArgument::get_name_atom() const
+{ return name_atom; }
+
 const Type*
 FunctionArgument::get_type() const
 { return type; }
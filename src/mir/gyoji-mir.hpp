@@ -17,7 +17,13 @@
 #include <gyoji-mir/types.hpp>
 #include <gyoji-mir/operations.hpp>
 #include <gyoji-mir/functions.hpp>
+#include <gyoji-mir/cfg.hpp>
+#include <gyoji-mir/dataflow.hpp>
+#include <gyoji-mir/liveness.hpp>
+#include <gyoji-mir/ranges.hpp>
+#include <gyoji-mir/constants.hpp>
 #include <gyoji-mir/symbols.hpp>
+#include <gyoji-mir/stats.hpp>
 
 /**
  * @brief Middle intermediate representation (MIR) of
@@ -70,7 +76,15 @@ namespace Gyoji::mir {
      */
     class MIR {
     public:
-	MIR();
+	/**
+	 * @brief Create an empty MIR.
+	 *
+	 * @details
+	 * Names of symbols, variables, and arguments
+	 * are interned in the given atom table, which is
+	 * normally the one owned by the CompilerContext.
+	 */
+	MIR(Gyoji::context::AtomTable & _atoms);
 	~MIR();
 
 	/**
@@ -193,7 +207,18 @@ namespace Gyoji::mir {
 	 * @endcode
 	 */
 	void dump(FILE *out) const;
+
+	/**
+	 * @brief Interned names used by the MIR.
+	 *
+	 * @details
+	 * Returns the atom table in which the names
+	 * of symbols, local variables, and arguments
+	 * are interned.
+	 */
+	Gyoji::context::AtomTable & get_atoms() const;
     private:
+	Gyoji::context::AtomTable & atoms;
 	Functions functions;
 	Types types;
 	Symbols symbols;
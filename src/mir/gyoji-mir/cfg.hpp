@@ -0,0 +1,202 @@
+/* Copyright 2025 Jonathan S. Arney
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      https://github.com/jarney/gyoji/blob/master/LICENSE
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#pragma once
+
+#include <vector>
+#include <stddef.h>
+
+namespace Gyoji::mir {
+    class Function;
+
+    /**
+     * @brief Control-flow graph facts about a function.
+     *
+     * @details
+     * This class holds the facts about the control-flow
+     * graph of a single function that more than one consumer
+     * needs: which blocks are reachable from the entry block,
+     * the successors and predecessors of each block,
+     * a reverse post-order traversal of the blocks, the
+     * dominator tree, and the loop-nesting depth of
+     * each block.
+     *
+     * All of the tables are dense vectors indexed directly
+     * by the basic-block ID.  Block IDs are handed out
+     * sequentially by Function::add_block(), so this wastes
+     * very little space even when some blocks have been culled.
+     *
+     * The information is computed once and cached by the Function
+     * (see Function::get_cfg_info()) and is discarded by the
+     * function whenever an operation changes the shape of
+     * the graph, so analysis passes and code-generators
+     * may freely share it rather than each deriving the
+     * graph for themselves.
+     */
+    class CFGInfo {
+    public:
+	/**
+	 * @brief Compute the CFG facts for a function.
+	 *
+	 * @details
+	 * This walks the terminators of every block
+	 * in the function and derives all of the
+	 * tables described above.  Block 0 is
+	 * always taken to be the entry block.
+	 */
+	CFGInfo(const Function & function);
+
+	/**
+	 * @brief Move along, nothing to see here.
+	 *
+	 * @details
+	 * Move along, nothing to see here.
+	 */
+	~CFGInfo();
+
+	/**
+	 * @brief One more than the largest block ID.
+	 *
+	 * @details
+	 * This is the size of each of the per-block tables and
+	 * any block ID passed to the accessors below must
+	 * be less than this value.
+	 */
+	size_t get_block_limit() const;
+
+	/**
+	 * @brief Returns true if the block exists.
+	 *
+	 * @details
+	 * Returns true if the block ID is present in the
+	 * function.  Blocks that have been culled or that
+	 * were never created return false.
+	 */
+	bool has_block(size_t blockid) const;
+
+	/**
+	 * @brief Returns true if the block is reachable.
+	 *
+	 * @details
+	 * Returns true if the block can be reached from
+	 * the entry block by following control-flow edges.
+	 * The entry block is always reachable.
+	 */
+	bool is_reachable(size_t blockid) const;
+
+	/**
+	 * @brief Blocks control may transfer to from this block.
+	 *
+	 * @details
+	 * Returns the blocks named by the terminator of the
+	 * given block, in the order the terminator lists them.
+	 * This is empty for blocks that return or that have
+	 * no terminator.
+	 */
+	const std::vector<size_t> & get_successors(size_t blockid) const;
+
+	/**
+	 * @brief Reachable blocks that may transfer control here.
+	 *
+	 * @details
+	 * Returns the list of reachable blocks that have an
+	 * edge into the given block.  Edges from unreachable
+	 * blocks are not recorded because no execution can
+	 * ever follow them, so a block other than the entry block
+	 * is reachable exactly when this list is non-empty.
+	 */
+	const std::vector<size_t> & get_predecessors(size_t blockid) const;
+
+	/**
+	 * @brief Reachable blocks in reverse post-order.
+	 *
+	 * @details
+	 * Returns the reachable blocks ordered so that each
+	 * block appears before all of its successors except
+	 * along back-edges.  The entry block is always first.
+	 * This is the natural order for forward data-flow
+	 * problems and for laying out code.
+	 */
+	const std::vector<size_t> & get_reverse_post_order() const;
+
+	/**
+	 * @brief Position of the block in the reverse post-order.
+	 *
+	 * @details
+	 * Returns the index of the block inside
+	 * get_reverse_post_order().  Unreachable blocks
+	 * return get_block_limit().
+	 */
+	size_t get_rpo_index(size_t blockid) const;
+
+	/**
+	 * @brief Immediate dominator of a block.
+	 *
+	 * @details
+	 * Returns the immediate dominator of the given
+	 * reachable block.  The entry block is its own
+	 * immediate dominator.  Unreachable blocks have
+	 * no dominator and return get_block_limit().
+	 */
+	size_t get_immediate_dominator(size_t blockid) const;
+
+	/**
+	 * @brief Returns true if 'a' dominates 'b'.
+	 *
+	 * @details
+	 * A block 'a' dominates block 'b' if every path
+	 * from the entry to 'b' passes through 'a'.  Every
+	 * reachable block dominates itself.  This
+	 * returns false if either block is unreachable.
+	 */
+	bool dominates(size_t a, size_t b) const;
+
+	/**
+	 * @brief Returns true if the block is the header of a loop.
+	 *
+	 * @details
+	 * A block is a loop header if it is the target
+	 * of a back-edge, that is, an edge from a block
+	 * that it dominates.
+	 */
+	bool is_loop_header(size_t blockid) const;
+
+	/**
+	 * @brief Number of natural loops containing the block.
+	 *
+	 * @details
+	 * Returns the number of natural loops that this block
+	 * belongs to.  Blocks outside of any loop have depth
+	 * zero and the header of an outermost loop has depth one.
+	 */
+	size_t get_loop_depth(size_t blockid) const;
+
+    private:
+	size_t block_limit;
+	std::vector<bool> present;
+	std::vector<bool> reachable;
+	std::vector<std::vector<size_t>> successors;
+	std::vector<std::vector<size_t>> predecessors;
+	std::vector<size_t> reverse_post_order;
+	std::vector<size_t> rpo_index;
+	std::vector<size_t> immediate_dominator;
+	std::vector<bool> loop_header;
+	std::vector<size_t> loop_depth;
+
+	void calculate_reverse_post_order();
+	void calculate_dominators();
+	void calculate_loops();
+    };
+
+};
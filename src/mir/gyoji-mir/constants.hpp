@@ -0,0 +1,114 @@
+/* Copyright 2025 Jonathan S. Arney
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      https://github.com/jarney/gyoji/blob/master/LICENSE
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#pragma once
+
+#include <vector>
+#include <stdint.h>
+#include <stddef.h>
+
+namespace Gyoji::mir {
+    class Function;
+
+    /**
+     * @brief Sparse conditional constant propagation.
+     *
+     * @details
+     * This works out which tmpvars of a function always hold
+     * the same integer or boolean value and which blocks can
+     * actually be reached once conditional jumps on those
+     * values are taken into account.  Each tmpvar is produced
+     * by exactly one operation, so the value of a tmpvar
+     * is simply the value of that operation.  Tmpvars start
+     * out 'unknown', become 'constant' when their operation
+     * is evaluated from constant operands, and become
+     * 'varying' when their value can't be known when compiling.
+     * Operations are only evaluated once their block is known
+     * to be reachable, and a conditional jump on a constant
+     * only makes the branch it takes reachable.
+     *
+     * The values of local variables are not tracked, because
+     * they are read and written through loads and stores, so
+     * only expressions made of literals are folded.  That
+     * covers widened literals, arithmetic on literals, and
+     * the literal 'one' added for increment and decrement.
+     * The size of a type ('sizeof') depends on the layout
+     * chosen by the back-end, so it is never constant here.
+     *
+     * Operations that could trap or have no defined result
+     * (division by zero, or shifting by the width of
+     * the type or more) are left alone so that the program
+     * behaves the same whether or not they are folded.
+     */
+    class ConstantPropagation {
+    public:
+	/**
+	 * Works out the constants and reachable
+	 * blocks of the function.
+	 */
+	ConstantPropagation(Function & _function);
+	/**
+	 * @brief Move along, nothing to see here.
+	 *
+	 * @details
+	 * Move along, nothing to see here.
+	 */
+	~ConstantPropagation();
+
+	/**
+	 * Returns true if the tmpvar always
+	 * holds the same value.
+	 */
+	bool is_constant(size_t tmpvar) const;
+	/**
+	 * Returns the value of a constant tmpvar,
+	 * zero-extended from the width of its type
+	 * (booleans are zero or one).
+	 */
+	uint64_t get_constant(size_t tmpvar) const;
+	/**
+	 * Returns true if the block can be reached
+	 * from the start of the function.
+	 */
+	bool is_executable(size_t blockid) const;
+
+	/**
+	 * @brief Rewrite the function using the constants found.
+	 *
+	 * @details
+	 * Replaces each operation that produces a constant
+	 * with the literal it evaluates to, replaces each
+	 * conditional jump on a constant with a jump to the
+	 * branch it takes, removes the blocks that can't be
+	 * reached, and finally removes the literals that
+	 * nothing reads any more.
+	 */
+	void fold();
+
+	size_t get_operations_folded() const;
+	size_t get_branches_resolved() const;
+	size_t get_blocks_removed() const;
+	size_t get_operations_removed() const;
+    private:
+	Function & function;
+	std::vector<bool> constant;
+	std::vector<uint64_t> values;
+	std::vector<bool> executable;
+	size_t operations_folded;
+	size_t branches_resolved;
+	size_t blocks_removed;
+	size_t operations_removed;
+    };
+
+};
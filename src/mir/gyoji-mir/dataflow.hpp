@@ -0,0 +1,190 @@
+/* Copyright 2025 Jonathan S. Arney
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      https://github.com/jarney/gyoji/blob/master/LICENSE
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#pragma once
+
+#include <gyoji-misc/bitset.hpp>
+
+#include <vector>
+#include <stddef.h>
+
+namespace Gyoji::mir {
+    class Function;
+    class Operation;
+
+    /**
+     * @brief A bit-vector data-flow problem over the blocks of a function.
+     *
+     * @details
+     * A data-flow problem numbers the facts it is interested in
+     * (variables, loans, expressions, etc.) from zero and
+     * describes how each operation changes the set of facts
+     * that hold.  The effect of an operation is given as the
+     * set of facts it makes true ('gen') and the set it makes
+     * false ('kill'), so the set after the operation is
+     *
+     * @code{.unparsed}
+     *     after = (before - kill) | gen
+     * @endcode
+     *
+     * Forward problems flow from the entry of the function
+     * toward its returns and backward problems flow the other
+     * way.  Where control-flow paths meet, 'may' problems take
+     * the union of the incoming sets and 'must' problems take
+     * the intersection.
+     *
+     * The problem is solved by the DataFlow class.
+     */
+    class DataFlowProblem {
+    public:
+	typedef enum {
+	    FORWARD,
+	    BACKWARD
+	} Direction;
+	typedef enum {
+	    /**
+	     * A fact holds if it holds along
+	     * any path (union).
+	     */
+	    MAY,
+	    /**
+	     * A fact holds only if it holds along
+	     * every path (intersection).
+	     */
+	    MUST
+	} Meet;
+
+	DataFlowProblem(Direction _direction, Meet _meet, size_t _facts);
+	/**
+	 * @brief Move along, nothing to see here.
+	 *
+	 * @details
+	 * Move along, nothing to see here.
+	 */
+	virtual ~DataFlowProblem();
+
+	Direction get_direction() const;
+	Meet get_meet() const;
+	/**
+	 * Number of facts, the size of
+	 * each set in the problem.
+	 */
+	size_t get_facts() const;
+
+	/**
+	 * @brief Facts that hold at the boundary of the function.
+	 *
+	 * @details
+	 * This gives the facts that hold on entry to the function
+	 * for a forward problem, or on leaving the function at
+	 * each return for a backward problem.  The set given is
+	 * empty and the default leaves it that way.
+	 */
+	virtual void boundary(Gyoji::misc::BitSet & facts) const;
+
+	/**
+	 * @brief Effect of a single operation.
+	 *
+	 * @details
+	 * Sets the facts made true and the facts made false
+	 * by the operation found at the given index of the
+	 * given block.  Both sets are empty when this is
+	 * called.  If a fact is in both, the operation
+	 * makes it true.
+	 */
+	virtual void effect(
+	    size_t block_id,
+	    size_t operation_index,
+	    const Operation & operation,
+	    Gyoji::misc::BitSet & gen,
+	    Gyoji::misc::BitSet & kill
+	    ) const = 0;
+    private:
+	Direction direction;
+	Meet meet;
+	size_t facts;
+    };
+
+    /**
+     * @brief Solution of a data-flow problem for one function.
+     *
+     * @details
+     * This solves a DataFlowProblem over the reachable blocks
+     * of a function using the shared CFGInfo of the function.
+     * The effect of each block is first summarized as a single
+     * gen and kill set so that solving only touches each
+     * operation once.  Blocks are then visited from a worklist
+     * in reverse post-order (or post-order for backward
+     * problems), and a block is only visited again when the
+     * facts flowing into it change, so most functions settle
+     * after a single pass plus one more for each loop.
+     *
+     * The solution gives the facts that hold at the start and
+     * end of each block.  To find the facts at a point inside
+     * of a block, start from get_in() and apply() each of the
+     * operations before it in the direction of the problem.
+     * Unreachable blocks have no solution and are reported
+     * with empty sets.
+     */
+    class DataFlow {
+    public:
+	/**
+	 * Solves the given problem for the function.
+	 */
+	DataFlow(const Function & _function, const DataFlowProblem & _problem);
+	/**
+	 * @brief Move along, nothing to see here.
+	 *
+	 * @details
+	 * Move along, nothing to see here.
+	 */
+	~DataFlow();
+
+	/**
+	 * Facts that hold when control enters the block
+	 * in the direction of the problem, that is, before the
+	 * first operation for a forward problem and after the
+	 * last operation for a backward one.
+	 */
+	const Gyoji::misc::BitSet & get_in(size_t blockid) const;
+	/**
+	 * Facts that hold when control leaves the block
+	 * in the direction of the problem.
+	 */
+	const Gyoji::misc::BitSet & get_out(size_t blockid) const;
+
+	/**
+	 * Applies the effect of the operation at the given
+	 * index of the block to the given set of facts.
+	 */
+	void apply(
+	    size_t block_id,
+	    size_t operation_index,
+	    const Operation & operation,
+	    Gyoji::misc::BitSet & facts
+	    ) const;
+    private:
+	const Function & function;
+	const DataFlowProblem & problem;
+	std::vector<Gyoji::misc::BitSet> in;
+	std::vector<Gyoji::misc::BitSet> out;
+	mutable Gyoji::misc::BitSet gen;
+	mutable Gyoji::misc::BitSet kill;
+	Gyoji::misc::BitSet empty;
+
+	void solve();
+    };
+
+
+};
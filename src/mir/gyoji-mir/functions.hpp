@@ -17,6 +17,7 @@
 #include <gyoji-misc/pointers.hpp>
 #include <gyoji-mir/types.hpp>
 #include <gyoji-mir/operations.hpp>
+#include <gyoji-mir/cfg.hpp>
 
 #include <string>
 #include <map>
@@ -64,6 +65,20 @@ namespace Gyoji::mir {
 	 */
 	void add_function(Gyoji::owned<Function> _function);
 
+	/**
+	 * @brief Move the functions of other tables into this one.
+	 *
+	 * @details
+	 * Functions lowered in parallel are each added to a
+	 * table of their own.  This moves the functions out of
+	 * each of those tables, in the order the tables are
+	 * given, and adds them to this one, so that the
+	 * functions come out in the same order no matter how
+	 * the work was divided among the threads.  The tables
+	 * are left empty.
+	 */
+	void merge(std::vector<Gyoji::owned<Functions>> & buffers);
+
 	/**
 	 * @brief Returns the list of functions defined.
 	 *
@@ -190,6 +205,36 @@ namespace Gyoji::mir {
 	 * statement will always be in a different basic block.
 	 */
 	void insert_operation(size_t position, Gyoji::owned<Operation> operation);
+
+	/**
+	 * @brief Replace the operation at a specific point.
+	 *
+	 * @details
+	 * This replaces the operation at the given position
+	 * and returns ownership of the old one to the caller.
+	 * It is intended to be called only through the
+	 * Function (see Function::replace_operation).
+	 */
+	Gyoji::owned<Operation> replace_operation(size_t position, Gyoji::owned<Operation> operation);
+
+	/**
+	 * @brief Remove operations from the block.
+	 *
+	 * @details
+	 * This removes each operation whose entry in the given
+	 * list is true.  It is intended to be called only through
+	 * the Function (see Function::remove_operations).
+	 */
+	void remove_operations(const std::vector<bool> & remove);
+
+	/**
+	 * @brief Flags the operation at a position as a dead store.
+	 *
+	 * @details
+	 * It is intended to be called only through the
+	 * Function (see Function::mark_dead_store).
+	 */
+	void mark_dead_store(size_t position);
 	
 	/**
 	 * @brief Access to list of Operation of basic block
@@ -230,24 +275,8 @@ namespace Gyoji::mir {
 	 */
 	std::vector<size_t> get_connections() const;
 
-	/**
-	 * This is the list of blocks that
-	 * can enter this block.  Note that this
-	 * is not valid until the 'calculate_block_reachability()'
-	 * function has been called on the parent function
-	 * to calculate the full reachability graph.
-	 */
-	const std::vector<size_t> & get_reachable_from() const;
-	
-	bool is_reachable() const;
-	/**
-	 * This is called from the 'calculate_block_reachability'
-	 * function when the reachability graph is calculated.
-	 */
-	void add_reachable_from(size_t other_block);
     private:
 	std::vector<Gyoji::owned<Operation>> operations;
-	std::vector<size_t> reachable_from;
 	bool start_block;
     };
 
@@ -268,7 +297,7 @@ namespace Gyoji::mir {
 	 *
 	 * @details
 	 * This creates a new argument from a name and a type.
-	 * The name is the name of the variable that is
+	 * The name is the interned name of the variable that is
 	 * referenced in the function by load and store
 	 * opcodes.  The type is a pointer to a type
 	 * defined in the Types table.  It must live at least
@@ -277,7 +306,8 @@ namespace Gyoji::mir {
 	 * that it is always valid in this scope.
 	 */
 	FunctionArgument(
-	    std::string & _name,
+	    const Gyoji::context::AtomTable & _atoms,
+	    Gyoji::context::Atom _name,
 	    const Type *_type,
 	    const Gyoji::context::SourceReference & _name_source_ref,
 	    const Gyoji::context::SourceReference & _type_source_ref
@@ -307,6 +337,16 @@ namespace Gyoji::mir {
 	 * name of the argument.
 	 */
 	const std::string & get_name() const;
+
+	/**
+	 * @brief Interned name of the argument
+	 *
+	 * @details
+	 * Returns the atom for the name of the argument
+	 * so that it can be matched against local variables
+	 * without comparing strings.
+	 */
+	Gyoji::context::Atom get_name_atom() const;
 	
 	/**
 	 * @brief Type of the argument
@@ -321,10 +361,11 @@ namespace Gyoji::mir {
 	const Gyoji::context::SourceReference & get_name_source_ref() const;
 	
     private:
-	std::string name;
+	Gyoji::context::Atom name_atom;
+	const std::string & name;
 	const Type * type;
-	const Gyoji::context::SourceReference & name_source_ref;
-	const Gyoji::context::SourceReference & type_source_ref;
+	Gyoji::context::SourceReference name_source_ref;
+	Gyoji::context::SourceReference type_source_ref;
     };
 
     /**
@@ -407,6 +448,50 @@ namespace Gyoji::mir {
 	void add_operation(size_t blockid, Gyoji::owned<Operation> operation);
 
 	void insert_operation(size_t blockid, size_t operation_index, Gyoji::owned<Operation> operation);
+
+	/**
+	 * @brief Replace an operation with another one.
+	 *
+	 * @details
+	 * This replaces the operation at the given index of
+	 * the block with a new one.  It is used by passes that
+	 * rewrite the MIR after it has been built, for example
+	 * to replace an arithmetic operation whose operands are
+	 * known with the literal it evaluates to.
+	 */
+	void replace_operation(size_t blockid, size_t operation_index, Gyoji::owned<Operation> operation);
+
+	/**
+	 * @brief Remove operations from a block.
+	 *
+	 * @details
+	 * This removes each operation of the block whose
+	 * entry in the given list is true, keeping the
+	 * remaining operations in order.  The caller must
+	 * make sure no other operation reads the result
+	 * of a removed operation.
+	 */
+	void remove_operations(size_t blockid, const std::vector<bool> & remove);
+
+	/**
+	 * @brief Flags an assignment whose value is never read.
+	 *
+	 * @details
+	 * Marks the operation at the given index of the block
+	 * as a dead store (see Liveness::get_dead_stores()) so
+	 * that code generation can leave it out.
+	 */
+	void mark_dead_store(size_t blockid, size_t operation_index);
+
+	/**
+	 * @brief Remove a basic block.
+	 *
+	 * @details
+	 * This removes a block along with all of its operations.
+	 * The caller must make sure that no other block
+	 * jumps to it.
+	 */
+	void remove_block(size_t blockid);
 	
 	/**
 	 * @brief Creates a new basic block and returns the ID.
@@ -458,6 +543,20 @@ namespace Gyoji::mir {
 	 */
 	bool is_unsafe() const;
 
+	/**
+	 * @brief Operations saved by sharing cleanup blocks.
+	 *
+	 * @details
+	 * Leaving a scope early unwinds the variables in
+	 * scope, calling their destructors.  The front-end
+	 * places that unwinding in cleanup blocks that every
+	 * exit with the same variables and destination jumps
+	 * into, and records here the number of operations
+	 * each such exit would otherwise have repeated.
+	 */
+	size_t get_shared_cleanup_operations() const;
+	void add_shared_cleanup_operations(size_t operations);
+
 	/**
 	 * @brief Temporary values used by opcodes
 	 *
@@ -485,6 +584,15 @@ namespace Gyoji::mir {
 
 	const Operation * tmpvar_get_operation(size_t tmpvar) const;
 
+	/**
+	 * @brief Number of temporary variables defined.
+	 *
+	 * @details
+	 * Temporary variable IDs run from zero up
+	 * to one less than this count.
+	 */
+	size_t tmpvar_count() const;
+
 	/**
 	 * @brief Duplicate a temporary variable/reigster.
 	 *
@@ -520,9 +628,27 @@ namespace Gyoji::mir {
 	 * for example, if you return from all branches of
 	 * a switch or if/else, leaving the tail of the
 	 * function empty.
+	 *
+	 * The reachability of each remaining block
+	 * can be queried afterward through get_cfg_info().
 	 */
 	void calculate_block_reachability();
 
+	/**
+	 * @brief Control-flow graph facts for this function.
+	 *
+	 * @details
+	 * Returns the reachability, predecessors, reverse
+	 * post-order, dominators, and loop nesting of the
+	 * basic blocks (see CFGInfo).  These are computed
+	 * the first time they are asked for and cached until
+	 * the shape of the graph changes, that is, until
+	 * a block is added or culled or a terminating
+	 * operation is added to a block.  The returned
+	 * reference is only valid until then.
+	 */
+	const CFGInfo & get_cfg_info() const;
+
 	/**
 	 * This method is used to iterate all of the operations
 	 * inside all basic blocks of a funciton.  The operations
@@ -537,8 +663,9 @@ namespace Gyoji::mir {
 	const Type *return_type;
 	std::vector<FunctionArgument> arguments;
 	bool m_is_unsafe;
+	size_t shared_cleanup_operations;
 	
-	const Gyoji::context::SourceReference & source_ref;
+	Gyoji::context::SourceReference source_ref;
 	
 	// Holds the max blockid
 	// as we build them.
@@ -546,6 +673,12 @@ namespace Gyoji::mir {
 	std::map<size_t, Gyoji::owned<BasicBlock>> blocks;
 	std::vector<const Type*> tmpvars;
 	std::map<size_t, Operation*> tmpvar_operations;
+
+	// Lazily computed from the blocks
+	// and discarded when they change shape.
+	mutable Gyoji::owned<CFGInfo> cfg_info;
+	void invalidate_cfg_info();
+	void tmpvar_forget_operation(const Operation & operation);
     };
 
     class OperationVisitor {
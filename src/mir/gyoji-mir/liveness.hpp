@@ -0,0 +1,234 @@
+/* Copyright 2025 Jonathan S. Arney
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      https://github.com/jarney/gyoji/blob/master/LICENSE
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#pragma once
+
+#include <gyoji-misc/pointers.hpp>
+#include <gyoji-mir/dataflow.hpp>
+#include <gyoji-context.hpp>
+
+#include <map>
+#include <vector>
+#include <stddef.h>
+
+namespace Gyoji::mir {
+    class Function;
+
+    /**
+     * @brief Start or end of the live range of a variable.
+     *
+     * @details
+     * A marker says that the storage of a local variable
+     * becomes live (START) or dead (END) just before the
+     * operation at the given index of a block.  Code generators
+     * use these to tell the back-end exactly when the stack
+     * slot of each variable is in use so that variables
+     * whose live ranges don't overlap can share a slot.
+     */
+    class LiveRangeMarker {
+    public:
+	typedef enum {
+	    START,
+	    END
+	} MarkerType;
+
+	LiveRangeMarker(MarkerType _type, size_t _operation_index, size_t _variable);
+	LiveRangeMarker(const LiveRangeMarker & other);
+	/**
+	 * @brief Move along, nothing to see here.
+	 *
+	 * @details
+	 * Move along, nothing to see here.
+	 */
+	~LiveRangeMarker();
+
+	MarkerType get_type() const;
+	/**
+	 * The marker applies just before the operation
+	 * at this index of the block.
+	 */
+	size_t get_operation_index() const;
+	/**
+	 * Index of the variable as numbered by Liveness.
+	 */
+	size_t get_variable() const;
+    private:
+	MarkerType type;
+	size_t operation_index;
+	size_t variable;
+    };
+
+    /**
+     * @brief Live ranges of the locals and tmpvars of a function.
+     *
+     * @details
+     * A local variable or tmpvar is live at a point if the
+     * value it holds there may be read later on.  This
+     * solves the backward 'may' problem over the blocks of the
+     * function with one fact for each local variable followed
+     * by one fact for each tmpvar.
+     *
+     * A tmpvar is defined by the operation that produces it
+     * and used by every operation that takes it as an operand.
+     * A local variable is defined when it is assigned as a
+     * whole and used by every operation that reads it or
+     * reads or writes a member or element of it, since
+     * writing only part of a variable keeps the rest of
+     * it alive.  Declaring and un-declaring a variable
+     * ends its live range.  Arguments are not numbered,
+     * because their storage lives for the whole function.
+     *
+     * A variable whose address is taken (with 'addressof',
+     * including the one taken to call its destructor) may be
+     * read and written through the reference at any point
+     * while it is in scope.  These variables are marked as
+     * live from their declaration to their un-declaration
+     * instead of by their uses.
+     *
+     * From the solution, this gives the points where each
+     * variable becomes live and dead (see LiveRangeMarker),
+     * which are usually much earlier than the end of the
+     * lexical scope, and the 'dead stores' which assign a
+     * value to a variable that is never read again.
+     */
+    class Liveness {
+    public:
+	/**
+	 * Computes the live ranges for the function.
+	 */
+	Liveness(const Function & _function);
+	/**
+	 * @brief Move along, nothing to see here.
+	 *
+	 * @details
+	 * Move along, nothing to see here.
+	 */
+	~Liveness();
+
+	/**
+	 * Number of local variables numbered,
+	 * which is also the fact number of the
+	 * first tmpvar.
+	 */
+	size_t get_variable_count() const;
+	/**
+	 * Returns the index of the local variable with
+	 * the given declaration id (see
+	 * OperationLocalDeclare::get_declaration_id()) or
+	 * get_variable_count() if it is not a local variable.
+	 * Variables declared with the same name in different
+	 * scopes each have their own index.
+	 */
+	size_t get_variable(size_t declaration_id) const;
+	/**
+	 * Returns the declaration id of the local
+	 * variable with the given index.
+	 */
+	size_t get_variable_declaration_id(size_t variable) const;
+	/**
+	 * Returns true if the address of the
+	 * variable is taken anywhere in the function.
+	 */
+	bool is_address_taken(size_t variable) const;
+
+	/**
+	 * Returns the fact number for the tmpvar.
+	 */
+	size_t get_tmpvar_fact(size_t tmpvar) const;
+	/**
+	 * @brief Returns false for tmpvars that are only written.
+	 *
+	 * @details
+	 * This is false if the tmpvar names a local variable and is
+	 * only ever used as the destination of an assignment to the
+	 * whole variable, so the current value of the variable never
+	 * needs to be loaded for it.
+	 */
+	bool is_tmpvar_read(size_t tmpvar) const;
+
+	/**
+	 * Facts live at the start of the block.
+	 */
+	const Gyoji::misc::BitSet & get_live_in(size_t blockid) const;
+	/**
+	 * Facts live at the end of the block.
+	 */
+	const Gyoji::misc::BitSet & get_live_out(size_t blockid) const;
+
+	/**
+	 * @brief Points where variables become live or dead.
+	 *
+	 * @details
+	 * Returns the markers for the block in order of operation
+	 * index.  A variable becomes live where it is assigned,
+	 * or just after its declaration if it may be read or
+	 * partly written before it is assigned as a whole, and
+	 * dead just after its last use.  Every path to the end
+	 * of a live range passes through its start.  A variable that is
+	 * live at the end of a predecessor but not on entry to the
+	 * block is marked dead before the first operation of the
+	 * block.  Variables that are never live (for example, when
+	 * every store to them is dead) have no markers at all.
+	 */
+	const std::vector<LiveRangeMarker> & get_markers(size_t blockid) const;
+
+	/**
+	 * @brief Assignments whose value is never read.
+	 *
+	 * @details
+	 * Returns the (block ID, operation index) of each
+	 * assignment to a whole variable whose value can't be
+	 * read before the variable is assigned again or goes
+	 * out of scope.  Variables whose address is taken
+	 * are never reported.
+	 */
+	const std::vector<std::pair<size_t, size_t>> & get_dead_stores() const;
+
+	/**
+	 * @brief Variables used and defined by an operation.
+	 *
+	 * @details
+	 * Adds the indices of the local variables the operation
+	 * uses and the ones it defines to the given lists.
+	 * Only assignments, declarations, and un-declarations
+	 * define variables.
+	 */
+	void get_variables(
+	    const Operation & operation,
+	    std::vector<size_t> & uses,
+	    std::vector<size_t> & defs
+	    ) const;
+    private:
+	const Function & function;
+	std::map<size_t, size_t> variables;
+	std::vector<size_t> variable_declarations;
+	std::vector<bool> address_taken;
+	// For each tmpvar, the variable it is a place in
+	// (the variable itself or a member or element of it).
+	std::vector<size_t> tmpvar_roots;
+	std::vector<bool> tmpvar_whole;
+	std::vector<bool> tmpvar_read;
+	std::vector<std::vector<LiveRangeMarker>> markers;
+	std::vector<std::pair<size_t, size_t>> dead_stores;
+	std::vector<LiveRangeMarker> no_markers;
+	Gyoji::owned<DataFlowProblem> problem;
+	Gyoji::owned<DataFlow> solution;
+
+	void number_variables();
+	size_t root_of(size_t tmpvar) const;
+	bool is_whole_assignment(const Operation & operation) const;
+	void find_markers();
+    };
+
+};
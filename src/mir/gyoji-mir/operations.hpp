@@ -900,6 +900,15 @@ namespace Gyoji::mir {
 	 */
 	OperationType get_type() const;
 
+	/**
+	 * @brief Name of an opcode.
+	 *
+	 * @details
+	 * This returns the name of the opcode as it
+	 * appears in the MIR dump, such as "add" or "load".
+	 */
+	static const std::string & get_type_name(OperationType _type);
+
 	/**
 	 * @brief Get the operands
 	 *
@@ -928,6 +937,39 @@ namespace Gyoji::mir {
 	 */
 	bool is_terminating() const;
 
+	/**
+	 * @brief Returns true if the operation produces a result.
+	 *
+	 * @details
+	 * Terminators and the operations that declare and
+	 * un-declare variables produce no value, so the
+	 * result of those operations is not a tmpvar.
+	 */
+	bool has_result() const;
+
+	/**
+	 * @brief Number of operands that are tmpvars.
+	 *
+	 * @details
+	 * Jumps carry the IDs of the basic blocks they connect
+	 * to as operands after any tmpvars they read, so only
+	 * this many of the leading operands refer to tmpvars.
+	 * For all other operations, every operand is a tmpvar.
+	 */
+	size_t get_tmpvar_operand_count() const;
+
+	/**
+	 * @brief Returns true if this is an assignment nobody reads.
+	 *
+	 * @details
+	 * The front-end flags assignments whose value is never
+	 * read before the variable is assigned again or goes
+	 * out of scope (see Liveness::get_dead_stores()), so
+	 * code-generators may leave the store out entirely.
+	 */
+	bool is_dead_store() const;
+	void set_dead_store(bool _dead_store);
+
 	/**
 	 * @brief Returns the list of basic blocks we might connect to.
 	 *
@@ -979,9 +1021,10 @@ namespace Gyoji::mir {
 #endif
     protected:
 	OperationType type;
-	const Gyoji::context::SourceReference & src_ref;
+	Gyoji::context::SourceReference src_ref;
 	std::vector<size_t> operands;
 	size_t result;
+	bool dead_store;
 
 	/**
 	 * @brief Add an operand
@@ -1329,13 +1372,17 @@ namespace Gyoji::mir {
     public:
 	/**
 	 * Construct an operation to load a local
-	 * variable given by symbol_name into
-	 * the operation's return-value.
+	 * variable given by the interned symbol name into
+	 * the operation's return-value.  The declaration
+	 * id says which declaration of that name is meant
+	 * (see OperationLocalDeclare::get_declaration_id()).
 	 */
 	OperationLocalVariable(
 	    const Gyoji::context::SourceReference & _src_ref,
 	    size_t _result,
-	    std::string _symbol_name,
+	    const Gyoji::context::AtomTable & _atoms,
+	    Gyoji::context::Atom _symbol,
+	    size_t _declaration_id,
 	    const Type * _var_type);
 	/**
 	 * @brief Move along, nothing to see here.
@@ -1345,12 +1392,23 @@ namespace Gyoji::mir {
 	 */
 	virtual ~OperationLocalVariable();
 	const std::string & get_symbol_name() const;
+	/**
+	 * Interned name of the variable, suitable for
+	 * use as a key in place of the name itself.
+	 */
+	Gyoji::context::Atom get_symbol_atom() const;
+	/**
+	 * Declaration of the variable being loaded.
+	 */
+	size_t get_declaration_id() const;
 	const Type * get_var_type() const;
 	
     protected:
 	virtual std::string get_description() const;
     private:
-	const std::string symbol_name;
+	Gyoji::context::Atom symbol;
+	const std::string & symbol_name;
+	size_t declaration_id;
 	const Type * var_type;
     };
 
@@ -1887,7 +1945,9 @@ namespace Gyoji::mir {
     public:
 	OperationLocalDeclare(
 	    const Gyoji::context::SourceReference & _src_ref,
-	    std::string _variable,
+	    const Gyoji::context::AtomTable & _atoms,
+	    Gyoji::context::Atom _variable,
+	    size_t _declaration_id,
 	    const Type *_variable_type
 	    );
 	/**
@@ -1901,6 +1961,22 @@ namespace Gyoji::mir {
 	 * Name of the variable to declare.
 	 */
 	const std::string & get_variable() const;
+	/**
+	 * Interned name of the variable to declare.
+	 */
+	Gyoji::context::Atom get_variable_atom() const;
+	/**
+	 * Identifies this declaration among all of the
+	 * variables of the function.  Names may be
+	 * re-used by declarations in different scopes,
+	 * so loads and un-declarations refer to the
+	 * variable by this id rather than by name.
+	 * The arguments of the function are numbered
+	 * by their position in the argument list and
+	 * the variables declared in the body are
+	 * numbered after them.
+	 */
+	size_t get_declaration_id() const;
 	/**
 	 * Returns a pointer to the immutable type
 	 * of the variable.
@@ -1909,7 +1985,9 @@ namespace Gyoji::mir {
     protected:
 	virtual std::string get_description() const;
     private:
-	std::string variable;
+	Gyoji::context::Atom variable_atom;
+	const std::string & variable;
+	size_t declaration_id;
 	const Type *variable_type;
     };
     /**
@@ -1925,7 +2003,9 @@ namespace Gyoji::mir {
     public:
 	OperationLocalUndeclare(
 	    const Gyoji::context::SourceReference & _src_ref,
-	    std::string _variable
+	    const Gyoji::context::AtomTable & _atoms,
+	    Gyoji::context::Atom _variable,
+	    size_t _declaration_id
 	    );
 	/**
 	 * @brief Move along, nothing to see here.
@@ -1934,10 +2014,20 @@ namespace Gyoji::mir {
 	 * Move along, nothing to see here.
 	 */
 	virtual ~OperationLocalUndeclare();
+	/**
+	 * Interned name of the variable to un-declare.
+	 */
+	Gyoji::context::Atom get_variable_atom() const;
+	/**
+	 * Declaration of the variable to un-declare.
+	 */
+	size_t get_declaration_id() const;
     protected:
 	virtual std::string get_description() const;
     private:
-	std::string variable;
+	Gyoji::context::Atom variable_atom;
+	const std::string & variable;
+	size_t declaration_id;
     };
 
     
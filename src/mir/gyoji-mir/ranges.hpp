@@ -0,0 +1,93 @@
+/* Copyright 2025 Jonathan S. Arney
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      https://github.com/jarney/gyoji/blob/master/LICENSE
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#pragma once
+
+#include <vector>
+#include <stddef.h>
+
+namespace Gyoji::mir {
+    class Function;
+    class Liveness;
+
+    /**
+     * @brief Ranges of unsigned values used to index arrays.
+     *
+     * @details
+     * This works out, for each point in a function, the
+     * smallest and largest value that each unsigned integer
+     * local variable and tmpvar can hold.  It is used to find
+     * the array accesses whose index is always less than the
+     * length of the array so that the bounds check for them
+     * can be left out.
+     *
+     * Ranges come from integer literals, from arithmetic on
+     * other ranges (when it can't overflow), and from the
+     * comparisons that decide a conditional jump: along
+     * the branch taken when 'i < 10u32' holds, 'i' is at
+     * most 9.  Loops are handled by widening the range of
+     * any variable that keeps growing around the loop to the
+     * full range of its type, so a loop counter is bounded
+     * only by the comparison that guards the loop body.
+     *
+     * Only variables whose address is never taken are
+     * tracked (see Liveness), because anything else might
+     * be changed through a reference.
+     */
+    class ValueRanges {
+    public:
+	/**
+	 * Works out the ranges for the function using
+	 * the variables numbered by its liveness.
+	 */
+	ValueRanges(const Function & _function, const Liveness & _liveness);
+	/**
+	 * @brief Move along, nothing to see here.
+	 *
+	 * @details
+	 * Move along, nothing to see here.
+	 */
+	~ValueRanges();
+
+	/**
+	 * @brief Returns true if an array index needs no bounds check.
+	 *
+	 * @details
+	 * Returns true if the operation at the given index of the
+	 * block is an array index whose index is always less than
+	 * the length of the array.
+	 */
+	bool is_index_in_bounds(size_t blockid, size_t operation_index) const;
+
+	/**
+	 * Number of array index operations
+	 * that still need a bounds check.
+	 */
+	size_t get_checks_kept() const;
+	/**
+	 * Number of array index operations whose
+	 * bounds check can be left out.
+	 */
+	size_t get_checks_eliminated() const;
+    private:
+	const Function & function;
+	const Liveness & liveness;
+	// For each block, whether each of its
+	// operations is an index known to be in bounds.
+	std::vector<std::vector<bool>> in_bounds;
+	size_t checks_kept;
+	size_t checks_eliminated;
+    };
+
+};
@@ -0,0 +1,186 @@
+/* Copyright 2025 Jonathan S. Arney
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      https://github.com/jarney/gyoji/blob/master/LICENSE
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#pragma once
+
+#include <gyoji-mir/operations.hpp>
+#include <gyoji-mir/types.hpp>
+
+#include <string>
+#include <map>
+#include <vector>
+#include <stdio.h>
+
+namespace Gyoji::mir {
+    class MIR;
+    class Function;
+
+    /**
+     * @brief Size and shape of a single function.
+     *
+     * @details
+     * This holds the counts gathered from one function
+     * by MIRStats.  The same class is used to hold the
+     * totals across all of the functions in the MIR, in
+     * which case the maximum number of operands is the
+     * largest of any function.
+     */
+    class FunctionStats {
+    public:
+	/**
+	 * Gathers the counts for the given function.
+	 */
+	FunctionStats(const Function & function);
+	/**
+	 * Creates an empty set of counts with the
+	 * given name, used to accumulate totals.
+	 */
+	FunctionStats(std::string _name);
+	/**
+	 * @brief Move along, nothing to see here.
+	 *
+	 * @details
+	 * Move along, nothing to see here.
+	 */
+	~FunctionStats();
+
+	/**
+	 * Adds the counts from another function
+	 * into these counts.
+	 */
+	void add(const FunctionStats & other);
+
+	const std::string & get_name() const;
+	size_t get_blocks() const;
+	size_t get_operations() const;
+	/**
+	 * Number of operations of each operation type.  Types
+	 * that do not appear in the function are not listed.
+	 */
+	const std::map<Operation::OperationType, size_t> & get_operations_by_type() const;
+	size_t get_tmpvars() const;
+	size_t get_max_operands() const;
+	/**
+	 * Approximate number of bytes of memory held by
+	 * the function, its blocks, its operations, and
+	 * its temporary variables.
+	 */
+	size_t get_bytes() const;
+	/**
+	 * Number of array index operations that need
+	 * a bounds check and the number that can be
+	 * proven in bounds (see ValueRanges).
+	 */
+	size_t get_bounds_checks_kept() const;
+	size_t get_bounds_checks_eliminated() const;
+	/**
+	 * Number of operations that leaving scopes early
+	 * would have repeated at each exit, but which are
+	 * shared in cleanup blocks instead.
+	 */
+	size_t get_cleanup_operations_shared() const;
+    private:
+	std::string name;
+	size_t blocks;
+	size_t operations;
+	std::map<Operation::OperationType, size_t> operations_by_type;
+	size_t tmpvars;
+	size_t max_operands;
+	size_t bytes;
+	size_t bounds_checks_kept;
+	size_t bounds_checks_eliminated;
+	size_t cleanup_operations_shared;
+    };
+
+    /**
+     * @brief Statistics about the size of the MIR.
+     *
+     * @details
+     * This gathers the number of blocks, operations,
+     * and temporary variables in each function along
+     * with an estimate of the memory each function uses
+     * and the number of each kind of type in the types
+     * table.  It is used by the --mir-stats option of
+     * the compiler to keep an eye on how much memory the
+     * compiler needs as programs get larger and to find
+     * functions that lower into unusually large MIR.
+     *
+     * The MIR knows nothing about the tokens or the
+     * syntax tree it was built from, so the front-end
+     * supplies the size of those separately.
+     *
+     * Byte counts are estimates computed from the size
+     * of each object and the capacity of its containers.
+     * They don't account for the overhead of the memory
+     * allocator, and operations are counted at the size
+     * of the Operation base class.  They are meant to be
+     * compared with each other from one build to the next
+     * rather than to the resident size of the process.
+     */
+    class MIRStats {
+    public:
+	/**
+	 * Gathers the statistics for every function
+	 * and type in the MIR.
+	 */
+	MIRStats(const MIR & mir);
+	/**
+	 * @brief Move along, nothing to see here.
+	 *
+	 * @details
+	 * Move along, nothing to see here.
+	 */
+	~MIRStats();
+
+	/**
+	 * Records the size of the token stream
+	 * the MIR was built from.
+	 */
+	void set_token_stream(size_t _tokens, size_t _bytes);
+	/**
+	 * Records the approximate size of the syntax
+	 * tree the MIR was built from.
+	 */
+	void set_syntax_tree_bytes(size_t _bytes);
+
+	const std::vector<FunctionStats> & get_functions() const;
+	const FunctionStats & get_total() const;
+	/**
+	 * Number of entries in the types table
+	 * of each kind, keyed by the name of the kind.
+	 */
+	const std::map<std::string, size_t> & get_types_by_kind() const;
+
+	/**
+	 * Prints the statistics as human-readable
+	 * tables to the given file handle.
+	 */
+	void print_table(FILE *out) const;
+	/**
+	 * Prints the statistics as a JSON document
+	 * to the given file handle.
+	 */
+	void print_json(FILE *out) const;
+    private:
+	std::vector<FunctionStats> functions;
+	FunctionStats total;
+	std::map<std::string, size_t> types_by_kind;
+	size_t types;
+	size_t types_bytes;
+	size_t tokens;
+	size_t token_stream_bytes;
+	size_t syntax_tree_bytes;
+    };
+
+};
@@ -49,7 +49,12 @@ namespace Gyoji::mir {
 	 * they do not conflict since this would pose
 	 * a problem for linkage of the generated binary.
 	 */
-	Symbol(std::string _name, SymbolType _type, const Type *_mir_type);
+	Symbol(
+	    Gyoji::context::Atom _name,
+	    const std::string & _name_string,
+	    SymbolType _type,
+	    const Type *_mir_type
+	    );
 
 	/**
 	 * @brief Move along, nothing to see here.
@@ -62,7 +67,11 @@ namespace Gyoji::mir {
 	/**
 	 * Returns the name of the symbol.
 	 */
-	std::string get_name() const;
+	const std::string & get_name() const;
+	/**
+	 * Returns the interned name of the symbol.
+	 */
+	Gyoji::context::Atom get_name_atom() const;
 	/**
 	 * Returns a pointer to the immutable type
 	 * of the symbol.
@@ -71,7 +80,8 @@ namespace Gyoji::mir {
 
 	SymbolType get_type() const;
     private:
-	std::string name;
+	Gyoji::context::Atom name;
+	const std::string & name_string;
 	SymbolType type;
 	const Type *mir_type;
     };
@@ -94,9 +104,10 @@ namespace Gyoji::mir {
     class Symbols {
     public:
 	/**
-	 * Creates a new symbol table.
+	 * Creates a new symbol table.  Symbol names
+	 * are interned in the given atom table.
 	 */
-	Symbols();
+	Symbols(Gyoji::context::AtomTable & _atoms);
 	/**
 	 * @brief Move along, nothing to see here.
 	 *
@@ -129,13 +140,23 @@ namespace Gyoji::mir {
 	 */
 	const Symbol * get_symbol(std::string name) const;
 
+	/**
+	 * @brief Look up a symbol by interned name.
+	 *
+	 * @details
+	 * Same as above, but without having to hash
+	 * or compare the text of the name.
+	 */
+	const Symbol * get_symbol(Gyoji::context::Atom name) const;
+
 	/**
 	 * This is used to dump the content of the global
 	 * symbol table for debugging purposes.
 	 */
 	void dump(FILE *out) const;
     private:
-	std::map<std::string, Gyoji::owned<Symbol>> symbols;
+	Gyoji::context::AtomTable & atoms;
+	std::map<Gyoji::context::Atom, Gyoji::owned<Symbol>> symbols;
     };
 
 };
@@ -18,7 +18,9 @@
 #include <gyoji-context.hpp>
 #include <string>
 #include <map>
+#include <unordered_map>
 #include <vector>
+#include <mutex>
 
 /**
  * @brief The types namespace is used to extract and resolve types from the syntax tree.
@@ -42,6 +44,93 @@ namespace Gyoji::mir {
     class Type;
     class Types;
     class Argument;
+
+    /**
+     * @brief Integer handle for a type.
+     *
+     * @details
+     * Each type defined in the Types table is given
+     * a small integer ID in the order it was defined.
+     * The ID is stable for the life of the table, so
+     * two types are the same type exactly when their
+     * IDs are equal, and consumers such as the code-generator
+     * can keep per-type information in a vector indexed
+     * by the ID rather than a map keyed by the type name.
+     */
+    typedef size_t TypeId;
+
+    /**
+     * @brief Structural identity of a derived type.
+     *
+     * @details
+     * Pointers, references, arrays, and function pointers
+     * are derived from other types, and two of them
+     * are the same type whenever they are built from the same
+     * parts.  This key captures those parts (the kind of
+     * type, the target or return type, the array length,
+     * the 'unsafe' modifier and the argument types) so that
+     * the Types table can find an existing derived type
+     * with a hash lookup instead of building and comparing
+     * its name.
+     */
+    class TypeKey {
+    public:
+	/**
+	 * @brief Create a key for a derived type.
+	 *
+	 * @details
+	 * The kind is the Type::TypeType of the derived
+	 * type.  The target is the type pointed to,
+	 * referenced, or contained in the array, or the
+	 * return type of a function pointer.  Parts that
+	 * don't apply to the kind should be passed as zero,
+	 * false, or empty.
+	 */
+	TypeKey(
+	    size_t _kind,
+	    TypeId _target,
+	    size_t _length,
+	    bool _is_unsafe,
+	    const std::vector<TypeId> & _arguments
+	    );
+	/**
+	 * @brief Copy constructor
+	 *
+	 * @details
+	 * Provided so that the key may be stored in
+	 * the hash-table of derived types.
+	 */
+	TypeKey(const TypeKey & _other);
+	/**
+	 * @brief Move along, nothing to see here.
+	 *
+	 * @details
+	 * Move along, nothing to see here.
+	 */
+	~TypeKey();
+
+	bool operator==(const TypeKey & _other) const;
+
+	/**
+	 * Returns a hash combining all of
+	 * the parts of the key.
+	 */
+	size_t hash() const;
+    private:
+	size_t kind;
+	TypeId target;
+	size_t length;
+	bool is_unsafe;
+	std::vector<TypeId> arguments;
+    };
+
+    /**
+     * @brief Hash function adapter for TypeKey.
+     */
+    class TypeKeyHash {
+    public:
+	size_t operator()(const TypeKey & key) const;
+    };
     
     /**
      * @brief Set of types extracted from a translation unit.
@@ -50,6 +139,15 @@ namespace Gyoji::mir {
      * This class represents a type extracted from the
      * source translation unit.  Types may be primitive
      * or composite structures containing other types.
+     *
+     * Types are only ever added to the table, so a type
+     * once found stays valid and keeps its ID.  Functions
+     * are lowered on several threads at once, and each of
+     * them may look up types and define new derived types
+     * such as pointers and arrays, so every lookup and
+     * definition holds a lock on the table.  The whole
+     * table (get_types() and dump()) should only be looked
+     * at while no other thread is defining types.
      */
     class Types {
     public:
@@ -106,6 +204,34 @@ namespace Gyoji::mir {
 	 */
 	const Type * get_array_of(const Type *_type, size_t _length, const Gyoji::context::SourceReference & _src_ref);
 
+	/**
+	 * This returns a type that is a pointer to a function
+	 * returning _return_type and accepting the given
+	 * arguments.  As with the other derived types, the
+	 * type is created and inserted into the table the first
+	 * time it is asked for and the existing type is
+	 * returned after that.
+	 */
+	const Type * get_function_pointer_to(
+	    const Type *_return_type,
+	    const std::vector<Argument> & _arguments,
+	    bool _is_unsafe,
+	    const Gyoji::context::SourceReference & _src_ref
+	    );
+
+	/**
+	 * Returns the type with the given ID.  The ID must
+	 * be less than get_type_count().
+	 */
+	const Type * get_type_by_id(TypeId type_id) const;
+
+	/**
+	 * Returns the number of types defined so
+	 * far.  Every type ID in the table is less than
+	 * this value.
+	 */
+	size_t get_type_count() const;
+
 	/**
 	 * This is used to define a fully-qualified type
 	 * from the definition.  Note that some types
@@ -113,8 +239,14 @@ namespace Gyoji::mir {
 	 * initially declared and a final resolution step may
 	 * be required in order to ensure that the type is fully
 	 * specified.
+	 *
+	 * The type is assigned the next type ID when
+	 * it is defined.  If a type with the same name
+	 * is already defined, the new one is thrown away.
+	 * Either way, this returns the type that is now
+	 * defined with that name.
 	 */
-	void define_type(Gyoji::owned<Type> type);
+	Type * define_type(Gyoji::owned<Type> type);
 	
 	/**
 	 * This is used for debugging purposes to dump
@@ -129,6 +261,15 @@ namespace Gyoji::mir {
 	const std::map<std::string, Gyoji::owned<Type>> & get_types() const;
     private:
 	std::map<std::string, Gyoji::owned<Type>> type_map;
+	std::vector<Type*> types_by_id;
+	std::unordered_map<TypeKey, TypeId, TypeKeyHash> derived_types;
+	mutable std::mutex mutex;
+
+	// These expect the caller to hold the lock.
+	Type *find_type(const std::string & type) const;
+	Type *insert_type(Gyoji::owned<Type> type);
+	const Type *derived_type_find(const TypeKey & key) const;
+	const Type *derived_type_define(const TypeKey & key, Gyoji::owned<Type> type);
     };
     
     /**
@@ -174,7 +315,7 @@ namespace Gyoji::mir {
 	const Gyoji::context::SourceReference & get_source_ref() const;
     private:
 	const Type *argument_type;
-	const Gyoji::context::SourceReference *source_ref;
+	Gyoji::context::SourceReference source_ref;
     };
     
     /**
@@ -252,7 +393,7 @@ namespace Gyoji::mir {
 	std::string member_name;
 	size_t index;
 	const Type *member_type;
-	const Gyoji::context::SourceReference *source_ref;
+	Gyoji::context::SourceReference source_ref;
     };
 
     /**
@@ -284,7 +425,7 @@ namespace Gyoji::mir {
 	const std::vector<Argument> & get_arguments() const;
     private:
 	std::string method_name;
-	const Gyoji::context::SourceReference & source_ref;
+	Gyoji::context::SourceReference source_ref;
 	const Type *class_type;
 	const Type *return_type;
 	std::vector<Argument> arguments;
@@ -769,6 +910,16 @@ namespace Gyoji::mir {
 	 */
 	void dump(FILE *out) const;
 
+	/**
+	 * @brief ID of this type in the Types table.
+	 *
+	 * @details
+	 * Returns the ID assigned when the type was defined
+	 * in the Types table.  Two defined types are the same
+	 * type exactly when their IDs are equal.
+	 */
+	TypeId get_type_id() const;
+
 	/**
 	 * If a type is forward-declared without a complete type,
 	 * this returns the reference to the source location
@@ -787,14 +938,16 @@ namespace Gyoji::mir {
 	const Gyoji::context::SourceReference & get_defined_source_ref() const;
 	
     private:
+	friend Types;
+	TypeId type_id;
 	std::string name;
 	std::string simple_name;
 	TypeType type;
 	bool complete;
 	bool m_is_unsafe;
 	
-	const Gyoji::context::SourceReference *declared_source_ref;
-	const Gyoji::context::SourceReference *defined_source_ref;
+	Gyoji::context::SourceReference declared_source_ref;
+	Gyoji::context::SourceReference defined_source_ref;
 
 	// Used only for pointer and reference types.
 	const Type *pointer_or_ref;
@@ -0,0 +1,457 @@
+/* Copyright 2025 Jonathan S. Arney
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      https://github.com/jarney/gyoji/blob/master/LICENSE
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#include <gyoji-mir.hpp>
+#include <algorithm>
+
+using namespace Gyoji::mir;
+using namespace Gyoji::context;
+using Gyoji::misc::BitSet;
+
+static const size_t none = (size_t)-1;
+
+namespace Gyoji::mir {
+
+    // Live variables is the backward 'may' problem
+    // where uses make a fact live and definitions
+    // make it dead.
+    class LiveVariables : public DataFlowProblem {
+    public:
+	LiveVariables(const Liveness & _liveness, size_t _tmpvars);
+	virtual ~LiveVariables();
+	virtual void effect(
+	    size_t block_id,
+	    size_t operation_index,
+	    const Operation & operation,
+	    BitSet & gen,
+	    BitSet & kill
+	    ) const;
+    private:
+	const Liveness & liveness;
+	mutable std::vector<size_t> uses;
+	mutable std::vector<size_t> defs;
+    };
+
+};
+
+//////////////////////////////////////////////
+// LiveRangeMarker
+//////////////////////////////////////////////
+LiveRangeMarker::LiveRangeMarker(MarkerType _type, size_t _operation_index, size_t _variable)
+    : type(_type)
+    , operation_index(_operation_index)
+    , variable(_variable)
+{}
+
+LiveRangeMarker::LiveRangeMarker(const LiveRangeMarker & other)
+    : type(other.type)
+    , operation_index(other.operation_index)
+    , variable(other.variable)
+{}
+
+LiveRangeMarker::~LiveRangeMarker()
+{}
+
+LiveRangeMarker::MarkerType
+LiveRangeMarker::get_type() const
+{ return type; }
+
+size_t
+LiveRangeMarker::get_operation_index() const
+{ return operation_index; }
+
+size_t
+LiveRangeMarker::get_variable() const
+{ return variable; }
+
+//////////////////////////////////////////////
+// LiveVariables
+//////////////////////////////////////////////
+LiveVariables::LiveVariables(const Liveness & _liveness, size_t _tmpvars)
+    : DataFlowProblem(BACKWARD, MAY, _liveness.get_variable_count() + _tmpvars)
+    , liveness(_liveness)
+{}
+
+LiveVariables::~LiveVariables()
+{}
+
+void
+LiveVariables::effect(
+    size_t block_id,
+    size_t operation_index,
+    const Operation & operation,
+    BitSet & gen,
+    BitSet & kill
+    ) const
+{
+    uses.clear();
+    defs.clear();
+    liveness.get_variables(operation, uses, defs);
+    for (size_t variable : defs) {
+	kill.set(variable);
+    }
+    for (size_t variable : uses) {
+	gen.set(variable);
+    }
+    if (operation.has_result()) {
+	kill.set(liveness.get_tmpvar_fact(operation.get_result()));
+    }
+    const std::vector<size_t> & operands = operation.get_operands();
+    size_t noperands = operation.get_tmpvar_operand_count();
+    for (size_t i = 0; i < noperands; i++) {
+	gen.set(liveness.get_tmpvar_fact(operands.at(i)));
+    }
+}
+
+//////////////////////////////////////////////
+// Liveness
+//////////////////////////////////////////////
+Liveness::Liveness(const Function & _function)
+    : function(_function)
+{
+    number_variables();
+    problem = Gyoji::owned_new<LiveVariables>(*this, function.tmpvar_count());
+    solution = Gyoji::owned_new<DataFlow>(function, *problem);
+    find_markers();
+}
+
+Liveness::~Liveness()
+{}
+
+void
+Liveness::number_variables()
+{
+    // Arguments live for the whole function,
+    // so they are not numbered.  They take the
+    // first declaration ids.
+    size_t narguments = function.get_arguments().size();
+    for (const auto & block_it : function.get_blocks()) {
+	for (const auto & operation : block_it.second->get_operations()) {
+	    if (operation->get_type() != Operation::OP_LOCAL_DECLARE) {
+		continue;
+	    }
+	    size_t declaration_id = ((const OperationLocalDeclare &)*operation).get_declaration_id();
+	    if (declaration_id < narguments ||
+		variables.find(declaration_id) != variables.end()) {
+		continue;
+	    }
+	    variables.insert(std::pair(declaration_id, variable_declarations.size()));
+	    variable_declarations.push_back(declaration_id);
+	}
+    }
+    address_taken.resize(variable_declarations.size(), false);
+
+    size_t ntmpvars = function.tmpvar_count();
+    tmpvar_roots.resize(ntmpvars, none);
+    tmpvar_whole.resize(ntmpvars, false);
+    tmpvar_read.resize(ntmpvars, false);
+    for (const auto & block_it : function.get_blocks()) {
+	for (const auto & operation : block_it.second->get_operations()) {
+	    if (!operation->has_result() || operation->get_result() >= ntmpvars) {
+		continue;
+	    }
+	    size_t result = operation->get_result();
+	    tmpvar_roots[result] = root_of(result);
+	    tmpvar_whole[result] =
+		operation->get_type() == Operation::OP_LOCAL_VARIABLE &&
+		tmpvar_roots[result] != none;
+	}
+    }
+
+    // Every use of a tmpvar is a read except
+    // as the destination of an assignment to
+    // the whole variable.
+    for (const auto & block_it : function.get_blocks()) {
+	for (const auto & operation : block_it.second->get_operations()) {
+	    const std::vector<size_t> & operands = operation->get_operands();
+	    size_t noperands = operation->get_tmpvar_operand_count();
+	    size_t first = is_whole_assignment(*operation) ? 1 : 0;
+	    for (size_t i = first; i < noperands; i++) {
+		size_t tmpvar = operands.at(i);
+		if (tmpvar >= ntmpvars) {
+		    continue;
+		}
+		tmpvar_read[tmpvar] = true;
+		if (operation->get_type() == Operation::OP_ADDRESSOF && tmpvar_roots[tmpvar] != none) {
+		    address_taken[tmpvar_roots[tmpvar]] = true;
+		}
+	    }
+	}
+    }
+}
+
+size_t
+Liveness::root_of(size_t tmpvar) const
+{
+    const Operation *operation = function.tmpvar_get_operation(tmpvar);
+    if (operation == nullptr) {
+	return none;
+    }
+    switch (operation->get_type()) {
+    case Operation::OP_LOCAL_VARIABLE:
+	{
+	    const auto & it = variables.find(((const OperationLocalVariable *)operation)->get_declaration_id());
+	    if (it == variables.end()) {
+		return none;
+	    }
+	    return it->second;
+	}
+    case Operation::OP_DOT:
+	return root_of(operation->get_operands().at(0));
+    case Operation::OP_ARRAY_INDEX:
+	{
+	    // Indexing through a pointer reaches
+	    // memory outside of the variable.
+	    size_t array = operation->get_operands().at(0);
+	    if (array >= function.tmpvar_count() || !function.tmpvar_get(array)->is_array()) {
+		return none;
+	    }
+	    return root_of(array);
+	}
+    default:
+	return none;
+    }
+}
+
+bool
+Liveness::is_whole_assignment(const Operation & operation) const
+{
+    if (operation.get_type() != Operation::OP_ASSIGN) {
+	return false;
+    }
+    size_t a = operation.get_operands().at(0);
+    size_t b = operation.get_operands().at(1);
+    if (a >= tmpvar_whole.size() || b >= tmpvar_whole.size() || !tmpvar_whole[a]) {
+	return false;
+    }
+    // Assigning an anonymous structure only
+    // writes the members it names.
+    return !function.tmpvar_get(b)->is_anonymous();
+}
+
+void
+Liveness::get_variables(
+    const Operation & operation,
+    std::vector<size_t> & uses,
+    std::vector<size_t> & defs
+    ) const
+{
+    switch (operation.get_type()) {
+    case Operation::OP_LOCAL_VARIABLE:
+	{
+	    // The variable is loaded here, so it is
+	    // used unless nothing reads the value.
+	    size_t result = operation.get_result();
+	    if (result < tmpvar_roots.size() && tmpvar_read[result] && tmpvar_roots[result] != none) {
+		uses.push_back(tmpvar_roots[result]);
+	    }
+	}
+	break;
+    case Operation::OP_LOCAL_DECLARE:
+	{
+	    size_t variable = get_variable(((const OperationLocalDeclare &)operation).get_declaration_id());
+	    if (variable != variable_declarations.size()) {
+		defs.push_back(variable);
+	    }
+	}
+	return;
+    case Operation::OP_LOCAL_UNDECLARE:
+	{
+	    size_t variable = get_variable(((const OperationLocalUndeclare &)operation).get_declaration_id());
+	    if (variable != variable_declarations.size()) {
+		defs.push_back(variable);
+	    }
+	}
+	return;
+    default:
+	break;
+    }
+
+    const std::vector<size_t> & operands = operation.get_operands();
+    size_t noperands = operation.get_tmpvar_operand_count();
+    bool whole = is_whole_assignment(operation);
+    for (size_t i = 0; i < noperands; i++) {
+	size_t tmpvar = operands.at(i);
+	if (tmpvar >= tmpvar_roots.size() || tmpvar_roots[tmpvar] == none) {
+	    continue;
+	}
+	if (i == 0 && whole) {
+	    defs.push_back(tmpvar_roots[tmpvar]);
+	}
+	else {
+	    uses.push_back(tmpvar_roots[tmpvar]);
+	}
+    }
+}
+
+void
+Liveness::find_markers()
+{
+    const CFGInfo & cfg = function.get_cfg_info();
+    markers.resize(cfg.get_block_limit());
+    size_t nvariables = variable_declarations.size();
+
+    BitSet facts(problem->get_facts());
+    std::vector<size_t> uses;
+    std::vector<size_t> defs;
+    std::vector<LiveRangeMarker> found;
+    std::vector<std::pair<size_t, size_t>> block_dead_stores;
+    for (const auto & block_it : function.get_blocks()) {
+	size_t blockid = block_it.first;
+	if (!cfg.is_reachable(blockid)) {
+	    continue;
+	}
+	std::vector<LiveRangeMarker> & block_markers = markers[blockid];
+
+	// Anything live leaving a predecessor but not
+	// coming into this block dies on the way in.
+	const std::vector<size_t> & predecessors = cfg.get_predecessors(blockid);
+	if (predecessors.size() != 0) {
+	    facts.clear();
+	    for (size_t predecessor : predecessors) {
+		facts.union_with(get_live_out(predecessor));
+	    }
+	    facts.subtract(get_live_in(blockid));
+	    for (size_t variable = facts.find_next(0); variable < nvariables; variable = facts.find_next(variable+1)) {
+		if (!address_taken[variable]) {
+		    block_markers.push_back(LiveRangeMarker(LiveRangeMarker::END, 0, variable));
+		}
+	    }
+	}
+
+	// Walk backward from the end of the block
+	// so that 'facts' holds what is live just
+	// after each operation.
+	const std::vector<Gyoji::owned<Operation>> & operations = block_it.second->get_operations();
+	found.clear();
+	block_dead_stores.clear();
+	facts = get_live_out(blockid);
+	for (size_t i = operations.size(); i-- > 0; ) {
+	    const Operation & operation = *operations.at(i);
+	    uses.clear();
+	    defs.clear();
+	    get_variables(operation, uses, defs);
+	    for (size_t variable : defs) {
+		// The storage of a variable only exists once it
+		// has been declared, so it is started just after
+		// the declaration rather than before it.
+		if (address_taken[variable]) {
+		    // These live for their whole scope.
+		    if (operation.get_type() == Operation::OP_LOCAL_DECLARE) {
+			found.push_back(LiveRangeMarker(LiveRangeMarker::START, i+1, variable));
+		    }
+		    else if (operation.get_type() == Operation::OP_LOCAL_UNDECLARE && i+1 < operations.size()) {
+			found.push_back(LiveRangeMarker(LiveRangeMarker::END, i+1, variable));
+		    }
+		    continue;
+		}
+		if (operation.get_type() == Operation::OP_LOCAL_DECLARE) {
+		    // A variable still live after its declaration is
+		    // used before (or without) being assigned as a
+		    // whole, for example an array filled in one element
+		    // at a time, so it must start here.  Otherwise a
+		    // path could reach the end of its range without
+		    // ever passing a start.
+		    if (facts.test(variable)) {
+			found.push_back(LiveRangeMarker(LiveRangeMarker::START, i+1, variable));
+		    }
+		    continue;
+		}
+		if (operation.get_type() != Operation::OP_ASSIGN) {
+		    continue;
+		}
+		if (!facts.test(variable)) {
+		    block_dead_stores.push_back(std::pair(blockid, i));
+		}
+		else if (std::find(uses.begin(), uses.end(), variable) == uses.end()) {
+		    found.push_back(LiveRangeMarker(LiveRangeMarker::START, i, variable));
+		}
+	    }
+	    for (size_t variable : uses) {
+		if (address_taken[variable] || facts.test(variable)) {
+		    continue;
+		}
+		// This is the last use, so the variable
+		// dies just after this operation.  Marking it
+		// live here also keeps us from ending the
+		// same variable twice.
+		if (i+1 < operations.size()) {
+		    found.push_back(LiveRangeMarker(LiveRangeMarker::END, i+1, variable));
+		}
+		facts.set(variable);
+	    }
+	    solution->apply(blockid, i, operation, facts);
+	}
+	block_markers.insert(block_markers.end(), found.rbegin(), found.rend());
+	dead_stores.insert(dead_stores.end(), block_dead_stores.rbegin(), block_dead_stores.rend());
+    }
+}
+
+size_t
+Liveness::get_variable_count() const
+{ return variable_declarations.size(); }
+
+size_t
+Liveness::get_variable(size_t declaration_id) const
+{
+    const auto & it = variables.find(declaration_id);
+    if (it == variables.end()) {
+	return variable_declarations.size();
+    }
+    return it->second;
+}
+
+size_t
+Liveness::get_variable_declaration_id(size_t variable) const
+{ return variable_declarations.at(variable); }
+
+bool
+Liveness::is_address_taken(size_t variable) const
+{ return address_taken.at(variable); }
+
+size_t
+Liveness::get_tmpvar_fact(size_t tmpvar) const
+{ return variable_declarations.size() + tmpvar; }
+
+bool
+Liveness::is_tmpvar_read(size_t tmpvar) const
+{
+    if (tmpvar >= tmpvar_read.size()) {
+	return true;
+    }
+    return tmpvar_read[tmpvar];
+}
+
+// The solution runs backward, so what it calls
+// the 'in' set is the end of the block.
+const BitSet &
+Liveness::get_live_in(size_t blockid) const
+{ return solution->get_out(blockid); }
+
+const BitSet &
+Liveness::get_live_out(size_t blockid) const
+{ return solution->get_in(blockid); }
+
+const std::vector<LiveRangeMarker> &
+Liveness::get_markers(size_t blockid) const
+{
+    if (blockid >= markers.size()) {
+	return no_markers;
+    }
+    return markers[blockid];
+}
+
+const std::vector<std::pair<size_t, size_t>> &
+Liveness::get_dead_stores() const
+{ return dead_stores; }
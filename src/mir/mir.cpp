@@ -16,7 +16,9 @@
 
 using namespace Gyoji::mir;
 
-MIR::MIR()
+MIR::MIR(Gyoji::context::AtomTable & _atoms)
+    : atoms(_atoms)
+    , symbols(_atoms)
 {}
 
 MIR::~MIR()
@@ -46,6 +48,10 @@ const Symbols &
 MIR::get_symbols() const
 { return symbols; }
 
+Gyoji::context::AtomTable &
+MIR::get_atoms() const
+{ return atoms; }
+
 void
 MIR::dump(FILE *out) const
 {
@@ -108,6 +108,7 @@ Operation::Operation(
     : type(_type)
     , src_ref(_src_ref)
     , result(_result)
+    , dead_store(false)
 {}
 Operation::Operation(
     OperationType _type,
@@ -118,6 +119,7 @@ Operation::Operation(
     : type(_type)
     , src_ref(_src_ref)
     , result(_result)
+    , dead_store(false)
 {
     add_operand(_operand);
 }
@@ -131,6 +133,7 @@ Operation::Operation(
     : type(_type)
     , src_ref(_src_ref)
     , result(_result)
+    , dead_store(false)
 {
     add_operand(_operand_a);
     add_operand(_operand_b);
@@ -146,6 +149,7 @@ Operation::Operation(
     : type(_type)
     , src_ref(_src_ref)
     , result(_result)
+    , dead_store(false)
 {
     add_operand(_operand_a);
     add_operand(_operand_b);
@@ -185,6 +189,36 @@ Operation::is_terminating() const
 	(type == OP_RETURN_VOID);
 }
 
+bool
+Operation::has_result() const
+{
+    return !is_terminating() &&
+	(type != OP_LOCAL_DECLARE) &&
+	(type != OP_LOCAL_UNDECLARE);
+}
+
+size_t
+Operation::get_tmpvar_operand_count() const
+{
+    switch (type) {
+    case OP_JUMP:
+    case OP_RETURN_VOID:
+	return 0;
+    case OP_JUMP_CONDITIONAL:
+	return 1;
+    default:
+	return operands.size();
+    }
+}
+
+bool
+Operation::is_dead_store() const
+{ return dead_store; }
+
+void
+Operation::set_dead_store(bool _dead_store)
+{ dead_store = _dead_store; }
+
 std::vector<size_t>
 Operation::get_connections() const
 {
@@ -209,6 +243,10 @@ Operation::OperationType
 Operation::get_type() const
 { return type; }
 
+const std::string &
+Operation::get_type_name(OperationType _type)
+{ return op_type_names.find(_type)->second; }
+
 const std::vector<size_t> &
 Operation::get_operands() const
 { return operands; }
@@ -225,7 +263,7 @@ void
 Operation::dump(FILE *out, size_t operation_index) const
 {
 //    fprintf(out, "            %ld : %s\n", operation_index, get_description().c_str());
-    fprintf(out, "            %s\n", get_description().c_str());
+    fprintf(out, "            %s%s\n", get_description().c_str(), dead_store ? " (dead store)" : "");
 }
 
 
@@ -417,11 +455,15 @@ OperationDot::get_description() const
 OperationLocalVariable::OperationLocalVariable(
     const Gyoji::context::SourceReference & _src_ref,
     size_t _result,
-    std::string _symbol_name,
+    const Gyoji::context::AtomTable & _atoms,
+    Gyoji::context::Atom _symbol,
+    size_t _declaration_id,
     const Type * _var_type
     )
     : Operation(OP_LOCAL_VARIABLE, _src_ref, _result)
-    , symbol_name(_symbol_name)
+    , symbol(_symbol)
+    , symbol_name(_atoms.get_string(_symbol))
+    , declaration_id(_declaration_id)
     , var_type(_var_type)
 {}
 OperationLocalVariable::~OperationLocalVariable()
@@ -431,6 +473,14 @@ const std::string &
 OperationLocalVariable::get_symbol_name() const
 { return symbol_name; }
 
+Gyoji::context::Atom
+OperationLocalVariable::get_symbol_atom() const
+{ return symbol; }
+
+size_t
+OperationLocalVariable::get_declaration_id() const
+{ return declaration_id; }
+
 const Type *
 OperationLocalVariable::get_var_type() const
 { return var_type; }
@@ -1002,11 +1052,15 @@ OperationReturnVoid::get_description() const
 //////////////////////////////////////////////
 OperationLocalDeclare::OperationLocalDeclare(
     const Gyoji::context::SourceReference & _src_ref,
-    std::string _variable,
+    const Gyoji::context::AtomTable & _atoms,
+    Gyoji::context::Atom _variable,
+    size_t _declaration_id,
     const Type *_variable_type
     )
     : Operation(OP_LOCAL_DECLARE, _src_ref, 0)
-    , variable(_variable)
+    , variable_atom(_variable)
+    , variable(_atoms.get_string(_variable))
+    , declaration_id(_declaration_id)
     , variable_type(_variable_type)
 {}
 OperationLocalDeclare::~OperationLocalDeclare()
@@ -1014,6 +1068,12 @@ OperationLocalDeclare::~OperationLocalDeclare()
 const std::string &
 OperationLocalDeclare::get_variable() const
 { return variable; }
+Gyoji::context::Atom
+OperationLocalDeclare::get_variable_atom() const
+{ return variable_atom; }
+size_t
+OperationLocalDeclare::get_declaration_id() const
+{ return declaration_id; }
 const Type*
 OperationLocalDeclare::get_variable_type() const
 { return variable_type; }
@@ -1035,15 +1095,27 @@ OperationLocalDeclare::get_description() const
 //////////////////////////////////////////////
 OperationLocalUndeclare::OperationLocalUndeclare(
     const Gyoji::context::SourceReference & _src_ref,
-    std::string _variable
+    const Gyoji::context::AtomTable & _atoms,
+    Gyoji::context::Atom _variable,
+    size_t _declaration_id
     )
     : Operation(OP_LOCAL_UNDECLARE, _src_ref, 0)
-    , variable(_variable)
+    , variable_atom(_variable)
+    , variable(_atoms.get_string(_variable))
+    , declaration_id(_declaration_id)
 {}
 
 OperationLocalUndeclare::~OperationLocalUndeclare()
 {}
 
+Gyoji::context::Atom
+OperationLocalUndeclare::get_variable_atom() const
+{ return variable_atom; }
+
+size_t
+OperationLocalUndeclare::get_declaration_id() const
+{ return declaration_id; }
+
 std::string
 OperationLocalUndeclare::get_description() const
 {
@@ -0,0 +1,689 @@
+/* Copyright 2025 Jonathan S. Arney
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      https://github.com/jarney/gyoji/blob/master/LICENSE
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#include <gyoji-mir.hpp>
+#include <algorithm>
+
+using namespace Gyoji::mir;
+using namespace Gyoji::context;
+using Gyoji::misc::BitSet;
+
+static const size_t none = (size_t)-1;
+
+namespace Gyoji::mir {
+
+    // The smallest and largest value something can hold.
+    class Range {
+    public:
+	Range();
+	Range(uint64_t _lo, uint64_t _hi);
+	Range(const Range & other);
+	~Range();
+	Range & operator=(const Range & other);
+	uint64_t lo;
+	uint64_t hi;
+    };
+
+    // Walks the operations of a block from the ranges
+    // of the variables on entry, working out the range
+    // of each unsigned tmpvar as it goes.
+    class RangeWalker {
+    public:
+	RangeWalker(
+	    const Function & _function,
+	    const Liveness & _liveness,
+	    const std::vector<uint64_t> & _variable_max,
+	    const std::vector<bool> & _tracked
+	    );
+	~RangeWalker();
+	void start(const std::vector<Range> & _variables);
+	void step(const Operation & operation);
+	bool tmpvar_range(size_t tmpvar, Range & range) const;
+	bool refine(const OperationJumpConditional & jump, bool taken, std::vector<Range> & state) const;
+	const std::vector<Range> & get_variables() const;
+    private:
+	const Function & function;
+	const Liveness & liveness;
+	const std::vector<uint64_t> & variable_max;
+	const std::vector<bool> & tracked;
+	std::vector<Range> variables;
+	std::vector<size_t> versions;
+	// A tmpvar's range is only trusted if this stamp
+	// says it was defined during the current walk.  A
+	// tmpvar from another block could hold any value.
+	size_t stamp;
+	std::vector<size_t> tmpvar_stamps;
+	std::vector<Range> tmpvar_ranges;
+	std::vector<bool> tmpvar_known;
+	std::vector<size_t> tmpvar_loaded_from;
+	std::vector<size_t> tmpvar_loaded_version;
+
+	bool defined_here(size_t tmpvar) const;
+	size_t loaded_variable(size_t tmpvar) const;
+	void set_range(size_t tmpvar, const Range & range);
+    };
+
+};
+
+static bool
+unsigned_max(const Type *type, uint64_t & max)
+{
+    if (type == nullptr) {
+	return false;
+    }
+    switch (type->get_type()) {
+    case Type::TYPE_PRIMITIVE_u8:
+	max = 0xff;
+	return true;
+    case Type::TYPE_PRIMITIVE_u16:
+	max = 0xffff;
+	return true;
+    case Type::TYPE_PRIMITIVE_u32:
+	max = 0xffffffff;
+	return true;
+    case Type::TYPE_PRIMITIVE_u64:
+	max = ~((uint64_t)0);
+	return true;
+    default:
+	return false;
+    }
+}
+
+static bool
+literal_value(const OperationLiteralInt & literal, uint64_t & value)
+{
+    switch (literal.get_literal_type()) {
+    case Type::TYPE_PRIMITIVE_u8:
+	value = literal.get_literal_u8();
+	return true;
+    case Type::TYPE_PRIMITIVE_u16:
+	value = literal.get_literal_u16();
+	return true;
+    case Type::TYPE_PRIMITIVE_u32:
+	value = literal.get_literal_u32();
+	return true;
+    case Type::TYPE_PRIMITIVE_u64:
+	value = literal.get_literal_u64();
+	return true;
+    default:
+	return false;
+    }
+}
+
+// Range of an arithmetic operation, or false if it
+// could overflow or we don't know how to bound it.
+static bool
+arithmetic_range(Operation::OperationType type, const Range & a, const Range & b, uint64_t max, Range & result)
+{
+    switch (type) {
+    case Operation::OP_ADD:
+	if (__builtin_add_overflow(a.hi, b.hi, &result.hi) || result.hi > max) {
+	    return false;
+	}
+	result.lo = a.lo + b.lo;
+	return true;
+    case Operation::OP_SUBTRACT:
+	if (a.lo < b.hi) {
+	    return false;
+	}
+	result.lo = a.lo - b.hi;
+	result.hi = a.hi - b.lo;
+	return true;
+    case Operation::OP_MULTIPLY:
+	if (__builtin_mul_overflow(a.hi, b.hi, &result.hi) || result.hi > max) {
+	    return false;
+	}
+	result.lo = a.lo * b.lo;
+	return true;
+    case Operation::OP_DIVIDE:
+	if (b.lo == 0) {
+	    return false;
+	}
+	result.lo = a.lo / b.hi;
+	result.hi = a.hi / b.lo;
+	return true;
+    case Operation::OP_MODULO:
+	if (b.lo == 0) {
+	    return false;
+	}
+	if (a.hi < b.lo) {
+	    result = a;
+	    return true;
+	}
+	result.lo = 0;
+	result.hi = std::min(a.hi, b.hi - 1);
+	return true;
+    case Operation::OP_BITWISE_AND:
+	result.lo = 0;
+	result.hi = std::min(a.hi, b.hi);
+	return true;
+    case Operation::OP_SHIFT_RIGHT:
+	// Shifting by the width of the type
+	// or more isn't defined.
+	if (b.hi >= (uint64_t)__builtin_popcountll(max)) {
+	    return false;
+	}
+	result.lo = a.lo >> b.hi;
+	result.hi = a.hi >> b.lo;
+	return true;
+    case Operation::OP_SHIFT_LEFT:
+	if (b.hi >= (uint64_t)__builtin_popcountll(max) || a.hi > (max >> b.hi)) {
+	    return false;
+	}
+	result.lo = a.lo << b.lo;
+	result.hi = a.hi << b.hi;
+	return true;
+    default:
+	return false;
+    }
+}
+
+// Narrows 'x' to the values where 'x <op> c' is true
+// and returns false if there are none.
+static bool
+narrow(Operation::OperationType compare, Range & x, const Range & c)
+{
+    switch (compare) {
+    case Operation::OP_COMPARE_LESS:
+	if (c.hi == 0) {
+	    return false;
+	}
+	x.hi = std::min(x.hi, c.hi - 1);
+	break;
+    case Operation::OP_COMPARE_LESS_EQUAL:
+	x.hi = std::min(x.hi, c.hi);
+	break;
+    case Operation::OP_COMPARE_GREATER:
+	if (c.lo == ~((uint64_t)0)) {
+	    return false;
+	}
+	x.lo = std::max(x.lo, c.lo + 1);
+	break;
+    case Operation::OP_COMPARE_GREATER_EQUAL:
+	x.lo = std::max(x.lo, c.lo);
+	break;
+    case Operation::OP_COMPARE_EQUAL:
+	x.lo = std::max(x.lo, c.lo);
+	x.hi = std::min(x.hi, c.hi);
+	break;
+    default:
+	// Knowing that two values differ
+	// says little about either range.
+	break;
+    }
+    return x.lo <= x.hi;
+}
+
+// The comparison that holds when the given one doesn't.
+static Operation::OperationType
+negate_compare(Operation::OperationType compare)
+{
+    switch (compare) {
+    case Operation::OP_COMPARE_LESS:
+	return Operation::OP_COMPARE_GREATER_EQUAL;
+    case Operation::OP_COMPARE_LESS_EQUAL:
+	return Operation::OP_COMPARE_GREATER;
+    case Operation::OP_COMPARE_GREATER:
+	return Operation::OP_COMPARE_LESS_EQUAL;
+    case Operation::OP_COMPARE_GREATER_EQUAL:
+	return Operation::OP_COMPARE_LESS;
+    case Operation::OP_COMPARE_EQUAL:
+	return Operation::OP_COMPARE_NOT_EQUAL;
+    case Operation::OP_COMPARE_NOT_EQUAL:
+	return Operation::OP_COMPARE_EQUAL;
+    default:
+	return compare;
+    }
+}
+
+// The comparison that holds with the operands swapped.
+static Operation::OperationType
+swap_compare(Operation::OperationType compare)
+{
+    switch (compare) {
+    case Operation::OP_COMPARE_LESS:
+	return Operation::OP_COMPARE_GREATER;
+    case Operation::OP_COMPARE_LESS_EQUAL:
+	return Operation::OP_COMPARE_GREATER_EQUAL;
+    case Operation::OP_COMPARE_GREATER:
+	return Operation::OP_COMPARE_LESS;
+    case Operation::OP_COMPARE_GREATER_EQUAL:
+	return Operation::OP_COMPARE_LESS_EQUAL;
+    default:
+	return compare;
+    }
+}
+
+// Joins the ranges coming along an edge into the ranges
+// on entry to a block and returns true if they grew.  When
+// widening, anything that grew goes straight to the full
+// range of its type so that loops settle quickly.
+static bool
+join(std::vector<Range> & into, const std::vector<Range> & from, const std::vector<uint64_t> & variable_max, bool widen)
+{
+    bool changed = false;
+    for (size_t i = 0; i < into.size(); i++) {
+	if (from[i].lo < into[i].lo) {
+	    into[i].lo = widen ? 0 : from[i].lo;
+	    changed = true;
+	}
+	if (from[i].hi > into[i].hi) {
+	    into[i].hi = widen ? variable_max[i] : from[i].hi;
+	    changed = true;
+	}
+    }
+    return changed;
+}
+
+//////////////////////////////////////////////
+// Range
+//////////////////////////////////////////////
+Range::Range()
+    : lo(0)
+    , hi(0)
+{}
+
+Range::Range(uint64_t _lo, uint64_t _hi)
+    : lo(_lo)
+    , hi(_hi)
+{}
+
+Range::Range(const Range & other)
+    : lo(other.lo)
+    , hi(other.hi)
+{}
+
+Range::~Range()
+{}
+
+Range &
+Range::operator=(const Range & other)
+{
+    lo = other.lo;
+    hi = other.hi;
+    return *this;
+}
+
+//////////////////////////////////////////////
+// RangeWalker
+//////////////////////////////////////////////
+RangeWalker::RangeWalker(
+    const Function & _function,
+    const Liveness & _liveness,
+    const std::vector<uint64_t> & _variable_max,
+    const std::vector<bool> & _tracked
+    )
+    : function(_function)
+    , liveness(_liveness)
+    , variable_max(_variable_max)
+    , tracked(_tracked)
+    , versions(_variable_max.size(), 0)
+    , stamp(0)
+    , tmpvar_stamps(_function.tmpvar_count(), 0)
+    , tmpvar_ranges(_function.tmpvar_count())
+    , tmpvar_known(_function.tmpvar_count(), false)
+    , tmpvar_loaded_from(_function.tmpvar_count(), none)
+    , tmpvar_loaded_version(_function.tmpvar_count(), 0)
+{}
+
+RangeWalker::~RangeWalker()
+{}
+
+void
+RangeWalker::start(const std::vector<Range> & _variables)
+{
+    variables = _variables;
+    stamp++;
+}
+
+const std::vector<Range> &
+RangeWalker::get_variables() const
+{ return variables; }
+
+bool
+RangeWalker::defined_here(size_t tmpvar) const
+{ return tmpvar < tmpvar_stamps.size() && tmpvar_stamps[tmpvar] == stamp; }
+
+size_t
+RangeWalker::loaded_variable(size_t tmpvar) const
+{
+    if (!defined_here(tmpvar)) {
+	return none;
+    }
+    size_t variable = tmpvar_loaded_from[tmpvar];
+    // If the variable has been assigned since it was
+    // loaded, the tmpvar no longer holds its value.
+    if (variable == none || tmpvar_loaded_version[tmpvar] != versions[variable]) {
+	return none;
+    }
+    return variable;
+}
+
+void
+RangeWalker::set_range(size_t tmpvar, const Range & range)
+{
+    tmpvar_ranges[tmpvar] = range;
+    tmpvar_known[tmpvar] = true;
+}
+
+bool
+RangeWalker::tmpvar_range(size_t tmpvar, Range & range) const
+{
+    if (tmpvar >= tmpvar_stamps.size()) {
+	return false;
+    }
+    if (defined_here(tmpvar) && tmpvar_known[tmpvar]) {
+	range = tmpvar_ranges[tmpvar];
+	return true;
+    }
+    // Anything else could hold any value of its type.
+    uint64_t max;
+    if (!unsigned_max(function.tmpvar_get(tmpvar), max)) {
+	return false;
+    }
+    range = Range(0, max);
+    return true;
+}
+
+void
+RangeWalker::step(const Operation & operation)
+{
+    if (!operation.has_result() || operation.get_result() >= tmpvar_stamps.size()) {
+	return;
+    }
+    size_t result = operation.get_result();
+    tmpvar_stamps[result] = stamp;
+    tmpvar_known[result] = false;
+    tmpvar_loaded_from[result] = none;
+
+    uint64_t max;
+    const std::vector<size_t> & operands = operation.get_operands();
+    switch (operation.get_type()) {
+    case Operation::OP_LITERAL_INT:
+	{
+	    uint64_t value;
+	    if (literal_value((const OperationLiteralInt &)operation, value)) {
+		set_range(result, Range(value, value));
+	    }
+	}
+	break;
+    case Operation::OP_LOCAL_VARIABLE:
+	{
+	    size_t variable = liveness.get_variable(((const OperationLocalVariable &)operation).get_declaration_id());
+	    if (variable == liveness.get_variable_count() || !tracked[variable]) {
+		break;
+	    }
+	    set_range(result, variables[variable]);
+	    tmpvar_loaded_from[result] = variable;
+	    tmpvar_loaded_version[result] = versions[variable];
+	}
+	break;
+    case Operation::OP_ASSIGN:
+	{
+	    // Whether or not the variable has changed since
+	    // its place was loaded, this is where it is written.
+	    size_t variable = none;
+	    const Operation *place = function.tmpvar_get_operation(operands.at(0));
+	    if (place != nullptr && place->get_type() == Operation::OP_LOCAL_VARIABLE) {
+		variable = liveness.get_variable(((const OperationLocalVariable *)place)->get_declaration_id());
+		if (variable == liveness.get_variable_count() || !tracked[variable]) {
+		    variable = none;
+		}
+	    }
+	    Range b;
+	    bool known = tmpvar_range(operands.at(1), b);
+	    if (variable != none) {
+		variables[variable] = known ? b : Range(0, variable_max[variable]);
+		versions[variable]++;
+	    }
+	    if (known) {
+		set_range(result, b);
+	    }
+	}
+	break;
+    case Operation::OP_WIDEN_UNSIGNED:
+	{
+	    Range a;
+	    if (tmpvar_range(operands.at(0), a)) {
+		set_range(result, a);
+	    }
+	}
+	break;
+    case Operation::OP_ADD:
+    case Operation::OP_SUBTRACT:
+    case Operation::OP_MULTIPLY:
+    case Operation::OP_DIVIDE:
+    case Operation::OP_MODULO:
+    case Operation::OP_BITWISE_AND:
+    case Operation::OP_SHIFT_RIGHT:
+    case Operation::OP_SHIFT_LEFT:
+	{
+	    Range a;
+	    Range b;
+	    Range r;
+	    if (unsigned_max(function.tmpvar_get(result), max) &&
+		tmpvar_range(operands.at(0), a) &&
+		tmpvar_range(operands.at(1), b) &&
+		arithmetic_range(operation.get_type(), a, b, max, r)) {
+		set_range(result, r);
+	    }
+	}
+	break;
+    default:
+	break;
+    }
+}
+
+bool
+RangeWalker::refine(const OperationJumpConditional & jump, bool taken, std::vector<Range> & state) const
+{
+    size_t condition = jump.get_operands().at(0);
+    if (!defined_here(condition)) {
+	return true;
+    }
+    const Operation *compare = function.tmpvar_get_operation(condition);
+    if (compare == nullptr) {
+	return true;
+    }
+    Operation::OperationType type = compare->get_type();
+    if (type != Operation::OP_COMPARE_LESS &&
+	type != Operation::OP_COMPARE_LESS_EQUAL &&
+	type != Operation::OP_COMPARE_GREATER &&
+	type != Operation::OP_COMPARE_GREATER_EQUAL &&
+	type != Operation::OP_COMPARE_EQUAL &&
+	type != Operation::OP_COMPARE_NOT_EQUAL) {
+	return true;
+    }
+    if (!taken) {
+	type = negate_compare(type);
+    }
+
+    // Narrow whichever side is a variable by the
+    // range of the other side.
+    size_t a = compare->get_operands().at(0);
+    size_t b = compare->get_operands().at(1);
+    Range range;
+    size_t variable = loaded_variable(a);
+    if (variable != none && tmpvar_range(b, range)) {
+	if (!narrow(type, state[variable], range)) {
+	    return false;
+	}
+    }
+    variable = loaded_variable(b);
+    if (variable != none && tmpvar_range(a, range)) {
+	if (!narrow(swap_compare(type), state[variable], range)) {
+	    return false;
+	}
+    }
+    return true;
+}
+
+//////////////////////////////////////////////
+// ValueRanges
+//////////////////////////////////////////////
+ValueRanges::ValueRanges(const Function & _function, const Liveness & _liveness)
+    : function(_function)
+    , liveness(_liveness)
+    , checks_kept(0)
+    , checks_eliminated(0)
+{
+    // Only unsigned integer variables
+    // whose address is never taken are tracked.
+    size_t nvariables = liveness.get_variable_count();
+    std::vector<uint64_t> variable_max(nvariables, 0);
+    std::vector<bool> tracked(nvariables, false);
+    for (const auto & block_it : function.get_blocks()) {
+	for (const auto & operation : block_it.second->get_operations()) {
+	    if (operation->get_type() != Operation::OP_LOCAL_DECLARE) {
+		continue;
+	    }
+	    const OperationLocalDeclare & declare = (const OperationLocalDeclare &)*operation;
+	    size_t variable = liveness.get_variable(declare.get_declaration_id());
+	    if (variable == nvariables) {
+		continue;
+	    }
+	    tracked[variable] =
+		unsigned_max(declare.get_variable_type(), variable_max[variable]) &&
+		!liveness.is_address_taken(variable);
+	}
+    }
+
+    const CFGInfo & cfg = function.get_cfg_info();
+    const std::vector<size_t> & rpo = cfg.get_reverse_post_order();
+    std::vector<size_t> order_index(cfg.get_block_limit(), 0);
+    for (size_t i = 0; i < rpo.size(); i++) {
+	order_index[rpo[i]] = i;
+    }
+
+    // Nothing is known about any variable
+    // on entry to the function.
+    std::vector<std::vector<Range>> block_in(cfg.get_block_limit());
+    std::vector<bool> reached(cfg.get_block_limit(), false);
+    block_in[0].resize(nvariables);
+    for (size_t variable = 0; variable < nvariables; variable++) {
+	block_in[0][variable] = Range(0, variable_max[variable]);
+    }
+    reached[0] = true;
+
+    RangeWalker walker(function, liveness, variable_max, tracked);
+    BitSet pending(rpo.size());
+    pending.set(0);
+    std::vector<Range> edge;
+    for (size_t i = pending.find_next(0); i < pending.size(); i = pending.find_next(0)) {
+	pending.reset(i);
+	size_t blockid = rpo[i];
+	const std::vector<Gyoji::owned<Operation>> & operations = function.get_basic_block(blockid).get_operations();
+	walker.start(block_in[blockid]);
+	for (const auto & operation : operations) {
+	    walker.step(*operation);
+	}
+	if (operations.size() == 0) {
+	    continue;
+	}
+
+	const Operation & terminator = *operations.back();
+	std::vector<std::pair<size_t, bool>> successors;
+	if (terminator.get_type() == Operation::OP_JUMP) {
+	    successors.push_back(std::pair(((const OperationJump &)terminator).get_jump_block(), true));
+	}
+	else if (terminator.get_type() == Operation::OP_JUMP_CONDITIONAL) {
+	    const OperationJumpConditional & jump = (const OperationJumpConditional &)terminator;
+	    successors.push_back(std::pair(jump.get_if_block(), true));
+	    successors.push_back(std::pair(jump.get_else_block(), false));
+	}
+	for (const auto & successor : successors) {
+	    size_t to = successor.first;
+	    edge = walker.get_variables();
+	    if (terminator.get_type() == Operation::OP_JUMP_CONDITIONAL &&
+		!walker.refine((const OperationJumpConditional &)terminator, successor.second, edge)) {
+		// This edge can never be taken.
+		continue;
+	    }
+	    bool changed;
+	    if (!reached[to]) {
+		block_in[to] = edge;
+		reached[to] = true;
+		changed = true;
+	    }
+	    else {
+		// Widen around the back edges of loops.
+		changed = join(block_in[to], edge, variable_max, order_index[to] <= i);
+	    }
+	    if (changed) {
+		pending.set(order_index[to]);
+	    }
+	}
+    }
+
+    // Now that the ranges have settled, check the
+    // index of each array access against the length
+    // of the array.
+    in_bounds.resize(cfg.get_block_limit());
+    for (size_t blockid : rpo) {
+	const std::vector<Gyoji::owned<Operation>> & operations = function.get_basic_block(blockid).get_operations();
+	in_bounds[blockid].resize(operations.size(), false);
+	if (reached[blockid]) {
+	    walker.start(block_in[blockid]);
+	}
+	for (size_t i = 0; i < operations.size(); i++) {
+	    const Operation & operation = *operations.at(i);
+	    if (operation.get_type() == Operation::OP_ARRAY_INDEX) {
+		const OperationArrayIndex & index = (const OperationArrayIndex &)operation;
+		const Type *array_type = function.tmpvar_get(index.get_a());
+		Range range;
+		bool safe;
+		if (!reached[blockid]) {
+		    // No path reaches this access, so
+		    // it can't be out of bounds.
+		    safe = true;
+		}
+		else {
+		    safe = array_type->is_array() &&
+			walker.tmpvar_range(index.get_b(), range) &&
+			range.hi < array_type->get_array_length();
+		}
+		in_bounds[blockid][i] = safe;
+		if (safe) {
+		    checks_eliminated++;
+		}
+		else {
+		    checks_kept++;
+		}
+	    }
+	    if (reached[blockid]) {
+		walker.step(operation);
+	    }
+	}
+    }
+}
+
+ValueRanges::~ValueRanges()
+{}
+
+bool
+ValueRanges::is_index_in_bounds(size_t blockid, size_t operation_index) const
+{
+    if (blockid >= in_bounds.size() || operation_index >= in_bounds[blockid].size()) {
+	return false;
+    }
+    return in_bounds[blockid][operation_index];
+}
+
+size_t
+ValueRanges::get_checks_kept() const
+{ return checks_kept; }
+
+size_t
+ValueRanges::get_checks_eliminated() const
+{ return checks_eliminated; }
@@ -0,0 +1,337 @@
+/* Copyright 2025 Jonathan S. Arney
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      https://github.com/jarney/gyoji/blob/master/LICENSE
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#include <gyoji-mir.hpp>
+#include <algorithm>
+
+using namespace Gyoji::mir;
+
+// Each entry of a std::map is its own node holding
+// the entry along with the color and three links
+// of the red-black tree.
+static const size_t map_node_overhead = 4 * sizeof(void*);
+
+static std::string
+type_kind_name(const Type & type)
+{
+    if (type.is_primitive()) {
+	return std::string("primitive");
+    }
+    switch (type.get_type()) {
+    case Type::TYPE_COMPOSITE:
+	return std::string("composite");
+    case Type::TYPE_ANONYMOUS_STRUCTURE:
+	return std::string("anonymous-structure");
+    case Type::TYPE_POINTER:
+	return std::string("pointer");
+    case Type::TYPE_FUNCTION_POINTER:
+	return std::string("function-pointer");
+    case Type::TYPE_REFERENCE:
+	return std::string("reference");
+    case Type::TYPE_ENUM:
+	return std::string("enum");
+    case Type::TYPE_ARRAY:
+	return std::string("array");
+    default:
+	return std::string("other");
+    }
+}
+
+// Function names are mangled names which can
+// contain characters like ':' and '<', but
+// we escape everything JSON requires just in case.
+static std::string
+json_string(const std::string & value)
+{
+    std::string escaped("\"");
+    for (char c : value) {
+	if (c == '"' || c == '\\') {
+	    escaped += '\\';
+	    escaped += c;
+	}
+	else if ((unsigned char)c < 0x20) {
+	    char buf[8];
+	    snprintf(buf, sizeof(buf), "\\u%04x", (unsigned int)(unsigned char)c);
+	    escaped += buf;
+	}
+	else {
+	    escaped += c;
+	}
+    }
+    escaped += '"';
+    return escaped;
+}
+
+/////////////////////////////////////
+// FunctionStats
+/////////////////////////////////////
+FunctionStats::FunctionStats(const Function & function)
+    : name(function.get_name())
+    , blocks(0)
+    , operations(0)
+    , tmpvars(function.tmpvar_count())
+    , max_operands(0)
+    , bytes(0)
+    , bounds_checks_kept(0)
+    , bounds_checks_eliminated(0)
+    , cleanup_operations_shared(function.get_shared_cleanup_operations())
+{
+    bytes += sizeof(Function) + function.get_name().capacity();
+    bytes += function.get_arguments().capacity() * sizeof(FunctionArgument);
+    // Each tmpvar has its type and, usually, an entry
+    // for the operation that produces it.
+    bytes += tmpvars * sizeof(const Type*);
+    bytes += tmpvars * (sizeof(std::pair<const size_t, Operation*>) + map_node_overhead);
+
+    for (const auto & block_it : function.get_blocks()) {
+	const BasicBlock & block = *block_it.second;
+	blocks++;
+	bytes += sizeof(std::pair<const size_t, Gyoji::owned<BasicBlock>>) + map_node_overhead;
+	bytes += sizeof(BasicBlock);
+	bytes += block.get_operations().capacity() * sizeof(Gyoji::owned<Operation>);
+	for (const auto & operation : block.get_operations()) {
+	    const std::vector<size_t> & operands = operation->get_operands();
+	    operations++;
+	    operations_by_type[operation->get_type()]++;
+	    max_operands = std::max(max_operands, operands.size());
+	    bytes += sizeof(Operation) + operands.capacity() * sizeof(size_t);
+	}
+    }
+
+    Liveness liveness(function);
+    ValueRanges ranges(function, liveness);
+    bounds_checks_kept = ranges.get_checks_kept();
+    bounds_checks_eliminated = ranges.get_checks_eliminated();
+}
+
+FunctionStats::FunctionStats(std::string _name)
+    : name(_name)
+    , blocks(0)
+    , operations(0)
+    , tmpvars(0)
+    , max_operands(0)
+    , bytes(0)
+    , bounds_checks_kept(0)
+    , bounds_checks_eliminated(0)
+    , cleanup_operations_shared(0)
+{}
+
+FunctionStats::~FunctionStats()
+{}
+
+void
+FunctionStats::add(const FunctionStats & other)
+{
+    blocks += other.blocks;
+    operations += other.operations;
+    for (const auto & it : other.operations_by_type) {
+	operations_by_type[it.first] += it.second;
+    }
+    tmpvars += other.tmpvars;
+    max_operands = std::max(max_operands, other.max_operands);
+    bytes += other.bytes;
+    bounds_checks_kept += other.bounds_checks_kept;
+    bounds_checks_eliminated += other.bounds_checks_eliminated;
+    cleanup_operations_shared += other.cleanup_operations_shared;
+}
+
+const std::string &
+FunctionStats::get_name() const
+{ return name; }
+
+size_t
+FunctionStats::get_blocks() const
+{ return blocks; }
+
+size_t
+FunctionStats::get_operations() const
+{ return operations; }
+
+const std::map<Operation::OperationType, size_t> &
+FunctionStats::get_operations_by_type() const
+{ return operations_by_type; }
+
+size_t
+FunctionStats::get_tmpvars() const
+{ return tmpvars; }
+
+size_t
+FunctionStats::get_max_operands() const
+{ return max_operands; }
+
+size_t
+FunctionStats::get_bytes() const
+{ return bytes; }
+
+size_t
+FunctionStats::get_bounds_checks_kept() const
+{ return bounds_checks_kept; }
+
+size_t
+FunctionStats::get_bounds_checks_eliminated() const
+{ return bounds_checks_eliminated; }
+
+size_t
+FunctionStats::get_cleanup_operations_shared() const
+{ return cleanup_operations_shared; }
+
+/////////////////////////////////////
+// MIRStats
+/////////////////////////////////////
+MIRStats::MIRStats(const MIR & mir)
+    : total("total")
+    , types(0)
+    , types_bytes(0)
+    , tokens(0)
+    , token_stream_bytes(0)
+    , syntax_tree_bytes(0)
+{
+    for (const auto & function : mir.get_functions().get_functions()) {
+	functions.push_back(FunctionStats(*function));
+	total.add(functions.back());
+    }
+
+    for (const auto & type_it : mir.get_types().get_types()) {
+	const Type & type = *type_it.second;
+	types++;
+	types_by_kind[type_kind_name(type)]++;
+	types_bytes += sizeof(std::pair<const std::string, Gyoji::owned<Type>>) + map_node_overhead;
+	types_bytes += type_it.first.capacity() + sizeof(Type) + type.get_name().capacity();
+	types_bytes += type.get_members().capacity() * sizeof(TypeMember);
+	types_bytes += type.get_argument_types().capacity() * sizeof(Argument);
+    }
+}
+
+MIRStats::~MIRStats()
+{}
+
+void
+MIRStats::set_token_stream(size_t _tokens, size_t _bytes)
+{
+    tokens = _tokens;
+    token_stream_bytes = _bytes;
+}
+
+void
+MIRStats::set_syntax_tree_bytes(size_t _bytes)
+{ syntax_tree_bytes = _bytes; }
+
+const std::vector<FunctionStats> &
+MIRStats::get_functions() const
+{ return functions; }
+
+const FunctionStats &
+MIRStats::get_total() const
+{ return total; }
+
+const std::map<std::string, size_t> &
+MIRStats::get_types_by_kind() const
+{ return types_by_kind; }
+
+static void
+print_function_row(FILE *out, const FunctionStats & stats)
+{
+    fprintf(out, "%-40s %8ld %8ld %8ld %8ld %10ld\n",
+	    stats.get_name().c_str(),
+	    stats.get_blocks(),
+	    stats.get_operations(),
+	    stats.get_tmpvars(),
+	    stats.get_max_operands(),
+	    stats.get_bytes());
+}
+
+void
+MIRStats::print_table(FILE *out) const
+{
+    fprintf(out, "%-40s %8s %8s %8s %8s %10s\n",
+	    "function", "blocks", "ops", "tmpvars", "operands", "bytes");
+    for (const auto & function : functions) {
+	print_function_row(out, function);
+    }
+    print_function_row(out, total);
+
+    fprintf(out, "\n%-40s %8s\n", "operation", "count");
+    for (const auto & it : total.get_operations_by_type()) {
+	fprintf(out, "%-40s %8ld\n",
+		Operation::get_type_name(it.first).c_str(),
+		it.second);
+    }
+
+    fprintf(out, "\n%-40s %8s\n", "type kind", "count");
+    for (const auto & it : types_by_kind) {
+	fprintf(out, "%-40s %8ld\n", it.first.c_str(), it.second);
+    }
+    fprintf(out, "%-40s %8ld\n", "total", types);
+
+    fprintf(out, "\n%-40s %8s\n", "bounds checks", "count");
+    fprintf(out, "%-40s %8ld\n", "kept", total.get_bounds_checks_kept());
+    fprintf(out, "%-40s %8ld\n", "eliminated", total.get_bounds_checks_eliminated());
+
+    fprintf(out, "\n%-40s %8s\n", "cleanup operations", "count");
+    fprintf(out, "%-40s %8ld\n", "shared", total.get_cleanup_operations_shared());
+
+    fprintf(out, "\n%-40s %10s\n", "memory (approximate)", "bytes");
+    fprintf(out, "%-40s %10ld\n", "MIR functions", total.get_bytes());
+    fprintf(out, "%-40s %10ld\n", "MIR types", types_bytes);
+    fprintf(out, "%-40s %10ld\n", (std::string("token stream (") + std::to_string(tokens) + std::string(" tokens)")).c_str(), token_stream_bytes);
+    fprintf(out, "%-40s %10ld\n", "syntax tree", syntax_tree_bytes);
+}
+
+static void
+print_function_json(FILE *out, const FunctionStats & stats)
+{
+    fprintf(out, "{\"name\": %s, \"blocks\": %ld, \"operations\": %ld, \"tmpvars\": %ld, \"max_operands\": %ld, \"bytes\": %ld, \"operations_by_type\": {",
+	    json_string(stats.get_name()).c_str(),
+	    stats.get_blocks(),
+	    stats.get_operations(),
+	    stats.get_tmpvars(),
+	    stats.get_max_operands(),
+	    stats.get_bytes());
+    const char *separator = "";
+    for (const auto & it : stats.get_operations_by_type()) {
+	fprintf(out, "%s%s: %ld",
+		separator,
+		json_string(Operation::get_type_name(it.first)).c_str(),
+		it.second);
+	separator = ", ";
+    }
+    fprintf(out, "}, \"bounds_checks\": {\"kept\": %ld, \"eliminated\": %ld}, \"cleanup_operations_shared\": %ld}",
+	    stats.get_bounds_checks_kept(),
+	    stats.get_bounds_checks_eliminated(),
+	    stats.get_cleanup_operations_shared());
+}
+
+void
+MIRStats::print_json(FILE *out) const
+{
+    fprintf(out, "{\n  \"functions\": [");
+    const char *separator = "\n    ";
+    for (const auto & function : functions) {
+	fprintf(out, "%s", separator);
+	print_function_json(out, function);
+	separator = ",\n    ";
+    }
+    fprintf(out, "\n  ],\n  \"total\": ");
+    print_function_json(out, total);
+    fprintf(out, ",\n  \"types\": {\"count\": %ld, \"bytes\": %ld, \"by_kind\": {", types, types_bytes);
+    separator = "";
+    for (const auto & it : types_by_kind) {
+	fprintf(out, "%s%s: %ld", separator, json_string(it.first).c_str(), it.second);
+	separator = ", ";
+    }
+    fprintf(out, "}},\n");
+    fprintf(out, "  \"token_stream\": {\"tokens\": %ld, \"bytes\": %ld},\n", tokens, token_stream_bytes);
+    fprintf(out, "  \"syntax_tree\": {\"bytes\": %ld}\n", syntax_tree_bytes);
+    fprintf(out, "}\n");
+}
@@ -17,10 +17,12 @@
 using namespace Gyoji::mir;
 
 Symbol::Symbol(
-    std::string _name,
+    Gyoji::context::Atom _name,
+    const std::string & _name_string,
     SymbolType _type,
     const Type *_mir_type)
     : name(_name)
+    , name_string(_name_string)
     , type(_type)
     , mir_type(_mir_type)
 {}
@@ -28,8 +30,12 @@ Symbol::Symbol(
 Symbol::~Symbol()
 {}
 
-std::string
+const std::string &
 Symbol::get_name() const
+{ return name_string; }
+
+Gyoji::context::Atom
+Symbol::get_name_atom() const
 { return name; }
 
 const Type *
@@ -41,7 +47,8 @@ Symbol::get_type() const
 { return type; }
 
 
-Symbols::Symbols()
+Symbols::Symbols(Gyoji::context::AtomTable & _atoms)
+    : atoms(_atoms)
 {}
 
 Symbols::~Symbols()
@@ -53,11 +60,12 @@ Symbols::define_symbol(
     Symbol::SymbolType type,
     const Type *mir_type)
 {
-    const auto & it = symbols.find(name);
+    Gyoji::context::Atom atom = atoms.intern(name);
+    const auto & it = symbols.find(atom);
     if (it != symbols.end()) {
 	return;
     }
-    symbols.insert(std::pair(name, Gyoji::owned_new<Symbol>(name, type, mir_type)));
+    symbols.insert(std::pair(atom, Gyoji::owned_new<Symbol>(atom, atoms.get_string(atom), type, mir_type)));
 }
 
 void
@@ -87,6 +95,16 @@ Symbols::dump(FILE *out) const
 
 const Symbol *
 Symbols::get_symbol(std::string name) const
+{
+    Gyoji::context::Atom atom;
+    if (!atoms.find(name, atom)) {
+	return nullptr;
+    }
+    return get_symbol(atom);
+}
+
+const Symbol *
+Symbols::get_symbol(Gyoji::context::Atom name) const
 {
     const auto & it = symbols.find(name);
     if (it == symbols.end()) {
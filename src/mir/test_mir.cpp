@@ -0,0 +1,515 @@
+/* Copyright 2025 Jonathan S. Arney
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      https://github.com/jarney/gyoji/blob/master/LICENSE
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#include <gyoji-mir.hpp>
+#include <gyoji-misc/test.hpp>
+
+using namespace Gyoji::mir;
+using namespace Gyoji::context;
+
+static const SourceReference zero_source_ref("internal", 1, 0, 0);
+
+int test_cfg_info();
+int test_liveness();
+int test_value_ranges();
+int test_constant_propagation();
+
+int main(int argc, char **argv)
+{
+    {
+	int rc = test_cfg_info();
+	if (rc != 0) {
+	    return rc;
+	}
+    }
+    {
+	int rc = test_liveness();
+	if (rc != 0) {
+	    return rc;
+	}
+    }
+    {
+	int rc = test_value_ranges();
+	if (rc != 0) {
+	    return rc;
+	}
+    }
+    {
+	int rc = test_constant_propagation();
+	if (rc != 0) {
+	    return rc;
+	}
+    }
+    printf("PASSED\n");
+    return 0;
+}
+
+/**
+ * A loop with a nested loop inside of it,
+ * followed by a block nothing jumps to:
+ *
+ *   0 -> 1
+ *   1 -> 2, 5      (outer loop header)
+ *   2 -> 3
+ *   3 -> 3, 4      (inner loop header, jumps to itself)
+ *   4 -> 1
+ *   5 return
+ *   6 -> 5         (unreachable)
+ */
+int test_cfg_info()
+{
+    Types types;
+    std::vector<FunctionArgument> arguments;
+    Function function("test_cfg_info", types.get_type("void"), arguments, false, zero_source_ref);
+    for (size_t i = 0; i < 7; i++) {
+	function.add_block();
+    }
+    size_t condition = function.tmpvar_define(types.get_type("bool"));
+    function.add_operation(0, Gyoji::owned_new<OperationLiteralBool>(zero_source_ref, condition, true));
+    function.add_operation(0, Gyoji::owned_new<OperationJump>(zero_source_ref, 1));
+    function.add_operation(1, Gyoji::owned_new<OperationJumpConditional>(zero_source_ref, condition, 2, 5));
+    function.add_operation(2, Gyoji::owned_new<OperationJump>(zero_source_ref, 3));
+    function.add_operation(3, Gyoji::owned_new<OperationJumpConditional>(zero_source_ref, condition, 3, 4));
+    function.add_operation(4, Gyoji::owned_new<OperationJump>(zero_source_ref, 1));
+    function.add_operation(5, Gyoji::owned_new<OperationReturnVoid>(zero_source_ref));
+    function.add_operation(6, Gyoji::owned_new<OperationJump>(zero_source_ref, 5));
+
+    const CFGInfo & cfg = function.get_cfg_info();
+    ASSERT_INT_EQUAL(7, cfg.get_block_limit(), "Every block is in the tables");
+    ASSERT_TRUE(cfg.is_reachable(5), "Exit block is reachable");
+    ASSERT_FALSE(cfg.is_reachable(6), "Nothing jumps to block 6");
+    ASSERT_INT_EQUAL(2, cfg.get_predecessors(1).size(), "Loop header has the entry and the latch as predecessors");
+    ASSERT_INT_EQUAL(1, cfg.get_predecessors(5).size(), "Unreachable blocks are not predecessors");
+    ASSERT_INT_EQUAL(6, cfg.get_reverse_post_order().size(), "Only reachable blocks are ordered");
+    ASSERT_INT_EQUAL(0, cfg.get_reverse_post_order().at(0), "Entry comes first");
+    ASSERT_TRUE(cfg.get_rpo_index(1) < cfg.get_rpo_index(2), "Header before its body");
+    ASSERT_TRUE(cfg.get_rpo_index(3) < cfg.get_rpo_index(4), "Inner loop before the latch");
+
+    ASSERT_INT_EQUAL(0, cfg.get_immediate_dominator(0), "Entry is its own dominator");
+    ASSERT_INT_EQUAL(0, cfg.get_immediate_dominator(1), "Header dominated by entry");
+    ASSERT_INT_EQUAL(1, cfg.get_immediate_dominator(5), "Exit dominated by the outer header");
+    ASSERT_INT_EQUAL(3, cfg.get_immediate_dominator(4), "Latch dominated by the inner loop");
+    ASSERT_INT_EQUAL(cfg.get_block_limit(), cfg.get_immediate_dominator(6), "Unreachable blocks have no dominator");
+    ASSERT_TRUE(cfg.dominates(1, 4), "Header dominates the latch");
+    ASSERT_TRUE(cfg.dominates(2, 2), "Blocks dominate themselves");
+    ASSERT_FALSE(cfg.dominates(2, 5), "The body doesn't dominate the exit");
+    ASSERT_FALSE(cfg.dominates(6, 5), "Unreachable blocks dominate nothing");
+
+    ASSERT_TRUE(cfg.is_loop_header(1), "Outer loop header");
+    ASSERT_TRUE(cfg.is_loop_header(3), "Inner loop header");
+    ASSERT_FALSE(cfg.is_loop_header(2), "Loop body is not a header");
+    ASSERT_INT_EQUAL(0, cfg.get_loop_depth(0), "Entry is outside of the loops");
+    ASSERT_INT_EQUAL(1, cfg.get_loop_depth(1), "Outer header");
+    ASSERT_INT_EQUAL(1, cfg.get_loop_depth(2), "Outer body");
+    ASSERT_INT_EQUAL(2, cfg.get_loop_depth(3), "Inner loop");
+    ASSERT_INT_EQUAL(1, cfg.get_loop_depth(4), "Outer latch");
+    ASSERT_INT_EQUAL(0, cfg.get_loop_depth(5), "Exit is outside of the loops");
+
+    // Changing a terminator throws the cached facts away.
+    function.replace_operation(4, 0, Gyoji::owned_new<OperationJump>(zero_source_ref, 5));
+    const CFGInfo & changed = function.get_cfg_info();
+    ASSERT_FALSE(changed.is_loop_header(1), "No back edge to block 1 any more");
+    ASSERT_INT_EQUAL(0, changed.get_loop_depth(2), "Block 2 is no longer in a loop");
+    ASSERT_INT_EQUAL(1, changed.get_loop_depth(3), "Inner loop is still a loop");
+    return 0;
+}
+
+static size_t
+load_declaration(Function & function, size_t blockid, const AtomTable & atoms, Atom variable, size_t declaration_id, const Type *type)
+{
+    size_t tmpvar = function.tmpvar_define(type);
+    function.add_operation(blockid, Gyoji::owned_new<OperationLocalVariable>(zero_source_ref, tmpvar, atoms, variable, declaration_id, type));
+    return tmpvar;
+}
+
+// Most tests declare a name only once, so its
+// atom also serves as its declaration id.
+static size_t
+load_variable(Function & function, size_t blockid, const AtomTable & atoms, Atom variable, const Type *type)
+{ return load_declaration(function, blockid, atoms, variable, variable, type); }
+
+static size_t
+literal_u32(Function & function, size_t blockid, const Type *u32_type, unsigned int value)
+{
+    size_t tmpvar = function.tmpvar_define(u32_type);
+    function.add_operation(blockid, Gyoji::owned_new<OperationLiteralInt>(zero_source_ref, tmpvar, Type::TYPE_PRIMITIVE_u32, value));
+    return tmpvar;
+}
+
+static size_t
+assign(Function & function, size_t blockid, size_t destination, size_t value)
+{
+    size_t result = function.tmpvar_duplicate(destination);
+    function.add_operation(blockid, Gyoji::owned_new<OperationBinary>(Operation::OP_ASSIGN, zero_source_ref, result, destination, value));
+    return function.get_basic_block(blockid).get_operations().size() - 1;
+}
+
+static size_t
+array_element(Function & function, size_t blockid, const AtomTable & atoms, Atom variable, const Type *array_type, unsigned int index)
+{
+    const Type *u32_type = array_type->get_pointer_target();
+    size_t array = load_variable(function, blockid, atoms, variable, array_type);
+    size_t element_index = literal_u32(function, blockid, u32_type, index);
+    size_t element = function.tmpvar_define(u32_type);
+    function.add_operation(blockid, Gyoji::owned_new<OperationArrayIndex>(zero_source_ref, element, array, element_index));
+    return element;
+}
+
+static bool
+has_marker(const Liveness & liveness, size_t blockid, LiveRangeMarker::MarkerType type, size_t operation_index, size_t variable)
+{
+    for (const LiveRangeMarker & marker : liveness.get_markers(blockid)) {
+	if (marker.get_type() == type && marker.get_operation_index() == operation_index && marker.get_variable() == variable) {
+	    return true;
+	}
+    }
+    return false;
+}
+
+// Walks the blocks in reverse post-order until
+// nothing changes, keeping the variables started
+// along every path, and checks that every END is
+// reached only after a START.
+static bool
+markers_balanced(const Function & function, const Liveness & liveness)
+{
+    const CFGInfo & cfg = function.get_cfg_info();
+    size_t nvariables = liveness.get_variable_count();
+    std::vector<std::vector<bool>> started_out(cfg.get_block_limit(), std::vector<bool>(nvariables, true));
+    bool changed = true;
+    while (changed) {
+	changed = false;
+	for (size_t blockid : cfg.get_reverse_post_order()) {
+	    std::vector<bool> started(nvariables, blockid != 0);
+	    for (size_t predecessor : cfg.get_predecessors(blockid)) {
+		for (size_t variable = 0; variable < nvariables; variable++) {
+		    started[variable] = started[variable] && started_out[predecessor][variable];
+		}
+	    }
+	    for (const LiveRangeMarker & marker : liveness.get_markers(blockid)) {
+		if (marker.get_type() == LiveRangeMarker::START) {
+		    started[marker.get_variable()] = true;
+		}
+		else if (!started[marker.get_variable()]) {
+		    return false;
+		}
+		else {
+		    started[marker.get_variable()] = false;
+		}
+	    }
+	    if (started != started_out[blockid]) {
+		started_out[blockid] = started;
+		changed = true;
+	    }
+	}
+    }
+    return true;
+}
+
+int test_liveness()
+{
+    AtomTable atoms;
+    Atom a = atoms.intern("a");
+    Atom x = atoms.intern("x");
+    Types types;
+    const Type *u32_type = types.get_type("u32");
+    const Type *array_type = types.get_array_of(u32_type, 4, zero_source_ref);
+    std::vector<FunctionArgument> arguments;
+
+    // x = 1; x = 2; return x;
+    // The first store is never read.
+    {
+	Function function("dead_store", u32_type, arguments, false, zero_source_ref);
+	size_t entry = function.add_block();
+	function.add_operation(entry, Gyoji::owned_new<OperationLocalDeclare>(zero_source_ref, atoms, x, x, u32_type));
+	size_t first = assign(function, entry, load_variable(function, entry, atoms, x, u32_type), literal_u32(function, entry, u32_type, 1));
+	size_t second = assign(function, entry, load_variable(function, entry, atoms, x, u32_type), literal_u32(function, entry, u32_type, 2));
+	size_t value = load_variable(function, entry, atoms, x, u32_type);
+	size_t load = function.get_basic_block(entry).get_operations().size() - 1;
+	function.add_operation(entry, Gyoji::owned_new<OperationLocalUndeclare>(zero_source_ref, atoms, x, x));
+	function.add_operation(entry, Gyoji::owned_new<OperationReturn>(zero_source_ref, value));
+
+	Liveness liveness(function);
+	size_t variable = liveness.get_variable(x);
+	ASSERT_INT_EQUAL(1, liveness.get_dead_stores().size(), "One dead store");
+	ASSERT_INT_EQUAL(entry, liveness.get_dead_stores().at(0).first, "Dead store block");
+	ASSERT_INT_EQUAL(first, liveness.get_dead_stores().at(0).second, "The first store is dead");
+	ASSERT_FALSE(has_marker(liveness, entry, LiveRangeMarker::START, 1, variable), "Not live after the declaration");
+	ASSERT_TRUE(has_marker(liveness, entry, LiveRangeMarker::START, second, variable), "Starts at the store that is read");
+	ASSERT_TRUE(has_marker(liveness, entry, LiveRangeMarker::END, load+1, variable), "Ends after the last use");
+	ASSERT_TRUE(markers_balanced(function, liveness), "Every end has a start");
+
+	function.mark_dead_store(entry, first);
+	ASSERT_TRUE(function.get_basic_block(entry).get_operations().at(first)->is_dead_store(), "Marked dead");
+	ASSERT_FALSE(function.get_basic_block(entry).get_operations().at(second)->is_dead_store(), "Still stored");
+    }
+
+    // u32[4] a; while (c) { a[0] = 1; } return a[0];
+    // The array is never assigned as a whole, so it
+    // has to start just after it is declared.
+    {
+	Function function("partial", u32_type, arguments, false, zero_source_ref);
+	size_t entry = function.add_block();
+	size_t header = function.add_block();
+	size_t body = function.add_block();
+	size_t after = function.add_block();
+	function.add_operation(entry, Gyoji::owned_new<OperationLocalDeclare>(zero_source_ref, atoms, a, a, array_type));
+	size_t condition = function.tmpvar_define(types.get_type("bool"));
+	function.add_operation(entry, Gyoji::owned_new<OperationLiteralBool>(zero_source_ref, condition, true));
+	function.add_operation(entry, Gyoji::owned_new<OperationJump>(zero_source_ref, header));
+	function.add_operation(header, Gyoji::owned_new<OperationJumpConditional>(zero_source_ref, condition, body, after));
+	assign(function, body, array_element(function, body, atoms, a, array_type, 0), literal_u32(function, body, u32_type, 1));
+	function.add_operation(body, Gyoji::owned_new<OperationJump>(zero_source_ref, header));
+	size_t value = array_element(function, after, atoms, a, array_type, 0);
+	function.add_operation(after, Gyoji::owned_new<OperationLocalUndeclare>(zero_source_ref, atoms, a, a));
+	function.add_operation(after, Gyoji::owned_new<OperationReturn>(zero_source_ref, value));
+
+	Liveness liveness(function);
+	size_t variable = liveness.get_variable(a);
+	ASSERT_TRUE(has_marker(liveness, entry, LiveRangeMarker::START, 1, variable), "Starts after the declaration");
+	ASSERT_TRUE(liveness.get_live_in(header).test(variable), "Live around the loop");
+	ASSERT_INT_EQUAL(0, liveness.get_dead_stores().size(), "Storing an element isn't a dead store");
+	ASSERT_TRUE(markers_balanced(function, liveness), "Every end has a start");
+    }
+
+    // u32 y; { u32 x = 1; y = x; } { u32 x = y; return x; }
+    // The two declarations of x are different variables.
+    {
+	Atom y = atoms.intern("y");
+	size_t outer_x = 0;
+	size_t inner_x = 1;
+	size_t y_declaration = 2;
+	Function function("siblings", u32_type, arguments, false, zero_source_ref);
+	size_t entry = function.add_block();
+	function.add_operation(entry, Gyoji::owned_new<OperationLocalDeclare>(zero_source_ref, atoms, y, y_declaration, u32_type));
+	function.add_operation(entry, Gyoji::owned_new<OperationLocalDeclare>(zero_source_ref, atoms, x, outer_x, u32_type));
+	size_t first = assign(function, entry, load_declaration(function, entry, atoms, x, outer_x, u32_type), literal_u32(function, entry, u32_type, 1));
+	assign(function, entry,
+	       load_declaration(function, entry, atoms, y, y_declaration, u32_type),
+	       load_declaration(function, entry, atoms, x, outer_x, u32_type));
+	function.add_operation(entry, Gyoji::owned_new<OperationLocalUndeclare>(zero_source_ref, atoms, x, outer_x));
+	function.add_operation(entry, Gyoji::owned_new<OperationLocalDeclare>(zero_source_ref, atoms, x, inner_x, u32_type));
+	size_t second = assign(function, entry,
+			       load_declaration(function, entry, atoms, x, inner_x, u32_type),
+			       load_declaration(function, entry, atoms, y, y_declaration, u32_type));
+	size_t value = load_declaration(function, entry, atoms, x, inner_x, u32_type);
+	function.add_operation(entry, Gyoji::owned_new<OperationLocalUndeclare>(zero_source_ref, atoms, x, inner_x));
+	function.add_operation(entry, Gyoji::owned_new<OperationLocalUndeclare>(zero_source_ref, atoms, y, y_declaration));
+	function.add_operation(entry, Gyoji::owned_new<OperationReturn>(zero_source_ref, value));
+
+	Liveness liveness(function);
+	size_t first_variable = liveness.get_variable(outer_x);
+	size_t second_variable = liveness.get_variable(inner_x);
+	ASSERT_INT_EQUAL(3, liveness.get_variable_count(), "Each declaration is its own variable");
+	ASSERT_TRUE(first_variable != second_variable, "Same name, different variables");
+	ASSERT_INT_EQUAL(inner_x, liveness.get_variable_declaration_id(second_variable), "Declaration of the variable");
+	ASSERT_TRUE(has_marker(liveness, entry, LiveRangeMarker::START, first, first_variable), "The first starts where it is assigned");
+	ASSERT_TRUE(has_marker(liveness, entry, LiveRangeMarker::START, second, second_variable), "The second starts where it is assigned");
+	ASSERT_INT_EQUAL(0, liveness.get_dead_stores().size(), "Every store is read");
+	ASSERT_TRUE(markers_balanced(function, liveness), "Every end has a start");
+    }
+
+    return 0;
+}
+
+static size_t
+binary(Function & function, size_t blockid, Operation::OperationType type, const Type *result_type, size_t a, size_t b)
+{
+    size_t result = function.tmpvar_define(result_type);
+    function.add_operation(blockid, Gyoji::owned_new<OperationBinary>(type, zero_source_ref, result, a, b));
+    return result;
+}
+
+// Indexes the array with the given tmpvar and
+// returns the position of the array index.
+static size_t
+index_array(Function & function, size_t blockid, const AtomTable & atoms, Atom variable, const Type *array_type, size_t index)
+{
+    size_t array = load_variable(function, blockid, atoms, variable, array_type);
+    size_t element = function.tmpvar_define(array_type->get_pointer_target());
+    function.add_operation(blockid, Gyoji::owned_new<OperationArrayIndex>(zero_source_ref, element, array, index));
+    size_t position = function.get_basic_block(blockid).get_operations().size() - 1;
+    assign(function, blockid, element, literal_u32(function, blockid, array_type->get_pointer_target(), 0));
+    return position;
+}
+
+int test_value_ranges()
+{
+    AtomTable atoms;
+    Atom a = atoms.intern("a");
+    Atom i = atoms.intern("i");
+    Types types;
+    const Type *u32_type = types.get_type("u32");
+    const Type *bool_type = types.get_type("bool");
+    const Type *array_type = types.get_array_of(u32_type, 8, zero_source_ref);
+    std::vector<FunctionArgument> arguments;
+
+    // Literal indexes and shifts of them.
+    {
+	Function function("literals", types.get_type("void"), arguments, false, zero_source_ref);
+	size_t entry = function.add_block();
+	function.add_operation(entry, Gyoji::owned_new<OperationLocalDeclare>(zero_source_ref, atoms, a, a, array_type));
+	size_t in_bounds = index_array(function, entry, atoms, a, array_type, literal_u32(function, entry, u32_type, 7));
+	size_t past_end = index_array(function, entry, atoms, a, array_type, literal_u32(function, entry, u32_type, 8));
+	size_t shifted = binary(function, entry, Operation::OP_SHIFT_LEFT, u32_type,
+				literal_u32(function, entry, u32_type, 1),
+				literal_u32(function, entry, u32_type, 2));
+	size_t shift_left = index_array(function, entry, atoms, a, array_type, shifted);
+	shifted = binary(function, entry, Operation::OP_SHIFT_LEFT, u32_type,
+			 literal_u32(function, entry, u32_type, 1),
+			 literal_u32(function, entry, u32_type, 3));
+	size_t shift_left_past_end = index_array(function, entry, atoms, a, array_type, shifted);
+	shifted = binary(function, entry, Operation::OP_SHIFT_RIGHT, u32_type,
+			 literal_u32(function, entry, u32_type, 15),
+			 literal_u32(function, entry, u32_type, 1));
+	size_t shift_right = index_array(function, entry, atoms, a, array_type, shifted);
+	// Shifting a u32 by 40 isn't defined, so
+	// nothing is known about the result.
+	shifted = binary(function, entry, Operation::OP_SHIFT_RIGHT, u32_type,
+			 literal_u32(function, entry, u32_type, 15),
+			 literal_u32(function, entry, u32_type, 40));
+	size_t shift_too_far = index_array(function, entry, atoms, a, array_type, shifted);
+	function.add_operation(entry, Gyoji::owned_new<OperationReturnVoid>(zero_source_ref));
+
+	Liveness liveness(function);
+	ValueRanges ranges(function, liveness);
+	ASSERT_TRUE(ranges.is_index_in_bounds(entry, in_bounds), "Last element");
+	ASSERT_FALSE(ranges.is_index_in_bounds(entry, past_end), "Past the end");
+	ASSERT_TRUE(ranges.is_index_in_bounds(entry, shift_left), "1 << 2");
+	ASSERT_FALSE(ranges.is_index_in_bounds(entry, shift_left_past_end), "1 << 3");
+	ASSERT_TRUE(ranges.is_index_in_bounds(entry, shift_right), "15 >> 1");
+	ASSERT_FALSE(ranges.is_index_in_bounds(entry, shift_too_far), "Shifting by more than the width");
+	ASSERT_INT_EQUAL(3, ranges.get_checks_eliminated(), "Checks left out");
+	ASSERT_INT_EQUAL(3, ranges.get_checks_kept(), "Checks kept");
+    }
+
+    // u32 i = 0; while (i < 8) { a[i] = 0; i = i + 1; } a[i] = 0;
+    // The loop condition bounds the index inside of
+    // the loop, but not after it.
+    {
+	Function function("loop", types.get_type("void"), arguments, false, zero_source_ref);
+	size_t entry = function.add_block();
+	size_t header = function.add_block();
+	size_t body = function.add_block();
+	size_t after = function.add_block();
+	function.add_operation(entry, Gyoji::owned_new<OperationLocalDeclare>(zero_source_ref, atoms, a, a, array_type));
+	function.add_operation(entry, Gyoji::owned_new<OperationLocalDeclare>(zero_source_ref, atoms, i, i, u32_type));
+	assign(function, entry, load_variable(function, entry, atoms, i, u32_type), literal_u32(function, entry, u32_type, 0));
+	function.add_operation(entry, Gyoji::owned_new<OperationJump>(zero_source_ref, header));
+
+	size_t condition = binary(function, header, Operation::OP_COMPARE_LESS, bool_type,
+				  load_variable(function, header, atoms, i, u32_type),
+				  literal_u32(function, header, u32_type, 8));
+	function.add_operation(header, Gyoji::owned_new<OperationJumpConditional>(zero_source_ref, condition, body, after));
+
+	size_t in_loop = index_array(function, body, atoms, a, array_type, load_variable(function, body, atoms, i, u32_type));
+	size_t next = binary(function, body, Operation::OP_ADD, u32_type,
+			     load_variable(function, body, atoms, i, u32_type),
+			     literal_u32(function, body, u32_type, 1));
+	assign(function, body, load_variable(function, body, atoms, i, u32_type), next);
+	function.add_operation(body, Gyoji::owned_new<OperationJump>(zero_source_ref, header));
+
+	size_t after_loop = index_array(function, after, atoms, a, array_type, load_variable(function, after, atoms, i, u32_type));
+	function.add_operation(after, Gyoji::owned_new<OperationReturnVoid>(zero_source_ref));
+
+	Liveness liveness(function);
+	ValueRanges ranges(function, liveness);
+	ASSERT_TRUE(ranges.is_index_in_bounds(body, in_loop), "Bounded by the loop condition");
+	ASSERT_FALSE(ranges.is_index_in_bounds(after, after_loop), "Not bounded after the loop");
+    }
+
+    return 0;
+}
+
+int test_constant_propagation()
+{
+    AtomTable atoms;
+    Atom x = atoms.intern("x");
+    Types types;
+    const Type *u32_type = types.get_type("u32");
+    const Type *bool_type = types.get_type("bool");
+    std::vector<FunctionArgument> arguments;
+
+    // if (2 + 3 < 10) { return 2 + 3; } else { return 0; }
+    {
+	Function function("branch", u32_type, arguments, false, zero_source_ref);
+	size_t entry = function.add_block();
+	size_t then_block = function.add_block();
+	size_t else_block = function.add_block();
+	size_t sum = binary(function, entry, Operation::OP_ADD, u32_type,
+			    literal_u32(function, entry, u32_type, 2),
+			    literal_u32(function, entry, u32_type, 3));
+	size_t condition = binary(function, entry, Operation::OP_COMPARE_LESS, bool_type,
+				  sum,
+				  literal_u32(function, entry, u32_type, 10));
+	function.add_operation(entry, Gyoji::owned_new<OperationJumpConditional>(zero_source_ref, condition, then_block, else_block));
+	function.add_operation(then_block, Gyoji::owned_new<OperationReturn>(zero_source_ref, sum));
+	function.add_operation(else_block, Gyoji::owned_new<OperationReturn>(zero_source_ref, literal_u32(function, else_block, u32_type, 0)));
+
+	ConstantPropagation constants(function);
+	ASSERT_TRUE(constants.is_constant(sum), "Sum of literals");
+	ASSERT_INT_EQUAL(5, constants.get_constant(sum), "2 + 3");
+	ASSERT_TRUE(constants.is_constant(condition), "Comparison of constants");
+	ASSERT_INT_EQUAL(1, constants.get_constant(condition), "5 < 10");
+	ASSERT_TRUE(constants.is_executable(then_block), "Branch taken");
+	ASSERT_FALSE(constants.is_executable(else_block), "Branch never taken");
+
+	constants.fold();
+	ASSERT_INT_EQUAL(1, constants.get_branches_resolved(), "Conditional jump resolved");
+	ASSERT_INT_EQUAL(1, constants.get_blocks_removed(), "Else block removed");
+	ASSERT_INT_EQUAL(2, function.get_blocks().size(), "Blocks left");
+	const BasicBlock & block = function.get_basic_block(entry);
+	ASSERT_INT_EQUAL(Operation::OP_JUMP, block.get_operations().back()->get_type(), "Jumps straight to the branch taken");
+	bool sum_folded = false;
+	for (const auto & operation : block.get_operations()) {
+	    if (operation->has_result() && operation->get_result() == sum) {
+		sum_folded = operation->get_type() == Operation::OP_LITERAL_INT;
+	    }
+	}
+	ASSERT_TRUE(sum_folded, "Sum replaced by a literal");
+	ASSERT_INT_EQUAL(2, block.get_operations().size(), "Only the sum and the jump are left");
+    }
+
+    // Loads of variables, division by zero, and shifts
+    // by the width of the type are never folded.
+    {
+	Function function("varying", u32_type, arguments, false, zero_source_ref);
+	size_t entry = function.add_block();
+	function.add_operation(entry, Gyoji::owned_new<OperationLocalDeclare>(zero_source_ref, atoms, x, x, u32_type));
+	assign(function, entry, load_variable(function, entry, atoms, x, u32_type), literal_u32(function, entry, u32_type, 1));
+	size_t loaded = binary(function, entry, Operation::OP_ADD, u32_type,
+			       load_variable(function, entry, atoms, x, u32_type),
+			       literal_u32(function, entry, u32_type, 1));
+	size_t divided = binary(function, entry, Operation::OP_DIVIDE, u32_type,
+				literal_u32(function, entry, u32_type, 1),
+				literal_u32(function, entry, u32_type, 0));
+	size_t shifted = binary(function, entry, Operation::OP_SHIFT_LEFT, u32_type,
+				literal_u32(function, entry, u32_type, 1),
+				literal_u32(function, entry, u32_type, 32));
+	size_t total = binary(function, entry, Operation::OP_ADD, u32_type,
+			      binary(function, entry, Operation::OP_ADD, u32_type, loaded, divided),
+			      shifted);
+	function.add_operation(entry, Gyoji::owned_new<OperationReturn>(zero_source_ref, total));
+
+	ConstantPropagation constants(function);
+	ASSERT_FALSE(constants.is_constant(loaded), "Variables aren't tracked");
+	ASSERT_FALSE(constants.is_constant(divided), "Division by zero");
+	ASSERT_FALSE(constants.is_constant(shifted), "Shift by the width of the type");
+	ASSERT_FALSE(constants.is_constant(total), "Sum of varying values");
+	constants.fold();
+	ASSERT_INT_EQUAL(0, constants.get_operations_folded(), "Nothing folded");
+    }
+
+    return 0;
+}
@@ -28,7 +28,7 @@ TypeMember::TypeMember(
     : member_name(_member_name)
     , index(_index)
     , member_type(_member_type)
-    , source_ref(&_source_ref)
+    , source_ref(_source_ref)
 {}
 TypeMember::TypeMember(const TypeMember & other)
     : member_name(other.member_name)
@@ -48,7 +48,7 @@ TypeMember::get_type() const
 { return member_type; }
 const Gyoji::context::SourceReference &
 TypeMember::get_source_ref() const
-{ return *source_ref; }
+{ return source_ref; }
 size_t
 TypeMember::get_index() const
 { return index; }
@@ -15,6 +15,7 @@
 #include <gyoji-mir/types.hpp>
 #include <variant>
 #include <stdio.h>
+#include <stdint.h>
 #include <gyoji-misc/jstring.hpp>
 
 using namespace Gyoji::context;
@@ -30,12 +31,13 @@ Type::Type(
     bool _complete,
     const SourceReference & _source_ref
     )
-    : name(_name)
+    : type_id(SIZE_MAX)
+    , name(_name)
     , simple_name(_simple_name)
     , type(_type)
     , complete(_complete)
-    , declared_source_ref(&_source_ref)
-    , defined_source_ref(&_source_ref)
+    , declared_source_ref(_source_ref)
+    , defined_source_ref(_source_ref)
     , pointer_or_ref(nullptr)
     , array_length(1)
     , return_type(nullptr)
@@ -50,12 +52,13 @@ Type::Type(
     bool _complete,
     const SourceReference & _source_ref
     )
-    : name(_name)
+    : type_id(SIZE_MAX)
+    , name(_name)
     , simple_name(_name)
     , type(_type)
     , complete(_complete)
-    , declared_source_ref(&_source_ref)
-    , defined_source_ref(&_source_ref)
+    , declared_source_ref(_source_ref)
+    , defined_source_ref(_source_ref)
     , pointer_or_ref(nullptr)
     , array_length(1)
     , return_type(nullptr)
@@ -69,12 +72,13 @@ Type::Type(
     std::string _simple_name,
     const SourceReference & _source_ref,
     const Type & _other)
-    : name(_name)
+    : type_id(SIZE_MAX)
+    , name(_name)
     , simple_name(_simple_name)
     , type(_other.type)
     , complete(_other.complete)
-    , declared_source_ref(&_source_ref)
-    , defined_source_ref(&_source_ref)
+    , declared_source_ref(_source_ref)
+    , defined_source_ref(_source_ref)
     , pointer_or_ref(_other.pointer_or_ref)
     , array_length(_other.array_length)
     , return_type(_other.return_type)
@@ -245,6 +249,10 @@ Type::get_primitive_size() const
 Type::TypeType
 Type::get_type() const
 { return type; }
+
+TypeId
+Type::get_type_id() const
+{ return type_id; }
 const std::string &
 Type::get_name() const
 { return name; }
@@ -328,7 +336,7 @@ Type::complete_pointer_definition(const Type *_type, const SourceReference & _so
 {
     complete = true;
     pointer_or_ref = _type;
-    defined_source_ref = &_source_ref;
+    defined_source_ref = _source_ref;
 }
 
 void
@@ -337,7 +345,7 @@ Type::complete_array_definition(const Type *_type, size_t _array_length, const G
     complete = true;
     pointer_or_ref = _type;
     array_length = _array_length;
-    defined_source_ref = &_source_ref;
+    defined_source_ref = _source_ref;
 }
 
 void
@@ -352,7 +360,7 @@ Type::complete_composite_definition(
     for (const TypeMember & member : members) {
 	members_by_name.insert(std::pair(member.get_name(), &member));
     }
-    defined_source_ref = &_source_ref;
+    defined_source_ref = _source_ref;
 }
 
 void
@@ -367,16 +375,16 @@ Type::complete_function_pointer_definition(
     return_type = _return_type;
     argument_types = _argument_types;
     m_is_unsafe = _is_unsafe;
-    defined_source_ref = &_source_ref;
+    defined_source_ref = _source_ref;
 }
 
 const SourceReference &
 Type::get_declared_source_ref() const
-{ return *declared_source_ref; }
+{ return declared_source_ref; }
 
 const SourceReference &
 Type::get_defined_source_ref() const
-{ return *defined_source_ref; }
+{ return defined_source_ref; }
 
 void
 Type::dump(FILE *out) const
@@ -454,7 +462,7 @@ Argument::Argument(
     const Gyoji::context::SourceReference & _source_ref
     )
     : argument_type(_argument_type)
-    , source_ref(&_source_ref)
+    , source_ref(_source_ref)
 {}
 Argument::Argument(const Argument & _other)
     : argument_type(_other.argument_type)
@@ -468,5 +476,5 @@ Argument::get_type() const
 
 const Gyoji::context::SourceReference &
 Argument::get_source_ref() const
-{ return *source_ref; }
+{ return source_ref; }
 
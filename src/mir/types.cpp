@@ -13,6 +13,7 @@
  *  limitations under the License.
  */
 #include <gyoji-mir/types.hpp>
+#include <gyoji-misc/jstring.hpp>
 #include <variant>
 #include <stdio.h>
 
@@ -54,6 +55,13 @@ Types::~Types()
 
 Type *
 Types::get_type(std::string type) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return find_type(type);
+}
+
+Type *
+Types::find_type(const std::string & type) const
 {
     const auto & it = type_map.find(type);
     if (it == type_map.end()) {
@@ -61,35 +69,71 @@ Types::get_type(std::string type) const
     }
     return it->second.get();
 }
+
+const Type *
+Types::get_type_by_id(TypeId type_id) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return types_by_id.at(type_id);
+}
+
+size_t
+Types::get_type_count() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return types_by_id.size();
+}
+
+const Type *
+Types::derived_type_find(const TypeKey & key) const
+{
+    const auto & it = derived_types.find(key);
+    if (it == derived_types.end()) {
+	return nullptr;
+    }
+    return types_by_id[it->second];
+}
+
+const Type *
+Types::derived_type_define(const TypeKey & key, Gyoji::owned<Type> type)
+{
+    // If something else already claimed this name,
+    // the derived type is the one with that name.
+    const Type *derived_type = insert_type(std::move(type));
+    derived_types.insert(std::pair(key, derived_type->get_type_id()));
+    return derived_type;
+}
+
 const Type *
 Types::get_pointer_to(const Type *_type, const SourceReference & src_ref)
 {
-    std::string pointer_type_name = _type->get_name() + std::string("*");
-    const Type* pointer_type = get_type(pointer_type_name);
+    static const std::vector<TypeId> no_arguments;
+    std::lock_guard<std::mutex> lock(mutex);
+    TypeKey key(Type::TYPE_POINTER, _type->get_type_id(), 0, false, no_arguments);
+    const Type* pointer_type = derived_type_find(key);
     if (pointer_type != nullptr) {
 	return pointer_type;
     }
+    std::string pointer_type_name = _type->get_name() + std::string("*");
     Gyoji::owned<Type> pointer_owned = Gyoji::owned_new<Type>(pointer_type_name, Type::TYPE_POINTER, false, src_ref);
-    pointer_type = pointer_owned.get();
     pointer_owned->complete_pointer_definition(_type, src_ref);
-    define_type(std::move(pointer_owned));
-    return pointer_type;
+    return derived_type_define(key, std::move(pointer_owned));
 }
 
 const Type *
 Types::get_reference_to(const Type *_type, const SourceReference & src_ref)
 {
-    std::string pointer_type_name = _type->get_name() + std::string("&");
-
-    const Type* pointer_type = get_type(pointer_type_name);
+    static const std::vector<TypeId> no_arguments;
+    std::lock_guard<std::mutex> lock(mutex);
+    TypeKey key(Type::TYPE_REFERENCE, _type->get_type_id(), 0, false, no_arguments);
+    const Type* pointer_type = derived_type_find(key);
     if (pointer_type != nullptr) {
 	return pointer_type;
     }
+    std::string pointer_type_name = _type->get_name() + std::string("&");
     Gyoji::owned<Type> pointer_owned = Gyoji::owned_new<Type>(pointer_type_name, Type::TYPE_REFERENCE, false, src_ref);
-    pointer_type = pointer_owned.get();
     pointer_owned->complete_pointer_definition(_type, src_ref);
-    define_type(std::move(pointer_owned));
-    return pointer_type;
+    return derived_type_define(key, std::move(pointer_owned));
 }
 
 const Type *
@@ -98,24 +142,69 @@ Types::get_array_of(
     size_t _length,
     const SourceReference & _src_ref)
 {
-    std::string array_type_name = _type->get_name() + std::string("[") + std::to_string(_length) + std::string("]");
-
-    const Type* array_type = get_type(array_type_name);
+    static const std::vector<TypeId> no_arguments;
+    std::lock_guard<std::mutex> lock(mutex);
+    TypeKey key(Type::TYPE_ARRAY, _type->get_type_id(), _length, false, no_arguments);
+    const Type* array_type = derived_type_find(key);
     if (array_type != nullptr) {
 	return array_type;
     }
+    std::string array_type_name = _type->get_name() + std::string("[") + std::to_string(_length) + std::string("]");
     Gyoji::owned<Type> array_owned = Gyoji::owned_new<Type>(array_type_name, Type::TYPE_ARRAY, false, _src_ref);
-    array_type = array_owned.get();
     array_owned->complete_array_definition(_type, _length, _src_ref);
-    define_type(std::move(array_owned));
-    return array_type;
+    return derived_type_define(key, std::move(array_owned));
 }
 
-void
+const Type *
+Types::get_function_pointer_to(
+    const Type *_return_type,
+    const std::vector<Argument> & _arguments,
+    bool _is_unsafe,
+    const SourceReference & _src_ref
+    )
+{
+    std::vector<TypeId> argument_ids;
+    for (const auto & argument : _arguments) {
+	argument_ids.push_back(argument.get_type()->get_type_id());
+    }
+    TypeKey key(Type::TYPE_FUNCTION_POINTER, _return_type->get_type_id(), 0, _is_unsafe, argument_ids);
+    std::lock_guard<std::mutex> lock(mutex);
+    const Type* fptr_type = derived_type_find(key);
+    if (fptr_type != nullptr) {
+	return fptr_type;
+    }
+
+    std::vector<std::string> arg_list;
+    for (const auto & argument : _arguments) {
+	arg_list.push_back(argument.get_type()->get_name());
+    }
+    std::string arg_string = Gyoji::misc::join(arg_list, ",");
+    std::string unsafe_str = _is_unsafe ? std::string("unsafe") : std::string("");
+    std::string fptr_type_name = _return_type->get_name() + std::string("(") + unsafe_str + std::string("*)") + std::string("(") + arg_string + std::string(")");
+
+    Gyoji::owned<Type> fptr_owned = Gyoji::owned_new<Type>(fptr_type_name, Type::TYPE_FUNCTION_POINTER, false, _src_ref);
+    fptr_owned->complete_function_pointer_definition(_return_type, _arguments, _is_unsafe, _src_ref);
+    return derived_type_define(key, std::move(fptr_owned));
+}
+
+Type *
 Types::define_type(Gyoji::owned<Type> type)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return insert_type(std::move(type));
+}
+
+Type *
+Types::insert_type(Gyoji::owned<Type> type)
 {
     std::string type_name = type->get_name();
-    type_map.insert(std::pair<std::string, Gyoji::owned<Type>>(type_name, std::move(type)));
+    Type *type_ptr = type.get();
+    const auto & inserted = type_map.insert(std::pair<std::string, Gyoji::owned<Type>>(type_name, std::move(type)));
+    if (inserted.second) {
+	type_ptr->type_id = types_by_id.size();
+	types_by_id.push_back(type_ptr);
+    }
+    return inserted.first->second.get();
 }
 
 const std::map<std::string, Gyoji::owned<Type>> &
@@ -131,3 +220,62 @@ Types::dump(FILE *out) const
     }
 }
 
+
+////////////////////////////////////////
+// TypeKey
+////////////////////////////////////////
+TypeKey::TypeKey(
+    size_t _kind,
+    TypeId _target,
+    size_t _length,
+    bool _is_unsafe,
+    const std::vector<TypeId> & _arguments
+    )
+    : kind(_kind)
+    , target(_target)
+    , length(_length)
+    , is_unsafe(_is_unsafe)
+    , arguments(_arguments)
+{}
+
+TypeKey::TypeKey(const TypeKey & _other)
+    : kind(_other.kind)
+    , target(_other.target)
+    , length(_other.length)
+    , is_unsafe(_other.is_unsafe)
+    , arguments(_other.arguments)
+{}
+
+TypeKey::~TypeKey()
+{}
+
+bool
+TypeKey::operator==(const TypeKey & _other) const
+{
+    return kind == _other.kind
+	&& target == _other.target
+	&& length == _other.length
+	&& is_unsafe == _other.is_unsafe
+	&& arguments == _other.arguments;
+}
+
+size_t
+TypeKey::hash() const
+{
+    // Boost-style hash_combine over each of the parts.
+    size_t h = std::hash<size_t>()(kind);
+    auto combine = [&h](size_t v) {
+	h ^= std::hash<size_t>()(v) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+    };
+    combine(target);
+    combine(length);
+    combine(is_unsafe ? 1 : 0);
+    for (TypeId argument : arguments) {
+	combine(argument);
+    }
+    return h;
+}
+
+size_t
+TypeKeyHash::operator()(const TypeKey & key) const
+{ return key.hash(); }
@@ -0,0 +1,133 @@
+/* Copyright 2025 Jonathan S. Arney
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      https://github.com/jarney/gyoji/blob/master/LICENSE
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#include <gyoji-misc/arena.hpp>
+#include <new>
+#include <stdlib.h>
+
+using namespace Gyoji::misc;
+
+// Everything handed out is aligned for any type.
+static const size_t arena_alignment = alignof(max_align_t);
+static const size_t arena_chunk_size = 64 * 1024;
+
+static thread_local Arena *current_arena = nullptr;
+
+static size_t
+align_up(size_t size)
+{ return (size + arena_alignment - 1) & ~(arena_alignment - 1); }
+
+/////////////////////////////////////
+// Arena
+/////////////////////////////////////
+Arena::Arena()
+    : next(nullptr)
+    , remaining(0)
+    , allocated(0)
+    , reserved(0)
+{}
+
+Arena::~Arena()
+{
+    for (char *chunk : chunks) {
+	::operator delete(chunk);
+    }
+}
+
+void *
+Arena::allocate(size_t size)
+{
+    size = align_up(size);
+    if (size > remaining) {
+	// Anything too big to share a chunk gets
+	// one of its own so the current chunk
+	// can still be filled.
+	if (size > arena_chunk_size / 4) {
+	    char *chunk = (char*)::operator new(size);
+	    chunks.push_back(chunk);
+	    reserved += size;
+	    allocated += size;
+	    return chunk;
+	}
+	next = (char*)::operator new(arena_chunk_size);
+	chunks.push_back(next);
+	remaining = arena_chunk_size;
+	reserved += arena_chunk_size;
+    }
+    void *ptr = next;
+    next += size;
+    remaining -= size;
+    allocated += size;
+    return ptr;
+}
+
+size_t
+Arena::get_allocated() const
+{ return allocated; }
+
+size_t
+Arena::get_footprint() const
+{ return reserved + chunks.capacity() * sizeof(char*); }
+
+Arena *
+Arena::get_current()
+{ return current_arena; }
+
+/////////////////////////////////////
+// ArenaScope
+/////////////////////////////////////
+ArenaScope::ArenaScope(Arena & _arena)
+    : previous(current_arena)
+{
+    current_arena = &_arena;
+}
+
+ArenaScope::~ArenaScope()
+{
+    current_arena = previous;
+}
+
+/////////////////////////////////////
+// ArenaAllocated
+/////////////////////////////////////
+// Each object is preceded by a header recording the
+// arena it came from (or nullptr for the heap).  The
+// header is a full alignment unit so that the object
+// itself stays aligned for any type.
+void *
+ArenaAllocated::operator new(size_t size)
+{
+    Arena *arena = current_arena;
+    char *block;
+    if (arena == nullptr) {
+	block = (char*)::operator new(arena_alignment + size);
+    }
+    else {
+	block = (char*)arena->allocate(arena_alignment + size);
+    }
+    *(Arena**)block = arena;
+    return block + arena_alignment;
+}
+
+void
+ArenaAllocated::operator delete(void *ptr)
+{
+    if (ptr == nullptr) {
+	return;
+    }
+    char *block = (char*)ptr - arena_alignment;
+    if (*(Arena**)block == nullptr) {
+	::operator delete(block);
+    }
+}
@@ -0,0 +1,195 @@
+/* Copyright 2025 Jonathan S. Arney
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      https://github.com/jarney/gyoji/blob/master/LICENSE
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#include <gyoji-misc/bitset.hpp>
+
+using namespace Gyoji::misc;
+
+static const size_t bits_per_word = 64;
+
+static size_t
+words_for(size_t nbits)
+{ return (nbits + bits_per_word - 1) / bits_per_word; }
+
+BitSet::BitSet()
+    : nbits(0)
+{}
+
+BitSet::BitSet(size_t _size)
+    : nbits(_size)
+    , words(words_for(_size), 0)
+{}
+
+BitSet::BitSet(const BitSet & other)
+    : nbits(other.nbits)
+    , words(other.words)
+{}
+
+BitSet::~BitSet()
+{}
+
+BitSet &
+BitSet::operator=(const BitSet & other)
+{
+    nbits = other.nbits;
+    words = other.words;
+    return *this;
+}
+
+bool
+BitSet::operator==(const BitSet & other) const
+{ return nbits == other.nbits && words == other.words; }
+
+bool
+BitSet::operator!=(const BitSet & other) const
+{ return !(*this == other); }
+
+void
+BitSet::resize(size_t _size)
+{
+    nbits = _size;
+    words.resize(words_for(_size), 0);
+    // Clear the unused bits of the last word so that
+    // growing the set again doesn't bring back elements
+    // that were cut off.
+    size_t spare = nbits % bits_per_word;
+    if (spare != 0) {
+	words.back() &= (((uint64_t)1) << spare) - 1;
+    }
+}
+
+size_t
+BitSet::size() const
+{ return nbits; }
+
+void
+BitSet::set(size_t element)
+{ words[element / bits_per_word] |= ((uint64_t)1) << (element % bits_per_word); }
+
+void
+BitSet::reset(size_t element)
+{ words[element / bits_per_word] &= ~(((uint64_t)1) << (element % bits_per_word)); }
+
+bool
+BitSet::test(size_t element) const
+{ return (words[element / bits_per_word] >> (element % bits_per_word)) & 1; }
+
+void
+BitSet::clear()
+{
+    for (uint64_t & word : words) {
+	word = 0;
+    }
+}
+
+void
+BitSet::fill()
+{
+    for (uint64_t & word : words) {
+	word = ~((uint64_t)0);
+    }
+    size_t spare = nbits % bits_per_word;
+    if (spare != 0) {
+	words.back() &= (((uint64_t)1) << spare) - 1;
+    }
+}
+
+bool
+BitSet::empty() const
+{
+    for (uint64_t word : words) {
+	if (word != 0) {
+	    return false;
+	}
+    }
+    return true;
+}
+
+size_t
+BitSet::count() const
+{
+    size_t n = 0;
+    for (uint64_t word : words) {
+	n += __builtin_popcountll(word);
+    }
+    return n;
+}
+
+bool
+BitSet::union_with(const BitSet & other)
+{
+    uint64_t changed = 0;
+    for (size_t i = 0; i < words.size(); i++) {
+	uint64_t before = words[i];
+	words[i] |= other.words[i];
+	changed |= before ^ words[i];
+    }
+    return changed != 0;
+}
+
+bool
+BitSet::subtract(const BitSet & other)
+{
+    uint64_t changed = 0;
+    for (size_t i = 0; i < words.size(); i++) {
+	uint64_t before = words[i];
+	words[i] &= ~other.words[i];
+	changed |= before ^ words[i];
+    }
+    return changed != 0;
+}
+
+bool
+BitSet::intersect_with(const BitSet & other)
+{
+    uint64_t changed = 0;
+    for (size_t i = 0; i < words.size(); i++) {
+	uint64_t before = words[i];
+	words[i] &= other.words[i];
+	changed |= before ^ words[i];
+    }
+    return changed != 0;
+}
+
+bool
+BitSet::intersects(const BitSet & other) const
+{
+    for (size_t i = 0; i < words.size(); i++) {
+	if ((words[i] & other.words[i]) != 0) {
+	    return true;
+	}
+    }
+    return false;
+}
+
+size_t
+BitSet::find_next(size_t from) const
+{
+    if (from >= nbits) {
+	return nbits;
+    }
+    size_t index = from / bits_per_word;
+    uint64_t word = words[index] & (~((uint64_t)0) << (from % bits_per_word));
+    while (true) {
+	if (word != 0) {
+	    size_t found = index * bits_per_word + __builtin_ctzll(word);
+	    return found < nbits ? found : nbits;
+	}
+	index++;
+	if (index >= words.size()) {
+	    return nbits;
+	}
+	word = words[index];
+    }
+}
@@ -304,29 +304,61 @@ GetOptions::getopt(int argc, char **argv)
 	std::string arg_value;
 	
 	if (startswith(arg, std::string("--"))) {
+	    // The value of a long option may be attached
+	    // with an '=' as in --jobs=4.
 	    std::string longname = arg.substr(2);
+	    size_t equals = longname.find('=');
+	    bool has_value = equals != std::string::npos;
+	    if (has_value) {
+		arg_value = longname.substr(equals + 1);
+		longname = longname.substr(0, equals);
+	    }
 	    const auto & it = options_by_longname.find(longname);
 	    if (it == options_by_longname.end()) {
 		fprintf(stderr, "No such long option %s\n", arg.c_str());
 		return nullptr;
 	    }
 	    opt = it->second;
+	    if (opt->get_type() == Option::OPTION_SINGLE_STRING ||
+		opt->get_type() == Option::OPTION_STRING_LIST) {
+		if (!has_value) {
+		    if ((pos + 1) < len) {
+			arg_value = argv[pos + 1];
+			pos++;
+		    }
+		    else {
+			fprintf(stderr, "String option %s requires a value\n", opt->get_id().c_str());
+			return nullptr;
+		    }
+		}
+	    }
+	    else if (has_value) {
+		fprintf(stderr, "Option %s does not take a value\n", opt->get_id().c_str());
+		return nullptr;
+	    }
 	    pos++;
 	}
 	else if (startswith(arg, std::string("-"))) {
 	    // The argument might be directly attached to the single-string argument
-	    // as in -lm where the argument is 'm'.
-	    std::string shortname = arg.substr(1, 1);
-	    const auto & it = options_by_shortname.find(shortname);
-	    if (it == options_by_shortname.end()) {
-		fprintf(stderr, "No such short option %s\n", shortname.c_str());
+	    // as in -lm where the argument is 'm'.  A short name may be more
+	    // than one letter (as in -MF), so the longest one that the
+	    // argument starts with is taken.
+	    std::string shortname;
+	    for (const auto & short_option : options_by_shortname) {
+		if (short_option.first.size() > shortname.size() &&
+		    startswith(arg.substr(1), short_option.first)) {
+		    shortname = short_option.first;
+		    opt = short_option.second;
+		}
+	    }
+	    if (opt == nullptr) {
+		fprintf(stderr, "No such short option %s\n", arg.c_str());
 		return nullptr;
 	    }
-	    opt = it->second;
 	    if (opt->get_type() == Option::OPTION_SINGLE_STRING ||
 		opt->get_type() == Option::OPTION_STRING_LIST) {
-		if (arg.substr(2).size() > 0) {
-		    arg_value = arg.substr(2);
+		if (arg.substr(1 + shortname.size()).size() > 0) {
+		    arg_value = arg.substr(1 + shortname.size());
 		}
 		else if ((pos + 1) < len) {
 		    arg_value = argv[pos + 1];
@@ -0,0 +1,176 @@
+/* Copyright 2025 Jonathan S. Arney
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      https://github.com/jarney/gyoji/blob/master/LICENSE
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#pragma once
+
+#include <vector>
+#include <stddef.h>
+
+namespace Gyoji::misc {
+
+    /**
+     * @brief Bump-pointer memory arena.
+     *
+     * @details
+     * Memory is handed out from large chunks by moving a
+     * pointer forward, and is only given back to the system
+     * all at once when the arena itself is destroyed.  This
+     * suits structures like the syntax tree that are made
+     * of a great many small objects which all die together:
+     * there is no per-object bookkeeping and nothing to do
+     * when an individual object is released.
+     *
+     * The arena does not run destructors.  Objects placed
+     * in it are expected to be destroyed in the usual way
+     * (see ArenaAllocated) before the arena goes away.
+     *
+     * An arena may be made 'current' for a thread with
+     * an ArenaScope, and objects derived from ArenaAllocated
+     * that are created while it is current are placed in it.
+     */
+    class Arena {
+    public:
+	/**
+	 * Creates an empty arena.  No memory is
+	 * reserved until the first allocation.
+	 */
+	Arena();
+	/**
+	 * @brief Releases all of the memory of the arena.
+	 *
+	 * @details
+	 * Any object still living in the arena must not
+	 * be used after this.
+	 */
+	~Arena();
+
+	/**
+	 * Returns a block of at least the given size,
+	 * aligned for any type.
+	 */
+	void *allocate(size_t size);
+
+	/**
+	 * Returns the number of bytes handed out
+	 * by allocate().
+	 */
+	size_t get_allocated() const;
+
+	/**
+	 * Returns the number of bytes reserved from the
+	 * system, including the unused ends of chunks.
+	 */
+	size_t get_footprint() const;
+
+	/**
+	 * Returns the arena that is current for this
+	 * thread, or nullptr if there is none.
+	 */
+	static Arena *get_current();
+    private:
+	friend class ArenaScope;
+	std::vector<char*> chunks;
+	char *next;
+	size_t remaining;
+	size_t allocated;
+	size_t reserved;
+    };
+
+    /**
+     * @brief Makes an arena current for the lifetime of this object.
+     *
+     * @details
+     * The arena that was current before is restored when
+     * the scope is destroyed, so scopes may be nested.
+     */
+    class ArenaScope {
+    public:
+	ArenaScope(Arena & _arena);
+	/**
+	 * @brief Move along, nothing to see here.
+	 *
+	 * @details
+	 * Move along, nothing to see here.
+	 */
+	~ArenaScope();
+    private:
+	Arena *previous;
+    };
+
+    /**
+     * @brief Base class for objects placed in the current arena.
+     *
+     * @details
+     * Classes deriving from this are allocated from the arena
+     * that is current when they are created with 'new', or from
+     * the heap if there is none.  They are still destroyed with
+     * 'delete' (usually by an owned pointer), which runs their
+     * destructor as normal but only gives the memory back
+     * when it came from the heap.
+     *
+     * An object must be deleted through a pointer to its own
+     * type or to a base class at the same address (single
+     * inheritance), because the arena that owns the memory is
+     * recorded just in front of the object.
+     */
+    class ArenaAllocated {
+    public:
+	static void *operator new(size_t size);
+	static void operator delete(void *ptr);
+    };
+
+    /**
+     * @brief Allocator that places containers in the current arena.
+     *
+     * @details
+     * The arena is chosen when the allocator is constructed,
+     * so a container built while an arena is current keeps
+     * using it.  Memory given back as the container grows
+     * stays in the arena until the arena is destroyed.
+     * With no current arena, this uses the heap.
+     */
+    template <class T> class ArenaAllocator {
+    public:
+	typedef T value_type;
+
+	ArenaAllocator()
+	    : arena(Arena::get_current())
+	{}
+	template <class U> ArenaAllocator(const ArenaAllocator<U> & other)
+	    : arena(other.get_arena())
+	{}
+
+	T *allocate(size_t n) {
+	    if (arena == nullptr) {
+		return (T*)::operator new(n * sizeof(T));
+	    }
+	    return (T*)arena->allocate(n * sizeof(T));
+	}
+	void deallocate(T *ptr, size_t n) {
+	    if (arena == nullptr) {
+		::operator delete(ptr);
+	    }
+	}
+	Arena *get_arena() const
+	{ return arena; }
+
+	template <class U> bool operator==(const ArenaAllocator<U> & other) const
+	{ return arena == other.get_arena(); }
+	template <class U> bool operator!=(const ArenaAllocator<U> & other) const
+	{ return arena != other.get_arena(); }
+    private:
+	Arena *arena;
+    };
+
+};
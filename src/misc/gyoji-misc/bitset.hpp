@@ -0,0 +1,132 @@
+/* Copyright 2025 Jonathan S. Arney
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      https://github.com/jarney/gyoji/blob/master/LICENSE
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#pragma once
+
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace Gyoji::misc {
+
+    /**
+     * @brief Dense set of small integers.
+     *
+     * @details
+     * This is a fixed-size set of the integers 0 through
+     * size()-1 stored one bit per element.  It is meant for
+     * data-flow problems where each program point carries
+     * a set of variables, loans, or other facts that have
+     * been numbered densely, so that the union and
+     * difference of two sets can be done a whole word
+     * at a time.
+     *
+     * Sets combined with union_with(), subtract(),
+     * intersect_with(), or intersects() must have
+     * the same size.
+     */
+    class BitSet {
+    public:
+	/**
+	 * Creates an empty set that can
+	 * hold no elements.
+	 */
+	BitSet();
+	/**
+	 * Creates an empty set that can hold the
+	 * elements 0 through _size-1.
+	 */
+	BitSet(size_t _size);
+	BitSet(const BitSet & other);
+	/**
+	 * @brief Move along, nothing to see here.
+	 *
+	 * @details
+	 * Move along, nothing to see here.
+	 */
+	~BitSet();
+
+	BitSet & operator=(const BitSet & other);
+	bool operator==(const BitSet & other) const;
+	bool operator!=(const BitSet & other) const;
+
+	/**
+	 * Changes the number of elements the set
+	 * can hold.  Elements that no longer fit
+	 * are removed and new elements are not
+	 * in the set.
+	 */
+	void resize(size_t _size);
+	size_t size() const;
+
+	void set(size_t element);
+	void reset(size_t element);
+	bool test(size_t element) const;
+	/**
+	 * Removes every element from the set.
+	 */
+	void clear();
+	/**
+	 * Adds every element 0 through
+	 * size()-1 to the set.
+	 */
+	void fill();
+	bool empty() const;
+	/**
+	 * Number of elements in the set.
+	 */
+	size_t count() const;
+
+	/**
+	 * Adds every element of the other set to this
+	 * one and returns true if this set changed.
+	 */
+	bool union_with(const BitSet & other);
+	/**
+	 * Removes every element of the other set from
+	 * this one and returns true if this set changed.
+	 */
+	bool subtract(const BitSet & other);
+	/**
+	 * Removes every element that is not also in the
+	 * other set and returns true if this set changed.
+	 */
+	bool intersect_with(const BitSet & other);
+	/**
+	 * Returns true if the two sets have
+	 * at least one element in common.
+	 */
+	bool intersects(const BitSet & other) const;
+
+	/**
+	 * @brief Find the next element of the set.
+	 *
+	 * @details
+	 * Returns the smallest element of the set that is
+	 * greater than or equal to 'from', or size() if there
+	 * is none.  This is used to visit the elements in order:
+	 *
+	 * @code{.unparsed}
+	 * for (size_t i = set.find_next(0); i < set.size(); i = set.find_next(i+1)) {
+	 *     ...
+	 * }
+	 * @endcode
+	 */
+	size_t find_next(size_t from) const;
+    private:
+	size_t nbits;
+	std::vector<uint64_t> words;
+    };
+
+};
@@ -0,0 +1,93 @@
+/* Copyright 2025 Jonathan S. Arney
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      https://github.com/jarney/gyoji/blob/master/LICENSE
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#pragma once
+
+#include <gyoji-misc/input-source.hpp>
+#include <stdio.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+namespace Gyoji::misc {
+
+    /**
+     * @brief This is an input source for files mapped into memory.
+     *
+     * @details
+     * This is an implementation of an input source that maps
+     * the whole of an ordinary file into memory instead of
+     * reading it with one system call after another.  The
+     * lexer scans the mapped memory in place (see read_all())
+     * and the tokens it produces point into it, so the source
+     * text is never copied at all.
+     *
+     * The mapping is private, so the writes flex makes
+     * while scanning never reach the file.  Files that can't be
+     * mapped (pipes, for example) and files that end too close
+     * to the end of a page to leave room for the two NUL bytes
+     * the lexer needs after the data are read in the ordinary
+     * way instead.
+     */
+    class InputSourceMmap : public InputSource {
+    public:
+	/**
+	 * @brief Create input source by file descriptor.
+	 *
+	 * @details
+	 * Maps the given file into memory.  The caller is
+	 * responsible for opening and closing the file and
+	 * must keep it open until the input has been read.
+	 */
+	InputSourceMmap(int _fd);
+	/**
+	 * @brief Move along, nothing to see here.
+	 *
+	 * @details
+	 * Move along, nothing to see here.
+	 */
+	virtual ~InputSourceMmap();
+
+	/**
+	 * Returns true if the file was
+	 * mapped into memory.
+	 */
+	bool is_mapped() const;
+
+	/**
+	 * @brief Method to read input from the file.
+	 *
+	 * @details
+	 * Copies the next part of the mapped file into the
+	 * buffer, or reads from the file if it couldn't
+	 * be mapped.
+	 */
+	void read(char *buf, int &result, int max_size);
+
+	/**
+	 * @brief Returns the mapped file.
+	 *
+	 * @details
+	 * Hands the mapping over to the caller without copying
+	 * it.  The mapping is released when the returned buffer
+	 * is destroyed.
+	 */
+	Gyoji::owned<InputBuffer> read_all();
+
+    private:
+	int fd;
+	Gyoji::owned<InputBuffer> mapped;
+	size_t position;
+    };
+
+};
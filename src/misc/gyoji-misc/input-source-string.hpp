@@ -0,0 +1,72 @@
+/* Copyright 2025 Jonathan S. Arney
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      https://github.com/jarney/gyoji/blob/master/LICENSE
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#pragma once
+
+#include <gyoji-misc/input-source.hpp>
+#include <string>
+
+namespace Gyoji::misc {
+
+    /**
+     * @brief This is an input source for text held in memory.
+     *
+     * @details
+     * This is an implementation of an input source that
+     * reads from a string, for input that was made by the
+     * compiler itself rather than read straight from a
+     * file (the output of the preprocessor, for example).
+     */
+    class InputSourceString : public InputSource {
+    public:
+	/**
+	 * @brief Create input source for the given text.
+	 *
+	 * @details
+	 * The input source takes the text over, so the
+	 * caller's string is left empty.
+	 */
+	InputSourceString(std::string & _text);
+	/**
+	 * @brief Move along, nothing to see here.
+	 *
+	 * @details
+	 * Move along, nothing to see here.
+	 */
+	~InputSourceString();
+	/**
+	 * @brief Method to read input from the string.
+	 *
+	 * @details
+	 * Copies the next part of the text into the buffer.
+	 * The 'result' represents the number of bytes
+	 * actually copied, which is zero at the end.
+	 */
+	void read(char *buf, int &result, int max_size);
+
+	/**
+	 * @brief Hands the text over as the input buffer.
+	 *
+	 * @details
+	 * The text is given to the buffer as it
+	 * is rather than being copied.
+	 */
+	Gyoji::owned<InputBuffer> read_all();
+
+    private:
+	std::string text;
+	size_t position;
+    };
+
+};
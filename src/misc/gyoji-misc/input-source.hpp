@@ -14,8 +14,62 @@
  */
 #pragma once
 
+#include <gyoji-misc/pointers.hpp>
+#include <stddef.h>
+
 namespace Gyoji::misc {
 
+    /**
+     * @brief The whole of an input held in memory.
+     *
+     * @details
+     * This holds all of the data of an input so that a
+     * lexer can scan it in place and hand out tokens that
+     * point into it instead of copying each one.  The data is
+     * followed by two NUL bytes that are not counted in
+     * the size, which is what flex needs in order to
+     * scan a buffer without copying it (yy_scan_buffer).
+     *
+     * The data is writable because flex briefly writes a
+     * NUL after each token it matches, but the contents
+     * are the same as the input again once scanning is done.
+     *
+     * Sub-classes decide where the memory comes from
+     * and how it is released.
+     */
+    class InputBuffer {
+    public:
+	/**
+	 * @brief Wraps memory holding the input.
+	 *
+	 * @details
+	 * The memory must hold _size bytes of data followed by
+	 * two NUL bytes and must live as long as this object.
+	 */
+	InputBuffer(char *_data, size_t _size);
+	/**
+	 * @brief Move along, nothing to see here.
+	 *
+	 * @details
+	 * Move along, nothing to see here.
+	 */
+	virtual ~InputBuffer();
+
+	/**
+	 * Returns the data, followed
+	 * by two NUL bytes.
+	 */
+	char *get_data() const;
+	/**
+	 * Returns the number of bytes of data,
+	 * not counting the two NUL bytes.
+	 */
+	size_t get_size() const;
+    protected:
+	char *data;
+	size_t size;
+    };
+
     /**
      * @brief Input Source used by lexer
      *
@@ -42,7 +96,7 @@ namespace Gyoji::misc {
 	 * @details
 	 * Move along, nothing to see here.
 	 */
-	~InputSource();
+	virtual ~InputSource();
 	
 	/**
 	 * Sub-classes must implement this method to provide input to
@@ -54,8 +108,27 @@ namespace Gyoji::misc {
 	 *                 from the input source.  Note that result must
 	 *                 always be less than or equal to max_size in order
 	 *                 to ensure that the buffer is not overflowed.
+	 *
+	 * If the read fails, result is -1 and errno is left set to
+	 * the reason (EINTR if a signal interrupted it before
+	 * anything was read, in which case it may be tried again).
 	 */
 	virtual void read(char *buf, int &result, int max_size) = 0;
+
+	/**
+	 * @brief Reads the whole input into memory.
+	 *
+	 * @details
+	 * Returns all of the remaining input as a single buffer.
+	 * By default this calls read() until there is nothing left
+	 * and copies the data into memory allocated for it.
+	 * Sub-classes that already have the data in memory
+	 * (see InputSourceMmap) return it without copying.
+	 * Once this has been called, there is nothing
+	 * left for read() to return.  Returns nullptr with
+	 * errno set if the input could not be read.
+	 */
+	virtual Gyoji::owned<InputBuffer> read_all();
     };
   
 };
@@ -17,16 +17,40 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <sys/types.h>
 #include <gyoji-misc/pointers.hpp>
 
+struct pollfd;
+
 namespace Gyoji::misc::subprocess {
 
+    /**
+     * @brief Receives what a subprocess writes to stdout or stderr.
+     *
+     * @details
+     * A reader that is simply a file descriptor says so
+     * through get_fd(), and the subprocess is then given
+     * the descriptor to write to directly instead of having
+     * its output copied through the parent.
+     */
     class SubProcessReader {
     public:
 	SubProcessReader();
 	virtual ~SubProcessReader();
 	virtual int write(char *buffer, size_t bytes) = 0;
+	/**
+	 * Returns the file descriptor the output should go
+	 * to, or -1 if it must be passed to write().
+	 */
+	virtual int get_fd() const;
     };
+    /**
+     * @brief Supplies what a subprocess reads from stdin.
+     *
+     * @details
+     * As with SubProcessReader, a writer that is simply a file
+     * descriptor is given to the subprocess to read directly.
+     */
     class SubProcessWriter {
     public:
 	SubProcessWriter();
@@ -35,9 +59,16 @@ namespace Gyoji::misc::subprocess {
 	/**
 	 * Used by the parent process to write data into a buffer
 	 * so that the subprocess has it available for read.
+	 * This may block until there is data to give, and
+	 * only returns zero once there is no more.
 	 */
-	virtual int read(const char *buffer, size_t bytes) = 0;
+	virtual int read(char *buffer, size_t bytes) = 0;
 	virtual bool is_eof() const = 0;
+	/**
+	 * Returns the file descriptor the input should come
+	 * from, or -1 if it must be taken from read().
+	 */
+	virtual int get_fd() const;
     };
 
     class SubProcessReaderFile : public SubProcessReader {
@@ -45,6 +76,7 @@ namespace Gyoji::misc::subprocess {
 	SubProcessReaderFile(int _fd);
 	virtual ~SubProcessReaderFile();
 	int write(char *buffer, size_t bytes);
+	int get_fd() const;
     private:
 	int fd;
     };
@@ -53,11 +85,38 @@ namespace Gyoji::misc::subprocess {
     public:
 	SubProcessWriterEmpty();
 	virtual ~SubProcessWriterEmpty();
-	int read(const char *buffer, size_t bytes);
+	int read(char *buffer, size_t bytes);
 	bool is_eof() const;
     private:
     };
+
+    class SubProcessWriterFile : public SubProcessWriter {
+    public:
+	SubProcessWriterFile(int _fd);
+	virtual ~SubProcessWriterFile();
+	int read(char *buffer, size_t bytes);
+	bool is_eof() const;
+	int get_fd() const;
+    private:
+	int fd;
+	bool eof;
+    };
     
+    /**
+     * @brief Runs a command with its input and output
+     *        connected to readers and writers.
+     *
+     * @details
+     * The command is started with posix_spawn so that a large
+     * compiler process is not copied just to run it.  Readers
+     * and writers that are file descriptors are handed to the
+     * command directly.  The others are connected through pipes
+     * that the parent services with poll(), waking only when
+     * there is something to do.
+     *
+     * Several subprocesses may be run at once by starting each
+     * of them and then waiting for all of them with wait_all().
+     */
     class SubProcess {
     public:
 	SubProcess(
@@ -65,16 +124,75 @@ namespace Gyoji::misc::subprocess {
 	    Gyoji::owned<SubProcessReader> _stderr_reader,
 	    Gyoji::owned<SubProcessWriter> _stdin_writer
 	    );
+	/**
+	 * Waits for the command if it was started
+	 * and not waited for.
+	 */
 	~SubProcess();
 
+	/**
+	 * Runs the command, searched for in the PATH, with
+	 * the given arguments and only the given environment,
+	 * and waits for it to finish.  Returns the exit status
+	 * of the command or -1 if it could not be started.
+	 */
 	int invoke(
 	    std::string command_name,
 	    std::vector<std::string> arguments,
 	    std::map<std::string, std::string> environment
-	    ) const;
+	    );
+
+	/**
+	 * Starts the command as invoke() does without waiting
+	 * for it.  Returns false if it could not be started.
+	 */
+	bool start(
+	    std::string command_name,
+	    std::vector<std::string> arguments,
+	    std::map<std::string, std::string> environment
+	    );
+
+	/**
+	 * Passes the input and output of the command along
+	 * until it finishes and returns its exit status,
+	 * or -1 if it was never started.
+	 */
+	int wait();
+
+	/**
+	 * Waits for all of the given subprocesses at once,
+	 * passing along the input and output of each of them.
+	 * The exit status of each is then had from wait().
+	 */
+	static void wait_all(const std::vector<SubProcess*> & processes);
+
     private:
+	void add_pollfds(std::vector<struct pollfd> & pollfds) const;
+	size_t handle_pollfds(const struct pollfd *pollfds);
+	void handle_stdin(short revents);
+	void handle_output(int & fd, SubProcessReader & reader, short revents);
+	void close_pipes();
+	bool has_pipes() const;
+	void reap();
+
 	Gyoji::owned<SubProcessReader> stdout_reader;
 	Gyoji::owned<SubProcessReader> stderr_reader;
 	Gyoji::owned<SubProcessWriter> stdin_writer;
+
+	pid_t pid;
+	bool running;
+	int exit_status;
+
+	// The parent's ends of the pipes, or -1 when
+	// closed or when the command was handed a file.
+	int child_stdin;
+	int child_stdout;
+	int child_stderr;
+
+	// Input taken from the writer but not
+	// yet written to the command.
+	std::vector<char> stdin_buffer;
+	size_t stdin_position;
+	size_t stdin_length;
     };
 };
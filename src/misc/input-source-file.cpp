@@ -28,10 +28,10 @@ void InputSourceFile::read(char *buf, int &result, int max_size)
 {
     errno = 0;
     result = (int) ::read(fd, buf, (size_t) max_size);
-    if (result == -1) {
-	if( errno != EINTR) {
-	    fprintf(stderr, "Fatal error reading input buffer %d\n", errno);
-	}
+    if (result == -1 && errno != EINTR) {
+	// Leave errno for the caller to find.
+	int error = errno;
+	fprintf(stderr, "Fatal error reading input buffer %d\n", error);
+	errno = error;
     }
-    errno = 0;
 }
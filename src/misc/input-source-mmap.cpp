@@ -0,0 +1,113 @@
+/* Copyright 2025 Jonathan S. Arney
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      https://github.com/jarney/gyoji/blob/master/LICENSE
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#include <gyoji-misc/input-source-mmap.hpp>
+#include <errno.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace Gyoji::misc;
+
+namespace Gyoji::misc {
+    // Input held in a private mapping of the file.
+    class InputBufferMapped : public InputBuffer {
+    public:
+	InputBufferMapped(char *_data, size_t _size, size_t _mapped_size);
+	virtual ~InputBufferMapped();
+    private:
+	size_t mapped_size;
+    };
+};
+
+/////////////////////////////////////
+// InputBufferMapped
+/////////////////////////////////////
+InputBufferMapped::InputBufferMapped(char *_data, size_t _size, size_t _mapped_size)
+    : InputBuffer(_data, _size)
+    , mapped_size(_mapped_size)
+{}
+
+InputBufferMapped::~InputBufferMapped()
+{
+    munmap(data, mapped_size);
+}
+
+/////////////////////////////////////
+// InputSourceMmap
+/////////////////////////////////////
+InputSourceMmap::InputSourceMmap(int _fd)
+    : fd(_fd)
+    , position(0)
+{
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0 || !S_ISREG(file_stat.st_mode)) {
+	return;
+    }
+    size_t size = (size_t)file_stat.st_size;
+    size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+
+    // The rest of the last page of a mapping past the
+    // end of the file reads as zeros, so that's where the
+    // two NUL bytes after the data come from.  If the file
+    // fills the last page, there's no room for them and
+    // touching the next page would fault.
+    size_t tail = size % page_size;
+    if (size == 0 || tail == 0 || tail > page_size - 2) {
+	return;
+    }
+    void *data = mmap(nullptr, size + 2, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+	return;
+    }
+    madvise(data, size + 2, MADV_SEQUENTIAL);
+    mapped = Gyoji::owned_new<InputBufferMapped>((char*)data, size, size + 2);
+}
+
+InputSourceMmap::~InputSourceMmap()
+{}
+
+bool
+InputSourceMmap::is_mapped() const
+{ return mapped != nullptr; }
+
+void
+InputSourceMmap::read(char *buf, int &result, int max_size)
+{
+    if (!mapped) {
+	errno = 0;
+	result = (int) ::read(fd, buf, (size_t) max_size);
+	if (result == -1 && errno != EINTR) {
+	    // Leave errno for the caller to find.
+	    int error = errno;
+	    fprintf(stderr, "Fatal error reading input buffer %d\n", error);
+	    errno = error;
+	}
+	return;
+    }
+    size_t remaining = mapped->get_size() - position;
+    size_t count = remaining < (size_t)max_size ? remaining : (size_t)max_size;
+    memcpy(buf, mapped->get_data() + position, count);
+    position += count;
+    result = (int)count;
+}
+
+Gyoji::owned<InputBuffer>
+InputSourceMmap::read_all()
+{
+    if (!mapped || position != 0) {
+	return InputSource::read_all();
+    }
+    return std::move(mapped);
+}
@@ -0,0 +1,80 @@
+/* Copyright 2025 Jonathan S. Arney
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      https://github.com/jarney/gyoji/blob/master/LICENSE
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#include <gyoji-misc/input-source-string.hpp>
+#include <string.h>
+#include <algorithm>
+
+using namespace Gyoji::misc;
+
+namespace Gyoji::misc {
+    class InputBufferString : public InputBuffer {
+    public:
+	InputBufferString(std::string & _text, size_t _size);
+	virtual ~InputBufferString();
+    private:
+	std::string text;
+    };
+};
+
+/////////////////////////////////////
+// InputBufferString
+/////////////////////////////////////
+InputBufferString::InputBufferString(std::string & _text, size_t _size)
+    : InputBuffer(nullptr, _size)
+{
+    text.swap(_text);
+    data = text.data();
+}
+
+InputBufferString::~InputBufferString()
+{}
+
+/////////////////////////////////////
+// InputSourceString
+/////////////////////////////////////
+InputSourceString::InputSourceString(std::string & _text)
+    : position(0)
+{
+    text.swap(_text);
+}
+InputSourceString::~InputSourceString()
+{}
+
+void InputSourceString::read(char *buf, int &result, int max_size)
+{
+    size_t count = std::min(text.size() - position, (size_t)max_size);
+    memcpy(buf, text.data() + position, count);
+    position += count;
+    result = (int)count;
+}
+
+Gyoji::owned<InputBuffer>
+InputSourceString::read_all()
+{
+    std::string remaining;
+    if (position == 0) {
+	remaining.swap(text);
+    }
+    else {
+	remaining.assign(text, position, std::string::npos);
+	text.clear();
+    }
+    position = 0;
+    // The buffer must end with two NUL bytes (see InputBuffer).
+    size_t size = remaining.size();
+    remaining.push_back('\0');
+    remaining.push_back('\0');
+    return Gyoji::owned_new<InputBufferString>(remaining, size);
+}
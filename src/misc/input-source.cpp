@@ -13,12 +13,92 @@
  *  limitations under the License.
  */
 #include <gyoji-misc/input-source.hpp>
+#include <errno.h>
+#include <vector>
 
 using namespace Gyoji::misc;
 
+namespace Gyoji::misc {
+    // Input copied into memory we allocated.
+    class InputBufferHeap : public InputBuffer {
+    public:
+	InputBufferHeap(std::vector<char> & _storage, size_t _size);
+	virtual ~InputBufferHeap();
+    private:
+	std::vector<char> storage;
+    };
+};
+
+/////////////////////////////////////
+// InputBuffer
+/////////////////////////////////////
+InputBuffer::InputBuffer(char *_data, size_t _size)
+    : data(_data)
+    , size(_size)
+{}
+
+InputBuffer::~InputBuffer()
+{}
+
+char *
+InputBuffer::get_data() const
+{ return data; }
+
+size_t
+InputBuffer::get_size() const
+{ return size; }
+
+/////////////////////////////////////
+// InputBufferHeap
+/////////////////////////////////////
+InputBufferHeap::InputBufferHeap(std::vector<char> & _storage, size_t _size)
+    : InputBuffer(nullptr, _size)
+{
+    // Take the storage over without copying it
+    // and only then point at its data.
+    storage.swap(_storage);
+    data = storage.data();
+}
+
+InputBufferHeap::~InputBufferHeap()
+{}
+
+/////////////////////////////////////
+// InputSource
+/////////////////////////////////////
 InputSource::InputSource()
 {}
 
 InputSource::~InputSource()
 {}
 
+Gyoji::owned<InputBuffer>
+InputSource::read_all()
+{
+    static const int chunk_size = 64 * 1024;
+
+    std::vector<char> storage;
+    size_t size = 0;
+    while (true) {
+	storage.resize(size + chunk_size);
+	int result = 0;
+	read(storage.data() + size, result, chunk_size);
+	if (result < 0) {
+	    // Being interrupted by a signal before anything
+	    // was read is not the end of the input.
+	    if (errno == EINTR) {
+		continue;
+	    }
+	    return nullptr;
+	}
+	if (result == 0) {
+	    break;
+	}
+	size += (size_t)result;
+    }
+    storage.resize(size + 2);
+    storage[size] = '\0';
+    storage[size + 1] = '\0';
+    return Gyoji::owned_new<InputBufferHeap>(storage, size);
+}
+
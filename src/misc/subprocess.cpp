@@ -15,93 +15,80 @@
 #include <gyoji-misc/subprocess.hpp>
 #include <unistd.h>
 #include <string.h>
-#include <sys/select.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <spawn.h>
 #include <sys/wait.h>
-#include <ctime>
+#include <algorithm>
 
 using namespace Gyoji::misc::subprocess;
 
 #define READ_END 0
 #define WRITE_END 1
 
-#define BUFFER_LENGTH (512)
+#define BUFFER_LENGTH (64*1024)
 
-class Buffer {
-public:
-    Buffer(
-        SubProcessWriter & _writer
-	);
-    ~Buffer();
-
-    size_t read(char *data, size_t maxlen);
-    void consume(size_t bytes);
-    bool is_eof() const;
-private:
-    char buffer[BUFFER_LENGTH];
-    size_t position;
-    size_t length;
-    bool eof;
-    SubProcessWriter & writer;
-};
-
-Buffer::Buffer(
-        SubProcessWriter & _writer
-    )
-    : position(0)
-    , length(0)
-    , eof(false)
-    , writer(_writer)
-{}
-Buffer::~Buffer()
-{}
+// Writes to the pipe without raising SIGPIPE if the command
+// has closed its end, which would kill us, so the caller sees
+// EPIPE instead.  A pipe raises SIGPIPE in the thread that
+// writes to it, so blocking it here is enough; any SIGPIPE
+// the write raised is taken back before it is unblocked.
+static ssize_t
+write_no_sigpipe(int fd, const char *buffer, size_t bytes)
+{
+    sigset_t sigpipe_set;
+    sigemptyset(&sigpipe_set);
+    sigaddset(&sigpipe_set, SIGPIPE);
+
+    // One that was already pending isn't ours to take.
+    sigset_t pending;
+    sigpending(&pending);
+    bool was_pending = sigismember(&pending, SIGPIPE);
+
+    sigset_t old_set;
+    pthread_sigmask(SIG_BLOCK, &sigpipe_set, &old_set);
+    ssize_t wrote = ::write(fd, buffer, bytes);
+    if (wrote < 0 && errno == EPIPE && !was_pending) {
+	struct timespec no_wait = { 0, 0 };
+	while (sigtimedwait(&sigpipe_set, nullptr, &no_wait) < 0 && errno == EINTR) {
+	}
+	errno = EPIPE;
+    }
+    pthread_sigmask(SIG_SETMASK, &old_set, nullptr);
+    return wrote;
+}
 
-bool
-Buffer::is_eof() const
-{ return eof; }
+// Makes a pipe whose ends are not inherited by any command
+// started later, since a stray copy of the write end would
+// keep the reading side from ever seeing the end of it.
+static bool
+make_pipe(int fds[2])
+{
+    if (::pipe2(fds, O_CLOEXEC) != 0) {
+	return false;
+    }
+    return true;
+}
 
-size_t
-Buffer::read(char *data, size_t maxlen)
+static void
+set_nonblocking(int fd)
 {
-    // We've read to the end of
-    // the buffer, so we want to refill the buffer
-    if (position == length) {
-	// Refill buffer.
-	position = 0;
-	length = 0;
-
-	// Read until we get something.
-	// If we get nothing, check for EOF
-	// otherwise keep spinning.
-	while (true) {
-	    int bytes_read = writer.read(buffer, sizeof(buffer));
-	    if (bytes_read == 0 && writer.is_eof()) {
-		eof = true;
-		return 0;
-	    }
-	    length += bytes_read;
-	    if (length != 0) {
-		break;
-	    }
-	    else {
-		// Keep spinning on the read
-		usleep(100*1000);
-	    }
-	}
-	// At this point, length != 0, so we definitely
-	// have some data to handle.  If it was EOF,
-	// we would have returned already.
-    }
-    
-    size_t bytes = std::min(maxlen, length-position);
-    memcpy(data, &buffer[position], bytes);
-    return bytes;
+    int flags = ::fcntl(fd, F_GETFL);
+    ::fcntl(fd, F_SETFL, flags | O_NONBLOCK);
 }
 
-void
-Buffer::consume(size_t bytes)
+static void
+close_fd(int & fd)
 {
-    position += bytes;
+    if (fd != -1) {
+	::close(fd);
+	fd = -1;
+    }
 }
+
 //////////////////////////////////////////////
 // SubProcessReader
 //////////////////////////////////////////////
@@ -112,6 +99,10 @@ SubProcessReader::SubProcessReader()
 SubProcessReader::~SubProcessReader()
 {}
 
+int
+SubProcessReader::get_fd() const
+{ return -1; }
+
 //////////////////////////////////////////////
 // SubProcessReaderFile
 //////////////////////////////////////////////
@@ -129,6 +120,9 @@ SubProcessReaderFile::write(char *buffer, size_t bytes)
     return ::write(fd, buffer, bytes);
 }
 
+int
+SubProcessReaderFile::get_fd() const
+{ return fd; }
 
 //////////////////////////////////////////////
 // SubProcessWriter
@@ -140,7 +134,9 @@ SubProcessWriter::SubProcessWriter()
 SubProcessWriter::~SubProcessWriter()
 {}
 
-
+int
+SubProcessWriter::get_fd() const
+{ return -1; }
 
 //////////////////////////////////////////////
 // SubProcessWriterEmpty
@@ -154,7 +150,7 @@ SubProcessWriterEmpty::~SubProcessWriterEmpty()
 {}
 
 int
-SubProcessWriterEmpty::read(const char *buffer, size_t bytes)
+SubProcessWriterEmpty::read(char *buffer, size_t bytes)
 {
     return 0;
 }
@@ -167,6 +163,38 @@ SubProcessWriterEmpty::is_eof() const
     return true;
 }
 
+//////////////////////////////////////////////
+// SubProcessWriterFile
+//////////////////////////////////////////////
+
+SubProcessWriterFile::SubProcessWriterFile(int _fd)
+    : SubProcessWriter()
+    , fd(_fd)
+    , eof(false)
+{}
+
+SubProcessWriterFile::~SubProcessWriterFile()
+{}
+
+int
+SubProcessWriterFile::read(char *buffer, size_t bytes)
+{
+    int got = ::read(fd, buffer, bytes);
+    if (got <= 0) {
+	eof = true;
+	return 0;
+    }
+    return got;
+}
+
+bool
+SubProcessWriterFile::is_eof() const
+{ return eof; }
+
+int
+SubProcessWriterFile::get_fd() const
+{ return fd; }
+
 //////////////////////////////////////////////
 // SubProcess
 //////////////////////////////////////////////
@@ -179,213 +207,315 @@ SubProcess::SubProcess(
     : stdout_reader(std::move(_stdout_reader))
     , stderr_reader(std::move(_stderr_reader))
     , stdin_writer(std::move(_stdin_writer))
+    , pid(-1)
+    , running(false)
+    , exit_status(-1)
+    , child_stdin(-1)
+    , child_stdout(-1)
+    , child_stderr(-1)
+    , stdin_position(0)
+    , stdin_length(0)
 {}
 
 SubProcess::~SubProcess()
-{}
+{
+    if (running) {
+	wait();
+    }
+}
 
 int
 SubProcess::invoke(
     std::string command_name,
     std::vector<std::string> arguments,
     std::map<std::string, std::string> environment
-    ) const
+    )
 {
-    Buffer reader(*stdin_writer);
-    
-    int stdin_fds[2];
-    int stdout_fds[2];
-    int stderr_fds[2];
-    
-    ::pipe(stdin_fds);
-    ::pipe(stdout_fds);
-    ::pipe(stderr_fds);
-
-    // fork the process
-    pid_t pid = ::fork();
-    if (pid == -1) {
-	// Fork failed, we're out of memory
-	// or the OS is in a bad state.
+    if (!start(command_name, arguments, environment)) {
 	return -1;
     }
-    else if (pid != 0) { // Parent
-	// Close write ends of stdout and stderr for write
-	// Close read end of stdin
-	::close(stdout_fds[WRITE_END]);
-	::close(stderr_fds[WRITE_END]);
-	::close(stdin_fds[READ_END]);
-
-	// Parent now has access to child read/write pipes.
-	int child_stdin = stdin_fds[WRITE_END];
-	bool child_stdin_open = true;
-	
-	int child_stdout = stdout_fds[READ_END];
-	bool child_stdout_open = true;
-	
-	int child_stderr = stderr_fds[READ_END];
-	bool child_stderr_open = true;
-
-	// TODO: This should be a giant loop.  Probably move this
-	// into another method that specifically handles the child I/O.
-	// We need to set up the 'select' and fd_set based on what
-	// file descriptors are still open.  This is because the 'stdin'
-	// descriptor is expected to close early in the process and the
-	// corresponding 'stdout/stderr' will close whenever the child is
-	// done writing their data, so we don't know when that's going to be
-	// either.  Bottom line, any of these descriptors might close at
-	// any time, so we need to handle all cases.
-	
-	// Parent now writes any required content to child
-	// and closes the FD to signal to the child
-	// that all writing has finished.
-	// Simultaneously, parent attempts to read
-	// from stdout, stderr, capturing any output
-	// from the child.
-
-	while (child_stdin_open ||
-	       child_stdout_open ||
-	       child_stderr_open) {
-	
-	    fd_set rd;
-	    fd_set wr;
-
-	    int max_fd = -1;
-	    FD_ZERO(&wr);
-	    if (child_stdin_open) {
-		max_fd = std::max(max_fd, child_stdin);
-		FD_SET(child_stdin, &wr);
-	    }
-	    
-	    FD_ZERO(&rd);
-	    if (child_stdout_open) {
-		max_fd = std::max(max_fd, child_stdout);
-		FD_SET(child_stdout, &rd);
-	    }
-	    if (child_stderr_open) {
-		max_fd = std::max(max_fd, child_stderr);
-		FD_SET(child_stderr, &rd);
+    return wait();
+}
+
+bool
+SubProcess::start(
+    std::string command_name,
+    std::vector<std::string> arguments,
+    std::map<std::string, std::string> environment
+    )
+{
+    if (running) {
+	return false;
+    }
+    exit_status = -1;
+
+    // Each of stdin, stdout and stderr is either handed
+    // to the command as it is or given a pipe, whose
+    // other end the parent keeps.
+    int stdin_fds[2] = { stdin_writer->get_fd(), -1 };
+    int stdout_fds[2] = { -1, stdout_reader->get_fd() };
+    int stderr_fds[2] = { -1, stderr_reader->get_fd() };
+    bool ok = true;
+    if (stdin_fds[READ_END] == -1) {
+	ok = ok && make_pipe(stdin_fds);
+    }
+    if (stdout_fds[WRITE_END] == -1) {
+	ok = ok && make_pipe(stdout_fds);
+    }
+    if (stderr_fds[WRITE_END] == -1) {
+	ok = ok && make_pipe(stderr_fds);
+    }
+
+    const char *cmd = command_name.c_str();
+    std::vector<char*> args;
+    args.push_back((char*)cmd);
+    for (const auto & arg : arguments) {
+	args.push_back((char*)arg.c_str());
+    }
+    args.push_back(nullptr);
+
+    std::vector<std::string> env_list;
+    for (const auto & env_var : environment) {
+	env_list.push_back(env_var.first + std::string("=") + env_var.second);
+    }
+    std::vector<char*> env;
+    for (const auto & env_var : env_list) {
+	env.push_back((char*)env_var.c_str());
+    }
+    env.push_back(nullptr);
+
+    if (ok) {
+	posix_spawn_file_actions_t actions;
+	posix_spawn_file_actions_init(&actions);
+	posix_spawn_file_actions_adddup2(&actions, stdin_fds[READ_END], STDIN_FILENO);
+	posix_spawn_file_actions_adddup2(&actions, stdout_fds[WRITE_END], STDOUT_FILENO);
+	posix_spawn_file_actions_adddup2(&actions, stderr_fds[WRITE_END], STDERR_FILENO);
+
+	// Anything the parent has buffered for a file
+	// handed to the command must come out before
+	// what the command writes to it.
+	fflush(stdout);
+	fflush(stderr);
+	int rc = posix_spawnp(&pid, cmd, &actions, nullptr, args.data(), env.data());
+	posix_spawn_file_actions_destroy(&actions);
+	if (rc != 0) {
+	    fprintf(stderr, "Process would not be launched: %s: %s\n", cmd, strerror(rc));
+	    ok = false;
+	}
+    }
+
+    // The command has its own copies of its ends of the
+    // pipes now, so the parent only keeps the other ends.
+    if (stdin_writer->get_fd() == -1) {
+	close_fd(stdin_fds[READ_END]);
+	child_stdin = stdin_fds[WRITE_END];
+    }
+    if (stdout_reader->get_fd() == -1) {
+	close_fd(stdout_fds[WRITE_END]);
+	child_stdout = stdout_fds[READ_END];
+    }
+    if (stderr_reader->get_fd() == -1) {
+	close_fd(stderr_fds[WRITE_END]);
+	child_stderr = stderr_fds[READ_END];
+    }
+    if (!ok) {
+	close_pipes();
+	return false;
+    }
+    if (child_stdin != -1) {
+	set_nonblocking(child_stdin);
+	stdin_buffer.resize(BUFFER_LENGTH);
+	stdin_position = 0;
+	stdin_length = 0;
+    }
+    if (child_stdout != -1) {
+	set_nonblocking(child_stdout);
+    }
+    if (child_stderr != -1) {
+	set_nonblocking(child_stderr);
+    }
+    running = true;
+    return true;
+}
+
+int
+SubProcess::wait()
+{
+    std::vector<SubProcess*> processes;
+    processes.push_back(this);
+    wait_all(processes);
+    return exit_status;
+}
+
+void
+SubProcess::wait_all(const std::vector<SubProcess*> & processes)
+{
+    // There is no timeout, since poll() wakes up as
+    // soon as any of the pipes has something to do.
+    std::vector<struct pollfd> pollfds;
+    while (true) {
+	pollfds.clear();
+	for (const SubProcess *process : processes) {
+	    if (process->running) {
+		process->add_pollfds(pollfds);
 	    }
-	    // Max fd must be >-1 here because
-	    // otherwise, at least one of child_stdout,err,in
-	    // is true.
-
-	    // Timeout in 100ms for read.
-	    struct timeval timeout;
-	    timeout.tv_sec = 0;
-	    timeout.tv_usec = 100*1000;
-	    
-	    // See what's available to read and/or write.
-	    int available = ::select(
-		max_fd+1,
-		&rd,
-		&wr,
-		nullptr,
-		&timeout
-		);
-	    if (FD_ISSET(child_stdin, &wr)) {
-		// This is a non-blocking pipe
-		// according to POSIX.
-		// https://pubs.opengroup.org/onlinepubs/9699919799/functions/pipe.html
-		//
-		// We will just keep writing chunks of data
-		// until we've reached the end of the stream
-		// and then we'll close the FD.
-		
-		// TODO: We need to only read from
-		// the reader when the read buffer is empty.  Probably
-		// should marshal this through an intermediary,
-		// maybe the writer itself.
-		char buffer[BUFFER_LENGTH];
-		int got_from_writer = reader.read(buffer, BUFFER_LENGTH);
-		if (got_from_writer == 0 && reader.is_eof()) {
-		    // on EOF, close it.
-		    // Register a callback to do the write
-		    // or at least grab a chunk of data to write.
-		    close(child_stdin);
-		    child_stdin_open = false;
-		}
-		else {
-		    size_t wrote_to_subprocess = write(child_stdin, buffer, got_from_writer);
-		    // We successfully wrote to the subprocess,
-		    // so we can safely mark that portion of the input as
-		    // consumed.
-		    reader.consume(wrote_to_subprocess);
-		}
+	}
+	if (pollfds.size() == 0) {
+	    break;
+	}
+	int available = ::poll(pollfds.data(), pollfds.size(), -1);
+	if (available < 0) {
+	    if (errno == EINTR) {
+		continue;
 	    }
-	    if (FD_ISSET(child_stdout, &rd)) {
-		// Reads child's stdout and
-		// put it somewhere.
-		// Register a callback to receive it.
-		char buffer[BUFFER_LENGTH];
-		errno = 0;
-		int read_from_stdout = ::read(child_stdout, buffer, BUFFER_LENGTH);
-		if (read_from_stdout == 0 && errno != EAGAIN) {
-		    ::close(child_stdout);
-		    child_stdout_open = false;
-		}
-		stdout_reader->write(buffer, read_from_stdout);
+	    // Nothing more can be passed along,
+	    // so just wait for the commands.
+	    for (SubProcess *process : processes) {
+		process->close_pipes();
 	    }
-	    if (FD_ISSET(child_stderr, &rd)) {
-		// Read child's stderr and
-		// put it somewhere.
-		char buffer[BUFFER_LENGTH];
-		errno = 0;
-		int read_from_stderr = ::read(child_stderr, buffer, BUFFER_LENGTH);
-		if (read_from_stderr == 0 && errno != EAGAIN) {
-		    ::close(child_stderr);
-		    child_stderr_open = false;
-		}
-		stderr_reader->write(buffer, read_from_stderr);
+	    break;
+	}
+	size_t index = 0;
+	for (SubProcess *process : processes) {
+	    if (process->running && process->has_pipes()) {
+		index += process->handle_pollfds(&pollfds[index]);
 	    }
 	}
-	int exit_status;
-	::waitpid(pid, &exit_status, 0);
-
-	return WEXITSTATUS(exit_status);
-    }
-    else { // Child, pid == 0
-	// Close read ends of stdout and stderr
-	// Close write end of stdin
-	close(stdout_fds[READ_END]);	
-	close(stderr_fds[READ_END]);	
-	close(stdin_fds[WRITE_END]);
-
-	// Assign the pipes to the
-	// actual file descriptors stdin,out,err
-	// respectively.
-	dup2(stdout_fds[WRITE_END], STDOUT_FILENO);
-	dup2(stderr_fds[WRITE_END], STDERR_FILENO);
-	dup2(stdin_fds[READ_END], STDIN_FILENO);
-	
-	// Exec the process we want to run.
-	const char *cmd = command_name.c_str();
-	const char * args[arguments.size()+2];
-
-	args[0] = cmd;
-	
-	size_t ai = 1;
-	for (const auto & arg : arguments) {
-	    args[ai++] = arg.c_str();
+    }
+    for (SubProcess *process : processes) {
+	if (process->running) {
+	    process->reap();
 	}
-	args[ai] = nullptr;
-
-	const char *env[environment.size()+1];
-	std::vector<std::string> env_list;
-	size_t ei = 0;
-	for (const auto & env_var : environment) {
-	    env_list.push_back(env_var.first + std::string("=") + std::string(env_var.second));
-	    env[ei++] = env_list.back().c_str();
+    }
+}
+
+bool
+SubProcess::has_pipes() const
+{ return child_stdin != -1 || child_stdout != -1 || child_stderr != -1; }
+
+void
+SubProcess::add_pollfds(std::vector<struct pollfd> & pollfds) const
+{
+    if (child_stdin != -1) {
+	pollfds.push_back({ child_stdin, POLLOUT, 0 });
+    }
+    if (child_stdout != -1) {
+	pollfds.push_back({ child_stdout, POLLIN, 0 });
+    }
+    if (child_stderr != -1) {
+	pollfds.push_back({ child_stderr, POLLIN, 0 });
+    }
+}
+
+size_t
+SubProcess::handle_pollfds(const struct pollfd *pollfds)
+{
+    // This takes the entries in the order
+    // add_pollfds() gave them.
+    size_t index = 0;
+    if (child_stdin != -1) {
+	handle_stdin(pollfds[index++].revents);
+    }
+    if (child_stdout != -1) {
+	handle_output(child_stdout, *stdout_reader, pollfds[index++].revents);
+    }
+    if (child_stderr != -1) {
+	handle_output(child_stderr, *stderr_reader, pollfds[index++].revents);
+    }
+    return index;
+}
+
+void
+SubProcess::handle_stdin(short revents)
+{
+    if (revents & (POLLERR | POLLNVAL)) {
+	// The command closed its stdin, so it
+	// won't read the rest of the input.
+	close_fd(child_stdin);
+	return;
+    }
+    if (!(revents & POLLOUT)) {
+	return;
+    }
+    if (stdin_position == stdin_length) {
+	int got = stdin_writer->read(stdin_buffer.data(), stdin_buffer.size());
+	if (got <= 0) {
+	    // Closing it tells the command
+	    // there is no more input.
+	    close_fd(child_stdin);
+	    return;
 	}
-	env[ei] = nullptr;
+	stdin_position = 0;
+	stdin_length = (size_t)got;
+    }
+    ssize_t wrote = write_no_sigpipe(child_stdin, &stdin_buffer[stdin_position], stdin_length - stdin_position);
+    if (wrote > 0) {
+	stdin_position += (size_t)wrote;
+    }
+    else if (wrote < 0 && errno != EAGAIN && errno != EINTR) {
+	// Most likely EPIPE, because the command closed
+	// its stdin after we polled it, which is the
+	// same as the POLLERR above.
+	close_fd(child_stdin);
+    }
+}
 
-	// I strongly suspect that the declaration of execvpe is wrong, but
-	// this seems to satisfy it.
-	int rc = execvpe(cmd, (char *const*)&args[0], (char *const*)&env[0]);
+void
+SubProcess::handle_output(int & fd, SubProcessReader & reader, short revents)
+{
+    if (!(revents & (POLLIN | POLLHUP | POLLERR | POLLNVAL))) {
+	return;
+    }
+    char buffer[BUFFER_LENGTH];
+    ssize_t got = ::read(fd, buffer, sizeof(buffer));
+    if (got < 0 && (errno == EAGAIN || errno == EINTR)) {
+	return;
+    }
+    if (got <= 0) {
+	// The command has closed its end,
+	// usually because it has finished.
+	close_fd(fd);
+	return;
+    }
+    size_t written = 0;
+    while (written < (size_t)got) {
+	int wrote = reader.write(buffer + written, (size_t)got - written);
+	if (wrote <= 0) {
+	    break;
+	}
+	written += (size_t)wrote;
+    }
+}
 
-	// If we have reached here at all, it must be
-	// an error regardless of what the value of rc is.
-	fprintf(stderr, "Process would not be launched\n");
+void
+SubProcess::close_pipes()
+{
+    close_fd(child_stdin);
+    close_fd(child_stdout);
+    close_fd(child_stderr);
+}
 
-	return rc;
+void
+SubProcess::reap()
+{
+    int status = 0;
+    pid_t result;
+    do {
+	result = ::waitpid(pid, &status, 0);
+    } while (result == -1 && errno == EINTR);
+    running = false;
+    pid = -1;
+    if (result == -1) {
+	exit_status = -1;
+    }
+    else if (WIFEXITED(status)) {
+	exit_status = WEXITSTATUS(status);
+    }
+    else if (WIFSIGNALED(status)) {
+	// As a shell reports it.
+	exit_status = 128 + WTERMSIG(status);
+    }
+    else {
+	exit_status = -1;
     }
 }
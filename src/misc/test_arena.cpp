@@ -0,0 +1,95 @@
+/* Copyright 2025 Jonathan S. Arney
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      https://github.com/jarney/gyoji/blob/master/LICENSE
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#include <gyoji-misc/arena.hpp>
+#include <gyoji-misc/pointers.hpp>
+#include <gyoji-misc/test.hpp>
+#include <stdint.h>
+
+using namespace Gyoji::misc;
+
+class Node : public ArenaAllocated {
+public:
+    Node(int _value, int & _destroyed)
+	: value(_value)
+	, destroyed(_destroyed)
+    {}
+    ~Node()
+    { destroyed++; }
+    int value;
+    int & destroyed;
+    std::vector<int, ArenaAllocator<int>> items;
+};
+
+int main(int argc, char **argv)
+{
+    printf("Testing arenas\n");
+
+    {
+	Arena arena;
+	ASSERT_INT_EQUAL(0, arena.get_allocated(), "Nothing allocated yet");
+	char *a = (char*)arena.allocate(1);
+	char *b = (char*)arena.allocate(3);
+	ASSERT_TRUE(((uintptr_t)a % alignof(max_align_t)) == 0, "Blocks are aligned");
+	ASSERT_TRUE(((uintptr_t)b % alignof(max_align_t)) == 0, "Blocks are aligned");
+	ASSERT_TRUE(b > a, "Blocks are handed out in order");
+	char *big = (char*)arena.allocate(1024 * 1024);
+	big[1024 * 1024 - 1] = 1;
+	char *c = (char*)arena.allocate(1);
+	ASSERT_TRUE(c > b && c < b + 1024, "A large block doesn't use up the current chunk");
+	ASSERT_TRUE(arena.get_footprint() >= arena.get_allocated(), "Footprint covers what was allocated");
+    }
+    {
+	ASSERT_TRUE(Arena::get_current() == nullptr, "No arena is current to start with");
+	Arena outer;
+	Arena inner;
+	{
+	    ArenaScope outer_scope(outer);
+	    ASSERT_TRUE(Arena::get_current() == &outer, "Outer arena is current");
+	    {
+		ArenaScope inner_scope(inner);
+		ASSERT_TRUE(Arena::get_current() == &inner, "Inner arena is current");
+	    }
+	    ASSERT_TRUE(Arena::get_current() == &outer, "Outer arena is current again");
+	}
+	ASSERT_TRUE(Arena::get_current() == nullptr, "No arena is current afterwards");
+    }
+    {
+	int destroyed = 0;
+	Arena arena;
+	Gyoji::owned<Node> node;
+	{
+	    ArenaScope scope(arena);
+	    node = Gyoji::owned_new<Node>(12, destroyed);
+	    node->items.push_back(1);
+	    node->items.push_back(2);
+	}
+	ASSERT_TRUE(arena.get_allocated() >= sizeof(Node), "Node was placed in the arena");
+	ASSERT_INT_EQUAL(12, node->value, "Node was constructed");
+	ASSERT_INT_EQUAL(2, node->items.size(), "Node's list was filled");
+	node.reset();
+	ASSERT_INT_EQUAL(1, destroyed, "Node was destroyed");
+    }
+    {
+	int destroyed = 0;
+	Gyoji::owned<Node> node = Gyoji::owned_new<Node>(7, destroyed);
+	node->items.push_back(3);
+	ASSERT_INT_EQUAL(7, node->value, "Node without an arena comes from the heap");
+	node.reset();
+	ASSERT_INT_EQUAL(1, destroyed, "Heap node was destroyed");
+    }
+
+    printf("    PASSED\n");
+    return 0;
+}
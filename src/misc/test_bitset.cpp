@@ -0,0 +1,89 @@
+/* Copyright 2025 Jonathan S. Arney
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      https://github.com/jarney/gyoji/blob/master/LICENSE
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#include <gyoji-misc/bitset.hpp>
+#include <gyoji-misc/test.hpp>
+
+using namespace Gyoji::misc;
+
+int main(int argc, char **argv)
+{
+    printf("Testing bit sets\n");
+
+    {
+	BitSet set(130);
+	ASSERT_INT_EQUAL(130, set.size(), "Size is the number of elements it can hold");
+	ASSERT_TRUE(set.empty(), "New sets are empty");
+	set.set(0);
+	set.set(63);
+	set.set(64);
+	set.set(129);
+	ASSERT_TRUE(set.test(63), "Element at the end of a word was set");
+	ASSERT_TRUE(set.test(64), "Element at the start of a word was set");
+	ASSERT_FALSE(set.test(65), "Element was never set");
+	ASSERT_INT_EQUAL(4, set.count(), "Four elements were set");
+	set.reset(63);
+	ASSERT_FALSE(set.test(63), "Element was reset");
+	ASSERT_INT_EQUAL(3, set.count(), "One element was removed");
+    }
+    {
+	BitSet set(200);
+	set.set(3);
+	set.set(70);
+	set.set(199);
+	std::vector<size_t> found;
+	for (size_t i = set.find_next(0); i < set.size(); i = set.find_next(i+1)) {
+	    found.push_back(i);
+	}
+	ASSERT_INT_EQUAL(3, found.size(), "Visit each element once");
+	ASSERT_INT_EQUAL(3, found.at(0), "Elements are visited in order");
+	ASSERT_INT_EQUAL(70, found.at(1), "Elements are visited in order");
+	ASSERT_INT_EQUAL(199, found.at(2), "Elements are visited in order");
+	ASSERT_INT_EQUAL(200, set.find_next(200), "Nothing past the end of the set");
+    }
+    {
+	BitSet a(100);
+	BitSet b(100);
+	a.set(1);
+	b.set(1);
+	b.set(90);
+	ASSERT_TRUE(a.intersects(b), "Both sets contain 1");
+	ASSERT_TRUE(a.union_with(b), "Union adds 90");
+	ASSERT_FALSE(a.union_with(b), "Second union changes nothing");
+	ASSERT_TRUE(a == b, "Sets are now the same");
+
+	BitSet c(100);
+	c.set(90);
+	ASSERT_TRUE(a.subtract(c), "Subtract removes 90");
+	ASSERT_FALSE(a.test(90), "90 was removed");
+	ASSERT_FALSE(a.subtract(c), "Second subtract changes nothing");
+	ASSERT_TRUE(b.intersect_with(a), "Intersection removes 90");
+	ASSERT_TRUE(a == b, "Sets are the same again");
+	ASSERT_FALSE(a.intersects(c), "Nothing in common");
+    }
+    {
+	BitSet set(70);
+	set.fill();
+	ASSERT_INT_EQUAL(70, set.count(), "Fill adds every element and nothing more");
+	ASSERT_INT_EQUAL(70, set.find_next(70), "Fill doesn't add past the end");
+	set.clear();
+	set.set(69);
+	set.resize(65);
+	set.resize(70);
+	ASSERT_FALSE(set.test(69), "Shrinking the set removes elements for good");
+    }
+
+    printf("    PASSED\n");
+    return 0;
+}
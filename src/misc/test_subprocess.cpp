@@ -1,23 +1,141 @@
 #include <gyoji-misc/subprocess.hpp>
+#include <gyoji-misc/test.hpp>
 #include <unistd.h>
+#include <string.h>
 
 using namespace Gyoji::misc::subprocess;
 
+// Collects what the subprocess writes.
+class SubProcessReaderString : public SubProcessReader {
+public:
+    SubProcessReaderString(std::string & _output)
+	: output(_output)
+    {}
+    ~SubProcessReaderString()
+    {}
+    int write(char *buffer, size_t bytes)
+    {
+	output.append(buffer, bytes);
+	return (int)bytes;
+    }
+private:
+    std::string & output;
+};
+
+// Gives the subprocess the same text over and over.
+class SubProcessWriterRepeat : public SubProcessWriter {
+public:
+    SubProcessWriterRepeat(std::string _text, size_t _count)
+	: text(_text)
+	, count(_count)
+    {}
+    ~SubProcessWriterRepeat()
+    {}
+    int read(char *buffer, size_t bytes)
+    {
+	if (count == 0 || bytes < text.size()) {
+	    return 0;
+	}
+	count--;
+	memcpy(buffer, text.c_str(), text.size());
+	return (int)text.size();
+    }
+    bool is_eof() const
+    { return count == 0; }
+private:
+    std::string text;
+    size_t count;
+};
+
 int main(int argc, char **argv)
 {
-    SubProcess lsproc(
-	std::move(Gyoji::owned_new<SubProcessReaderFile>(STDOUT_FILENO)),
-	std::move(Gyoji::owned_new<SubProcessReaderFile>(STDERR_FILENO)),
-	std::move(Gyoji::owned_new<SubProcessWriterEmpty>())
-	);
-
-    std::vector<std::string> arguments;
     std::map<std::string, std::string> environment;
-//    int rc = lsproc.invoke("/home/jona/NetBeansProjects/jos/compiler/jlang2/test-shell.sh",
-    int rc = lsproc.invoke("ls",
-		  arguments,
-		  environment
-	);
-    fprintf(stderr, "Child process exited with %d\n", rc);
+    {
+	SubProcess lsproc(
+	    std::move(Gyoji::owned_new<SubProcessReaderFile>(STDOUT_FILENO)),
+	    std::move(Gyoji::owned_new<SubProcessReaderFile>(STDERR_FILENO)),
+	    std::move(Gyoji::owned_new<SubProcessWriterEmpty>())
+	    );
+	std::vector<std::string> arguments;
+	int rc = lsproc.invoke("ls",
+			       arguments,
+			       environment
+	    );
+	fprintf(stderr, "Child process exited with %d\n", rc);
+	ASSERT_INT_EQUAL(0, rc, "ls should run");
+    }
+    {
+	std::string output;
+	std::string errors;
+	SubProcess echoproc(
+	    std::move(Gyoji::owned_new<SubProcessReaderString>(output)),
+	    std::move(Gyoji::owned_new<SubProcessReaderString>(errors)),
+	    std::move(Gyoji::owned_new<SubProcessWriterEmpty>())
+	    );
+	std::vector<std::string> arguments;
+	arguments.push_back("-c");
+	arguments.push_back("echo out; echo err 1>&2; exit 3");
+	int rc = echoproc.invoke("sh", arguments, environment);
+	ASSERT_INT_EQUAL(3, rc, "Exit status should be passed back");
+	ASSERT_STR_EQUAL("out\n", output, "stdout should be captured");
+	ASSERT_STR_EQUAL("err\n", errors, "stderr should be captured");
+    }
+    {
+	// More input than a pipe holds, so the input and
+	// output must be passed along at the same time.
+	std::string output;
+	SubProcess catproc(
+	    std::move(Gyoji::owned_new<SubProcessReaderString>(output)),
+	    std::move(Gyoji::owned_new<SubProcessReaderFile>(STDERR_FILENO)),
+	    std::move(Gyoji::owned_new<SubProcessWriterRepeat>("0123456789\n", 100000))
+	    );
+	std::vector<std::string> arguments;
+	int rc = catproc.invoke("cat", arguments, environment);
+	ASSERT_INT_EQUAL(0, rc, "cat should run");
+	ASSERT_INT_EQUAL(1100000, output.size(), "All of the input should come back");
+    }
+    {
+	// A command that exits without reading its input
+	// must not take us down with SIGPIPE.
+	SubProcess trueproc(
+	    std::move(Gyoji::owned_new<SubProcessReaderFile>(STDOUT_FILENO)),
+	    std::move(Gyoji::owned_new<SubProcessReaderFile>(STDERR_FILENO)),
+	    std::move(Gyoji::owned_new<SubProcessWriterRepeat>("0123456789\n", 100000))
+	    );
+	std::vector<std::string> arguments;
+	int rc = trueproc.invoke("true", arguments, environment);
+	ASSERT_INT_EQUAL(0, rc, "Unread input is not an error");
+    }
+    {
+	std::vector<Gyoji::owned<SubProcess>> processes;
+	std::vector<SubProcess*> waiting;
+	std::string outputs[4];
+	for (size_t i = 0; i < 4; i++) {
+	    processes.push_back(Gyoji::owned_new<SubProcess>(
+				    Gyoji::owned_new<SubProcessReaderString>(outputs[i]),
+				    Gyoji::owned_new<SubProcessReaderFile>(STDERR_FILENO),
+				    Gyoji::owned_new<SubProcessWriterEmpty>()
+				    ));
+	    std::vector<std::string> arguments;
+	    arguments.push_back(std::to_string(i));
+	    ASSERT_TRUE(processes.back()->start("echo", arguments, environment), "echo should start");
+	    waiting.push_back(processes.back().get());
+	}
+	SubProcess::wait_all(waiting);
+	for (size_t i = 0; i < 4; i++) {
+	    ASSERT_INT_EQUAL(0, processes[i]->wait(), "Each process should finish");
+	    ASSERT_STR_EQUAL(std::to_string(i) + "\n", outputs[i], "Each process has its own output");
+	}
+    }
+    {
+	SubProcess missing(
+	    std::move(Gyoji::owned_new<SubProcessReaderFile>(STDOUT_FILENO)),
+	    std::move(Gyoji::owned_new<SubProcessReaderFile>(STDERR_FILENO)),
+	    std::move(Gyoji::owned_new<SubProcessWriterEmpty>())
+	    );
+	std::vector<std::string> arguments;
+	ASSERT_INT_EQUAL(-1, missing.invoke("gyoji-no-such-command", arguments, environment), "Missing command can't start");
+    }
+    printf("PASSED\n");
     return 0;
 }
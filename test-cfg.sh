@@ -21,11 +21,6 @@ TEST_CFG_DIR=${CMAKE_BINARY_DIR}/test-cfg-dir
 
 JCC=${CMAKE_BINARY_DIR}/src/cmdline/jcc
 
-# TODO: semantics-arrays
-# Array initialization is basically broken
-# because we don't have a good way to initialize
-# arrays for the 'use before initialization' check.
-
 TEST_FILES="
 semantics-if-else
 semantics-types
@@ -40,6 +35,19 @@ semantics-sizeof
 semantics-while
 semantics-goto
 semantics-for
+semantics-arrays
+semantics-use-before-initialization-partial
+semantics-borrow
+semantics-bounds-check
+semantics-constants
+"
+
+# These are expected to be rejected by
+# the compiler with errors.
+TEST_FILES_BAD="
+semantics-use-before-initialization-bad1
+semantics-borrow-bad1
+semantics-constants-bad1
 "
 
 echo "Checking token stream output."
@@ -84,6 +92,20 @@ for TEST_FILE in ${TEST_FILES} ; do
 
 done
 
+echo "Checking that invalid programs are rejected."
+for TEST_FILE in ${TEST_FILES_BAD} ; do
+    echo -n "    ${TEST_FILE}"
+    ${JCC} \
+	-c ${CMAKE_SOURCE_DIR}/tests/${TEST_FILE}.j \
+	-o ${TEST_CFG_DIR}/${TEST_FILE}.o 2>/dev/null
+    if [ $? -eq 0 ] ; then
+	echo " : FAILED compiled without errors"
+	failed=1
+    else
+	echo " : PASSED"
+    fi
+done
+
 if [ ${failed} -ne 0 ] ; then
     exit 1
 fi
@@ -209,3 +209,34 @@ FUNCTION(i64_modulo, i64, i64, i64, %)
 FUNCTION(i64_modulo_widen_a, i64, i32, i64, %)
 FUNCTION(i64_modulo_widen_b, i64, i64, i32, %)
 
+//////////////////////////
+// Scopes
+//////////////////////////
+// Variables with the same name declared in
+// sibling scopes are different variables.
+u32 FNAME(u32_sibling_loops)(u32 a, u32 b)
+{
+    u32 total = 0;
+    for (u32 i = 0; i < a % 16; i += 1) {
+	total = total + b;
+    }
+    for (u32 i = 0; i < b % 16; i += 1) {
+	total = total + i;
+    }
+    return total;
+}
+
+u32 FNAME(u32_sibling_blocks)(u32 a, u32 b)
+{
+    {
+	u32 x = a;
+	if (b < a) {
+	    return x;
+	}
+    }
+    {
+	u32 x = b;
+	return x + 1;
+    }
+}
+
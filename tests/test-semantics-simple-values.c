@@ -224,6 +224,12 @@ DECLARE_BINARY_OPERATIONS_FULL(i64, i64, i64, _modulo);
 DECLARE_BINARY_OPERATIONS_FULL(i64, i32, i64, _modulo_widen_a);
 DECLARE_BINARY_OPERATIONS_FULL(i64, i64, i32, _modulo_widen_b);
 
+//////////////////////////
+// Scopes
+//////////////////////////
+DECLARE_BINARY_OPERATIONS_FULL(u32, u32, u32, _sibling_loops);
+DECLARE_BINARY_OPERATIONS_FULL(u32, u32, u32, _sibling_blocks);
+
 
 int main(int argc, char **argv)
 {
@@ -389,6 +395,12 @@ int main(int argc, char **argv)
 	TEST_BINARY_OPERATION_FULL(i64, i32, i64, "%ld", "%d", "%ld", _modulo_widen_a);
 	TEST_BINARY_OPERATION_FULL(i64, i64, i32, "%ld", "%ld", "%d", _modulo_widen_b);
 
+//////////////////////////
+// Scopes
+//////////////////////////
+	TEST_BINARY_OPERATION_FULL(u32, u32, u32, "%d", "%d", "%d", _sibling_loops);
+	TEST_BINARY_OPERATION_FULL(u32, u32, u32, "%d", "%d", "%d", _sibling_blocks);
+
     }
     return 0;
 }